@@ -16,8 +16,44 @@ typedef enum
     SCOPE_SCALE_TARGET_TIME
 } ScopeScaleTarget;
 
+typedef enum
+{
+    SCOPE_VIEW_WAVEFORM = 0,
+    SCOPE_VIEW_HISTOGRAM,
+    SCOPE_VIEW_EYE,
+    SCOPE_VIEW_BODE,
+    SCOPE_VIEW_JITTER,
+    SCOPE_VIEW_COUNT
+} ScopeView;
+
+typedef struct
+{
+    uint32_t events;
+    uint32_t dropped;
+    /* Worst post-to-apply delay seen by the frame loop. */
+    uint32_t max_latency_ms;
+} ScopeEventStats;
+
+/* The part of the scope state the settings journal keeps across resets. */
+typedef struct
+{
+    uint32_t span_counts;
+    int32_t center_counts;
+    uint32_t samples_visible;
+    int32_t center_sample;
+    ScopeScaleTarget scale_target;
+} ScopePersistentSettings;
+
 void Scope_Init(void);
+/* Lends the spare frame buffer: a frame filled there and passed to
+   Scope_ProcessFrame becomes the live frame without a copy. NULL while a
+   history frame is held and every buffer is in use. */
+uint16_t *Scope_AcquireFrameBuffer(void);
 void Scope_ProcessFrame(uint16_t *samples, uint16_t count);
+/* Packs every acquired frame into history from the DMA interrupt, whether
+   or not the main loop keeps up; event_index is the software trigger's
+   result for it. */
+void Scope_RecordFrameFromISR(uint16_t *samples, uint16_t count, uint32_t sequence, uint16_t event_index);
 void Scope_RequestAutoSet(void);
 void Scope_RequestMoreCycles(void);
 void Scope_RequestFewerCycles(void);
@@ -27,12 +63,31 @@ void Scope_RequestOffsetDecrease(void);
 void Scope_RequestOffsetIncrease(void);
 void Scope_ToggleScaleTarget(void);
 ScopeScaleTarget Scope_GetScaleTarget(void);
+void Scope_GetPersistentSettings(ScopePersistentSettings *settings);
+/* Clamped like the button handlers; call before the first frame. */
+void Scope_RestorePersistentSettings(const ScopePersistentSettings *settings);
 uint16_t Scope_FrameSampleCount(void);
+uint8_t Scope_GetFrameMean(uint16_t *mean_counts);
+/* Reference traces: saved from the held frame (else the newest live one)
+   together with the display window, shown as an overlay in the waveform
+   view. */
+uint8_t Scope_SaveReference(uint8_t slot);
+uint8_t Scope_ShowReference(uint8_t slot);
+void Scope_HideReference(void);
+uint8_t Scope_EraseReference(uint8_t slot);
+int8_t Scope_GetShownReference(void);
+/* The shown reference was taken at another sample rate; its overlay is
+   hidden until the rate is set back. */
+uint8_t Scope_IsReferenceRateMismatched(void);
 void Scope_ToggleWaveformHold(void);
+void Scope_GetEventStats(ScopeEventStats *stats);
 uint8_t Scope_IsWaveformHoldEnabled(void);
 void Scope_RequestCursorShift(int8_t direction);
 void Scope_RequestCursorSelectNext(void);
 void Scope_ToggleCursorAutoShift(int8_t direction);
+void Scope_RequestView(ScopeView view);
+ScopeView Scope_GetView(void);
+uint8_t Scope_CaptureMask(uint32_t tolerance_millivolt, uint16_t tolerance_columns);
 
 #ifdef __cplusplus
 }
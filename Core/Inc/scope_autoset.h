@@ -0,0 +1,44 @@
+#ifndef INC_SCOPE_AUTOSET_H_
+#define INC_SCOPE_AUTOSET_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef enum
+{
+    SCOPE_AUTOSET_IDLE = 0,
+    SCOPE_AUTOSET_RUNNING,
+    SCOPE_AUTOSET_DONE
+} ScopeAutosetState;
+
+typedef struct
+{
+    uint32_t sample_rate_hz;
+    uint32_t period_q8;
+    uint32_t freq_hz;
+    uint16_t signal_min;
+    uint16_t signal_max;
+    uint16_t trigger_level;
+    uint8_t period_found;
+    uint8_t rates_tried;
+    uint32_t elapsed_ms;
+} ScopeAutosetResult;
+
+void ScopeAutoset_Init(uint16_t min_amplitude_counts);
+void ScopeAutoset_Start(uint32_t now_ms);
+uint8_t ScopeAutoset_IsRunning(void);
+ScopeAutosetState ScopeAutoset_Step(uint16_t *samples,
+                                    uint16_t count,
+                                    uint32_t sequence,
+                                    uint32_t now_ms,
+                                    ScopeAutosetResult *result);
+uint8_t ScopeAutoset_TakeReport(ScopeAutosetResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_AUTOSET_H_ */
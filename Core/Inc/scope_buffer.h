@@ -11,6 +11,11 @@ void ScopeBuffer_Init(void);
 void ScopeBuffer_EnqueueFromISR(uint8_t buffer_index);
 uint16_t *ScopeBuffer_Dequeue(uint16_t *frame_samples);
 uint32_t ScopeBuffer_GetOverrunCount(void);
+uint32_t ScopeBuffer_GetLastSequence(void);
+/* Software trigger event in the last dequeued frame, or
+   SCOPE_TRIGGER_NO_EVENT. */
+uint16_t ScopeBuffer_GetLastTriggerIndex(void);
+uint32_t ScopeBuffer_GetNextSequence(void);
 uint8_t ScopeBuffer_HasPending(void);
 uint16_t *ScopeBuffer_GetDmaBaseAddress(void);
 
@@ -0,0 +1,46 @@
+#ifndef INC_SCOPE_CALIB_H_
+#define INC_SCOPE_CALIB_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t vdda_millivolt;
+    uint16_t vrefint_counts;
+    uint16_t vrefint_factory_counts;
+    int16_t offset_counts;
+    uint32_t gain_q16;
+    uint32_t scale_q16;
+    uint32_t refresh_count;
+    uint8_t refresh_active;
+    uint8_t stored;
+} ScopeCalibStatus;
+
+void ScopeCalib_Init(void);
+/* acquisition_paused: no acquired frame is being kept (hold), so a
+   refresh that does not fit between two samples may run anyway. */
+void ScopeCalib_Service(uint32_t now_ms, uint8_t acquisition_paused);
+void ScopeCalib_GetStatus(ScopeCalibStatus *status);
+
+uint32_t ScopeCalib_CountsToMillivolt(uint32_t counts);
+uint32_t ScopeCalib_SpanToMillivolt(uint32_t counts);
+uint16_t ScopeCalib_MillivoltToCounts(uint32_t millivolt);
+uint16_t ScopeCalib_MillivoltToSpan(uint32_t millivolt);
+int16_t ScopeCalib_OffsetCounts(void);
+
+uint8_t ScopeCalib_SetZero(uint16_t mean_counts);
+uint8_t ScopeCalib_SetGain(uint16_t mean_counts, uint32_t millivolt);
+void ScopeCalib_ResetBoard(void);
+/* Range-checked; used by the settings journal at boot. */
+uint8_t ScopeCalib_Restore(int16_t offset_counts, uint32_t gain_q16);
+uint8_t ScopeCalib_Save(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_CALIB_H_ */
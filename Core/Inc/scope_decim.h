@@ -0,0 +1,38 @@
+#ifndef INC_SCOPE_DECIM_H_
+#define INC_SCOPE_DECIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum
+{
+    SCOPE_DECIM_MIN_RATIO = 2U,
+    SCOPE_DECIM_MAX_RATIO = 4096U,
+    SCOPE_DECIM_MIN_OUTPUT_HZ = 100U,
+    SCOPE_DECIM_MAX_INPUT_HZ = 1000000U
+};
+
+typedef struct
+{
+    uint16_t ratio;
+    uint32_t input_rate_hz;
+    uint32_t output_rate_hz;
+    uint32_t frames;
+    uint32_t cycles_per_buffer;
+    uint32_t max_cycles_per_buffer;
+} ScopeDecimStatus;
+
+void ScopeDecim_Init(void);
+uint8_t ScopeDecim_Configure(uint16_t ratio);
+uint16_t ScopeDecim_GetRatio(void);
+uint16_t *ScopeDecim_ProcessFromISR(uint16_t *samples, uint16_t count);
+void ScopeDecim_GetStatus(ScopeDecimStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_DECIM_H_ */
@@ -0,0 +1,57 @@
+#ifndef INC_SCOPE_DECODE_H_
+#define INC_SCOPE_DECODE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope_signal.h"
+#include <stdint.h>
+
+enum
+{
+    SCOPE_DECODE_MAX_FRAME_BYTES = 16U,
+    SCOPE_DECODE_MIN_SAMPLES_PER_BIT = 8U
+};
+
+typedef struct
+{
+    uint8_t value;
+    uint8_t framing_error;
+    uint16_t start_index;
+    uint16_t stop_index;
+} ScopeDecodeByte;
+
+typedef struct
+{
+    ScopeDecodeByte bytes[SCOPE_DECODE_MAX_FRAME_BYTES];
+    uint8_t count;
+} ScopeDecodeFrame;
+
+typedef struct
+{
+    uint32_t baud;
+    uint32_t bytes;
+    uint32_t framing_errors;
+    uint32_t resyncs;
+    uint32_t stream_drops;
+    uint8_t rate_ok;
+} ScopeDecodeStatus;
+
+void ScopeDecode_Init(void);
+uint8_t ScopeDecode_Configure(uint32_t baud);
+uint8_t ScopeDecode_IsEnabled(void);
+void ScopeDecode_GetStatus(ScopeDecodeStatus *status);
+void ScopeDecode_Process(const ScopeSignalCrossings *crossings,
+                         uint16_t count,
+                         uint8_t levels_valid,
+                         uint8_t contiguous,
+                         uint32_t sample_rate_hz,
+                         ScopeDecodeFrame *out);
+uint8_t ScopeDecode_PopStream(ScopeDecodeByte *byte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_DECODE_H_ */
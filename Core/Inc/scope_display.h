@@ -5,6 +5,12 @@
 extern "C" {
 #endif
 
+#include "scope_eye.h"
+#include "scope_fra.h"
+#include "scope_histogram.h"
+#include "scope_jitter.h"
+#include "scope_measure.h"
+#include "scope_stats.h"
 #include <stdint.h>
 
 typedef struct
@@ -32,7 +38,6 @@ typedef struct
     uint16_t grid_spacing_px;
     uint16_t waveform_color;
     uint16_t adc_max_counts;
-    uint16_t adc_ref_millivolt;
 } ScopeDisplayConfig;
 
 void ScopeDisplay_Init(const ScopeDisplayConfig *cfg);
@@ -51,8 +56,21 @@ typedef struct
     uint16_t sample_indices[2];
     uint16_t sample_values[2];
     uint8_t count;
+    /* Set while K5/K6 step through history instead of moving a cursor. */
+    uint8_t history_selected;
+    uint16_t history_age;
+    uint16_t history_count;
+    /* Frames joined into the held deep record. */
+    uint16_t record_frames;
 } ScopeDisplayCursorMeasurements;
 
+/* Fills the frame sample index shown in each screen column; returns the
+   number of columns. */
+uint16_t ScopeDisplay_MapColumns(const ScopeDisplaySettings *settings,
+                                 uint16_t count,
+                                 uint16_t visible_samples,
+                                 uint16_t trigger_index,
+                                 uint16_t *column_sample_map);
 void ScopeDisplay_DrawWaveform(const ScopeDisplaySettings *settings,
                                uint16_t *samples,
                                uint16_t count,
@@ -60,9 +78,75 @@ void ScopeDisplay_DrawWaveform(const ScopeDisplaySettings *settings,
                                uint16_t trigger_index,
                                const ScopeDisplayCursorRenderInfo *cursor_info,
                                uint16_t *column_sample_map);
-void ScopeDisplay_DrawMeasurements(uint16_t vmin,
-                                   uint16_t vmax,
-                                   uint32_t freq_hz);
+/* MapColumns over a record longer than one frame (held deep record). */
+uint16_t ScopeDisplay_MapRecordColumns(const ScopeDisplaySettings *settings,
+                                       uint16_t length,
+                                       uint16_t visible_samples,
+                                       uint16_t trigger_index,
+                                       uint16_t *column_sample_map);
+/* Draws the lowest to highest sample of each column, for windows wider
+   than one sample per column; the columns come from the last
+   MapRecordColumns. */
+void ScopeDisplay_DrawEnvelope(const ScopeDisplaySettings *settings,
+                               const uint16_t *column_min,
+                               const uint16_t *column_max,
+                               uint16_t columns,
+                               const ScopeDisplayCursorRenderInfo *cursor_info);
+void ScopeDisplay_DrawMeasurements(const ScopeMeasureResult *result);
+
+/* Reference trace painted under the live one, built from a sample stream so
+   the stored record never has to be copied into RAM. It becomes part of the
+   background, so erasing the live trace restores it. */
+void ScopeDisplay_BeginReference(const ScopeDisplaySettings *settings,
+                                 uint16_t count,
+                                 uint16_t trigger_index);
+void ScopeDisplay_AddReferenceSample(uint16_t index, uint16_t value);
+void ScopeDisplay_EndReference(void);
+void ScopeDisplay_ClearReference(void);
+/* Only the waveform view shows it; takes effect at the next DrawGrid. */
+void ScopeDisplay_SetReferenceVisible(uint8_t visible);
+
+typedef struct
+{
+    uint8_t tolerance_px;
+    uint32_t drawn;
+    uint32_t skipped;
+    /* Column-to-sample and count-to-row mapping: the last rebuild after a
+       zoom or pan, and the per-frame pass over the columns. */
+    uint32_t plan_cycles;
+    uint32_t map_cycles;
+    uint32_t max_map_cycles;
+} ScopeDisplayRedrawStats;
+
+/* Trace redraws are skipped while no column moved by more than this. */
+void ScopeDisplay_SetRedrawTolerance(uint8_t tolerance_px);
+void ScopeDisplay_GetRedrawStats(ScopeDisplayRedrawStats *stats);
+void ScopeDisplay_ResetRedrawStats(void);
+void ScopeDisplay_DrawStatistics(const ScopeStatsSummary *slots);
+void ScopeDisplay_DrawHistogram(const ScopeDisplaySettings *settings,
+                                const uint32_t *bins,
+                                uint16_t bin_count,
+                                const ScopeHistogramSummary *summary);
+void ScopeDisplay_DrawEye(const uint8_t *hits, const ScopeEyeStatus *status);
+void ScopeDisplay_DrawBode(const ScopeFraPoint *points, const ScopeFraStatus *status);
+void ScopeDisplay_DrawJitter(const uint32_t *bins,
+                             const float *trend_ns,
+                             uint16_t trend_count,
+                             const ScopeJitterStatus *status);
+
+enum { SCOPE_DISPLAY_MAX_ANNOTATIONS = 16U };
+
+typedef struct
+{
+    uint16_t first_sample;
+    uint16_t last_sample;
+    uint16_t color;
+    char text[5];
+} ScopeDisplayAnnotation;
+
+void ScopeDisplay_DrawAnnotations(const ScopeDisplayAnnotation *items,
+                                  uint8_t count,
+                                  const uint16_t *column_sample_map);
 void ScopeDisplay_DrawCursorMeasurements(const ScopeDisplayCursorMeasurements *measurements);
 
 #ifdef __cplusplus
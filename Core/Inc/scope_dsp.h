@@ -0,0 +1,61 @@
+#ifndef INC_SCOPE_DSP_H_
+#define INC_SCOPE_DSP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdint.h>
+#include <string.h>
+
+/* Thin wrappers over the Cortex-M4 SIMD instructions. The portable branches keep
+   the kernels readable on targets without the DSP extension. */
+
+static inline uint32_t ScopeDsp_Pack16(int16_t low, int16_t high)
+{
+    return ((uint32_t)(uint16_t)low) | ((uint32_t)(uint16_t)high << 16);
+}
+
+static inline uint32_t ScopeDsp_ReadPair(const int16_t *ptr)
+{
+    uint32_t pair;
+    memcpy(&pair, ptr, sizeof(pair));
+    return pair;
+}
+
+static inline int32_t ScopeDsp_DualMac(uint32_t x_pair, uint32_t h_pair, int32_t acc)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    return (int32_t)__SMLAD(x_pair, h_pair, (uint32_t)acc);
+#else
+    return acc + (int32_t)(int16_t)(x_pair & 0xFFFFU) * (int16_t)(h_pair & 0xFFFFU)
+               + (int32_t)(int16_t)(x_pair >> 16) * (int16_t)(h_pair >> 16);
+#endif
+}
+
+static inline uint32_t ScopeDsp_SubSaturateU16x2(uint32_t a_pair, uint32_t b_pair)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    return __UQSUB16(a_pair, b_pair);
+#else
+    uint32_t a_low = a_pair & 0xFFFFU;
+    uint32_t b_low = b_pair & 0xFFFFU;
+    uint32_t a_high = a_pair >> 16;
+    uint32_t b_high = b_pair >> 16;
+    uint32_t low = (a_low > b_low) ? (a_low - b_low) : 0U;
+    uint32_t high = (a_high > b_high) ? (a_high - b_high) : 0U;
+    return low | (high << 16);
+#endif
+}
+
+static inline int16_t ScopeDsp_SaturateQ15(int32_t value)
+{
+    return (int16_t)__SSAT(value, 16);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_DSP_H_ */
@@ -0,0 +1,66 @@
+#ifndef INC_SCOPE_EVENTS_H_
+#define INC_SCOPE_EVENTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* Bounded lock-free event queue: any number of producers (EXTI and UART
+   interrupts at any priority, or the main loop), one consumer. Slots carry
+   sequence numbers, so producers only contend on one compare-and-swap and
+   nothing ever masks interrupts. Free of HAL dependencies so it builds on a
+   host as well. */
+
+enum { SCOPE_EVENT_RING_SIZE = 32U };
+
+typedef enum
+{
+    SCOPE_EVENT_AUTOSET = 0,
+    SCOPE_EVENT_ZOOM_TIME,
+    SCOPE_EVENT_ZOOM_VOLTAGE,
+    SCOPE_EVENT_OFFSET_TIME,
+    SCOPE_EVENT_OFFSET_VOLTAGE,
+    SCOPE_EVENT_HOLD_TOGGLE,
+    SCOPE_EVENT_VIEW,
+    SCOPE_EVENT_CURSOR_SHIFT,
+    SCOPE_EVENT_CURSOR_SELECT,
+    SCOPE_EVENT_CURSOR_AUTOSHIFT
+} ScopeEventType;
+
+typedef struct
+{
+    uint8_t type;
+    /* Zoom: +1 in, -1 out, or a step count once merged in the scale
+       backlog. Offset and cursor: signed step. View: ScopeView. */
+    int8_t arg;
+    uint32_t timestamp_ms;
+} ScopeEvent;
+
+typedef struct
+{
+    atomic_uint sequence;
+    ScopeEvent event;
+} ScopeEventSlot;
+
+typedef struct
+{
+    ScopeEventSlot slots[SCOPE_EVENT_RING_SIZE];
+    atomic_uint enqueue_pos;
+    atomic_uint dropped;
+    /* Consumer-owned. */
+    uint32_t dequeue_pos;
+} ScopeEventRing;
+
+void ScopeEvents_Init(ScopeEventRing *ring);
+uint8_t ScopeEvents_Push(ScopeEventRing *ring, uint8_t type, int8_t arg, uint32_t timestamp_ms);
+uint8_t ScopeEvents_Pop(ScopeEventRing *ring, ScopeEvent *event);
+uint32_t ScopeEvents_Dropped(ScopeEventRing *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_EVENTS_H_ */
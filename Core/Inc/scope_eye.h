@@ -0,0 +1,51 @@
+#ifndef INC_SCOPE_EYE_H_
+#define INC_SCOPE_EYE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope_signal.h"
+#include <stdint.h>
+
+enum
+{
+    SCOPE_EYE_COLUMNS = 160U,
+    SCOPE_EYE_UI_COLUMNS = SCOPE_EYE_COLUMNS / 2U,
+    SCOPE_EYE_ROWS = 88U,
+    SCOPE_EYE_MIN_SAMPLES_PER_UI = 4U
+};
+
+typedef struct
+{
+    uint32_t baud;
+    uint32_t ui_q8;
+    uint32_t unit_intervals;
+    uint32_t generation;
+    uint32_t height_counts;
+    uint32_t width_q8;
+    uint16_t width_permille;
+    uint8_t locked;
+    uint8_t open;
+} ScopeEyeStatus;
+
+void ScopeEye_Init(void);
+uint8_t ScopeEye_Configure(uint32_t baud);
+void ScopeEye_SetEnabled(uint8_t enabled);
+uint8_t ScopeEye_IsEnabled(void);
+void ScopeEye_Reset(void);
+void ScopeEye_Process(const uint16_t *samples,
+                      uint16_t count,
+                      const ScopeSignalCrossings *crossings,
+                      uint8_t contiguous,
+                      uint32_t sample_rate_hz,
+                      int32_t lower_counts,
+                      uint32_t span_counts);
+void ScopeEye_GetStatus(ScopeEyeStatus *status);
+const uint8_t *ScopeEye_Hits(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_EYE_H_ */
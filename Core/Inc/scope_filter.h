@@ -0,0 +1,43 @@
+#ifndef INC_SCOPE_FILTER_H_
+#define INC_SCOPE_FILTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef enum
+{
+    SCOPE_FILTER_OFF = 0,
+    SCOPE_FILTER_LOWPASS,
+    SCOPE_FILTER_HIGHPASS,
+    SCOPE_FILTER_BANDPASS,
+    SCOPE_FILTER_FIR_LOWPASS
+} ScopeFilterType;
+
+typedef struct
+{
+    ScopeFilterType type;
+    uint32_t cutoff_hz;
+    uint32_t sample_rate_hz;
+    uint32_t cycles_per_frame;
+    uint32_t cycles_per_sample_x100;
+} ScopeFilterStatus;
+
+void ScopeFilter_Init(void);
+uint8_t ScopeFilter_Configure(ScopeFilterType type, uint32_t cutoff_hz);
+/* Main loop: redesigns for a new record rate (and reprimes), or turns the
+   filter off when the cutoff no longer fits. */
+void ScopeFilter_Service(uint32_t sample_rate_hz);
+/* Filters a frame in place from the DMA interrupt. Every frame passes
+   through here, dropped ones included, so the delay lines only ever see
+   contiguous data. */
+void ScopeFilter_ProcessFromISR(uint16_t *samples, uint16_t count);
+void ScopeFilter_GetStatus(ScopeFilterStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_FILTER_H_ */
@@ -0,0 +1,27 @@
+#ifndef INC_SCOPE_FLASH_H_
+#define INC_SCOPE_FLASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Internal flash sectors 5-15 of the F413 are 128 KB each. Erasing or
+   programming stalls instruction fetches, so these run from the main loop
+   only and never while a caller expects real-time behaviour. */
+
+enum { SCOPE_FLASH_SECTOR_BYTES = 128U * 1024U };
+
+/* zlib-compatible CRC-32; pass 0 to start and the previous result to chain. */
+uint32_t ScopeFlash_Crc32(uint32_t crc, const void *data, uint32_t length);
+uint8_t ScopeFlash_IsErased(uint32_t address, uint32_t length);
+uint8_t ScopeFlash_EraseSector(uint32_t sector);
+/* Source words may themselves live in flash (compaction copies in place). */
+uint8_t ScopeFlash_ProgramWords(uint32_t address, const uint32_t *words, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_FLASH_H_ */
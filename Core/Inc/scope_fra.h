@@ -0,0 +1,58 @@
+#ifndef INC_SCOPE_FRA_H_
+#define INC_SCOPE_FRA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum
+{
+    SCOPE_FRA_MAX_POINTS = 48U,
+    SCOPE_FRA_MIN_POINTS = 2U,
+    SCOPE_FRA_DEFAULT_POINTS = 20U,
+    SCOPE_FRA_MIN_HZ = 10U,
+    SCOPE_FRA_MAX_HZ = 5000U,
+    /* The display spans this range; points outside are clipped to its edges. */
+    SCOPE_FRA_PLOT_TOP_DB = 20,
+    SCOPE_FRA_PLOT_BOTTOM_DB = -60
+};
+
+typedef struct
+{
+    /* Stimulus frequency actually produced by the DAC timer. */
+    uint32_t freq_centihz;
+    float amplitude_mv;
+    float gain_db;
+    float phase_deg;
+} ScopeFraPoint;
+
+typedef struct
+{
+    uint8_t running;
+    uint8_t aborted;
+    uint8_t point_count;
+    uint8_t points_done;
+    uint32_t start_hz;
+    uint32_t stop_hz;
+    uint32_t sweeps;
+    uint32_t elapsed_ms;
+    uint32_t cycles_per_point;
+} ScopeFraStatus;
+
+void ScopeFra_Init(void);
+uint8_t ScopeFra_Start(uint32_t start_hz, uint32_t stop_hz, uint8_t points, uint32_t now_ms);
+void ScopeFra_Stop(void);
+uint8_t ScopeFra_IsRunning(void);
+uint8_t ScopeFra_Step(const uint16_t *samples, uint16_t count, uint32_t sequence, uint32_t now_ms);
+const ScopeFraPoint *ScopeFra_Points(void);
+void ScopeFra_GetStatus(ScopeFraStatus *status);
+uint8_t ScopeFra_TakePoint(ScopeFraPoint *point, uint8_t *index);
+uint8_t ScopeFra_TakeDone(ScopeFraStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_FRA_H_ */
@@ -0,0 +1,44 @@
+#ifndef INC_SCOPE_GOVERNOR_H_
+#define INC_SCOPE_GOVERNOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum
+{
+    SCOPE_GOVERNOR_MIN_FPS = 1U,
+    SCOPE_GOVERNOR_MAX_FPS = 60U,
+    SCOPE_GOVERNOR_DEFAULT_FPS = 25U
+};
+
+typedef struct
+{
+    uint16_t target_fps;
+    /* Redraw period actually in force after the render-cost limit. */
+    uint32_t interval_ms;
+    uint32_t acquired;
+    uint32_t analyzed;
+    uint32_t rendered;
+    uint32_t dropped;
+    uint32_t analysis_cycles;
+    uint32_t render_cycles;
+    uint32_t max_render_cycles;
+} ScopeGovernorStatus;
+
+void ScopeGovernor_Init(void);
+void ScopeGovernor_Reset(void);
+uint8_t ScopeGovernor_SetTargetFps(uint16_t fps);
+uint16_t ScopeGovernor_GetTargetFps(void);
+void ScopeGovernor_FrameAnalyzed(uint32_t cycles);
+uint8_t ScopeGovernor_RenderDue(uint32_t now_ms);
+void ScopeGovernor_RenderDone(uint32_t now_ms, uint32_t cycles);
+void ScopeGovernor_GetStatus(ScopeGovernorStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_GOVERNOR_H_ */
@@ -0,0 +1,49 @@
+#ifndef INC_SCOPE_HISTOGRAM_H_
+#define INC_SCOPE_HISTOGRAM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum
+{
+    SCOPE_HISTOGRAM_MAX_BINS = 4096U,
+    SCOPE_HISTOGRAM_MIN_BINS = 64U
+};
+
+typedef struct
+{
+    uint32_t total;
+    uint16_t bin_count;
+    uint16_t min;
+    uint16_t max;
+    uint16_t top;
+    uint16_t base;
+    uint8_t bimodal;
+    float mean;
+    float stddev;
+    float noise;
+} ScopeHistogramSummary;
+
+void ScopeHistogram_Init(void);
+uint8_t ScopeHistogram_Configure(uint16_t bin_count);
+void ScopeHistogram_Reset(void);
+void ScopeHistogram_SetEnabled(uint8_t enabled);
+uint8_t ScopeHistogram_IsEnabled(void);
+void ScopeHistogram_Accumulate(const uint16_t *samples, uint16_t count);
+uint8_t ScopeHistogram_Analyze(ScopeHistogramSummary *summary);
+const uint32_t *ScopeHistogram_Bins(uint16_t *bin_count);
+uint8_t ScopeHistogram_EstimateLevels(const uint16_t *samples,
+                                      uint16_t count,
+                                      uint16_t frame_min,
+                                      uint16_t frame_max,
+                                      uint16_t *top,
+                                      uint16_t *base);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_HISTOGRAM_H_ */
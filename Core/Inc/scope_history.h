@@ -0,0 +1,46 @@
+#ifndef INC_SCOPE_HISTORY_H_
+#define INC_SCOPE_HISTORY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope.h"
+#include <stdint.h>
+
+enum
+{
+    /* SRAM set aside for the ring; the depth follows from the slot size. */
+    SCOPE_HISTORY_BYTES = 96U * 1024U,
+    /* Two 12-bit samples in three bytes. */
+    SCOPE_HISTORY_PACKED_BYTES = (SCOPE_FRAME_SAMPLES * 3U + 1U) / 2U,
+    SCOPE_HISTORY_NO_AGE = 0xFFFFU
+};
+
+typedef struct
+{
+    uint32_t sequence;
+    uint16_t sample_count;
+    uint16_t trigger_index;
+    uint16_t frame_min;
+    uint16_t frame_max;
+} ScopeHistoryInfo;
+
+void ScopeHistory_Init(void);
+void ScopeHistory_Reset(void);
+/* Frames recorded at another sample rate are dropped first, so every frame
+   in the ring shares the current timebase. */
+void ScopeHistory_Push(const uint16_t *samples, const ScopeHistoryInfo *info, uint32_t sample_rate_hz);
+uint16_t ScopeHistory_Count(void);
+uint16_t ScopeHistory_Depth(void);
+/* Age 0 is the newest frame. Unpacks into samples (SCOPE_FRAME_SAMPLES);
+   with samples NULL only the info is read. */
+uint8_t ScopeHistory_Get(uint16_t age, uint16_t *samples, ScopeHistoryInfo *info);
+/* Unpacks samples [first, first + count) of one frame. */
+uint8_t ScopeHistory_GetRange(uint16_t age, uint16_t first, uint16_t count, uint16_t *samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_HISTORY_H_ */
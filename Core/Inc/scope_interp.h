@@ -0,0 +1,31 @@
+#ifndef INC_SCOPE_INTERP_H_
+#define INC_SCOPE_INTERP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef enum
+{
+    /* Nearest sample: a zoomed-in trace shows the raw staircase. */
+    SCOPE_INTERP_OFF = 0,
+    SCOPE_INTERP_LINEAR,
+    SCOPE_INTERP_SINC
+} ScopeInterpMode;
+
+void ScopeInterp_Init(void);
+void ScopeInterp_SetMode(ScopeInterpMode mode);
+ScopeInterpMode ScopeInterp_GetMode(void);
+/* Value in ADC counts at samples[index] + frac_q16 / 65536. Taps past either
+   end wrap to the other, as the display window does, so the curve joins
+   the samples drawn on both sides of the seam. May overshoot the input
+   range around edges in sinc mode. */
+int32_t ScopeInterp_Sample(const uint16_t *samples, uint16_t count, uint16_t index, uint32_t frac_q16);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_INTERP_H_ */
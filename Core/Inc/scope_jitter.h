@@ -0,0 +1,53 @@
+#ifndef INC_SCOPE_JITTER_H_
+#define INC_SCOPE_JITTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum
+{
+    SCOPE_JITTER_BINS = 160U,
+    SCOPE_JITTER_TREND_POINTS = 320U,
+    /* Edges per least-squares clock fit. */
+    SCOPE_JITTER_BLOCK_EDGES = 128U
+};
+
+typedef struct
+{
+    uint8_t enabled;
+    uint8_t scaled;
+    uint32_t generation;
+    uint32_t edges;
+    uint32_t tie_count;
+    uint32_t dropped;
+    uint32_t resyncs;
+    uint32_t adc_rate_hz;
+    /* Recovered clock period and all jitter figures in nanoseconds. */
+    float period_ns;
+    float tie_rms_ns;
+    float tie_pp_ns;
+    float period_sd_ns;
+    float bin_ns;
+    uint32_t cycles_per_buffer;
+    uint32_t max_cycles_per_buffer;
+} ScopeJitterStatus;
+
+void ScopeJitter_Init(void);
+void ScopeJitter_SetEnabled(uint8_t enabled);
+uint8_t ScopeJitter_IsEnabled(void);
+void ScopeJitter_Reset(void);
+void ScopeJitter_ProcessFromISR(const uint16_t *samples, uint16_t count);
+void ScopeJitter_Service(void);
+const uint32_t *ScopeJitter_Histogram(void);
+/* Last periods oldest first, in nanoseconds relative to the recovered period. */
+uint16_t ScopeJitter_GetTrend(float *deviation_ns, uint16_t max_points);
+void ScopeJitter_GetStatus(ScopeJitterStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_JITTER_H_ */
@@ -0,0 +1,43 @@
+#ifndef INC_SCOPE_LOCKIN_H_
+#define INC_SCOPE_LOCKIN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum
+{
+    SCOPE_LOCKIN_MIN_SAMPLES_PER_CYCLE = 4U,
+    SCOPE_LOCKIN_DEFAULT_TC_MS = 100U
+};
+
+typedef struct
+{
+    uint8_t enabled;
+    uint8_t locked;
+    uint32_t reference_centihz;
+    uint32_t time_constant_ms;
+    uint32_t buffers;
+    uint32_t relocks;
+    uint32_t cycles_per_buffer;
+    float in_phase_counts;
+    float quadrature_counts;
+    float amplitude_counts;
+    float phase_deg;
+} ScopeLockinStatus;
+
+void ScopeLockin_Init(void);
+uint8_t ScopeLockin_SetEnabled(uint8_t enabled);
+uint8_t ScopeLockin_IsEnabled(void);
+uint8_t ScopeLockin_SetTimeConstantMs(uint32_t time_constant_ms);
+void ScopeLockin_ProcessFromISR(const uint16_t *samples, uint16_t count, uint8_t buffer_index);
+void ScopeLockin_Service(void);
+void ScopeLockin_GetStatus(ScopeLockinStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_LOCKIN_H_ */
@@ -0,0 +1,59 @@
+#ifndef INC_SCOPE_MASK_H_
+#define INC_SCOPE_MASK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope.h"
+#include <stdint.h>
+
+enum { SCOPE_MASK_COLUMNS = SCOPE_FRAME_SAMPLES };
+
+/* What the column map was built from; bands only mean something for the
+   time window they were captured in. */
+typedef struct
+{
+    uint32_t sample_rate_hz;
+    uint16_t samples_visible;
+    int32_t center_sample;
+} ScopeMaskWindow;
+
+typedef struct
+{
+    uint8_t valid;
+    uint8_t enabled;
+    /* Set while the window differs from the captured one; frames are not
+       tested until it is restored or the mask is captured again. */
+    uint8_t window_mismatch;
+    uint8_t stop_on_fail;
+    uint16_t last_fail_columns;
+    uint32_t tested;
+    uint32_t passed;
+    uint32_t failed;
+    uint32_t cycles;
+} ScopeMaskStatus;
+
+void ScopeMask_Init(void);
+uint8_t ScopeMask_Build(const uint16_t *samples,
+                        const uint16_t *column_map,
+                        uint16_t columns,
+                        const ScopeMaskWindow *window,
+                        uint16_t tolerance_counts,
+                        uint16_t tolerance_columns);
+void ScopeMask_SetEnabled(uint8_t enabled);
+uint8_t ScopeMask_IsEnabled(void);
+void ScopeMask_SetStopOnFail(uint8_t stop);
+uint8_t ScopeMask_IsStopOnFail(void);
+void ScopeMask_ResetCounters(void);
+uint8_t ScopeMask_Test(const uint16_t *samples,
+                       const uint16_t *column_map,
+                       uint16_t columns,
+                       const ScopeMaskWindow *window);
+void ScopeMask_GetStatus(ScopeMaskStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_MASK_H_ */
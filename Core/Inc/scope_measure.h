@@ -0,0 +1,85 @@
+#ifndef INC_SCOPE_MEASURE_H_
+#define INC_SCOPE_MEASURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope_signal.h"
+#include <stdint.h>
+
+typedef enum
+{
+    SCOPE_MEASURE_VMAX = 0,
+    SCOPE_MEASURE_VMIN,
+    SCOPE_MEASURE_VPP,
+    SCOPE_MEASURE_MEAN,
+    SCOPE_MEASURE_RMS,
+    SCOPE_MEASURE_FREQ,
+    SCOPE_MEASURE_PERIOD,
+    SCOPE_MEASURE_DUTY_POS,
+    SCOPE_MEASURE_DUTY_NEG,
+    SCOPE_MEASURE_WIDTH_POS,
+    SCOPE_MEASURE_WIDTH_NEG,
+    SCOPE_MEASURE_RISE,
+    SCOPE_MEASURE_FALL,
+    SCOPE_MEASURE_OVERSHOOT,
+    SCOPE_MEASURE_COUNT
+} ScopeMeasureId;
+
+typedef enum
+{
+    SCOPE_MEASURE_UNIT_MILLIVOLT = 0,
+    SCOPE_MEASURE_UNIT_HZ,
+    SCOPE_MEASURE_UNIT_NS,
+    SCOPE_MEASURE_UNIT_PERMILLE
+} ScopeMeasureUnit;
+
+enum
+{
+    SCOPE_MEASURE_DISPLAY_SLOTS = 3U,
+    SCOPE_MEASURE_ALL_MASK = (1UL << SCOPE_MEASURE_COUNT) - 1UL
+};
+
+typedef struct
+{
+    int32_t values[SCOPE_MEASURE_COUNT];
+    uint32_t valid_mask;
+    uint32_t cycles;
+} ScopeMeasureResult;
+
+typedef struct
+{
+    const uint16_t *samples;
+    uint16_t count;
+    uint16_t frame_min;
+    uint16_t frame_max;
+    uint16_t min_amplitude_counts;
+    uint16_t top_counts;
+    uint16_t base_counts;
+    const ScopeSignalCrossings *crossings;
+    uint32_t sample_rate_hz;
+} ScopeMeasureInput;
+
+void ScopeMeasure_Init(void);
+void ScopeMeasure_Compute(const ScopeMeasureInput *input,
+                          uint32_t mask,
+                          ScopeMeasureResult *result);
+uint32_t ScopeMeasure_ActiveMask(void);
+uint32_t ScopeMeasure_DisplayMask(void);
+uint8_t ScopeMeasure_SetDisplaySlot(uint8_t slot, ScopeMeasureId id);
+ScopeMeasureId ScopeMeasure_GetDisplaySlot(uint8_t slot);
+void ScopeMeasure_RequestReport(void);
+uint8_t ScopeMeasure_IsReportPending(void);
+void ScopeMeasure_PublishReport(const ScopeMeasureResult *result);
+uint8_t ScopeMeasure_TakeReport(ScopeMeasureResult *result);
+uint32_t ScopeMeasure_GetLastCycles(void);
+const char *ScopeMeasure_Label(ScopeMeasureId id);
+ScopeMeasureUnit ScopeMeasure_Unit(ScopeMeasureId id);
+uint8_t ScopeMeasure_FindByName(const char *name, ScopeMeasureId *out_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_MEASURE_H_ */
@@ -0,0 +1,22 @@
+#ifndef INC_SCOPE_PROFILE_H_
+#define INC_SCOPE_PROFILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+#include <stdint.h>
+
+void ScopeProfile_Init(void);
+
+static inline uint32_t ScopeProfile_CycleCount(void)
+{
+    return DWT->CYCCNT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_PROFILE_H_ */
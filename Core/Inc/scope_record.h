@@ -0,0 +1,59 @@
+#ifndef INC_SCOPE_RECORD_H_
+#define INC_SCOPE_RECORD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Deep record for hold: the held frame joined with the history frames
+   captured back to back before it, read straight from the packed history
+   ring. A min/max pyramid built once per hold lets any window of it be
+   drawn with a bounded amount of work per column.
+
+   History is pushed from the DMA interrupt, so the record runs back
+   unbroken until the ring ends or the sample rate changed; the hold panel
+   shows how many frames were joined. */
+
+enum
+{
+    /* Nearly the whole history ring; 61440 samples. */
+    SCOPE_RECORD_MAX_FRAMES = 192U
+};
+
+typedef struct
+{
+    uint16_t frames;
+    uint16_t length;
+    uint16_t newest_age;
+    uint8_t levels;
+    uint32_t build_cycles;
+} ScopeRecordStatus;
+
+/* Starts from the history frame at age and walks back while the sequence
+   numbers are consecutive; returns the number of frames joined. */
+uint16_t ScopeRecord_Build(uint16_t age);
+void ScopeRecord_Clear(void);
+uint16_t ScopeRecord_Length(void);
+uint8_t ScopeRecord_Contains(uint16_t age);
+/* Record index of the first sample of the frame at age. */
+uint16_t ScopeRecord_FrameStart(uint16_t age);
+uint16_t ScopeRecord_Sample(uint16_t index);
+/* Copies count samples from first, wrapping at the end of the record. */
+void ScopeRecord_Read(uint16_t first, uint16_t count, uint16_t *samples);
+/* Lowest and highest sample under each screen column; column i covers the
+   record from column_sample_map[i] up to the next column's start, and the
+   last column ends visible_samples after the first one starts. */
+void ScopeRecord_Envelope(const uint16_t *column_sample_map,
+                          uint16_t columns,
+                          uint16_t visible_samples,
+                          uint16_t *column_min,
+                          uint16_t *column_max);
+void ScopeRecord_GetStatus(ScopeRecordStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_RECORD_H_ */
@@ -0,0 +1,57 @@
+#ifndef INC_SCOPE_REFERENCE_H_
+#define INC_SCOPE_REFERENCE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope_display.h"
+#include <stdint.h>
+
+/* Reference traces kept in flash sectors 12 and 13. Records are appended,
+   delta coded, and only count once their commit word is programmed, so a
+   save cut short by power loss leaves the previous copy in place. */
+
+enum { SCOPE_REFERENCE_SLOTS = 4U };
+
+typedef struct
+{
+    uint16_t sample_count;
+    uint16_t trigger_index;
+    uint32_t sample_rate_hz;
+    ScopeDisplaySettings settings;
+    uint16_t payload_bytes;
+} ScopeReferenceInfo;
+
+/* Decodes a stored trace straight out of flash, one sample at a time. */
+typedef struct
+{
+    const uint8_t *next;
+    const uint8_t *end;
+    uint16_t remaining;
+    int32_t previous;
+} ScopeReferenceReader;
+
+typedef struct
+{
+    uint8_t stored_mask;
+    uint8_t sector;
+    uint32_t generation;
+    uint32_t used_bytes;
+    uint32_t free_bytes;
+    uint32_t compactions;
+    uint32_t torn_records;
+} ScopeReferenceStatus;
+
+void ScopeReference_Init(void);
+uint8_t ScopeReference_Save(uint8_t slot, const uint16_t *samples, const ScopeReferenceInfo *info);
+uint8_t ScopeReference_Erase(uint8_t slot);
+uint8_t ScopeReference_Open(uint8_t slot, ScopeReferenceInfo *info, ScopeReferenceReader *reader);
+uint8_t ScopeReference_Next(ScopeReferenceReader *reader, uint16_t *sample);
+void ScopeReference_GetStatus(ScopeReferenceStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_REFERENCE_H_ */
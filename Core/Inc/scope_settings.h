@@ -0,0 +1,44 @@
+#ifndef INC_SCOPE_SETTINGS_H_
+#define INC_SCOPE_SETTINGS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Settings journal in flash sectors 14 and 15: sample rate and decimation,
+   display window, scale target, generator frequencies and board
+   calibration. Changes are polled from the main loop and written once they
+   have settled, so a burst of button presses costs one record. */
+
+typedef struct
+{
+    uint8_t restored;
+    uint8_t pending;
+    /* Zero once a compaction has used the spare sector; it is erased at the
+       next boot, and until then a full sector leaves changes pending. */
+    uint8_t spare_blank;
+    uint8_t sector;
+    uint32_t generation;
+    uint32_t records;
+    uint32_t free_records;
+    uint32_t writes;
+    uint32_t coalesced;
+    uint32_t compactions;
+    uint32_t torn_records;
+} ScopeSettingsStatus;
+
+/* Restores the newest record; call once every module has its defaults. */
+void ScopeSettings_Init(uint32_t now_ms);
+void ScopeSettings_Service(uint32_t now_ms);
+/* Writes the current settings now if they differ from the stored ones. */
+uint8_t ScopeSettings_Flush(void);
+uint8_t ScopeSettings_IsSaved(void);
+void ScopeSettings_GetStatus(ScopeSettingsStatus *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_SETTINGS_H_ */
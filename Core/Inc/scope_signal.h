@@ -7,12 +7,31 @@ extern "C" {
 
 #include <stdint.h>
 
+enum { SCOPE_SIGNAL_MAX_CROSSINGS = 128U };
+
+typedef struct
+{
+    uint32_t position_q8;
+    uint8_t rising;
+} ScopeSignalCrossing;
+
+typedef struct
+{
+    ScopeSignalCrossing edges[SCOPE_SIGNAL_MAX_CROSSINGS];
+    uint16_t count;
+    uint16_t threshold;
+    uint8_t initial_high;
+    uint8_t truncated;
+} ScopeSignalCrossings;
+
 uint16_t ScopeSignal_FindTriggerIndex(uint16_t *buf,
                                       uint16_t len,
                                       uint16_t trigger_min_delta,
                                       uint16_t *out_min,
                                       uint16_t *out_max);
 
+uint16_t ScopeSignal_FindRisingCrossing(const uint16_t *buf, uint16_t len, uint16_t threshold);
+
 uint32_t ScopeSignal_EstimatePeriodSamples(uint16_t *buf,
                                            uint16_t len,
                                            uint16_t trig_idx,
@@ -20,10 +39,36 @@ uint32_t ScopeSignal_EstimatePeriodSamples(uint16_t *buf,
                                            uint16_t frame_max,
                                            uint16_t trigger_min_delta);
 
+uint32_t ScopeSignal_EstimatePeriodAcfQ8(const uint16_t *buf, uint16_t len);
+uint32_t ScopeSignal_EstimatePeriodRobustQ8(uint16_t *buf,
+                                            uint16_t len,
+                                            uint16_t trig_idx,
+                                            uint16_t frame_min,
+                                            uint16_t frame_max,
+                                            uint16_t trigger_min_delta);
+
+uint16_t ScopeSignal_FindCrossings(const uint16_t *buf,
+                                   uint16_t len,
+                                   uint16_t threshold,
+                                   uint16_t hysteresis,
+                                   ScopeSignalCrossings *out);
+uint32_t ScopeSignal_InterpolateCrossingQ8(uint16_t index,
+                                           uint16_t v_prev,
+                                           uint16_t v_now,
+                                           uint16_t threshold);
+
 uint32_t ScopeSignal_GetSampleRateHz(void);
-uint32_t ScopeSignal_AdcToMillivolt(uint16_t sample,
-                                    uint16_t adc_max_counts,
-                                    uint16_t adc_ref_millivolt);
+uint8_t ScopeSignal_SetSampleRateHz(uint32_t rate_hz);
+uint8_t ScopeSignal_SetTimerPeriod(uint32_t prescaler, uint32_t period);
+void ScopeSignal_GetTimerPeriod(uint32_t *prescaler, uint32_t *period);
+/* Restarts the ADC (TIM3) and DAC (TIM4) timers on the same clock edge and
+   reports the DMA counters they resume from, fixing the phase between the
+   sampled record and the sine output. */
+void ScopeSignal_RestartWithDac(uint32_t *dac_remaining, uint32_t *adc_remaining);
+uint32_t ScopeSignal_GetAdcRateHz(void);
+void ScopeSignal_SetDecimation(uint16_t ratio);
+uint32_t ScopeSignal_TimeToTimerTicks(uint32_t time_ns, uint32_t *period_ticks);
+uint32_t ScopeSignal_GetTimerCount(void);
 
 #ifdef __cplusplus
 }
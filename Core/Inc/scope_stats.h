@@ -0,0 +1,32 @@
+#ifndef INC_SCOPE_STATS_H_
+#define INC_SCOPE_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scope_measure.h"
+#include <stdint.h>
+
+typedef struct
+{
+    int32_t current;
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    int32_t stddev;
+    uint32_t count;
+} ScopeStatsSummary;
+
+void ScopeStats_Init(void);
+void ScopeStats_Reset(void);
+void ScopeStats_Accumulate(const ScopeMeasureResult *result);
+uint8_t ScopeStats_Get(ScopeMeasureId id, ScopeStatsSummary *summary);
+void ScopeStats_SetPanelVisible(uint8_t visible);
+uint8_t ScopeStats_IsPanelVisible(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_STATS_H_ */
@@ -0,0 +1,65 @@
+#ifndef INC_SCOPE_TRIGGER_H_
+#define INC_SCOPE_TRIGGER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef enum
+{
+    SCOPE_TRIGGER_EDGE = 0,
+    SCOPE_TRIGGER_PULSE_LESS,
+    SCOPE_TRIGGER_PULSE_GREATER,
+    SCOPE_TRIGGER_RUNT,
+    SCOPE_TRIGGER_TIMEOUT
+} ScopeTriggerType;
+
+typedef enum
+{
+    SCOPE_TRIGGER_POLARITY_POSITIVE = 0,
+    SCOPE_TRIGGER_POLARITY_NEGATIVE
+} ScopeTriggerPolarity;
+
+typedef struct
+{
+    ScopeTriggerType type;
+    ScopeTriggerPolarity polarity;
+    uint32_t width_ns;
+    uint16_t level_low;
+    uint16_t level_high;
+    uint8_t auto_levels;
+} ScopeTriggerConfig;
+
+typedef struct
+{
+    uint32_t events;
+    uint32_t resyncs;
+    uint16_t level_low;
+    uint16_t level_high;
+} ScopeTriggerStatus;
+
+enum { SCOPE_TRIGGER_NO_EVENT = 0xFFFFU };
+
+void ScopeTrigger_Init(void);
+uint8_t ScopeTrigger_Configure(const ScopeTriggerConfig *cfg);
+void ScopeTrigger_GetConfig(ScopeTriggerConfig *cfg);
+ScopeTriggerType ScopeTrigger_GetType(void);
+void ScopeTrigger_GetStatus(ScopeTriggerStatus *status);
+/* Main loop: converts the width to samples at the current record rate and
+   resynchronises when the rate changed. The state machine stays idle until
+   the first call. */
+void ScopeTrigger_Service(uint32_t sample_rate_hz);
+/* Runs on every frame from the DMA interrupt, after the acquisition filter,
+   so frames the main loop never gets to are still examined and events are
+   judged on the trace that is displayed. Returns the index of the first event in the
+   frame, or SCOPE_TRIGGER_NO_EVENT. Auto levels follow the envelope of the
+   frames before this one. */
+uint16_t ScopeTrigger_ProcessFromISR(const uint16_t *samples, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SCOPE_TRIGGER_H_ */
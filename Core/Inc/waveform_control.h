@@ -30,6 +30,8 @@ extern "C" {
 void WaveformControl_Init(void);
 uint8_t WaveformControl_SetSquareFrequency(uint32_t target_hz);
 uint8_t WaveformControl_SetSineFrequency(uint32_t target_hz);
+uint32_t WaveformControl_GetSineFrequency(void);
+uint32_t WaveformControl_GetSquareFrequency(void);
 uint8_t WaveformControl_SetFrequency(uint32_t target_hz);
 
 #ifdef __cplusplus
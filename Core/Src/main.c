@@ -32,6 +32,15 @@
 #include <string.h>
 #include "scope.h"
 #include "scope_buffer.h"
+#include "scope_calib.h"
+#include "scope_decim.h"
+#include "scope_fra.h"
+#include "scope_jitter.h"
+#include "scope_lockin.h"
+#include "scope_filter.h"
+#include "scope_profile.h"
+#include "scope_settings.h"
+#include "scope_signal.h"
 #include "input_handler.h"
 #include "waveform_control.h"
 #include "uart_command.h"
@@ -54,7 +63,7 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
-static uint16_t scope_frame_copy[SCOPE_FRAME_SAMPLES];
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -121,10 +130,18 @@ int main(void)
   MX_DAC_Init();
   MX_TIM4_Init();
   /* USER CODE BEGIN 2 */
+  ScopeProfile_Init();
+  ScopeCalib_Init();
   ScopeBuffer_Init();
+  ScopeDecim_Init();
+  ScopeLockin_Init();
+  ScopeFra_Init();
+  ScopeJitter_Init();
+  ScopeFilter_Init();
   InputHandler_Init();
   Scope_Init();
   WaveformControl_Init();
+  ScopeSettings_Init(HAL_GetTick());
   UartCommand_Init();
   const uint16_t frame_samples = Scope_FrameSampleCount();
   const uint32_t dma_samples = (uint32_t)frame_samples * 2U;
@@ -140,20 +157,32 @@ int main(void)
       {
           uint16_t samples_count = 0U;
           uint16_t *ready_buf = ScopeBuffer_Dequeue(&samples_count);
-          if (ready_buf != NULL)
+          /* The frame is copied out of the DMA buffer once, into the
+             buffer that becomes the live frame. */
+          uint16_t *frame = (ready_buf != NULL) ? Scope_AcquireFrameBuffer() : NULL;
+          if (frame != NULL)
           {
               uint16_t samples_to_process = samples_count;
               if (samples_to_process > SCOPE_FRAME_SAMPLES)
               {
                   samples_to_process = SCOPE_FRAME_SAMPLES;
               }
-              memcpy(scope_frame_copy,
+              memcpy(frame,
                      ready_buf,
                      (size_t)samples_to_process * sizeof(uint16_t));
-              Scope_ProcessFrame(scope_frame_copy, samples_to_process);
+              Scope_ProcessFrame(frame, samples_to_process);
+          }
+          else if (ready_buf != NULL)
+          {
+              /* Every buffer is held: keep the held screen serviced. */
+              Scope_ProcessFrame(NULL, 0U);
           }
       }
       UartCommand_Process();
+      ScopeCalib_Service(HAL_GetTick(), Scope_IsWaveformHoldEnabled());
+      ScopeSettings_Service(HAL_GetTick());
+      ScopeLockin_Service();
+      ScopeFilter_Service(ScopeSignal_GetSampleRateHz());
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -1,8 +1,28 @@
 #include "scope.h"
 
 #include "main.h"
+#include "scope_autoset.h"
+#include "scope_buffer.h"
+#include "scope_calib.h"
+#include "scope_decim.h"
+#include "scope_decode.h"
 #include "scope_display.h"
+#include "scope_events.h"
+#include "scope_eye.h"
+#include "scope_fra.h"
+#include "scope_governor.h"
+#include "scope_histogram.h"
+#include "scope_history.h"
+#include "scope_interp.h"
+#include "scope_jitter.h"
+#include "scope_mask.h"
+#include "scope_measure.h"
+#include "scope_profile.h"
+#include "scope_record.h"
+#include "scope_reference.h"
 #include "scope_signal.h"
+#include "scope_stats.h"
+#include "scope_trigger.h"
 
 #include <string.h>
 
@@ -12,16 +32,20 @@ enum
     OFFSET_STEP_DIVISOR = 10U,
     AUTOSET_MARGIN_PERCENT_NUMERATOR = 1U,
     AUTOSET_MARGIN_PERCENT_DENOMINATOR = 5U,
-    CURSOR_AUTOSHIFT_INTERVAL_MS = 50U
+    CURSOR_AUTOSHIFT_INTERVAL_MS = 50U,
+    SCOPE_FRAME_POOL_SIZE = 2U
 };
 
+/* Frame buffers get their own output section so the map summary shows
+   what acquisition and hold cost in RAM. */
+#define SCOPE_FRAME_POOL_SECTION __attribute__((section(".frame_pool")))
+
 typedef struct
 {
     uint16_t samples_per_frame;
     uint16_t info_panel_height;
     uint16_t grid_spacing_px;
     uint16_t trigger_min_delta;
-    uint16_t adc_ref_millivolt;
     uint16_t adc_max_counts;
     uint16_t waveform_color;
 } ScopeConfig;
@@ -31,34 +55,26 @@ static const ScopeConfig scope_cfg = {
     .info_panel_height = 64U,
     .grid_spacing_px = 40U,
     .trigger_min_delta = 20U,
-    .adc_ref_millivolt = 3300U,
     .adc_max_counts = 4095U,
     .waveform_color = ILI9341_YELLOW
 };
 
-typedef struct
+enum
 {
-    volatile uint8_t autoset_request;
-    volatile uint8_t zoom_out_requests;
-    volatile uint8_t zoom_in_requests;
-    volatile uint8_t v_zoom_out_requests;
-    volatile uint8_t v_zoom_in_requests;
-    volatile int8_t horizontal_offset_shift_requests;
-    volatile int8_t vertical_offset_shift_requests;
-    volatile uint8_t hold_toggle_request;
-} ScopeControlFlags;
-
-enum { SCOPE_CURSOR_COUNT = 2U };
+    SCOPE_CURSOR_COUNT = 2U,
+    /* Selection slot after the cursors: K5/K6 then step through history. */
+    SCOPE_HOLD_TARGET_HISTORY = SCOPE_CURSOR_COUNT,
+    SCOPE_HOLD_TARGET_COUNT
+};
 
 typedef struct
 {
     uint16_t samples[SCOPE_FRAME_SAMPLES];
-    uint16_t column_map[SCOPE_FRAME_SAMPLES];
     uint16_t sample_count;
     uint16_t trigger_index;
     uint16_t frame_min;
     uint16_t frame_max;
-    uint32_t freq_hz;
+    ScopeMeasureResult measurements;
     uint8_t valid;
 } ScopeFrameSnapshot;
 
@@ -67,55 +83,132 @@ typedef struct
     uint16_t columns[SCOPE_CURSOR_COUNT];
     uint8_t selected;
     uint8_t active;
-    volatile int8_t shift_requests;
-    volatile uint8_t select_toggle_request;
 } ScopeCursorState;
 
 typedef struct
 {
-    volatile int8_t direction;
-    volatile uint32_t last_tick_ms;
+    int8_t direction;
+    uint32_t last_tick_ms;
 } ScopeCursorAutoShiftState;
 
 static ScopeDisplaySettings scope_display_settings;
-static ScopeControlFlags scope_control = {0};
+/* Every control input from interrupts and the UART is an event here, applied
+   in arrival order once per frame. */
+static ScopeEventRing scope_events;
+/* Zoom and offset events wait, still in order, until the live path or the
+   held frame takes them. A run of one kind is kept as one entry whose arg
+   counts the steps, so an autoset sweep cannot fill it with presses. */
+static ScopeEvent scope_scale_backlog[SCOPE_EVENT_RING_SIZE];
+static uint8_t scope_scale_backlog_count = 0U;
+/* Steps lost to a full backlog or to an entry already at its limit. */
+static uint32_t scope_scale_dropped = 0U;
+static uint8_t scope_autoset_pending = 0U;
+static uint32_t scope_event_count = 0U;
+static uint32_t scope_event_max_latency_ms = 0U;
 static ScopeScaleTarget scope_scale_target = SCOPE_SCALE_TARGET_VOLTAGE;
 static volatile uint8_t scope_waveform_hold = 0U;
-static ScopeFrameSnapshot scope_live_frame = {0};
-static ScopeFrameSnapshot scope_hold_frame = {0};
+/* The live and held frames point into this pool. The main loop fills the
+   buffer neither of them uses, committing it as the live frame is a pointer
+   swap, and hold pins the live buffer. Only a history frame needs a buffer
+   of its own while held; it takes the spare and new frames are dropped. */
+static ScopeFrameSnapshot scope_frame_pool[SCOPE_FRAME_POOL_SIZE] SCOPE_FRAME_POOL_SECTION;
+/* Column map of whichever frame is on screen. */
+static uint16_t scope_column_map[SCOPE_FRAME_SAMPLES] SCOPE_FRAME_POOL_SECTION;
+static ScopeFrameSnapshot *scope_live_frame = &scope_frame_pool[0];
+static ScopeFrameSnapshot *scope_hold_frame = NULL;
 static ScopeCursorState scope_cursor_state = {0};
 static ScopeCursorAutoShiftState scope_cursor_autoshift = {0};
 static uint8_t scope_hold_render_pending = 0U;
+/* Frames back from the newest history entry shown while held. */
+static uint16_t scope_history_age = 0U;
+/* History is filled by the DMA interrupt and frozen while held, so it
+   stands still under the record and the stepping. The live frame's age in
+   it is looked up by sequence when hold starts. */
+static volatile uint8_t scope_history_frozen = 0U;
+static uint32_t scope_live_sequence = 0U;
+static uint16_t scope_live_age = SCOPE_HISTORY_NO_AGE;
+/* Shown reference slot, -1 for none, and the window its overlay was built
+   for: any zoom or pan rebuilds it from flash. */
+static int8_t scope_reference_slot = -1;
+static uint8_t scope_reference_stale = 0U;
+/* Rate the shown reference was taken at; the overlay is only drawn while
+   acquisition runs at the same rate. */
+static uint32_t scope_reference_rate_hz = 0U;
+static ScopeDisplaySettings scope_reference_window;
+static ScopeSignalCrossings scope_crossings;
+static ScopeDecodeFrame scope_decode_frame;
+/* Decode of the frame scope_live_frame points to, for its annotations. */
+static ScopeDecodeFrame scope_live_decode;
+static uint8_t scope_render_pending = 0U;
+static uint32_t scope_last_sequence = 0U;
+static uint8_t scope_sequence_valid = 0U;
+static uint16_t scope_trigger_level = 0U;
+static ScopeView scope_view = SCOPE_VIEW_WAVEFORM;
+static ScopeHistogramSummary scope_histogram_summary;
+static uint8_t scope_histogram_valid = 0U;
+static float scope_jitter_trend[SCOPE_JITTER_TREND_POINTS];
 static void Scope_DisplaySettingsInit(void);
 static void Scope_ResetVerticalWindow(void);
 static void Scope_UpdateVerticalWindow(uint32_t span, int32_t center);
 static void Scope_UpdateHorizontalWindow(uint32_t span_samples);
+static void Scope_RestoreWindow(const ScopeDisplaySettings *settings);
+static uint32_t Scope_HorizontalRecordLength(void);
+static uint8_t Scope_IsHoldRecordShown(void);
 static uint32_t Scope_MaxVerticalSpan(void);
 static uint16_t Scope_GetVisibleSampleCount(uint16_t available_samples);
-static void Scope_ApplyAutoSet(uint16_t *buf, uint16_t len);
+static void Scope_ApplyAutoSet(const ScopeAutosetResult *result);
 static uint8_t Scope_ConsumeAutoSetRequest(void);
-static void Scope_ApplyHorizontalScaleRequests(void);
-static void Scope_ApplyVerticalScaleRequests(void);
-static void Scope_ApplyOffsetRequests(void);
+static void Scope_PostEvent(ScopeEventType type, int8_t arg);
+static void Scope_DrainEvents(void);
+static void Scope_QueueScaleEvent(const ScopeEvent *event);
+static void Scope_ApplyScaleEvents(void);
 static void Scope_ZoomHorizontal(uint8_t zoom_in);
 static void Scope_ZoomVertical(uint8_t zoom_in);
-static void Scope_QueueZoomRequest(volatile uint8_t *request_counter);
-static void Scope_RequestOffsetStep(int8_t direction);
-static void Scope_QueueOffsetRequest(volatile int8_t *request_counter, int8_t direction);
 static void Scope_ShiftHorizontalOffset(int8_t steps);
 static void Scope_ShiftVerticalOffset(int8_t steps);
-static void Scope_HandleHoldToggleRequest(void);
+static void Scope_ApplyView(ScopeView view);
+static void Scope_ApplyCursorEvent(const ScopeEvent *event);
+static void Scope_ApplyCursorAutoShift(int8_t direction);
 static void Scope_SetHoldState(uint8_t enable);
-static uint8_t Scope_CopyLiveFrameToHold(void);
+static uint8_t Scope_PinLiveFrame(void);
 static void Scope_DisableHoldState(void);
 static void Scope_InitCursorPositions(void);
 static void Scope_ResetCursorAutoShift(void);
 static void Scope_UpdateCursorAutoShift(void);
-static void Scope_ApplyCursorRequests(void);
 static void Scope_MoveCursor(uint8_t cursor_index, int8_t steps);
+static void Scope_StepHoldTarget(int8_t steps);
+static void Scope_StepHistory(int8_t steps);
+static void Scope_ServiceHold(void);
 static void Scope_RenderHoldFrame(void);
+static void Scope_RenderHoldRecord(const ScopeDisplayCursorRenderInfo *cursor_info);
+static void Scope_UpdateReferenceOverlay(void);
 static void Scope_DrawCursorMeasurements(void);
 static uint16_t Scope_GetCursorColumnLimit(void);
+static void Scope_FindFrameCrossings(const uint16_t *samples,
+                                     uint16_t count,
+                                     uint16_t frame_min,
+                                     uint16_t frame_max);
+static void Scope_MeasureFrame(const uint16_t *samples,
+                               uint16_t count,
+                               uint16_t frame_min,
+                               uint16_t frame_max,
+                               uint32_t mask,
+                               ScopeMeasureResult *result);
+static ScopeFrameSnapshot *Scope_GetSpareFrame(void);
+static ScopeFrameSnapshot *Scope_ClaimFrame(const uint16_t *samples, uint16_t count);
+static const ScopeFrameSnapshot *Scope_GetShownFrame(void);
+static void Scope_MapFrameColumns(const ScopeFrameSnapshot *frame);
+static void Scope_GetFrameWindow(const ScopeFrameSnapshot *frame, ScopeDisplaySettings *settings);
+static uint16_t Scope_FindEdgeTrigger(uint16_t *samples, uint16_t count, uint16_t *frame_min, uint16_t *frame_max);
+static uint16_t Scope_FindLiveAge(void);
+static void Scope_AnalyzeFrame(uint16_t *samples, uint16_t count, uint8_t contiguous);
+static void Scope_RenderFrame(void);
+static void Scope_DrawDecodeAnnotations(void);
+static void Scope_DrawInfoPanel(const ScopeMeasureResult *result);
+static void Scope_ServiceHoldReport(void);
+static uint8_t Scope_ConsumeFrameContinuity(void);
+static uint16_t Scope_DisplayColumnCount(void);
+static void Scope_GetMaskWindow(uint16_t count, ScopeMaskWindow *window);
 
 uint16_t Scope_FrameSampleCount(void)
 {
@@ -125,35 +218,109 @@ uint16_t Scope_FrameSampleCount(void)
 void Scope_Init(void)
 {
     ILI9341_Init();
+    /* The pool's section is not cleared by the startup code. */
+    memset(scope_frame_pool, 0, sizeof(scope_frame_pool));
+    memset(scope_column_map, 0, sizeof(scope_column_map));
     ScopeDisplayConfig display_cfg = {
         .frame_samples = scope_cfg.samples_per_frame,
         .info_panel_height = scope_cfg.info_panel_height,
         .grid_spacing_px = scope_cfg.grid_spacing_px,
         .waveform_color = scope_cfg.waveform_color,
-        .adc_max_counts = scope_cfg.adc_max_counts,
-        .adc_ref_millivolt = scope_cfg.adc_ref_millivolt
+        .adc_max_counts = scope_cfg.adc_max_counts
     };
     ScopeDisplay_Init(&display_cfg);
+    ScopeInterp_Init();
+    ScopeMeasure_Init();
+    ScopeTrigger_Init();
+    ScopeDecode_Init();
+    ScopeStats_Init();
+    ScopeMask_Init();
+    ScopeHistogram_Init();
+    ScopeEye_Init();
+    ScopeHistory_Init();
+    ScopeReference_Init();
+    ScopeAutoset_Init(scope_cfg.trigger_min_delta);
+    ScopeGovernor_Init();
+    ScopeEvents_Init(&scope_events);
     Scope_DisplaySettingsInit();
     ScopeDisplay_DrawGrid();
-    ScopeDisplay_DrawMeasurements(0U, 0U, 0U);
+    ScopeMeasureResult empty = {0};
+    ScopeDisplay_DrawMeasurements(&empty);
+}
+
+uint16_t *Scope_AcquireFrameBuffer(void)
+{
+    ScopeFrameSnapshot *frame = Scope_GetSpareFrame();
+    return (frame != NULL) ? frame->samples : NULL;
+}
+
+static ScopeFrameSnapshot *Scope_GetSpareFrame(void)
+{
+    for (uint8_t i = 0U; i < SCOPE_FRAME_POOL_SIZE; ++i)
+    {
+        ScopeFrameSnapshot *frame = &scope_frame_pool[i];
+        if (frame != scope_live_frame && frame != scope_hold_frame)
+        {
+            return frame;
+        }
+    }
+    return NULL;
+}
+
+/* A frame filled in the spare buffer is taken as it is; samples from
+   anywhere else are copied into it. */
+static ScopeFrameSnapshot *Scope_ClaimFrame(const uint16_t *samples, uint16_t count)
+{
+    ScopeFrameSnapshot *frame = Scope_GetSpareFrame();
+    if (frame != NULL && frame->samples != samples && count != 0U)
+    {
+        memcpy(frame->samples, samples, (size_t)count * sizeof(uint16_t));
+    }
+    return frame;
+}
+
+static const ScopeFrameSnapshot *Scope_GetShownFrame(void)
+{
+    return scope_waveform_hold ? scope_hold_frame : scope_live_frame;
+}
+
+static void Scope_MapFrameColumns(const ScopeFrameSnapshot *frame)
+{
+    (void)ScopeDisplay_MapColumns(&scope_display_settings,
+                                  frame->sample_count,
+                                  Scope_GetVisibleSampleCount(frame->sample_count),
+                                  frame->trigger_index,
+                                  scope_column_map);
+}
+
+/* The shown window in the frame's own positions. A held deep record keeps
+   the window in record positions; offsets from the trigger mean the same
+   in both, so only the width and the pan range need clamping. */
+static void Scope_GetFrameWindow(const ScopeFrameSnapshot *frame, ScopeDisplaySettings *settings)
+{
+    *settings = scope_display_settings;
+    settings->horizontal.samples_visible = Scope_GetVisibleSampleCount(frame->sample_count);
+    int32_t limit = (int32_t)scope_cfg.samples_per_frame * 2;
+    if (settings->horizontal.center_sample > limit)
+    {
+        settings->horizontal.center_sample = limit;
+    }
+    else if (settings->horizontal.center_sample < -limit)
+    {
+        settings->horizontal.center_sample = -limit;
+    }
 }
 
 void Scope_ProcessFrame(uint16_t *samples, uint16_t count)
 {
-    Scope_HandleHoldToggleRequest();
+    Scope_DrainEvents();
     Scope_UpdateCursorAutoShift();
 
     if (samples == NULL || count == 0U)
     {
         if (scope_waveform_hold)
         {
-            Scope_ApplyCursorRequests();
-            if (scope_hold_render_pending)
-            {
-                Scope_RenderHoldFrame();
-                scope_hold_render_pending = 0U;
-            }
+            Scope_ServiceHold();
         }
         return;
     }
@@ -163,104 +330,429 @@ void Scope_ProcessFrame(uint16_t *samples, uint16_t count)
         count = scope_cfg.samples_per_frame;
     }
 
+    uint8_t contiguous = Scope_ConsumeFrameContinuity();
+
     if (scope_waveform_hold)
     {
-        Scope_ApplyCursorRequests();
-        if (scope_hold_render_pending)
+        Scope_ServiceHold();
+        return;
+    }
+
+    /* Every frame is analysed; the screen is only redrawn at the governed
+       rate, from the newest frame that produced something to show. */
+    uint32_t analysis_start = ScopeProfile_CycleCount();
+    Scope_AnalyzeFrame(samples, count, contiguous);
+    ScopeGovernor_FrameAnalyzed(ScopeProfile_CycleCount() - analysis_start);
+    Scope_RenderFrame();
+}
+
+/* Every frame the DMA delivers, before the queue, so a frame the main loop
+   never gets to still joins the deep record. The trigger is placed as the
+   analysis would place it; the software trigger's event wins when it has
+   one. */
+void Scope_RecordFrameFromISR(uint16_t *samples, uint16_t count, uint32_t sequence, uint16_t event_index)
+{
+    if (scope_history_frozen || samples == NULL || count == 0U)
+    {
+        return;
+    }
+    if (count > scope_cfg.samples_per_frame)
+    {
+        count = scope_cfg.samples_per_frame;
+    }
+    ScopeHistoryInfo info = {
+        .sequence = sequence,
+        .sample_count = count
+    };
+    info.trigger_index = Scope_FindEdgeTrigger(samples, count, &info.frame_min, &info.frame_max);
+    if (ScopeTrigger_GetType() != SCOPE_TRIGGER_EDGE && event_index < count)
+    {
+        info.trigger_index = event_index;
+    }
+    ScopeHistory_Push(samples, &info, ScopeSignal_GetSampleRateHz());
+}
+
+static uint16_t Scope_FindEdgeTrigger(uint16_t *samples, uint16_t count, uint16_t *frame_min, uint16_t *frame_max)
+{
+    uint16_t trig = ScopeSignal_FindTriggerIndex(samples,
+                                                 count,
+                                                 scope_cfg.trigger_min_delta,
+                                                 frame_min,
+                                                 frame_max);
+    uint16_t level = scope_trigger_level;
+    if (level != 0U &&
+        (uint32_t)*frame_max - *frame_min >= scope_cfg.trigger_min_delta &&
+        level > *frame_min && level <= *frame_max)
+    {
+        trig = ScopeSignal_FindRisingCrossing(samples, count, level);
+    }
+    return trig;
+}
+
+static void Scope_AnalyzeFrame(uint16_t *samples, uint16_t count, uint8_t contiguous)
+{
+    if (scope_view == SCOPE_VIEW_BODE)
+    {
+        /* The analyzer owns both timers while it sweeps; autoset waits until
+           the view is left. */
+        if (ScopeFra_IsRunning())
         {
-            Scope_RenderHoldFrame();
-            scope_hold_render_pending = 0U;
+            (void)ScopeFra_Step(samples, count, ScopeBuffer_GetLastSequence(), HAL_GetTick());
         }
+        scope_render_pending = 1U;
         return;
     }
 
     if (Scope_ConsumeAutoSetRequest())
     {
-        Scope_ApplyAutoSet(samples, count);
+        /* The sweep retunes the ADC itself and judges each rate on raw frames. */
+        (void)ScopeDecim_Configure(1U);
+        ScopeAutoset_Start(HAL_GetTick());
+        scope_render_pending = 0U;
+    }
+    if (ScopeAutoset_IsRunning())
+    {
+        /* Sweep frames are analysed only; the display keeps the last trace until
+           the new timebase is in place. */
+        ScopeAutosetResult autoset_result;
+        if (ScopeAutoset_Step(samples,
+                              count,
+                              ScopeBuffer_GetLastSequence(),
+                              HAL_GetTick(),
+                              &autoset_result) == SCOPE_AUTOSET_DONE)
+        {
+            Scope_ApplyAutoSet(&autoset_result);
+        }
+        return;
     }
 
-    Scope_ApplyHorizontalScaleRequests();
-    Scope_ApplyVerticalScaleRequests();
-    Scope_ApplyOffsetRequests();
+    Scope_ApplyScaleEvents();
+    ScopeTrigger_Service(ScopeSignal_GetSampleRateHz());
+
+    if (scope_view == SCOPE_VIEW_JITTER)
+    {
+        /* Edges were taken from every half-buffer in the interrupt; this frame
+           only paces the analysis and the redraw. */
+        ScopeJitter_Service();
+        scope_render_pending = 1U;
+        return;
+    }
 
     uint16_t frame_min = 0U;
     uint16_t frame_max = 0U;
-    uint16_t trig = ScopeSignal_FindTriggerIndex(samples,
-                                                 count,
-                                                 scope_cfg.trigger_min_delta,
-                                                 &frame_min,
-                                                 &frame_max);
-    uint32_t period_samples = ScopeSignal_EstimatePeriodSamples(samples,
-                                                                count,
-                                                                trig,
-                                                                frame_min,
-                                                                frame_max,
-                                                                scope_cfg.trigger_min_delta);
-    uint32_t freq_hz = 0U;
-    if (period_samples != 0U)
-    {
-        uint32_t sample_rate = ScopeSignal_GetSampleRateHz();
-        if (sample_rate != 0U)
+    uint16_t trig = Scope_FindEdgeTrigger(samples, count, &frame_min, &frame_max);
+    Scope_FindFrameCrossings(samples, count, frame_min, frame_max);
+    ScopeDecode_Process(&scope_crossings,
+                        count,
+                        ((uint32_t)frame_max - frame_min >= scope_cfg.trigger_min_delta) ? 1U : 0U,
+                        contiguous,
+                        ScopeSignal_GetSampleRateHz(),
+                        &scope_decode_frame);
+
+    if (scope_view == SCOPE_VIEW_EYE)
+    {
+        ScopeEye_Process(samples,
+                         count,
+                         &scope_crossings,
+                         contiguous,
+                         ScopeSignal_GetSampleRateHz(),
+                         scope_display_settings.vertical.center_counts -
+                             (int32_t)(scope_display_settings.vertical.span_counts / 2U),
+                         scope_display_settings.vertical.span_counts);
+        scope_render_pending = 1U;
+        return;
+    }
+
+    if (ScopeTrigger_GetType() != SCOPE_TRIGGER_EDGE)
+    {
+        /* The interrupt ran the trigger over every frame, dropped ones
+           included; only frames holding an event are shown. */
+        uint16_t event_index = ScopeBuffer_GetLastTriggerIndex();
+        if (event_index >= count)
         {
-            freq_hz = sample_rate / period_samples;
+            return;
         }
+        trig = event_index;
     }
 
-    uint16_t visible_samples = Scope_GetVisibleSampleCount(count);
-    ScopeDisplay_DrawWaveform(&scope_display_settings,
-                              samples,
-                              count,
-                              visible_samples,
-                              trig,
-                              NULL,
-                              scope_live_frame.column_map);
-    ScopeDisplay_DrawMeasurements(frame_min, frame_max, freq_hz);
+    ScopeHistogram_Accumulate(samples, count);
+    scope_histogram_valid = ScopeHistogram_IsEnabled() ? ScopeHistogram_Analyze(&scope_histogram_summary) : 0U;
+
+    ScopeFrameSnapshot *frame = Scope_ClaimFrame(samples, count);
+    if (frame == NULL)
+    {
+        return;
+    }
+    Scope_MeasureFrame(samples,
+                       count,
+                       frame_min,
+                       frame_max,
+                       ScopeMeasure_ActiveMask(),
+                       &frame->measurements);
+    ScopeMeasure_PublishReport(&frame->measurements);
+    ScopeStats_Accumulate(&frame->measurements);
+
+    frame->sample_count = count;
+    frame->trigger_index = trig;
+    frame->frame_min = frame_min;
+    frame->frame_max = frame_max;
+    frame->valid = 1U;
+    scope_live_frame = frame;
+    scope_live_sequence = ScopeBuffer_GetLastSequence();
+    scope_live_decode = scope_decode_frame;
+    scope_render_pending = 1U;
+
+    /* The mask judges every triggered frame, drawn or not, so the column map
+       is built here rather than as a side effect of drawing. */
+    Scope_MapFrameColumns(frame);
+    ScopeMaskWindow mask_window;
+    Scope_GetMaskWindow(count, &mask_window);
+    if (ScopeMask_Test(frame->samples, scope_column_map, Scope_DisplayColumnCount(), &mask_window) &&
+        ScopeMask_IsStopOnFail())
+    {
+        Scope_SetHoldState(1U);
+    }
+}
+
+static void Scope_RenderFrame(void)
+{
+    if (!scope_render_pending || scope_waveform_hold)
+    {
+        return;
+    }
+    uint32_t now = HAL_GetTick();
+    if (!ScopeGovernor_RenderDue(now))
+    {
+        return;
+    }
+
+    uint32_t render_start = ScopeProfile_CycleCount();
+    switch (scope_view)
+    {
+    case SCOPE_VIEW_BODE:
+    {
+        ScopeFraStatus fra_status;
+        ScopeFra_GetStatus(&fra_status);
+        ScopeDisplay_DrawBode(ScopeFra_Points(), &fra_status);
+        break;
+    }
+    case SCOPE_VIEW_JITTER:
+    {
+        ScopeJitterStatus jitter_status;
+        ScopeJitter_GetStatus(&jitter_status);
+        uint16_t trend_count = ScopeJitter_GetTrend(scope_jitter_trend, SCOPE_JITTER_TREND_POINTS);
+        ScopeDisplay_DrawJitter(ScopeJitter_Histogram(), scope_jitter_trend, trend_count, &jitter_status);
+        break;
+    }
+    case SCOPE_VIEW_EYE:
+    {
+        ScopeEyeStatus eye_status;
+        ScopeEye_GetStatus(&eye_status);
+        ScopeDisplay_DrawEye(ScopeEye_Hits(), &eye_status);
+        break;
+    }
+    case SCOPE_VIEW_HISTOGRAM:
+    {
+        uint16_t bin_count = 0U;
+        const uint32_t *bins = ScopeHistogram_Bins(&bin_count);
+        ScopeDisplay_DrawHistogram(&scope_display_settings, bins, bin_count, &scope_histogram_summary);
+        break;
+    }
+    default:
+    {
+        uint16_t visible_samples = Scope_GetVisibleSampleCount(scope_live_frame->sample_count);
+        Scope_UpdateReferenceOverlay();
+        ScopeDisplay_DrawWaveform(&scope_display_settings,
+                                  scope_live_frame->samples,
+                                  scope_live_frame->sample_count,
+                                  visible_samples,
+                                  scope_live_frame->trigger_index,
+                                  NULL,
+                                  scope_column_map);
+        Scope_DrawDecodeAnnotations();
+        Scope_DrawInfoPanel(&scope_live_frame->measurements);
+        break;
+    }
+    }
+    scope_render_pending = 0U;
+    ScopeGovernor_RenderDone(now, ScopeProfile_CycleCount() - render_start);
+}
+
+void Scope_RequestView(ScopeView view)
+{
+    if (view >= SCOPE_VIEW_COUNT)
+    {
+        return;
+    }
+
+    Scope_PostEvent(SCOPE_EVENT_VIEW, (int8_t)view);
+}
+
+ScopeView Scope_GetView(void)
+{
+    return scope_view;
+}
+
+uint8_t Scope_CaptureMask(uint32_t tolerance_millivolt, uint16_t tolerance_columns)
+{
+    const ScopeFrameSnapshot *frame = Scope_GetShownFrame();
+    if (frame == NULL || !frame->valid)
+    {
+        return 0U;
+    }
+    /* A held deep record leaves record positions in the map. */
+    if (Scope_IsHoldRecordShown())
+    {
+        Scope_MapFrameColumns(frame);
+        scope_hold_render_pending = 1U;
+    }
+    ScopeMaskWindow mask_window;
+    Scope_GetMaskWindow(frame->sample_count, &mask_window);
+    return ScopeMask_Build(frame->samples,
+                           scope_column_map,
+                           Scope_DisplayColumnCount(),
+                           &mask_window,
+                           ScopeCalib_MillivoltToSpan(tolerance_millivolt),
+                           tolerance_columns);
+}
+
+uint8_t Scope_SaveReference(uint8_t slot)
+{
+    const ScopeFrameSnapshot *frame = Scope_GetShownFrame();
+    if (frame == NULL || !frame->valid || frame->sample_count == 0U)
+    {
+        return 0U;
+    }
+
+    ScopeReferenceInfo info = {
+        .sample_count = frame->sample_count,
+        .trigger_index = frame->trigger_index,
+        .sample_rate_hz = ScopeSignal_GetSampleRateHz()
+    };
+    /* Only the held frame is stored, so the window goes with it in frame
+       positions even when the deep record around it is on screen. */
+    Scope_GetFrameWindow(frame, &info.settings);
+    if (!ScopeReference_Save(slot, frame->samples, &info))
+    {
+        return 0U;
+    }
+    if (scope_reference_slot == (int8_t)slot)
+    {
+        scope_reference_stale = 1U;
+        scope_hold_render_pending = scope_waveform_hold;
+    }
+    return 1U;
+}
 
-    if (count != 0U)
+uint8_t Scope_ShowReference(uint8_t slot)
+{
+    ScopeReferenceInfo info;
+    if (!ScopeReference_Open(slot, &info, NULL) || info.sample_count == 0U)
+    {
+        return 0U;
+    }
+    /* Samples taken at another rate would be drawn at the wrong time scale;
+       the rate has to be set back first. */
+    if (info.sample_rate_hz != ScopeSignal_GetSampleRateHz())
     {
-        memcpy(scope_live_frame.samples, samples, (size_t)count * sizeof(uint16_t));
+        return 0U;
     }
-    scope_live_frame.sample_count = count;
-    scope_live_frame.trigger_index = trig;
-    scope_live_frame.frame_min = frame_min;
-    scope_live_frame.frame_max = frame_max;
-    scope_live_frame.freq_hz = freq_hz;
-    scope_live_frame.valid = 1U;
+    /* Back to the window it was saved with, so the two traces line up as
+       they did then; zooming afterwards moves both together. The record is
+       only checked for its CRC, so the window is clamped like any other. */
+    Scope_RestoreWindow(&info.settings);
+    scope_reference_slot = (int8_t)slot;
+    scope_reference_rate_hz = info.sample_rate_hz;
+    scope_reference_stale = 1U;
+    scope_hold_render_pending = scope_waveform_hold;
+    return 1U;
+}
+
+void Scope_HideReference(void)
+{
+    if (scope_reference_slot < 0)
+    {
+        return;
+    }
+    scope_reference_slot = -1;
+    ScopeDisplay_ClearReference();
+    scope_hold_render_pending = scope_waveform_hold;
+}
+
+uint8_t Scope_EraseReference(uint8_t slot)
+{
+    if (scope_reference_slot == (int8_t)slot)
+    {
+        Scope_HideReference();
+    }
+    return ScopeReference_Erase(slot);
+}
+
+int8_t Scope_GetShownReference(void)
+{
+    return scope_reference_slot;
+}
+
+uint8_t Scope_IsReferenceRateMismatched(void)
+{
+    return (uint8_t)(scope_reference_slot >= 0 &&
+                     scope_reference_rate_hz != ScopeSignal_GetSampleRateHz());
+}
+
+uint8_t Scope_GetFrameMean(uint16_t *mean_counts)
+{
+    const ScopeFrameSnapshot *frame = Scope_GetShownFrame();
+    if (frame == NULL || !frame->valid || frame->sample_count == 0U || mean_counts == NULL)
+    {
+        return 0U;
+    }
+    uint32_t sum = 0U;
+    for (uint16_t i = 0U; i < frame->sample_count; ++i)
+    {
+        sum += frame->samples[i];
+    }
+    *mean_counts = (uint16_t)((sum + frame->sample_count / 2U) / frame->sample_count);
+    return 1U;
 }
 
 void Scope_RequestAutoSet(void)
 {
-    scope_control.autoset_request = 1U;
+    Scope_PostEvent(SCOPE_EVENT_AUTOSET, 0);
 }
 
 void Scope_RequestMoreCycles(void)
 {
-    Scope_QueueZoomRequest(&scope_control.zoom_out_requests);
+    Scope_PostEvent(SCOPE_EVENT_ZOOM_TIME, -1);
 }
 
 void Scope_RequestFewerCycles(void)
 {
-    Scope_QueueZoomRequest(&scope_control.zoom_in_requests);
+    Scope_PostEvent(SCOPE_EVENT_ZOOM_TIME, 1);
 }
 
 void Scope_RequestMoreVoltageScale(void)
 {
-    Scope_QueueZoomRequest(&scope_control.v_zoom_out_requests);
+    Scope_PostEvent(SCOPE_EVENT_ZOOM_VOLTAGE, -1);
 }
 
 void Scope_RequestLessVoltageScale(void)
 {
-    Scope_QueueZoomRequest(&scope_control.v_zoom_in_requests);
+    Scope_PostEvent(SCOPE_EVENT_ZOOM_VOLTAGE, 1);
 }
 
 void Scope_RequestOffsetDecrease(void)
 {
-    Scope_RequestOffsetStep(-1);
+    /* The target is sampled at the key press, as the user saw it. */
+    Scope_PostEvent((scope_scale_target == SCOPE_SCALE_TARGET_TIME) ? SCOPE_EVENT_OFFSET_TIME
+                                                                    : SCOPE_EVENT_OFFSET_VOLTAGE,
+                    -1);
 }
 
 void Scope_RequestOffsetIncrease(void)
 {
-    Scope_RequestOffsetStep(1);
+    Scope_PostEvent((scope_scale_target == SCOPE_SCALE_TARGET_TIME) ? SCOPE_EVENT_OFFSET_TIME
+                                                                    : SCOPE_EVENT_OFFSET_VOLTAGE,
+                    1);
 }
 
 void Scope_ToggleScaleTarget(void)
@@ -280,15 +772,48 @@ ScopeScaleTarget Scope_GetScaleTarget(void)
     return scope_scale_target;
 }
 
+void Scope_GetPersistentSettings(ScopePersistentSettings *settings)
+{
+    if (settings == NULL)
+    {
+        return;
+    }
+    settings->span_counts = scope_display_settings.vertical.span_counts;
+    settings->center_counts = scope_display_settings.vertical.center_counts;
+    settings->samples_visible = scope_display_settings.horizontal.samples_visible;
+    settings->center_sample = scope_display_settings.horizontal.center_sample;
+    settings->scale_target = scope_scale_target;
+}
+
+void Scope_RestorePersistentSettings(const ScopePersistentSettings *settings)
+{
+    if (settings == NULL)
+    {
+        return;
+    }
+    ScopeDisplaySettings window = {
+        .vertical = { .span_counts = settings->span_counts, .center_counts = settings->center_counts },
+        .horizontal = { .samples_visible = settings->samples_visible, .center_sample = settings->center_sample }
+    };
+    Scope_RestoreWindow(&window);
+    scope_scale_target = (settings->scale_target == SCOPE_SCALE_TARGET_TIME) ? SCOPE_SCALE_TARGET_TIME
+                                                                            : SCOPE_SCALE_TARGET_VOLTAGE;
+}
+
 void Scope_ToggleWaveformHold(void)
 {
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    scope_control.hold_toggle_request = 1U;
-    if (primask == 0U)
+    Scope_PostEvent(SCOPE_EVENT_HOLD_TOGGLE, 0);
+}
+
+void Scope_GetEventStats(ScopeEventStats *stats)
+{
+    if (stats == NULL)
     {
-        __enable_irq();
+        return;
     }
+    stats->events = scope_event_count;
+    stats->dropped = ScopeEvents_Dropped(&scope_events) + scope_scale_dropped;
+    stats->max_latency_ms = scope_event_max_latency_ms;
 }
 
 uint8_t Scope_IsWaveformHoldEnabled(void)
@@ -302,26 +827,7 @@ void Scope_ToggleCursorAutoShift(int8_t direction)
     {
         return;
     }
-
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    if (!scope_waveform_hold)
-    {
-        Scope_ResetCursorAutoShift();
-    }
-    else if (scope_cursor_autoshift.direction == direction)
-    {
-        Scope_ResetCursorAutoShift();
-    }
-    else
-    {
-        scope_cursor_autoshift.direction = direction;
-        scope_cursor_autoshift.last_tick_ms = 0U;
-    }
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
+    Scope_PostEvent(SCOPE_EVENT_CURSOR_AUTOSHIFT, direction);
 }
 
 void Scope_RequestCursorShift(int8_t direction)
@@ -330,24 +836,7 @@ void Scope_RequestCursorShift(int8_t direction)
     {
         return;
     }
-
-    const int8_t max_pending = 64;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    int16_t pending = (int16_t)scope_cursor_state.shift_requests + (int16_t)direction;
-    if (pending > max_pending)
-    {
-        pending = max_pending;
-    }
-    else if (pending < -max_pending)
-    {
-        pending = -max_pending;
-    }
-    scope_cursor_state.shift_requests = (int8_t)pending;
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
+    Scope_PostEvent(SCOPE_EVENT_CURSOR_SHIFT, direction);
 }
 
 void Scope_RequestCursorSelectNext(void)
@@ -356,27 +845,65 @@ void Scope_RequestCursorSelectNext(void)
     {
         return;
     }
+    Scope_PostEvent(SCOPE_EVENT_CURSOR_SELECT, 0);
+}
 
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    scope_cursor_state.select_toggle_request = 1U;
-    if (primask == 0U)
+static void Scope_PostEvent(ScopeEventType type, int8_t arg)
+{
+    /* A full ring drops the newest input; ScopeEvents counts it. */
+    (void)ScopeEvents_Push(&scope_events, (uint8_t)type, arg, HAL_GetTick());
+}
+
+static void Scope_DrainEvents(void)
+{
+    ScopeEvent event;
+    uint32_t now = HAL_GetTick();
+    while (ScopeEvents_Pop(&scope_events, &event))
     {
-        __enable_irq();
+        uint32_t latency = now - event.timestamp_ms;
+        if ((int32_t)latency > 0 && latency > scope_event_max_latency_ms)
+        {
+            scope_event_max_latency_ms = latency;
+        }
+        scope_event_count++;
+
+        switch ((ScopeEventType)event.type)
+        {
+        case SCOPE_EVENT_VIEW:
+            Scope_ApplyView((ScopeView)event.arg);
+            break;
+        case SCOPE_EVENT_HOLD_TOGGLE:
+            if (scope_view == SCOPE_VIEW_WAVEFORM)
+            {
+                Scope_SetHoldState((uint8_t)(!scope_waveform_hold));
+            }
+            break;
+        case SCOPE_EVENT_AUTOSET:
+            scope_autoset_pending = 1U;
+            break;
+        case SCOPE_EVENT_CURSOR_SHIFT:
+        case SCOPE_EVENT_CURSOR_SELECT:
+            Scope_ApplyCursorEvent(&event);
+            break;
+        case SCOPE_EVENT_CURSOR_AUTOSHIFT:
+            Scope_ApplyCursorAutoShift(event.arg);
+            break;
+        case SCOPE_EVENT_ZOOM_TIME:
+        case SCOPE_EVENT_ZOOM_VOLTAGE:
+        case SCOPE_EVENT_OFFSET_TIME:
+        case SCOPE_EVENT_OFFSET_VOLTAGE:
+            Scope_QueueScaleEvent(&event);
+            break;
+        default:
+            break;
+        }
     }
 }
 
 static uint8_t Scope_ConsumeAutoSetRequest(void)
 {
-    uint8_t pending;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    pending = scope_control.autoset_request;
-    scope_control.autoset_request = 0U;
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
+    uint8_t pending = scope_autoset_pending;
+    scope_autoset_pending = 0U;
     return pending;
 }
 
@@ -423,9 +950,27 @@ static void Scope_UpdateVerticalWindow(uint32_t span, int32_t center)
     scope_display_settings.vertical.center_counts = center;
 }
 
+/* A window from storage goes through the same clamps as the buttons. */
+static void Scope_RestoreWindow(const ScopeDisplaySettings *settings)
+{
+    Scope_UpdateVerticalWindow(settings->vertical.span_counts, settings->vertical.center_counts);
+    Scope_UpdateHorizontalWindow(settings->horizontal.samples_visible);
+    int32_t limit = (int32_t)scope_cfg.samples_per_frame * 2;
+    int32_t center = settings->horizontal.center_sample;
+    if (center > limit)
+    {
+        center = limit;
+    }
+    else if (center < -limit)
+    {
+        center = -limit;
+    }
+    scope_display_settings.horizontal.center_sample = center;
+}
+
 static void Scope_UpdateHorizontalWindow(uint32_t span_samples)
 {
-    uint32_t max_samples = scope_cfg.samples_per_frame;
+    uint32_t max_samples = Scope_HorizontalRecordLength();
     if (max_samples == 0U)
     {
         scope_display_settings.horizontal.samples_visible = 0U;
@@ -453,6 +998,19 @@ static void Scope_UpdateHorizontalWindow(uint32_t span_samples)
         (int32_t)(scope_display_settings.horizontal.samples_visible / 2U);
 }
 
+/* One frame, or the whole deep record while one is held. */
+static uint32_t Scope_HorizontalRecordLength(void)
+{
+    uint32_t record = scope_waveform_hold ? ScopeRecord_Length() : 0U;
+    return (record > scope_cfg.samples_per_frame) ? record : scope_cfg.samples_per_frame;
+}
+
+static uint8_t Scope_IsHoldRecordShown(void)
+{
+    return (scope_waveform_hold && scope_hold_frame != NULL &&
+            ScopeRecord_Length() > scope_cfg.samples_per_frame) ? 1U : 0U;
+}
+
 static uint32_t Scope_MaxVerticalSpan(void)
 {
     uint32_t base_span = scope_cfg.adc_max_counts;
@@ -493,112 +1051,115 @@ static uint16_t Scope_GetVisibleSampleCount(uint16_t available_samples)
     return visible;
 }
 
-static void Scope_ConsumeAndApplyZoomRequests(volatile uint8_t *zoom_out_requests,
-                                               volatile uint8_t *zoom_in_requests,
-                                               void (*zoom_func)(uint8_t zoom_in))
+/* Replayed in arrival order, so a zoom followed by a pan pans in the new
+   scale. Autoset sweeps leave the backlog for later; a held frame takes it
+   at once, see Scope_ServiceHold. */
+/* Merged into the newest entry when it is of the same kind: steps add up,
+   and a zoom in undone by a zoom out leaves nothing. */
+static void Scope_QueueScaleEvent(const ScopeEvent *event)
 {
-    uint8_t zoom_out = 0U;
-    uint8_t zoom_in = 0U;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    zoom_out = *zoom_out_requests;
-    zoom_in = *zoom_in_requests;
-    *zoom_out_requests = 0U;
-    *zoom_in_requests = 0U;
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
-
-    while (zoom_out != 0U)
+    if (scope_scale_backlog_count > 0U)
     {
-        zoom_func(0U);
-        zoom_out--;
+        ScopeEvent *last = &scope_scale_backlog[scope_scale_backlog_count - 1U];
+        if (last->type == event->type)
+        {
+            int32_t steps = (int32_t)last->arg + event->arg;
+            if (steps > INT8_MAX || steps < INT8_MIN)
+            {
+                scope_scale_dropped++;
+                return;
+            }
+            last->arg = (int8_t)steps;
+            if (steps == 0)
+            {
+                scope_scale_backlog_count--;
+            }
+            return;
+        }
     }
-
-    while (zoom_in != 0U)
+    if (scope_scale_backlog_count >= SCOPE_EVENT_RING_SIZE)
     {
-        zoom_func(1U);
-        zoom_in--;
+        scope_scale_dropped++;
+        return;
     }
+    scope_scale_backlog[scope_scale_backlog_count++] = *event;
 }
 
-static void Scope_ApplyHorizontalScaleRequests(void)
-{
-    Scope_ConsumeAndApplyZoomRequests(&scope_control.zoom_out_requests,
-                                      &scope_control.zoom_in_requests,
-                                      Scope_ZoomHorizontal);
-}
-
-static void Scope_ApplyVerticalScaleRequests(void)
+static void Scope_ApplyScaleEvents(void)
 {
-    Scope_ConsumeAndApplyZoomRequests(&scope_control.v_zoom_out_requests,
-                                      &scope_control.v_zoom_in_requests,
-                                      Scope_ZoomVertical);
-}
-
-static void Scope_ApplyOffsetRequests(void)
-{
-    int8_t horizontal_pending = 0;
-    int8_t vertical_pending = 0;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    horizontal_pending = scope_control.horizontal_offset_shift_requests;
-    vertical_pending = scope_control.vertical_offset_shift_requests;
-    scope_control.horizontal_offset_shift_requests = 0;
-    scope_control.vertical_offset_shift_requests = 0;
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
-
-    if (horizontal_pending != 0)
-    {
-        Scope_ShiftHorizontalOffset(horizontal_pending);
-    }
-
-    if (vertical_pending != 0)
+    for (uint8_t i = 0U; i < scope_scale_backlog_count; ++i)
     {
-        Scope_ShiftVerticalOffset(vertical_pending);
+        const ScopeEvent *event = &scope_scale_backlog[i];
+        uint8_t zoom_steps = (uint8_t)((event->arg < 0) ? -event->arg : event->arg);
+        switch ((ScopeEventType)event->type)
+        {
+        case SCOPE_EVENT_ZOOM_TIME:
+            for (uint8_t step = 0U; step < zoom_steps; ++step)
+            {
+                Scope_ZoomHorizontal((event->arg > 0) ? 1U : 0U);
+            }
+            break;
+        case SCOPE_EVENT_ZOOM_VOLTAGE:
+            for (uint8_t step = 0U; step < zoom_steps; ++step)
+            {
+                Scope_ZoomVertical((event->arg > 0) ? 1U : 0U);
+            }
+            break;
+        case SCOPE_EVENT_OFFSET_TIME:
+            Scope_ShiftHorizontalOffset(event->arg);
+            break;
+        case SCOPE_EVENT_OFFSET_VOLTAGE:
+            Scope_ShiftVerticalOffset(event->arg);
+            break;
+        default:
+            break;
+        }
     }
+    scope_scale_backlog_count = 0U;
 }
 
 static void Scope_ZoomHorizontal(uint8_t zoom_in)
 {
+    /* Visible samples for 0.5-1-2-5-10-20 samples per division over the
+       eight 40-pixel divisions, then the whole frame; a held deep record
+       goes on at 100-200-500-... samples per division, then the whole
+       record. */
+    static const uint16_t spans[] = {4U, 8U, 16U, 40U, 80U, 160U, SCOPE_FRAME_SAMPLES,
+                                     800U, 1600U, 4000U, 8000U, 16000U, 40000U};
+    const uint8_t span_count = (uint8_t)(sizeof(spans) / sizeof(spans[0]));
+    const uint32_t record = Scope_HorizontalRecordLength();
+
     uint32_t span = scope_display_settings.horizontal.samples_visible;
     if (span == 0U)
     {
         span = scope_cfg.samples_per_frame;
     }
 
+    /* Autoset leaves arbitrary spans; the next step snaps onto the list. */
+    uint32_t next = record;
     if (zoom_in)
     {
-        if (span > 2U)
-        {
-            span /= 2U;
-        }
-        else
+        next = spans[0];
+        for (uint8_t i = 0U; i < span_count; ++i)
         {
-            span = 2U;
+            if (spans[i] < span)
+            {
+                next = spans[i];
+            }
         }
     }
     else
     {
-        if (span < scope_cfg.samples_per_frame)
+        for (uint8_t i = span_count; i > 0U; --i)
         {
-            span *= 2U;
-            if (span > scope_cfg.samples_per_frame)
+            if (spans[i - 1U] > span && spans[i - 1U] < record)
             {
-                span = scope_cfg.samples_per_frame;
+                next = spans[i - 1U];
             }
         }
-        else
-        {
-            span = scope_cfg.samples_per_frame;
-        }
     }
 
-    Scope_UpdateHorizontalWindow(span);
+    Scope_UpdateHorizontalWindow(next);
 }
 
 static void Scope_ZoomVertical(uint8_t zoom_in)
@@ -644,67 +1205,6 @@ static void Scope_ZoomVertical(uint8_t zoom_in)
     Scope_UpdateVerticalWindow(span, scope_display_settings.vertical.center_counts);
 }
 
-static void Scope_QueueZoomRequest(volatile uint8_t *request_counter)
-{
-    if (request_counter == NULL)
-    {
-        return;
-    }
-
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    if (*request_counter < 0xFFU)
-    {
-        (*request_counter)++;
-    }
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
-}
-
-static void Scope_RequestOffsetStep(int8_t direction)
-{
-    if (direction == 0)
-    {
-        return;
-    }
-
-    volatile int8_t *queue = &scope_control.vertical_offset_shift_requests;
-    if (scope_scale_target == SCOPE_SCALE_TARGET_TIME)
-    {
-        queue = &scope_control.horizontal_offset_shift_requests;
-    }
-
-    Scope_QueueOffsetRequest(queue, direction);
-}
-
-static void Scope_QueueOffsetRequest(volatile int8_t *request_counter, int8_t direction)
-{
-    if (request_counter == NULL || direction == 0)
-    {
-        return;
-    }
-
-    const int8_t max_pending = 64;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    int16_t pending = (int16_t)(*request_counter) + (int16_t)direction;
-    if (pending > max_pending)
-    {
-        pending = max_pending;
-    }
-    else if (pending < -max_pending)
-    {
-        pending = -max_pending;
-    }
-    *request_counter = (int8_t)pending;
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
-}
-
 static void Scope_ShiftHorizontalOffset(int8_t steps)
 {
     if (steps == 0)
@@ -713,7 +1213,7 @@ static void Scope_ShiftHorizontalOffset(int8_t steps)
     }
 
     uint32_t visible = scope_display_settings.horizontal.samples_visible;
-    uint32_t frame_samples = scope_cfg.samples_per_frame;
+    uint32_t frame_samples = Scope_HorizontalRecordLength();
     if (visible == 0U || frame_samples == 0U)
     {
         return;
@@ -779,29 +1279,22 @@ static void Scope_ShiftVerticalOffset(int8_t steps)
     scope_display_settings.vertical.center_counts = center;
 }
 
-static void Scope_ApplyAutoSet(uint16_t *buf, uint16_t len)
+static void Scope_ApplyAutoSet(const ScopeAutosetResult *result)
 {
-    if (buf == NULL || len == 0U)
-    {
-        return;
-    }
-
-    uint16_t frame_min = 0xFFFFU;
-    uint16_t frame_max = 0U;
-    uint16_t trig = ScopeSignal_FindTriggerIndex(buf,
-                                                 len,
-                                                 scope_cfg.trigger_min_delta,
-                                                 &frame_min,
-                                                 &frame_max);
+    /* The sweep may have left the timer at a different rate than the last frame
+       seen here, so the next frame must not be stitched onto it. */
+    scope_sequence_valid = 0U;
+    scope_trigger_level = 0U;
+    ScopeStats_Reset();
 
-    if (frame_max < frame_min)
+    if (result == NULL || result->signal_max < result->signal_min)
     {
         Scope_ResetVerticalWindow();
         Scope_UpdateHorizontalWindow(scope_cfg.samples_per_frame);
         return;
     }
 
-    uint32_t span = (uint32_t)frame_max - (uint32_t)frame_min;
+    uint32_t span = (uint32_t)result->signal_max - (uint32_t)result->signal_min;
     if (span < scope_cfg.trigger_min_delta)
     {
         Scope_ResetVerticalWindow();
@@ -810,63 +1303,71 @@ static void Scope_ApplyAutoSet(uint16_t *buf, uint16_t len)
     }
 
     uint32_t margin_span = span + (span * AUTOSET_MARGIN_PERCENT_NUMERATOR / AUTOSET_MARGIN_PERCENT_DENOMINATOR);
-    if (margin_span == 0U)
-    {
-        margin_span = scope_cfg.trigger_min_delta;
-    }
-
-    uint32_t center = (uint32_t)frame_min + span / 2U;
+    uint32_t center = (uint32_t)result->signal_min + span / 2U;
     Scope_UpdateVerticalWindow(margin_span, (int32_t)center);
+    scope_trigger_level = result->trigger_level;
 
-    uint32_t period_samples = ScopeSignal_EstimatePeriodSamples(buf,
-                                                                len,
-                                                                trig,
-                                                                frame_min,
-                                                                frame_max,
-                                                                scope_cfg.trigger_min_delta);
+    uint32_t period_samples = (result->period_q8 + 128U) >> 8;
     if (period_samples == 0U)
     {
         Scope_UpdateHorizontalWindow(scope_cfg.samples_per_frame);
     }
     else
     {
-        uint32_t span_samples = period_samples * 2U;
-        if (span_samples == 0U)
-        {
-            span_samples = scope_cfg.samples_per_frame;
-        }
-        Scope_UpdateHorizontalWindow(span_samples);
+        Scope_UpdateHorizontalWindow(period_samples * 2U);
     }
 }
 
-static void Scope_HandleHoldToggleRequest(void)
+static void Scope_ApplyView(ScopeView view)
 {
-    uint8_t pending = 0U;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    pending = scope_control.hold_toggle_request;
-    scope_control.hold_toggle_request = 0U;
-    if (primask == 0U)
+    if (view >= SCOPE_VIEW_COUNT || view == scope_view)
     {
-        __enable_irq();
+        return;
     }
 
-    if (pending != 0U)
+    /* Hold, cursors and the mask only make sense over the time-domain trace. */
+    if (scope_waveform_hold)
     {
-        Scope_SetHoldState((uint8_t)(!scope_waveform_hold));
+        Scope_SetHoldState(0U);
     }
+    /* A sweep in progress hands the timers back when its plot is left. */
+    if (scope_view == SCOPE_VIEW_BODE)
+    {
+        ScopeFra_Stop();
+    }
+    scope_view = view;
+    ScopeHistogram_SetEnabled((view == SCOPE_VIEW_HISTOGRAM) ? 1U : 0U);
+    ScopeEye_SetEnabled((view == SCOPE_VIEW_EYE) ? 1U : 0U);
+    ScopeJitter_SetEnabled((view == SCOPE_VIEW_JITTER) ? 1U : 0U);
+    scope_histogram_valid = 0U;
+    scope_render_pending = 0U;
+    ScopeDisplay_SetReferenceVisible((view == SCOPE_VIEW_WAVEFORM) ? 1U : 0U);
+    ScopeDisplay_DrawGrid();
 }
 
 static void Scope_SetHoldState(uint8_t enable)
 {
     if (enable)
     {
-        if (!Scope_CopyLiveFrameToHold())
+        if (!Scope_PinLiveFrame())
         {
             scope_waveform_hold = 0U;
             return;
         }
         scope_waveform_hold = 1U;
+        scope_history_frozen = 1U;
+        scope_live_age = Scope_FindLiveAge();
+        if (scope_live_age != SCOPE_HISTORY_NO_AGE)
+        {
+            scope_history_age = scope_live_age;
+            (void)ScopeRecord_Build(scope_live_age);
+        }
+        else
+        {
+            /* The rate changed since the frame came in: no record. */
+            scope_history_age = 0U;
+            ScopeRecord_Clear();
+        }
         Scope_InitCursorPositions();
         Scope_ResetCursorAutoShift();
         scope_hold_render_pending = 1U;
@@ -878,34 +1379,60 @@ static void Scope_SetHoldState(uint8_t enable)
     }
 }
 
-static uint8_t Scope_CopyLiveFrameToHold(void)
+static uint8_t Scope_PinLiveFrame(void)
 {
-    if (!scope_live_frame.valid || scope_live_frame.sample_count == 0U)
+    if (!scope_live_frame->valid || scope_live_frame->sample_count == 0U)
     {
         return 0U;
     }
 
-    size_t sample_bytes = (size_t)scope_live_frame.sample_count * sizeof(uint16_t);
-    memcpy(scope_hold_frame.samples, scope_live_frame.samples, sample_bytes);
-    memcpy(scope_hold_frame.column_map,
-           scope_live_frame.column_map,
-           sizeof(scope_live_frame.column_map));
-    scope_hold_frame.sample_count = scope_live_frame.sample_count;
-    scope_hold_frame.trigger_index = scope_live_frame.trigger_index;
-    scope_hold_frame.frame_min = scope_live_frame.frame_min;
-    scope_hold_frame.frame_max = scope_live_frame.frame_max;
-    scope_hold_frame.freq_hz = scope_live_frame.freq_hz;
-    scope_hold_frame.valid = 1U;
+    /* No new frame is committed while held, so the live buffer and the
+       column map already built for it are the held frame as they stand. */
+    scope_hold_frame = scope_live_frame;
     return 1U;
 }
 
+/* Frames that came in after the live one, shown or not, sit in front of
+   it; with the ring frozen the walk is short and the answer stays put. */
+static uint16_t Scope_FindLiveAge(void)
+{
+    uint16_t count = ScopeHistory_Count();
+    for (uint16_t age = 0U; age < count; ++age)
+    {
+        ScopeHistoryInfo info;
+        if (!ScopeHistory_Get(age, NULL, &info))
+        {
+            break;
+        }
+        if (info.sequence == scope_live_sequence)
+        {
+            return age;
+        }
+        if ((int32_t)(info.sequence - scope_live_sequence) < 0)
+        {
+            break;
+        }
+    }
+    return SCOPE_HISTORY_NO_AGE;
+}
+
 static void Scope_DisableHoldState(void)
 {
-    scope_hold_frame.valid = 0U;
+    /* A history frame or the deep record may have left its column map
+       behind, and the timebase goes back within one frame. */
+    if (scope_hold_frame != NULL)
+    {
+        ScopeRecord_Clear();
+        if (scope_display_settings.horizontal.samples_visible > scope_cfg.samples_per_frame)
+        {
+            Scope_UpdateHorizontalWindow(scope_cfg.samples_per_frame);
+        }
+        Scope_MapFrameColumns(scope_live_frame);
+    }
+    scope_hold_frame = NULL;
+    scope_history_frozen = 0U;
     scope_cursor_state.active = 0U;
     scope_cursor_state.selected = 0U;
-    scope_cursor_state.shift_requests = 0;
-    scope_cursor_state.select_toggle_request = 0U;
     Scope_ResetCursorAutoShift();
     scope_hold_render_pending = 0U;
 }
@@ -931,112 +1458,155 @@ static void Scope_InitCursorPositions(void)
     }
 
     scope_cursor_state.selected = 0U;
-    scope_cursor_state.shift_requests = 0;
-    scope_cursor_state.select_toggle_request = 0U;
     scope_cursor_state.active = 1U;
 }
 
 static void Scope_ResetCursorAutoShift(void)
 {
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
     scope_cursor_autoshift.direction = 0;
     scope_cursor_autoshift.last_tick_ms = 0U;
-    if (primask == 0U)
-    {
-        __enable_irq();
-    }
 }
 
-static void Scope_UpdateCursorAutoShift(void)
+static void Scope_ApplyCursorAutoShift(int8_t direction)
 {
-    int8_t direction = 0;
-    uint32_t last_tick = 0U;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    direction = scope_cursor_autoshift.direction;
-    last_tick = scope_cursor_autoshift.last_tick_ms;
-    if (primask == 0U)
+    if (!scope_waveform_hold || scope_cursor_autoshift.direction == direction)
     {
-        __enable_irq();
+        Scope_ResetCursorAutoShift();
+        return;
     }
+    scope_cursor_autoshift.direction = direction;
+    scope_cursor_autoshift.last_tick_ms = 0U;
+}
 
+static void Scope_UpdateCursorAutoShift(void)
+{
+    int8_t direction = scope_cursor_autoshift.direction;
     if (direction == 0)
     {
         return;
     }
 
-    if (!scope_waveform_hold || !scope_hold_frame.valid || !scope_cursor_state.active)
+    if (!scope_waveform_hold || scope_hold_frame == NULL || !scope_cursor_state.active)
     {
         Scope_ResetCursorAutoShift();
         return;
     }
 
     uint32_t now = HAL_GetTick();
+    uint32_t last_tick = scope_cursor_autoshift.last_tick_ms;
     if (last_tick == 0U || (now - last_tick) >= CURSOR_AUTOSHIFT_INTERVAL_MS)
     {
-        primask = __get_PRIMASK();
-        __disable_irq();
-        if (scope_cursor_autoshift.direction == direction)
-        {
-            scope_cursor_autoshift.last_tick_ms = now;
-        }
-        else
-        {
-            direction = 0;
-        }
-        if (primask == 0U)
-        {
-            __enable_irq();
-        }
-        if (direction != 0)
+        scope_cursor_autoshift.last_tick_ms = now;
+        Scope_StepHoldTarget(direction);
+        scope_hold_render_pending = 1U;
+    }
+}
+
+static void Scope_ApplyCursorEvent(const ScopeEvent *event)
+{
+    if (!scope_waveform_hold || scope_hold_frame == NULL || !scope_cursor_state.active)
+    {
+        return;
+    }
+
+    if (event->type == SCOPE_EVENT_CURSOR_SELECT)
+    {
+        scope_cursor_state.selected++;
+        if (scope_cursor_state.selected >= SCOPE_HOLD_TARGET_COUNT)
         {
-            Scope_RequestCursorShift(direction);
+            scope_cursor_state.selected = 0U;
         }
     }
+    else
+    {
+        Scope_StepHoldTarget(event->arg);
+    }
+    scope_hold_render_pending = 1U;
 }
 
-static void Scope_ApplyCursorRequests(void)
+static void Scope_StepHoldTarget(int8_t steps)
 {
-    int8_t shift = 0;
-    uint8_t toggle = 0U;
-    uint32_t primask = __get_PRIMASK();
-    __disable_irq();
-    shift = scope_cursor_state.shift_requests;
-    scope_cursor_state.shift_requests = 0;
-    toggle = scope_cursor_state.select_toggle_request;
-    scope_cursor_state.select_toggle_request = 0U;
-    if (primask == 0U)
+    if (scope_cursor_state.selected == SCOPE_HOLD_TARGET_HISTORY)
     {
-        __enable_irq();
+        /* Right is towards the newest frame. */
+        Scope_StepHistory((int8_t)-steps);
     }
+    else
+    {
+        Scope_MoveCursor(scope_cursor_state.selected, steps);
+    }
+}
 
-    if (!scope_waveform_hold || !scope_hold_frame.valid || !scope_cursor_state.active)
+static void Scope_StepHistory(int8_t steps)
+{
+    uint16_t count = ScopeHistory_Count();
+    if (count == 0U || steps == 0)
     {
         return;
     }
 
-    uint8_t updated = 0U;
-    if (toggle != 0U)
+    int32_t age = (int32_t)scope_history_age + steps;
+    if (age < 0)
     {
-        scope_cursor_state.selected++;
-        if (scope_cursor_state.selected >= SCOPE_CURSOR_COUNT)
+        age = 0;
+    }
+    else if (age >= (int32_t)count)
+    {
+        age = (int32_t)count - 1;
+    }
+    if ((uint16_t)age == scope_history_age)
+    {
+        return;
+    }
+
+    /* The live frame's own entry: pin it again and give the spare back to
+       acquisition. */
+    if ((uint16_t)age == scope_live_age)
+    {
+        scope_history_age = scope_live_age;
+        scope_hold_frame = scope_live_frame;
+        Scope_MapFrameColumns(scope_hold_frame);
+        if (!ScopeRecord_Contains(scope_live_age))
         {
-            scope_cursor_state.selected = 0U;
+            (void)ScopeRecord_Build(scope_live_age);
         }
-        updated = 1U;
+        return;
     }
 
-    if (shift != 0)
+    ScopeFrameSnapshot *frame = scope_hold_frame;
+    if (frame == scope_live_frame)
     {
-        Scope_MoveCursor(scope_cursor_state.selected, shift);
-        updated = 1U;
+        frame = Scope_GetSpareFrame();
     }
-
-    if (updated)
+    ScopeHistoryInfo info;
+    if (frame == NULL || !ScopeHistory_Get((uint16_t)age, frame->samples, &info))
     {
-        scope_hold_render_pending = 1U;
+        return;
     }
+    scope_history_age = (uint16_t)age;
+    scope_hold_frame = frame;
+    /* Inside the deep record a step only moves the trigger it is centred
+       on; past a gap the record is rebuilt from there. */
+    if (!ScopeRecord_Contains(scope_history_age))
+    {
+        (void)ScopeRecord_Build(scope_history_age);
+    }
+    frame->sample_count = info.sample_count;
+    frame->trigger_index = info.trigger_index;
+    frame->frame_min = info.frame_min;
+    frame->frame_max = info.frame_max;
+    frame->valid = 1U;
+    Scope_MapFrameColumns(frame);
+    Scope_FindFrameCrossings(frame->samples,
+                             frame->sample_count,
+                             frame->frame_min,
+                             frame->frame_max);
+    Scope_MeasureFrame(frame->samples,
+                       frame->sample_count,
+                       frame->frame_min,
+                       frame->frame_max,
+                       ScopeMeasure_ActiveMask(),
+                       &frame->measurements);
 }
 
 static void Scope_MoveCursor(uint8_t cursor_index, int8_t steps)
@@ -1066,9 +1636,24 @@ static void Scope_MoveCursor(uint8_t cursor_index, int8_t steps)
     scope_cursor_state.columns[cursor_index] = (uint16_t)column;
 }
 
+static void Scope_ServiceHold(void)
+{
+    if (scope_scale_backlog_count != 0U)
+    {
+        Scope_ApplyScaleEvents();
+        scope_hold_render_pending = 1U;
+    }
+    if (scope_hold_render_pending)
+    {
+        Scope_RenderHoldFrame();
+        scope_hold_render_pending = 0U;
+    }
+    Scope_ServiceHoldReport();
+}
+
 static void Scope_RenderHoldFrame(void)
 {
-    if (!scope_waveform_hold || !scope_hold_frame.valid)
+    if (!scope_waveform_hold || scope_hold_frame == NULL)
     {
         return;
     }
@@ -1090,14 +1675,22 @@ static void Scope_RenderHoldFrame(void)
         }
     }
 
-    uint16_t visible_samples = Scope_GetVisibleSampleCount(scope_hold_frame.sample_count);
-    ScopeDisplay_DrawWaveform(&scope_display_settings,
-                              scope_hold_frame.samples,
-                              scope_hold_frame.sample_count,
-                              visible_samples,
-                              scope_hold_frame.trigger_index,
-                              (cursor_info.count > 0U) ? &cursor_info : NULL,
-                              scope_hold_frame.column_map);
+    Scope_UpdateReferenceOverlay();
+    if (Scope_IsHoldRecordShown())
+    {
+        Scope_RenderHoldRecord((cursor_info.count > 0U) ? &cursor_info : NULL);
+    }
+    else
+    {
+        uint16_t visible_samples = Scope_GetVisibleSampleCount(scope_hold_frame->sample_count);
+        ScopeDisplay_DrawWaveform(&scope_display_settings,
+                                  scope_hold_frame->samples,
+                                  scope_hold_frame->sample_count,
+                                  visible_samples,
+                                  scope_hold_frame->trigger_index,
+                                  (cursor_info.count > 0U) ? &cursor_info : NULL,
+                                  scope_column_map);
+    }
 
     if (scope_cursor_state.active)
     {
@@ -1105,15 +1698,116 @@ static void Scope_RenderHoldFrame(void)
     }
     else
     {
-        ScopeDisplay_DrawMeasurements(scope_hold_frame.frame_min,
-                                      scope_hold_frame.frame_max,
-                                      scope_hold_frame.freq_hz);
+        Scope_DrawInfoPanel(&scope_hold_frame->measurements);
+    }
+}
+
+/* The held frame inside its deep record. Either way the column map ends up
+   holding record positions, which the cursors read back. */
+static void Scope_RenderHoldRecord(const ScopeDisplayCursorRenderInfo *cursor_info)
+{
+    const uint16_t frame_samples = scope_cfg.samples_per_frame;
+    uint16_t length = ScopeRecord_Length();
+    uint16_t visible = Scope_GetVisibleSampleCount(length);
+    uint16_t trigger = (uint16_t)(ScopeRecord_FrameStart(scope_history_age) + scope_hold_frame->trigger_index);
+
+    if (visible > frame_samples)
+    {
+        /* Several samples per column: their min/max from the pyramid. */
+        uint16_t column_min[SCOPE_FRAME_SAMPLES];
+        uint16_t column_max[SCOPE_FRAME_SAMPLES];
+        uint16_t columns = ScopeDisplay_MapRecordColumns(&scope_display_settings,
+                                                         length,
+                                                         visible,
+                                                         trigger,
+                                                         scope_column_map);
+        ScopeRecord_Envelope(scope_column_map, columns, visible, column_min, column_max);
+        ScopeDisplay_DrawEnvelope(&scope_display_settings, column_min, column_max, columns, cursor_info);
+        return;
+    }
+
+    /* Up to one frame wide: copy the window out with the rest of a frame
+       around it, for the interpolator, and draw that as a frame whose
+       window starts where this one does. */
+    int32_t center = scope_display_settings.horizontal.center_sample;
+    int32_t margin = (int32_t)(frame_samples - visible) / 2;
+    int32_t start = ((int32_t)trigger - center) % (int32_t)length;
+    if (start < 0)
+    {
+        start += (int32_t)length;
+    }
+    int32_t base = start - margin;
+    if (base < 0)
+    {
+        base += (int32_t)length;
+    }
+    int32_t window_trigger = (margin + center) % (int32_t)frame_samples;
+    if (window_trigger < 0)
+    {
+        window_trigger += (int32_t)frame_samples;
+    }
+
+    uint16_t window[SCOPE_FRAME_SAMPLES];
+    ScopeRecord_Read((uint16_t)base, frame_samples, window);
+    ScopeDisplay_DrawWaveform(&scope_display_settings,
+                              window,
+                              frame_samples,
+                              visible,
+                              (uint16_t)window_trigger,
+                              cursor_info,
+                              scope_column_map);
+    for (uint16_t i = 0U; i < Scope_DisplayColumnCount(); ++i)
+    {
+        uint32_t index = (uint32_t)base + scope_column_map[i];
+        if (index >= length)
+        {
+            index -= length;
+        }
+        scope_column_map[i] = (uint16_t)index;
+    }
+}
+
+static void Scope_UpdateReferenceOverlay(void)
+{
+    /* A reference is one frame and a deep record's window is in record
+       positions, so the two cannot share columns; after a rate change they
+       do not share a time scale. Either way the overlay steps aside and is
+       rebuilt once the two agree again. */
+    if (scope_reference_slot >= 0 && (Scope_IsHoldRecordShown() || Scope_IsReferenceRateMismatched()))
+    {
+        ScopeDisplay_ClearReference();
+        scope_reference_stale = 1U;
+        return;
+    }
+    if (scope_reference_slot < 0 ||
+        (!scope_reference_stale &&
+         memcmp(&scope_reference_window, &scope_display_settings, sizeof(scope_display_settings)) == 0))
+    {
+        return;
+    }
+
+    ScopeReferenceInfo info;
+    ScopeReferenceReader reader;
+    if (!ScopeReference_Open((uint8_t)scope_reference_slot, &info, &reader))
+    {
+        Scope_HideReference();
+        return;
     }
+    /* Decoded sample by sample from flash straight into column ranges. */
+    ScopeDisplay_BeginReference(&scope_display_settings, info.sample_count, info.trigger_index);
+    uint16_t sample = 0U;
+    for (uint16_t index = 0U; ScopeReference_Next(&reader, &sample); ++index)
+    {
+        ScopeDisplay_AddReferenceSample(index, sample);
+    }
+    ScopeDisplay_EndReference();
+    scope_reference_window = scope_display_settings;
+    scope_reference_stale = 0U;
 }
 
 static void Scope_DrawCursorMeasurements(void)
 {
-    if (!scope_hold_frame.valid || scope_hold_frame.sample_count == 0U)
+    if (scope_hold_frame == NULL || scope_hold_frame->sample_count == 0U)
     {
         return;
     }
@@ -1121,6 +1815,12 @@ static void Scope_DrawCursorMeasurements(void)
     ScopeDisplayCursorMeasurements measurements = {0};
     measurements.count = SCOPE_CURSOR_COUNT;
     measurements.sample_rate_hz = ScopeSignal_GetSampleRateHz();
+    measurements.history_selected = (scope_cursor_state.selected == SCOPE_HOLD_TARGET_HISTORY) ? 1U : 0U;
+    measurements.history_age = scope_history_age;
+    measurements.history_count = ScopeHistory_Count();
+    ScopeRecordStatus record_status;
+    ScopeRecord_GetStatus(&record_status);
+    measurements.record_frames = record_status.frames;
     uint16_t limit = Scope_GetCursorColumnLimit();
     if (limit == 0U)
     {
@@ -1134,13 +1834,21 @@ static void Scope_DrawCursorMeasurements(void)
         {
             column = limit - 1U;
         }
-        uint16_t sample_idx = scope_hold_frame.column_map[column];
-        if (sample_idx >= scope_hold_frame.sample_count)
+        uint16_t sample_idx = scope_column_map[column];
+        if (Scope_IsHoldRecordShown())
+        {
+            /* Exact record sample at any zoom; times count from the
+               record's start. */
+            measurements.sample_indices[idx] = sample_idx;
+            measurements.sample_values[idx] = ScopeRecord_Sample(sample_idx);
+            continue;
+        }
+        if (sample_idx >= scope_hold_frame->sample_count)
         {
-            sample_idx = scope_hold_frame.sample_count - 1U;
+            sample_idx = scope_hold_frame->sample_count - 1U;
         }
         measurements.sample_indices[idx] = sample_idx;
-        measurements.sample_values[idx] = scope_hold_frame.samples[sample_idx];
+        measurements.sample_values[idx] = scope_hold_frame->samples[sample_idx];
     }
 
     ScopeDisplay_DrawCursorMeasurements(&measurements);
@@ -1154,3 +1862,119 @@ static uint16_t Scope_GetCursorColumnLimit(void)
     }
     return scope_cfg.samples_per_frame;
 }
+
+static void Scope_FindFrameCrossings(const uint16_t *samples,
+                                     uint16_t count,
+                                     uint16_t frame_min,
+                                     uint16_t frame_max)
+{
+    uint16_t threshold = (uint16_t)(((uint32_t)frame_min + frame_max) / 2U);
+    ScopeSignal_FindCrossings(samples,
+                              count,
+                              threshold,
+                              scope_cfg.trigger_min_delta / 2U,
+                              &scope_crossings);
+}
+
+static void Scope_MeasureFrame(const uint16_t *samples,
+                               uint16_t count,
+                               uint16_t frame_min,
+                               uint16_t frame_max,
+                               uint32_t mask,
+                               ScopeMeasureResult *result)
+{
+    ScopeMeasureInput input = {
+        .samples = samples,
+        .count = count,
+        .frame_min = frame_min,
+        .frame_max = frame_max,
+        .min_amplitude_counts = scope_cfg.trigger_min_delta,
+        .top_counts = (scope_histogram_valid && scope_histogram_summary.bimodal) ? scope_histogram_summary.top : 0U,
+        .base_counts = (scope_histogram_valid && scope_histogram_summary.bimodal) ? scope_histogram_summary.base : 0U,
+        .crossings = &scope_crossings,
+        .sample_rate_hz = ScopeSignal_GetSampleRateHz()
+    };
+    ScopeMeasure_Compute(&input, mask, result);
+}
+
+static void Scope_ServiceHoldReport(void)
+{
+    if (!ScopeMeasure_IsReportPending() || scope_hold_frame == NULL)
+    {
+        return;
+    }
+
+    ScopeMeasureResult result;
+    Scope_FindFrameCrossings(scope_hold_frame->samples,
+                             scope_hold_frame->sample_count,
+                             scope_hold_frame->frame_min,
+                             scope_hold_frame->frame_max);
+    Scope_MeasureFrame(scope_hold_frame->samples,
+                       scope_hold_frame->sample_count,
+                       scope_hold_frame->frame_min,
+                       scope_hold_frame->frame_max,
+                       SCOPE_MEASURE_ALL_MASK,
+                       &result);
+    ScopeMeasure_PublishReport(&result);
+}
+
+static uint8_t Scope_ConsumeFrameContinuity(void)
+{
+    uint32_t sequence = ScopeBuffer_GetLastSequence();
+    uint8_t contiguous = (scope_sequence_valid && sequence == scope_last_sequence + 1U) ? 1U : 0U;
+    scope_last_sequence = sequence;
+    scope_sequence_valid = 1U;
+    return contiguous;
+}
+
+static void Scope_DrawDecodeAnnotations(void)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+    ScopeDisplayAnnotation items[SCOPE_DISPLAY_MAX_ANNOTATIONS];
+    uint8_t count = 0U;
+
+    if (ScopeDecode_IsEnabled())
+    {
+        for (uint8_t idx = 0U; idx < scope_live_decode.count && count < SCOPE_DISPLAY_MAX_ANNOTATIONS; idx++)
+        {
+            const ScopeDecodeByte *byte = &scope_live_decode.bytes[idx];
+            ScopeDisplayAnnotation *item = &items[count++];
+            item->first_sample = byte->start_index;
+            item->last_sample = byte->stop_index;
+            item->color = byte->framing_error ? ILI9341_RED : ILI9341_CYAN;
+            item->text[0] = hex_digits[byte->value >> 4];
+            item->text[1] = hex_digits[byte->value & 0x0FU];
+            item->text[2] = '\0';
+        }
+    }
+
+    ScopeDisplay_DrawAnnotations(items, count, scope_column_map);
+}
+
+static void Scope_DrawInfoPanel(const ScopeMeasureResult *result)
+{
+    if (!ScopeStats_IsPanelVisible())
+    {
+        ScopeDisplay_DrawMeasurements(result);
+        return;
+    }
+
+    ScopeStatsSummary slots[SCOPE_MEASURE_DISPLAY_SLOTS];
+    for (uint8_t slot = 0U; slot < SCOPE_MEASURE_DISPLAY_SLOTS; slot++)
+    {
+        (void)ScopeStats_Get(ScopeMeasure_GetDisplaySlot(slot), &slots[slot]);
+    }
+    ScopeDisplay_DrawStatistics(slots);
+}
+
+static uint16_t Scope_DisplayColumnCount(void)
+{
+    return (scope_cfg.samples_per_frame < ILI9341_WIDTH) ? scope_cfg.samples_per_frame : ILI9341_WIDTH;
+}
+
+static void Scope_GetMaskWindow(uint16_t count, ScopeMaskWindow *window)
+{
+    window->sample_rate_hz = ScopeSignal_GetSampleRateHz();
+    window->samples_visible = Scope_GetVisibleSampleCount(count);
+    window->center_sample = scope_display_settings.horizontal.center_sample;
+}
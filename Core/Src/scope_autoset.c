@@ -0,0 +1,199 @@
+#include "scope_autoset.h"
+
+#include "scope_buffer.h"
+#include "scope_signal.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum
+{
+    AUTOSET_TIME_BUDGET_MS = 300U,
+    AUTOSET_MIN_PERIOD_SAMPLES = 10U,
+    AUTOSET_MAX_PERIOD_SAMPLES = 160U
+};
+
+/* Fastest first: a slow signal shows no full period at the high rates, and the
+   sweep stops at the first rate that resolves one. Two frames at each rate down
+   to 5 kHz take about 250 ms, which keeps the sweep inside the time budget. */
+static const uint32_t autoset_rates_hz[] = {
+    1000000U,
+    500000U,
+    200000U,
+    100000U,
+    50000U,
+    20000U,
+    10000U,
+    5000U
+};
+
+enum { AUTOSET_RATE_COUNT = sizeof(autoset_rates_hz) / sizeof(autoset_rates_hz[0]) };
+
+typedef struct
+{
+    ScopeAutosetState state;
+    uint16_t min_amplitude;
+    uint8_t rate_index;
+    uint32_t settle_sequence;
+    uint32_t start_ms;
+    uint32_t initial_rate_hz;
+    uint16_t signal_min;
+    uint16_t signal_max;
+    uint8_t fallback_valid;
+    uint8_t fallback_index;
+    uint32_t fallback_period_q8;
+    ScopeAutosetResult report;
+    uint8_t report_pending;
+} ScopeAutosetModule;
+
+static ScopeAutosetModule scope_autoset_module;
+
+static void ScopeAutoset_SelectRate(uint8_t index);
+static void ScopeAutoset_Finish(uint8_t rate_index, uint32_t period_q8, uint32_t now_ms,
+                                ScopeAutosetResult *result);
+
+void ScopeAutoset_Init(uint16_t min_amplitude_counts)
+{
+    memset(&scope_autoset_module, 0, sizeof(scope_autoset_module));
+    scope_autoset_module.min_amplitude = min_amplitude_counts;
+}
+
+void ScopeAutoset_Start(uint32_t now_ms)
+{
+    ScopeAutosetModule *as = &scope_autoset_module;
+    as->state = SCOPE_AUTOSET_RUNNING;
+    as->start_ms = now_ms;
+    as->initial_rate_hz = ScopeSignal_GetSampleRateHz();
+    as->signal_min = 0xFFFFU;
+    as->signal_max = 0U;
+    as->fallback_valid = 0U;
+    ScopeAutoset_SelectRate(0U);
+}
+
+uint8_t ScopeAutoset_IsRunning(void)
+{
+    return (scope_autoset_module.state == SCOPE_AUTOSET_RUNNING) ? 1U : 0U;
+}
+
+ScopeAutosetState ScopeAutoset_Step(uint16_t *samples,
+                                    uint16_t count,
+                                    uint32_t sequence,
+                                    uint32_t now_ms,
+                                    ScopeAutosetResult *result)
+{
+    ScopeAutosetModule *as = &scope_autoset_module;
+    if (as->state != SCOPE_AUTOSET_RUNNING)
+    {
+        return as->state;
+    }
+
+    uint8_t over_budget = ((now_ms - as->start_ms) >= AUTOSET_TIME_BUDGET_MS) ? 1U : 0U;
+    if (samples != NULL && count != 0U && (int32_t)(sequence - as->settle_sequence) >= 0)
+    {
+        uint16_t frame_min = 0U;
+        uint16_t frame_max = 0U;
+        uint16_t trig = ScopeSignal_FindTriggerIndex(samples, count, as->min_amplitude, &frame_min, &frame_max);
+        as->signal_min = (frame_min < as->signal_min) ? frame_min : as->signal_min;
+        as->signal_max = (frame_max > as->signal_max) ? frame_max : as->signal_max;
+
+        uint32_t period_q8 = ScopeSignal_EstimatePeriodRobustQ8(samples,
+                                                                count,
+                                                                trig,
+                                                                frame_min,
+                                                                frame_max,
+                                                                as->min_amplitude);
+        uint32_t period_samples = period_q8 >> 8;
+        if (period_q8 != 0U)
+        {
+            if (period_samples >= AUTOSET_MIN_PERIOD_SAMPLES || as->rate_index == 0U)
+            {
+                if (period_samples <= AUTOSET_MAX_PERIOD_SAMPLES)
+                {
+                    ScopeAutoset_Finish(as->rate_index, period_q8, now_ms, result);
+                    return as->state;
+                }
+            }
+            if (!as->fallback_valid)
+            {
+                as->fallback_valid = 1U;
+                as->fallback_index = as->rate_index;
+                as->fallback_period_q8 = period_q8;
+            }
+        }
+
+        if (!over_budget && (uint8_t)(as->rate_index + 1U) < AUTOSET_RATE_COUNT)
+        {
+            ScopeAutoset_SelectRate((uint8_t)(as->rate_index + 1U));
+            return as->state;
+        }
+        over_budget = 1U;
+    }
+
+    if (over_budget)
+    {
+        if (as->fallback_valid)
+        {
+            ScopeAutoset_Finish(as->fallback_index, as->fallback_period_q8, now_ms, result);
+        }
+        else
+        {
+            ScopeAutoset_Finish(0xFFU, 0U, now_ms, result);
+        }
+    }
+    return as->state;
+}
+
+uint8_t ScopeAutoset_TakeReport(ScopeAutosetResult *result)
+{
+    if (!scope_autoset_module.report_pending || result == NULL)
+    {
+        return 0U;
+    }
+    *result = scope_autoset_module.report;
+    scope_autoset_module.report_pending = 0U;
+    return 1U;
+}
+
+static void ScopeAutoset_SelectRate(uint8_t index)
+{
+    scope_autoset_module.rate_index = index;
+    (void)ScopeSignal_SetSampleRateHz(autoset_rates_hz[index]);
+    /* The half-buffer being filled now mixes both rates; wait for the one after. */
+    scope_autoset_module.settle_sequence = ScopeBuffer_GetNextSequence() + 1U;
+}
+
+static void ScopeAutoset_Finish(uint8_t rate_index, uint32_t period_q8, uint32_t now_ms,
+                                ScopeAutosetResult *result)
+{
+    ScopeAutosetModule *as = &scope_autoset_module;
+    uint32_t rate_hz = (rate_index < AUTOSET_RATE_COUNT) ? autoset_rates_hz[rate_index] : as->initial_rate_hz;
+    if (rate_hz != ScopeSignal_GetSampleRateHz())
+    {
+        (void)ScopeSignal_SetSampleRateHz(rate_hz);
+    }
+
+    ScopeAutosetResult report = {0};
+    report.sample_rate_hz = ScopeSignal_GetSampleRateHz();
+    report.period_q8 = period_q8;
+    report.period_found = (period_q8 != 0U) ? 1U : 0U;
+    if (period_q8 != 0U)
+    {
+        report.freq_hz = (uint32_t)(((uint64_t)report.sample_rate_hz * 256U + period_q8 / 2U) / period_q8);
+    }
+    if (as->signal_max >= as->signal_min)
+    {
+        report.signal_min = as->signal_min;
+        report.signal_max = as->signal_max;
+        report.trigger_level = (uint16_t)(((uint32_t)as->signal_min + as->signal_max) / 2U);
+    }
+    report.rates_tried = (uint8_t)(as->rate_index + 1U);
+    report.elapsed_ms = now_ms - as->start_ms;
+
+    as->report = report;
+    as->report_pending = 1U;
+    as->state = SCOPE_AUTOSET_DONE;
+    if (result != NULL)
+    {
+        *result = report;
+    }
+}
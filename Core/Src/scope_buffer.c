@@ -1,6 +1,11 @@
 #include "scope_buffer.h"
 
 #include "scope.h"
+#include "scope_decim.h"
+#include "scope_filter.h"
+#include "scope_jitter.h"
+#include "scope_lockin.h"
+#include "scope_trigger.h"
 #include "main.h"
 
 enum
@@ -10,11 +15,16 @@ enum
 
 typedef struct
 {
-    uint8_t order[SCOPE_DMA_BUFFER_COUNT];
+    uint16_t *frame[SCOPE_DMA_BUFFER_COUNT];
+    uint32_t sequence[SCOPE_DMA_BUFFER_COUNT];
+    uint16_t trigger_index[SCOPE_DMA_BUFFER_COUNT];
     uint8_t head;
     uint8_t tail;
     uint8_t pending;
     uint32_t overruns;
+    uint32_t next_sequence;
+    uint32_t last_sequence;
+    uint16_t last_trigger_index;
 } ScopeDmaFrameQueue;
 
 static ScopeDmaFrameQueue scope_dma_queue = {0};
@@ -27,11 +37,32 @@ void ScopeBuffer_Init(void)
     scope_dma_queue.tail = 0U;
     scope_dma_queue.pending = 0U;
     scope_dma_queue.overruns = 0U;
+    scope_dma_queue.next_sequence = 0U;
+    scope_dma_queue.last_sequence = 0U;
+    scope_dma_queue.last_trigger_index = SCOPE_TRIGGER_NO_EVENT;
     scope_frame_ready = 0U;
 }
 
 void ScopeBuffer_EnqueueFromISR(uint8_t buffer_index)
 {
+    ScopeLockin_ProcessFromISR(adc_dma_buf[buffer_index], SCOPE_FRAME_SAMPLES, buffer_index);
+    ScopeJitter_ProcessFromISR(adc_dma_buf[buffer_index], SCOPE_FRAME_SAMPLES);
+
+    /* With decimation on, the half-buffer is consumed here so no input block is
+       ever skipped; only completed decimated frames enter the queue. */
+    uint16_t *frame = ScopeDecim_ProcessFromISR(adc_dma_buf[buffer_index], SCOPE_FRAME_SAMPLES);
+    if (frame == NULL)
+    {
+        return;
+    }
+    ScopeFilter_ProcessFromISR(frame, SCOPE_FRAME_SAMPLES);
+    /* Qualified before the queue, so an overrun cannot hide an event from
+       the trigger; the main loop only gets the event position. It runs on
+       the filtered samples, the trace that is shown, so a glitch the filter
+       removed never fires it. */
+    uint16_t trigger_index = ScopeTrigger_ProcessFromISR(frame, SCOPE_FRAME_SAMPLES);
+    Scope_RecordFrameFromISR(frame, SCOPE_FRAME_SAMPLES, scope_dma_queue.next_sequence, trigger_index);
+
     if (scope_dma_queue.pending == SCOPE_DMA_BUFFER_COUNT)
     {
         scope_dma_queue.tail = (uint8_t)((scope_dma_queue.tail + 1U) % SCOPE_DMA_BUFFER_COUNT);
@@ -39,7 +70,9 @@ void ScopeBuffer_EnqueueFromISR(uint8_t buffer_index)
         scope_dma_queue.overruns++;
     }
 
-    scope_dma_queue.order[scope_dma_queue.head] = buffer_index;
+    scope_dma_queue.frame[scope_dma_queue.head] = frame;
+    scope_dma_queue.sequence[scope_dma_queue.head] = scope_dma_queue.next_sequence++;
+    scope_dma_queue.trigger_index[scope_dma_queue.head] = trigger_index;
     scope_dma_queue.head = (uint8_t)((scope_dma_queue.head + 1U) % SCOPE_DMA_BUFFER_COUNT);
     scope_dma_queue.pending++;
     scope_frame_ready = 1U;
@@ -53,10 +86,11 @@ uint16_t *ScopeBuffer_Dequeue(uint16_t *frame_samples)
 
     if (scope_dma_queue.pending > 0U)
     {
-        uint8_t buffer_index = scope_dma_queue.order[scope_dma_queue.tail];
+        buffer = scope_dma_queue.frame[scope_dma_queue.tail];
+        scope_dma_queue.last_sequence = scope_dma_queue.sequence[scope_dma_queue.tail];
+        scope_dma_queue.last_trigger_index = scope_dma_queue.trigger_index[scope_dma_queue.tail];
         scope_dma_queue.tail = (uint8_t)((scope_dma_queue.tail + 1U) % SCOPE_DMA_BUFFER_COUNT);
         scope_dma_queue.pending--;
-        buffer = adc_dma_buf[buffer_index];
     }
 
     if (scope_dma_queue.pending == 0U)
@@ -90,6 +124,29 @@ uint32_t ScopeBuffer_GetOverrunCount(void)
     return count;
 }
 
+uint32_t ScopeBuffer_GetLastSequence(void)
+{
+    return scope_dma_queue.last_sequence;
+}
+
+uint16_t ScopeBuffer_GetLastTriggerIndex(void)
+{
+    return scope_dma_queue.last_trigger_index;
+}
+
+uint32_t ScopeBuffer_GetNextSequence(void)
+{
+    uint32_t sequence;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    sequence = scope_dma_queue.next_sequence;
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+    return sequence;
+}
+
 uint8_t ScopeBuffer_HasPending(void)
 {
     return scope_frame_ready;
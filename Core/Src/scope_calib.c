@@ -0,0 +1,337 @@
+#include "scope_calib.h"
+
+#include "adc.h"
+#include "main.h"
+#include "scope_settings.h"
+#include "scope_signal.h"
+
+#include <string.h>
+
+enum
+{
+    CALIB_ADC_MAX_COUNTS = 4095U,
+    CALIB_NOMINAL_VDDA_MV = 3300U,
+    CALIB_FACTORY_VREF_MV = 3300U,
+    CALIB_VDDA_MIN_MV = 1700U,
+    CALIB_VDDA_MAX_MV = 3600U,
+    CALIB_GAIN_UNITY_Q16 = 65536U,
+    CALIB_GAIN_MIN_Q16 = 49152U,
+    CALIB_GAIN_MAX_Q16 = 81920U,
+    CALIB_GAIN_MIN_SPAN_COUNTS = 400U,
+    CALIB_OFFSET_LIMIT_COUNTS = 256U,
+    CALIB_BOOT_CONVERSIONS = 8U,
+    CALIB_REFRESH_INTERVAL_MS = 1000U,
+    /* 480 sampling cycles keep VREFINT above its 10 us minimum sampling time
+       for any ADC clock up to 36 MHz; 12 more cycles for the conversion. */
+    CALIB_INJECTED_ADC_CYCLES = 480U + 12U,
+    /* A triggered regular conversion (3 + 12 cycles) plus margin for the
+       instructions between reading the timer and starting the conversion. */
+    CALIB_REGULAR_GUARD_ADC_CYCLES = 64U
+};
+
+/* VREFINT raw reading taken in production at 30 degC with VDDA = 3.3 V. */
+#define CALIB_VREFINT_FACTORY_ADDR ((const uint16_t *)0x1FFF7A2AU)
+
+typedef struct
+{
+    uint16_t vrefint_factory;
+    uint16_t vrefint_counts;
+    uint32_t vdda_millivolt;
+    int16_t offset_counts;
+    uint32_t gain_q16;
+    uint32_t scale_q16;
+    uint32_t inverse_q16;
+    uint32_t last_refresh_ms;
+    uint32_t refresh_count;
+    uint8_t conversion_pending;
+    uint8_t refresh_active;
+} ScopeCalibModule;
+
+static ScopeCalibModule scope_calib_module;
+
+static void ScopeCalib_ConfigureInjected(void);
+static void ScopeCalib_MeasureAtBoot(void);
+static void ScopeCalib_ApplyVrefint(uint16_t vrefint_counts);
+static void ScopeCalib_UpdateScale(void);
+static uint8_t ScopeCalib_StartInWindow(uint8_t acquisition_paused);
+
+void ScopeCalib_Init(void)
+{
+    memset(&scope_calib_module, 0, sizeof(scope_calib_module));
+    scope_calib_module.vdda_millivolt = CALIB_NOMINAL_VDDA_MV;
+    scope_calib_module.gain_q16 = CALIB_GAIN_UNITY_Q16;
+
+    uint16_t factory = *CALIB_VREFINT_FACTORY_ADDR;
+    if (factory != 0U && factory < CALIB_ADC_MAX_COUNTS)
+    {
+        scope_calib_module.vrefint_factory = factory;
+    }
+
+    ScopeCalib_ConfigureInjected();
+    ScopeCalib_MeasureAtBoot();
+    ScopeCalib_UpdateScale();
+}
+
+void ScopeCalib_Service(uint32_t now_ms, uint8_t acquisition_paused)
+{
+    if (scope_calib_module.conversion_pending)
+    {
+        if (!__HAL_ADC_GET_FLAG(&hadc1, ADC_FLAG_JEOC))
+        {
+            return;
+        }
+        uint16_t raw = (uint16_t)HAL_ADCEx_InjectedGetValue(&hadc1, ADC_INJECTED_RANK_1);
+        scope_calib_module.conversion_pending = 0U;
+        scope_calib_module.last_refresh_ms = now_ms;
+        scope_calib_module.refresh_count++;
+        /* Quarter-weight smoothing: one noisy reading moves the scale by little. */
+        int32_t delta = (int32_t)raw - (int32_t)scope_calib_module.vrefint_counts;
+        ScopeCalib_ApplyVrefint((uint16_t)((int32_t)scope_calib_module.vrefint_counts + delta / 4));
+        return;
+    }
+
+    if ((uint32_t)(now_ms - scope_calib_module.last_refresh_ms) < CALIB_REFRESH_INTERVAL_MS ||
+        scope_calib_module.vrefint_factory == 0U)
+    {
+        return;
+    }
+
+    scope_calib_module.conversion_pending = ScopeCalib_StartInWindow(acquisition_paused);
+}
+
+void ScopeCalib_GetStatus(ScopeCalibStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    status->vdda_millivolt = scope_calib_module.vdda_millivolt;
+    status->vrefint_counts = scope_calib_module.vrefint_counts;
+    status->vrefint_factory_counts = scope_calib_module.vrefint_factory;
+    status->offset_counts = scope_calib_module.offset_counts;
+    status->gain_q16 = scope_calib_module.gain_q16;
+    status->scale_q16 = scope_calib_module.scale_q16;
+    status->refresh_count = scope_calib_module.refresh_count;
+    status->refresh_active = scope_calib_module.refresh_active;
+    status->stored = ScopeSettings_IsSaved();
+}
+
+uint32_t ScopeCalib_CountsToMillivolt(uint32_t counts)
+{
+    int32_t corrected = (int32_t)counts - scope_calib_module.offset_counts;
+    if (corrected <= 0)
+    {
+        return 0U;
+    }
+    return ScopeCalib_SpanToMillivolt((uint32_t)corrected);
+}
+
+uint32_t ScopeCalib_SpanToMillivolt(uint32_t counts)
+{
+    return (uint32_t)(((uint64_t)counts * scope_calib_module.scale_q16 + 0x8000U) >> 16);
+}
+
+uint16_t ScopeCalib_MillivoltToCounts(uint32_t millivolt)
+{
+    int32_t counts = (int32_t)ScopeCalib_MillivoltToSpan(millivolt) + scope_calib_module.offset_counts;
+    if (counts < 0)
+    {
+        counts = 0;
+    }
+    else if (counts > (int32_t)CALIB_ADC_MAX_COUNTS)
+    {
+        counts = (int32_t)CALIB_ADC_MAX_COUNTS;
+    }
+    return (uint16_t)counts;
+}
+
+uint16_t ScopeCalib_MillivoltToSpan(uint32_t millivolt)
+{
+    uint64_t counts = ((uint64_t)millivolt * scope_calib_module.inverse_q16 + 0x8000U) >> 16;
+    return (counts > CALIB_ADC_MAX_COUNTS) ? (uint16_t)CALIB_ADC_MAX_COUNTS : (uint16_t)counts;
+}
+
+int16_t ScopeCalib_OffsetCounts(void)
+{
+    return scope_calib_module.offset_counts;
+}
+
+uint8_t ScopeCalib_SetZero(uint16_t mean_counts)
+{
+    if (mean_counts > CALIB_OFFSET_LIMIT_COUNTS)
+    {
+        return 0U;
+    }
+    scope_calib_module.offset_counts = (int16_t)mean_counts;
+    return 1U;
+}
+
+uint8_t ScopeCalib_SetGain(uint16_t mean_counts, uint32_t millivolt)
+{
+    int32_t span = (int32_t)mean_counts - scope_calib_module.offset_counts;
+    if (span < (int32_t)CALIB_GAIN_MIN_SPAN_COUNTS || millivolt == 0U)
+    {
+        return 0U;
+    }
+
+    /* gain = wanted / nominal, where nominal = span * VDDA / full scale. */
+    uint64_t gain = ((uint64_t)millivolt * CALIB_ADC_MAX_COUNTS << 16) /
+                    ((uint64_t)span * scope_calib_module.vdda_millivolt);
+    if (gain < CALIB_GAIN_MIN_Q16 || gain > CALIB_GAIN_MAX_Q16)
+    {
+        return 0U;
+    }
+    scope_calib_module.gain_q16 = (uint32_t)gain;
+    ScopeCalib_UpdateScale();
+    return 1U;
+}
+
+void ScopeCalib_ResetBoard(void)
+{
+    scope_calib_module.offset_counts = 0;
+    scope_calib_module.gain_q16 = CALIB_GAIN_UNITY_Q16;
+    ScopeCalib_UpdateScale();
+}
+
+uint8_t ScopeCalib_Restore(int16_t offset_counts, uint32_t gain_q16)
+{
+    if (offset_counts < 0 || offset_counts > (int16_t)CALIB_OFFSET_LIMIT_COUNTS ||
+        gain_q16 < CALIB_GAIN_MIN_Q16 || gain_q16 > CALIB_GAIN_MAX_Q16)
+    {
+        return 0U;
+    }
+    scope_calib_module.offset_counts = offset_counts;
+    scope_calib_module.gain_q16 = gain_q16;
+    ScopeCalib_UpdateScale();
+    return 1U;
+}
+
+/* Offset and gain are journalled with the other settings; this only skips
+   the wait for them to settle. */
+uint8_t ScopeCalib_Save(void)
+{
+    return ScopeSettings_Flush();
+}
+
+static void ScopeCalib_ConfigureInjected(void)
+{
+    ADC_InjectionConfTypeDef config = {0};
+    config.InjectedChannel = ADC_CHANNEL_VREFINT;
+    config.InjectedRank = ADC_INJECTED_RANK_1;
+    config.InjectedSamplingTime = ADC_SAMPLETIME_480CYCLES;
+    config.InjectedOffset = 0U;
+    config.InjectedNbrOfConversion = 1U;
+    config.InjectedDiscontinuousConvMode = DISABLE;
+    config.AutoInjectedConv = DISABLE;
+    config.ExternalTrigInjecConv = ADC_INJECTED_SOFTWARE_START;
+    config.ExternalTrigInjecConvEdge = ADC_EXTERNALTRIGINJECCONVEDGE_NONE;
+    if (HAL_ADCEx_InjectedConfigChannel(&hadc1, &config) != HAL_OK)
+    {
+        scope_calib_module.vrefint_factory = 0U;
+    }
+}
+
+static void ScopeCalib_MeasureAtBoot(void)
+{
+    if (scope_calib_module.vrefint_factory == 0U)
+    {
+        return;
+    }
+
+    /* Regular conversions are not running yet, so the injected group can be
+       polled back to back. The first reading covers the VREFINT start-up. */
+    uint32_t sum = 0U;
+    uint32_t taken = 0U;
+    for (uint32_t i = 0U; i <= CALIB_BOOT_CONVERSIONS; ++i)
+    {
+        if (HAL_ADCEx_InjectedStart(&hadc1) != HAL_OK ||
+            HAL_ADCEx_InjectedPollForConversion(&hadc1, 2U) != HAL_OK)
+        {
+            break;
+        }
+        uint32_t raw = HAL_ADCEx_InjectedGetValue(&hadc1, ADC_INJECTED_RANK_1);
+        if (i > 0U)
+        {
+            sum += raw;
+            taken++;
+        }
+    }
+
+    if (taken != 0U)
+    {
+        ScopeCalib_ApplyVrefint((uint16_t)((sum + taken / 2U) / taken));
+    }
+}
+
+static void ScopeCalib_ApplyVrefint(uint16_t vrefint_counts)
+{
+    if (vrefint_counts == 0U)
+    {
+        return;
+    }
+    uint32_t vdda = (CALIB_FACTORY_VREF_MV * (uint32_t)scope_calib_module.vrefint_factory +
+                     vrefint_counts / 2U) / vrefint_counts;
+    if (vdda < CALIB_VDDA_MIN_MV || vdda > CALIB_VDDA_MAX_MV)
+    {
+        return;
+    }
+    scope_calib_module.vrefint_counts = vrefint_counts;
+    scope_calib_module.vdda_millivolt = vdda;
+    ScopeCalib_UpdateScale();
+}
+
+static void ScopeCalib_UpdateScale(void)
+{
+    /* mV per count and counts per mV, both Q16, so every conversion is one
+       multiply and a shift. */
+    uint64_t full_scale_q16 = (uint64_t)scope_calib_module.vdda_millivolt * scope_calib_module.gain_q16;
+    scope_calib_module.scale_q16 = (uint32_t)((full_scale_q16 + CALIB_ADC_MAX_COUNTS / 2U) /
+                                              CALIB_ADC_MAX_COUNTS);
+    scope_calib_module.inverse_q16 = (uint32_t)((((uint64_t)CALIB_ADC_MAX_COUNTS << 32) +
+                                                 full_scale_q16 / 2U) / full_scale_q16);
+}
+
+static uint8_t ScopeCalib_StartInWindow(uint8_t acquisition_paused)
+{
+    /* A software-started injected conversion delays any regular trigger that
+       lands while it runs, so it is only started right after a regular
+       conversion and only if it ends before the next TIM3 update. VREFINT
+       needs 10 us of sampling, 480 cycles at the 24 MHz ADC clock, so
+       above about 38 kHz it never fits; there the refresh waits for a
+       pause, when the one late sample lands in a frame nobody keeps. */
+    uint32_t adc_clk = HAL_RCC_GetPCLK2Freq() / 4U;
+    if (adc_clk == 0U)
+    {
+        return 0U;
+    }
+    uint32_t period_ticks = 0U;
+    uint32_t guard = ScopeSignal_TimeToTimerTicks(
+        (uint32_t)((CALIB_REGULAR_GUARD_ADC_CYCLES * 1000000000ULL) / adc_clk), &period_ticks);
+    uint32_t busy = ScopeSignal_TimeToTimerTicks(
+        (uint32_t)((CALIB_INJECTED_ADC_CYCLES * 1000000000ULL) / adc_clk), NULL);
+
+    scope_calib_module.refresh_active = (uint8_t)(guard + busy + guard < period_ticks);
+    if (!scope_calib_module.refresh_active)
+    {
+        if (acquisition_paused)
+        {
+            return (uint8_t)(HAL_ADCEx_InjectedStart(&hadc1) == HAL_OK);
+        }
+        scope_calib_module.last_refresh_ms = HAL_GetTick();
+        return 0U;
+    }
+
+    uint8_t started = 0U;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t count = ScopeSignal_GetTimerCount();
+    if (count >= guard && count + busy + guard < period_ticks)
+    {
+        started = (uint8_t)(HAL_ADCEx_InjectedStart(&hadc1) == HAL_OK);
+    }
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+    return started;
+}
@@ -0,0 +1,270 @@
+#include "scope_decode.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum
+{
+    DECODE_DATA_BITS = 8U,
+    DECODE_STOP_BIT_INDEX = DECODE_DATA_BITS + 1U,
+    DECODE_STREAM_DEPTH = 64U
+};
+
+typedef struct
+{
+    uint32_t baud;
+    uint8_t synced;
+    uint8_t level;
+    uint8_t in_byte;
+    uint8_t bit_index;
+    uint8_t shift;
+    int32_t start_q8;
+    uint32_t bytes;
+    uint32_t framing_errors;
+    uint32_t resyncs;
+    uint32_t stream_drops;
+    uint8_t rate_ok;
+    ScopeDecodeByte stream[DECODE_STREAM_DEPTH];
+    uint8_t stream_head;
+    uint8_t stream_tail;
+} ScopeDecodeModule;
+
+static ScopeDecodeModule scope_decode_module;
+
+static void ScopeDecode_Resync(void);
+static void ScopeDecode_StartByte(int32_t start_q8);
+static void ScopeDecode_EmitByte(uint8_t framing_error, int32_t stop_q8, uint16_t count,
+                                 ScopeDecodeFrame *out);
+static uint16_t ScopeDecode_ClampIndex(int32_t position_q8, uint16_t count);
+
+void ScopeDecode_Init(void)
+{
+    memset(&scope_decode_module, 0, sizeof(scope_decode_module));
+    scope_decode_module.level = 1U;
+}
+
+uint8_t ScopeDecode_Configure(uint32_t baud)
+{
+    scope_decode_module.baud = baud;
+    scope_decode_module.bytes = 0U;
+    scope_decode_module.framing_errors = 0U;
+    scope_decode_module.resyncs = 0U;
+    scope_decode_module.stream_drops = 0U;
+    scope_decode_module.stream_head = 0U;
+    scope_decode_module.stream_tail = 0U;
+    ScopeDecode_Resync();
+    return 1U;
+}
+
+uint8_t ScopeDecode_IsEnabled(void)
+{
+    return (scope_decode_module.baud != 0U) ? 1U : 0U;
+}
+
+void ScopeDecode_GetStatus(ScopeDecodeStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    status->baud = scope_decode_module.baud;
+    status->bytes = scope_decode_module.bytes;
+    status->framing_errors = scope_decode_module.framing_errors;
+    status->resyncs = scope_decode_module.resyncs;
+    status->stream_drops = scope_decode_module.stream_drops;
+    status->rate_ok = scope_decode_module.rate_ok;
+}
+
+void ScopeDecode_Process(const ScopeSignalCrossings *crossings,
+                         uint16_t count,
+                         uint8_t levels_valid,
+                         uint8_t contiguous,
+                         uint32_t sample_rate_hz,
+                         ScopeDecodeFrame *out)
+{
+    ScopeDecodeModule *dec = &scope_decode_module;
+    if (out != NULL)
+    {
+        out->count = 0U;
+    }
+    if (dec->baud == 0U || crossings == NULL || count == 0U)
+    {
+        return;
+    }
+
+    dec->rate_ok = ((uint64_t)dec->baud * SCOPE_DECODE_MIN_SAMPLES_PER_BIT <= sample_rate_hz) ? 1U : 0U;
+    if (!dec->rate_ok)
+    {
+        dec->synced = 0U;
+        dec->in_byte = 0U;
+        return;
+    }
+
+    if (!contiguous || crossings->truncated)
+    {
+        ScopeDecode_Resync();
+    }
+
+    const int32_t bit_q8 = (int32_t)(((uint64_t)sample_rate_hz << 8) / dec->baud);
+    const int32_t end_q8 = (int32_t)count << 8;
+    const ScopeSignalCrossing *edges = crossings->edges;
+    const uint16_t edge_count = levels_valid ? crossings->count : 0U;
+
+    /* The crossing list starts from the level of the first sample, so a transition
+       that fell between two half-buffers shows up as a level mismatch here. */
+    if (!dec->synced)
+    {
+        dec->level = levels_valid ? crossings->initial_high : 1U;
+        dec->synced = 1U;
+    }
+    else if (levels_valid && crossings->initial_high != dec->level)
+    {
+        dec->level = crossings->initial_high;
+        if (!dec->level && !dec->in_byte)
+        {
+            ScopeDecode_StartByte(0);
+        }
+    }
+
+    uint16_t e = 0U;
+    for (;;)
+    {
+        if (dec->in_byte)
+        {
+            int32_t sample_q8 = dec->start_q8 + (int32_t)dec->bit_index * bit_q8 + bit_q8 / 2;
+            if (sample_q8 >= end_q8)
+            {
+                break;
+            }
+            while (e < edge_count && (int32_t)edges[e].position_q8 <= sample_q8)
+            {
+                dec->level = edges[e].rising;
+                e++;
+            }
+
+            if (dec->bit_index == 0U)
+            {
+                if (dec->level)
+                {
+                    dec->in_byte = 0U;
+                    continue;
+                }
+            }
+            else if (dec->bit_index <= DECODE_DATA_BITS)
+            {
+                if (dec->level)
+                {
+                    dec->shift |= (uint8_t)(1U << (dec->bit_index - 1U));
+                }
+            }
+            else
+            {
+                ScopeDecode_EmitByte(dec->level ? 0U : 1U, sample_q8, count, out);
+                dec->in_byte = 0U;
+                continue;
+            }
+            dec->bit_index++;
+        }
+        else
+        {
+            while (e < edge_count && edges[e].rising)
+            {
+                dec->level = 1U;
+                e++;
+            }
+            if (e >= edge_count)
+            {
+                break;
+            }
+            dec->level = 0U;
+            ScopeDecode_StartByte((int32_t)edges[e].position_q8);
+            e++;
+        }
+    }
+
+    if (edge_count > 0U)
+    {
+        dec->level = edges[edge_count - 1U].rising;
+    }
+    if (dec->in_byte)
+    {
+        dec->start_q8 -= end_q8;
+    }
+}
+
+uint8_t ScopeDecode_PopStream(ScopeDecodeByte *byte)
+{
+    ScopeDecodeModule *dec = &scope_decode_module;
+    if (byte == NULL || dec->stream_tail == dec->stream_head)
+    {
+        return 0U;
+    }
+    *byte = dec->stream[dec->stream_tail];
+    dec->stream_tail = (uint8_t)((dec->stream_tail + 1U) % DECODE_STREAM_DEPTH);
+    return 1U;
+}
+
+static void ScopeDecode_Resync(void)
+{
+    if (scope_decode_module.synced)
+    {
+        scope_decode_module.resyncs++;
+    }
+    scope_decode_module.synced = 0U;
+    scope_decode_module.in_byte = 0U;
+    scope_decode_module.level = 1U;
+}
+
+static void ScopeDecode_StartByte(int32_t start_q8)
+{
+    scope_decode_module.in_byte = 1U;
+    scope_decode_module.bit_index = 0U;
+    scope_decode_module.shift = 0U;
+    scope_decode_module.start_q8 = start_q8;
+}
+
+static void ScopeDecode_EmitByte(uint8_t framing_error, int32_t stop_q8, uint16_t count,
+                                 ScopeDecodeFrame *out)
+{
+    ScopeDecodeModule *dec = &scope_decode_module;
+    ScopeDecodeByte byte = {
+        .value = dec->shift,
+        .framing_error = framing_error,
+        .start_index = ScopeDecode_ClampIndex(dec->start_q8, count),
+        .stop_index = ScopeDecode_ClampIndex(stop_q8, count)
+    };
+
+    dec->bytes++;
+    if (framing_error)
+    {
+        dec->framing_errors++;
+    }
+
+    if (out != NULL && out->count < SCOPE_DECODE_MAX_FRAME_BYTES)
+    {
+        out->bytes[out->count++] = byte;
+    }
+
+    uint8_t next_head = (uint8_t)((dec->stream_head + 1U) % DECODE_STREAM_DEPTH);
+    if (next_head == dec->stream_tail)
+    {
+        dec->stream_drops++;
+        return;
+    }
+    dec->stream[dec->stream_head] = byte;
+    dec->stream_head = next_head;
+}
+
+static uint16_t ScopeDecode_ClampIndex(int32_t position_q8, uint16_t count)
+{
+    if (position_q8 <= 0)
+    {
+        return 0U;
+    }
+    int32_t index = position_q8 >> 8;
+    if (index >= (int32_t)count)
+    {
+        index = (int32_t)count - 1;
+    }
+    return (uint16_t)index;
+}
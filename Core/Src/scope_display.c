@@ -2,6 +2,9 @@
 
 #include "scope.h"
 #include "ili9341.h"
+#include "scope_calib.h"
+#include "scope_interp.h"
+#include "scope_profile.h"
 #include "scope_signal.h"
 
 #include <stdio.h>
@@ -19,10 +22,96 @@ static uint16_t last_y_max[SCOPE_FRAME_SAMPLES];
 static uint16_t scope_column_buf[ILI9341_HEIGHT];
 static uint8_t first_draw = 1U;
 
+enum { WAVEFORM_MAX_SKIP_TOLERANCE_PX = 8U };
+
+/* Unclipped trace rows as last sent to the panel, so a redraw can be skipped
+   when the new frame lands on (nearly) the same pixels. Compared against what
+   is on screen, not the previous frame, so skipped frames never accumulate
+   more than the tolerance. */
+typedef struct
+{
+    int32_t y[SCOPE_FRAME_SAMPLES];
+    uint16_t width;
+    uint8_t had_cursors;
+    uint8_t tolerance_px;
+    uint32_t drawn;
+    uint32_t skipped;
+} ScopeDisplayWaveformCache;
+
+static ScopeDisplayWaveformCache waveform_cache = {.tolerance_px = 1U};
+
+typedef struct
+{
+    uint8_t valid;
+    uint16_t draw_width;
+    uint32_t samples_visible;
+    uint32_t span_counts;
+    int32_t center_counts;
+    /* 16.16 record position of every column from the left edge of the window. */
+    uint32_t column_pos_q16[SCOPE_FRAME_SAMPLES];
+    /* y = y_bottom - (sample - window_lower) * y_scale_q32 / 2^32. */
+    int32_t window_lower;
+    int32_t y_bottom;
+    uint64_t y_scale_q32;
+    uint32_t plan_cycles;
+    uint32_t map_cycles;
+    uint32_t max_map_cycles;
+} ScopeDisplayMapPlan;
+
+static ScopeDisplayMapPlan waveform_plan;
+
+#define REFERENCE_COLOR ILI9341_GREEN
+
+/* Rows covered by the reference trace in each column; empty columns have
+   y_min > y_max. The y_last row of the previous column joins neighbours
+   into a continuous line. */
+typedef struct
+{
+    uint8_t active;
+    uint8_t visible;
+    uint16_t width;
+    uint16_t count;
+    uint32_t visible_samples;
+    int32_t start;
+    int32_t window_lower;
+    int32_t span;
+    uint16_t y_min[SCOPE_FRAME_SAMPLES];
+    uint16_t y_max[SCOPE_FRAME_SAMPLES];
+    uint16_t y_last[SCOPE_FRAME_SAMPLES];
+} ScopeDisplayReference;
+
+static ScopeDisplayReference reference_trace = {.visible = 1U};
+
+enum
+{
+    ANNOTATION_TOP_MARGIN = 2U,
+    ANNOTATION_HEIGHT = 8U,
+    ANNOTATION_CHAR_WIDTH = 6U,
+    ANNOTATION_GAP = 2U
+};
+
+static uint16_t annotation_last_x[SCOPE_DISPLAY_MAX_ANNOTATIONS];
+static uint16_t annotation_last_width[SCOPE_DISPLAY_MAX_ANNOTATIONS];
+static uint8_t annotation_last_count = 0U;
+static uint16_t histogram_last_length[ILI9341_HEIGHT];
+static uint8_t eye_last_shade[SCOPE_EYE_ROWS][SCOPE_EYE_COLUMNS];
+static uint32_t eye_last_generation = 0U;
+static uint8_t bode_drawn = 0U;
+static uint32_t bode_last_sweep = 0U;
+static uint16_t jitter_last_height[SCOPE_JITTER_BINS];
+static uint16_t jitter_trend_last_y0[SCOPE_JITTER_TREND_POINTS];
+static uint16_t jitter_trend_last_y1[SCOPE_JITTER_TREND_POINTS];
+static uint32_t jitter_last_generation = 0U;
+
 typedef enum
 {
     SCOPE_DISPLAY_INFO_MODE_NONE = 0,
     SCOPE_DISPLAY_INFO_MODE_MEASUREMENTS,
+    SCOPE_DISPLAY_INFO_MODE_STATISTICS,
+    SCOPE_DISPLAY_INFO_MODE_HISTOGRAM,
+    SCOPE_DISPLAY_INFO_MODE_EYE,
+    SCOPE_DISPLAY_INFO_MODE_BODE,
+    SCOPE_DISPLAY_INFO_MODE_JITTER,
     SCOPE_DISPLAY_INFO_MODE_CURSOR
 } ScopeDisplayInfoMode;
 
@@ -45,12 +134,46 @@ static inline uint16_t ScopeDisplay_WaveformHeight(void)
 }
 
 static uint16_t ScopeDisplay_BackgroundColor(uint16_t x, uint16_t y);
-static int32_t ScopeDisplay_SampleToY(const ScopeDisplaySettings *settings, int32_t sample);
+static void ScopeDisplay_UpdateMapPlan(const ScopeDisplaySettings *settings,
+                                       uint32_t visible_samples,
+                                       uint16_t draw_width);
+static uint16_t ScopeDisplay_MapWindow(const ScopeDisplaySettings *settings,
+                                       uint16_t count,
+                                       uint16_t visible_samples,
+                                       uint16_t trigger_index,
+                                       uint16_t *column_sample_map);
+static void ScopeDisplay_PaintTrace(const int32_t *y_top,
+                                    const int32_t *y_bottom,
+                                    uint16_t draw_width,
+                                    const ScopeDisplayCursorRenderInfo *cursor_info);
+static int32_t ScopeDisplay_CountsToY(int32_t sample);
 static uint8_t ScopeDisplay_ClipWaveformSegment(int32_t *y0, int32_t *y1);
+static void ScopeDisplay_PaintReference(void);
+static uint8_t ScopeDisplay_WaveformUnchanged(const int32_t *new_y, uint16_t width);
 static void ScopeDisplay_EraseColumn(uint16_t x, uint16_t y0, uint16_t y1);
 static void ScopeDisplay_DrawColumn(uint16_t x, uint16_t y0, uint16_t y1);
 static void ScopeDisplay_DrawCursorLine(uint16_t x, uint16_t color);
-static void ScopeDisplay_UpdateMeasurements(uint16_t vmin, uint16_t vmax, uint32_t freq_hz);
+static void ScopeDisplay_RestoreRegion(uint16_t x, uint16_t width, uint16_t y, uint16_t height);
+static void ScopeDisplay_EraseRow(uint16_t y, uint16_t x, uint16_t width);
+static void ScopeDisplay_UpdateHistogramInfo(const ScopeHistogramSummary *summary);
+static uint32_t ScopeDisplay_CountsToMillivoltF(float counts);
+static uint8_t ScopeDisplay_EyeShade(uint8_t hits);
+static void ScopeDisplay_UpdateEyeInfo(const ScopeEyeStatus *status);
+static void ScopeDisplay_DrawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+static void ScopeDisplay_BodePoint(const ScopeFraPoint *point, uint8_t index, uint8_t count,
+                                   int32_t *x, int32_t *y_gain, int32_t *y_phase);
+static void ScopeDisplay_UpdateBodeInfo(const ScopeFraPoint *points, const ScopeFraStatus *status);
+static void ScopeDisplay_FormatTenths(char *buf, size_t len, float value);
+static void ScopeDisplay_DrawJitterTrend(const float *trend_ns, uint16_t trend_count, uint16_t top, uint16_t height);
+static void ScopeDisplay_UpdateJitterInfo(const ScopeJitterStatus *status);
+static int32_t ScopeDisplay_FindSampleColumn(const uint16_t *column_sample_map,
+                                             uint16_t first_sample,
+                                             uint16_t last_sample);
+static void ScopeDisplay_UpdateMeasurements(const ScopeMeasureResult *result);
+static void ScopeDisplay_FormatMeasurement(char *buf, size_t len, ScopeMeasureId id,
+                                           const ScopeMeasureResult *result);
+static void ScopeDisplay_FormatValue(char *buf, size_t len, ScopeMeasureId id, int32_t value);
+static void ScopeDisplay_FormatFrequency(char *buf, size_t len, uint32_t freq_hz);
 static void ScopeDisplay_UpdateInfoLine(uint16_t x, uint16_t y, const char *text,
                                         uint16_t color, char *last_text, size_t buf_len);
 static int64_t ScopeDisplay_SamplesToTimeNs(int32_t sample_index, uint32_t sample_rate_hz);
@@ -70,6 +193,7 @@ void ScopeDisplay_Init(const ScopeDisplayConfig *cfg)
 
     scope_display_module.cfg = *cfg;
     scope_display_module.initialized = 1U;
+    waveform_plan.valid = 0U;
     first_draw = 1U;
     scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_NONE;
     ScopeDisplay_ClearMeasurementInfoCache();
@@ -112,73 +236,216 @@ void ScopeDisplay_DrawGrid(void)
         last_y_max[x] = mid;
     }
 
+    ScopeDisplay_PaintReference();
+
+    annotation_last_count = 0U;
+    memset(histogram_last_length, 0, sizeof(histogram_last_length));
+    memset(eye_last_shade, 0, sizeof(eye_last_shade));
+    scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_NONE;
     first_draw = 1U;
 }
 
-void ScopeDisplay_DrawWaveform(const ScopeDisplaySettings *settings,
-                               uint16_t *samples,
-                               uint16_t count,
-                               uint16_t visible_samples,
-                               uint16_t trigger_index,
-                               const ScopeDisplayCursorRenderInfo *cursor_info,
-                               uint16_t *column_sample_map)
+uint16_t ScopeDisplay_MapColumns(const ScopeDisplaySettings *settings,
+                                 uint16_t count,
+                                 uint16_t visible_samples,
+                                 uint16_t trigger_index,
+                                 uint16_t *column_sample_map)
 {
     if (!scope_display_module.initialized ||
         settings == NULL ||
-        samples == NULL ||
+        column_sample_map == NULL ||
         count == 0U ||
         visible_samples == 0U)
     {
-        return;
+        return 0U;
     }
 
     if (count > scope_display_module.cfg.frame_samples)
     {
         count = scope_display_module.cfg.frame_samples;
     }
+    if (visible_samples > count)
+    {
+        visible_samples = count;
+    }
     if (trigger_index >= count)
     {
         trigger_index = 0U;
     }
+    return ScopeDisplay_MapWindow(settings, count, visible_samples, trigger_index, column_sample_map);
+}
 
-    int32_t center_sample = settings->horizontal.center_sample;
-    int32_t start_offset = (int32_t)trigger_index - center_sample;
-    int32_t samples_in_frame = (int32_t)count;
-
+static uint16_t ScopeDisplay_MapWindow(const ScopeDisplaySettings *settings,
+                                       uint16_t count,
+                                       uint16_t visible_samples,
+                                       uint16_t trigger_index,
+                                       uint16_t *column_sample_map)
+{
     uint16_t draw_width = scope_display_module.cfg.frame_samples;
     if (draw_width > ILI9341_WIDTH)
     {
         draw_width = ILI9341_WIDTH;
     }
+    ScopeDisplay_UpdateMapPlan(settings, visible_samples, draw_width);
+
+    /* One modulo per frame; every column then lies less than one record
+       past the window start, so a single subtraction wraps it. */
+    int32_t start = ((int32_t)trigger_index - settings->horizontal.center_sample) % (int32_t)count;
+    if (start < 0)
+    {
+        start += (int32_t)count;
+    }
+    const uint32_t *column_pos = waveform_plan.column_pos_q16;
+    for (uint16_t i = 0; i < draw_width; i++)
+    {
+        uint32_t idx = (uint32_t)start + (column_pos[i] >> 16);
+        if (idx >= count)
+        {
+            idx -= count;
+        }
+        column_sample_map[i] = (uint16_t)idx;
+    }
+    return draw_width;
+}
+
+void ScopeDisplay_DrawWaveform(const ScopeDisplaySettings *settings,
+                               uint16_t *samples,
+                               uint16_t count,
+                               uint16_t visible_samples,
+                               uint16_t trigger_index,
+                               const ScopeDisplayCursorRenderInfo *cursor_info,
+                               uint16_t *column_sample_map)
+{
+    if (samples == NULL)
+    {
+        return;
+    }
+
+    uint32_t map_start = ScopeProfile_CycleCount();
+    uint16_t local_map[SCOPE_FRAME_SAMPLES];
+    uint16_t *map = (column_sample_map != NULL) ? column_sample_map : local_map;
+    uint16_t draw_width = ScopeDisplay_MapColumns(settings, count, visible_samples, trigger_index, map);
     if (draw_width == 0U)
     {
         return;
     }
 
+    if (count > scope_display_module.cfg.frame_samples)
+    {
+        count = scope_display_module.cfg.frame_samples;
+    }
+    /* Zoomed in past one sample per column, each column sits between two
+       samples; interpolating there costs the same per column whatever the
+       record length. */
+    uint8_t interpolate = (waveform_plan.samples_visible < draw_width &&
+                           ScopeInterp_GetMode() != SCOPE_INTERP_OFF) ? 1U : 0U;
+    const int32_t adc_max = (int32_t)scope_display_module.cfg.adc_max_counts;
+
     int32_t new_y[SCOPE_FRAME_SAMPLES];
     for (uint16_t i = 0; i < draw_width; i++)
     {
-        uint32_t scaled = ((uint32_t)i * visible_samples);
-        int32_t relative = start_offset + (int32_t)(scaled / draw_width);
-        int32_t wrapped = relative % samples_in_frame;
-        if (wrapped < 0)
-        {
-            wrapped += samples_in_frame;
-        }
-        uint16_t idx = (uint16_t)wrapped;
-
-        uint16_t val = samples[idx];
-        if (val > scope_display_module.cfg.adc_max_counts)
+        int32_t val = (int32_t)samples[map[i]];
+        if (interpolate)
         {
-            val = scope_display_module.cfg.adc_max_counts;
+            val = ScopeInterp_Sample(samples, count, map[i], waveform_plan.column_pos_q16[i] & 0xFFFFU);
+            if (val < 0)
+            {
+                val = 0;
+            }
         }
-        new_y[i] = ScopeDisplay_SampleToY(settings, (int32_t)val);
-        if (column_sample_map != NULL)
+        if (val > adc_max)
         {
-            column_sample_map[i] = idx;
+            val = adc_max;
         }
+        new_y[i] = ScopeDisplay_CountsToY(val);
+    }
+    waveform_plan.map_cycles = ScopeProfile_CycleCount() - map_start;
+    if (waveform_plan.map_cycles > waveform_plan.max_map_cycles)
+    {
+        waveform_plan.max_map_cycles = waveform_plan.map_cycles;
+    }
+
+    uint8_t has_cursors = (cursor_info != NULL && cursor_info->count > 0U) ? 1U : 0U;
+    if (!has_cursors && !waveform_cache.had_cursors && ScopeDisplay_WaveformUnchanged(new_y, draw_width))
+    {
+        waveform_cache.skipped++;
+        return;
+    }
+    memcpy(waveform_cache.y, new_y, (size_t)draw_width * sizeof(int32_t));
+    waveform_cache.width = draw_width;
+    waveform_cache.had_cursors = has_cursors;
+    waveform_cache.drawn++;
+
+    ScopeDisplay_PaintTrace(new_y, new_y, draw_width, cursor_info);
+}
+
+uint16_t ScopeDisplay_MapRecordColumns(const ScopeDisplaySettings *settings,
+                                       uint16_t length,
+                                       uint16_t visible_samples,
+                                       uint16_t trigger_index,
+                                       uint16_t *column_sample_map)
+{
+    if (!scope_display_module.initialized ||
+        settings == NULL ||
+        column_sample_map == NULL ||
+        length == 0U ||
+        visible_samples == 0U)
+    {
+        return 0U;
+    }
+    if (visible_samples > length)
+    {
+        visible_samples = length;
+    }
+    if (trigger_index >= length)
+    {
+        trigger_index = 0U;
     }
+    return ScopeDisplay_MapWindow(settings, length, visible_samples, trigger_index, column_sample_map);
+}
+
+void ScopeDisplay_DrawEnvelope(const ScopeDisplaySettings *settings,
+                               const uint16_t *column_min,
+                               const uint16_t *column_max,
+                               uint16_t columns,
+                               const ScopeDisplayCursorRenderInfo *cursor_info)
+{
+    if (!scope_display_module.initialized || settings == NULL ||
+        column_min == NULL || column_max == NULL || columns == 0U)
+    {
+        return;
+    }
+    if (columns > SCOPE_FRAME_SAMPLES)
+    {
+        columns = SCOPE_FRAME_SAMPLES;
+    }
+    ScopeDisplay_UpdateMapPlan(settings, waveform_plan.samples_visible, columns);
 
+    const int32_t adc_max = (int32_t)scope_display_module.cfg.adc_max_counts;
+    int32_t y_top[SCOPE_FRAME_SAMPLES];
+    int32_t y_bottom[SCOPE_FRAME_SAMPLES];
+    for (uint16_t i = 0; i < columns; i++)
+    {
+        int32_t high = (column_max[i] > adc_max) ? adc_max : (int32_t)column_max[i];
+        int32_t low = (column_min[i] > adc_max) ? adc_max : (int32_t)column_min[i];
+        y_top[i] = ScopeDisplay_CountsToY(high);
+        y_bottom[i] = ScopeDisplay_CountsToY(low);
+    }
+
+    /* Not comparable with a single-row trace: the next one redraws in full. */
+    waveform_cache.width = 0U;
+    waveform_cache.had_cursors = (cursor_info != NULL && cursor_info->count > 0U) ? 1U : 0U;
+    waveform_cache.drawn++;
+    ScopeDisplay_PaintTrace(y_top, y_bottom, columns, cursor_info);
+}
+
+/* Each column spans its own rows and reaches the nearer end of the previous
+   column's, so the trace stays connected; a plain trace has top == bottom. */
+static void ScopeDisplay_PaintTrace(const int32_t *y_top,
+                                    const int32_t *y_bottom,
+                                    uint16_t draw_width,
+                                    const ScopeDisplayCursorRenderInfo *cursor_info)
+{
     for (uint16_t x = 0; x < draw_width; x++)
     {
         if (!first_draw)
@@ -186,8 +453,19 @@ void ScopeDisplay_DrawWaveform(const ScopeDisplaySettings *settings,
             ScopeDisplay_EraseColumn(x, last_y_min[x], last_y_max[x]);
         }
 
-        int32_t y1 = new_y[x];
-        int32_t y0 = (x > 0) ? new_y[x - 1] : new_y[x];
+        int32_t y0 = y_top[x];
+        int32_t y1 = y_bottom[x];
+        if (x > 0U)
+        {
+            if (y_bottom[x - 1] < y0)
+            {
+                y0 = y_bottom[x - 1];
+            }
+            if (y_top[x - 1] > y1)
+            {
+                y1 = y_top[x - 1];
+            }
+        }
 
         uint16_t ymin_new = ScopeDisplay_InfoPanelHeight();
         uint16_t ymax_new = ScopeDisplay_InfoPanelHeight();
@@ -238,21 +516,327 @@ void ScopeDisplay_DrawWaveform(const ScopeDisplaySettings *settings,
     first_draw = 0U;
 }
 
-static int32_t ScopeDisplay_SampleToY(const ScopeDisplaySettings *settings, int32_t sample)
+void ScopeDisplay_SetRedrawTolerance(uint8_t tolerance_px)
+{
+    if (tolerance_px > WAVEFORM_MAX_SKIP_TOLERANCE_PX)
+    {
+        tolerance_px = WAVEFORM_MAX_SKIP_TOLERANCE_PX;
+    }
+    waveform_cache.tolerance_px = tolerance_px;
+}
+
+void ScopeDisplay_GetRedrawStats(ScopeDisplayRedrawStats *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+    stats->tolerance_px = waveform_cache.tolerance_px;
+    stats->drawn = waveform_cache.drawn;
+    stats->skipped = waveform_cache.skipped;
+    stats->plan_cycles = waveform_plan.plan_cycles;
+    stats->map_cycles = waveform_plan.map_cycles;
+    stats->max_map_cycles = waveform_plan.max_map_cycles;
+}
+
+void ScopeDisplay_ResetRedrawStats(void)
+{
+    waveform_cache.drawn = 0U;
+    waveform_cache.skipped = 0U;
+    waveform_plan.max_map_cycles = 0U;
+}
+
+void ScopeDisplay_BeginReference(const ScopeDisplaySettings *settings,
+                                 uint16_t count,
+                                 uint16_t trigger_index)
+{
+    ScopeDisplay_ClearReference();
+    if (!scope_display_module.initialized || settings == NULL || count == 0U)
+    {
+        reference_trace.count = 0U;
+        return;
+    }
+
+    if (count > scope_display_module.cfg.frame_samples)
+    {
+        count = scope_display_module.cfg.frame_samples;
+    }
+    if (trigger_index >= count)
+    {
+        trigger_index = 0U;
+    }
+    uint32_t visible = settings->horizontal.samples_visible;
+    if (visible == 0U || visible > count)
+    {
+        visible = count;
+    }
+    uint16_t width = scope_display_module.cfg.frame_samples;
+    if (width > ILI9341_WIDTH)
+    {
+        width = ILI9341_WIDTH;
+    }
+    int32_t start = ((int32_t)trigger_index - settings->horizontal.center_sample) % (int32_t)count;
+    if (start < 0)
+    {
+        start += (int32_t)count;
+    }
+    int32_t span = (int32_t)settings->vertical.span_counts;
+    if (span <= 0)
+    {
+        span = (int32_t)scope_display_module.cfg.adc_max_counts;
+    }
+
+    reference_trace.width = width;
+    reference_trace.count = count;
+    reference_trace.visible_samples = visible;
+    reference_trace.start = start;
+    reference_trace.window_lower = settings->vertical.center_counts - span / 2;
+    reference_trace.span = span;
+    for (uint16_t x = 0U; x < width; x++)
+    {
+        reference_trace.y_min[x] = UINT16_MAX;
+        reference_trace.y_max[x] = 0U;
+    }
+}
+
+/* Built once per recall or window change, so plain divisions are fine:
+   column i shows sample floor(i * visible / width), as in the live map. */
+void ScopeDisplay_AddReferenceSample(uint16_t index, uint16_t value)
+{
+    if (reference_trace.count == 0U || index >= reference_trace.count)
+    {
+        return;
+    }
+    int32_t relative = (int32_t)index - reference_trace.start;
+    if (relative < 0)
+    {
+        relative += (int32_t)reference_trace.count;
+    }
+    const uint32_t r = (uint32_t)relative;
+    const uint32_t visible = reference_trace.visible_samples;
+    const uint32_t width = reference_trace.width;
+    if (r >= visible)
+    {
+        return;
+    }
+
+    uint32_t first = (r * width + visible - 1U) / visible;
+    uint32_t last = ((r + 1U) * width + visible - 1U) / visible;
+    if (first >= last)
+    {
+        /* Zoomed out: several samples share a column and widen its range. */
+        first = (r * width) / visible;
+        last = first + 1U;
+    }
+    if (last > width)
+    {
+        last = width;
+    }
+
+    int32_t counts = (int32_t)value;
+    if (counts > (int32_t)scope_display_module.cfg.adc_max_counts)
+    {
+        counts = (int32_t)scope_display_module.cfg.adc_max_counts;
+    }
+    const int32_t waveform_height = (int32_t)ScopeDisplay_WaveformHeight();
+    int32_t y = (int32_t)ScopeDisplay_InfoPanelHeight() + (waveform_height - 1) -
+                ((counts - reference_trace.window_lower) * (waveform_height - 1)) / reference_trace.span;
+    if (y < 0)
+    {
+        y = 0;
+    }
+    else if (y > (int32_t)UINT16_MAX - 1)
+    {
+        y = (int32_t)UINT16_MAX - 1;
+    }
+
+    for (uint32_t x = first; x < last; x++)
+    {
+        if ((uint16_t)y < reference_trace.y_min[x])
+        {
+            reference_trace.y_min[x] = (uint16_t)y;
+        }
+        if ((uint16_t)y > reference_trace.y_max[x])
+        {
+            reference_trace.y_max[x] = (uint16_t)y;
+        }
+        reference_trace.y_last[x] = (uint16_t)y;
+    }
+}
+
+void ScopeDisplay_EndReference(void)
+{
+    if (reference_trace.count == 0U)
+    {
+        return;
+    }
+
+    const uint16_t top = ScopeDisplay_InfoPanelHeight();
+    const uint16_t bottom = ILI9341_HEIGHT - 1U;
+    uint8_t previous_valid = 0U;
+    uint16_t previous_last = 0U;
+    for (uint16_t x = 0U; x < reference_trace.width; x++)
+    {
+        uint16_t y_min = reference_trace.y_min[x];
+        uint16_t y_max = reference_trace.y_max[x];
+        uint8_t valid = (y_min <= y_max) ? 1U : 0U;
+        uint16_t last = reference_trace.y_last[x];
+        if (valid && previous_valid)
+        {
+            y_min = (previous_last < y_min) ? previous_last : y_min;
+            y_max = (previous_last > y_max) ? previous_last : y_max;
+        }
+        if (!valid || y_max < top || y_min > bottom)
+        {
+            y_min = 1U;
+            y_max = 0U;
+        }
+        else
+        {
+            y_min = (y_min < top) ? top : y_min;
+            y_max = (y_max > bottom) ? bottom : y_max;
+        }
+        reference_trace.y_min[x] = y_min;
+        reference_trace.y_max[x] = y_max;
+        previous_valid = valid;
+        previous_last = last;
+    }
+
+    reference_trace.active = 1U;
+    ScopeDisplay_PaintReference();
+}
+
+void ScopeDisplay_ClearReference(void)
+{
+    if (!reference_trace.active)
+    {
+        return;
+    }
+    reference_trace.active = 0U;
+    if (!reference_trace.visible)
+    {
+        return;
+    }
+    for (uint16_t x = 0U; x < reference_trace.width; x++)
+    {
+        if (reference_trace.y_min[x] <= reference_trace.y_max[x])
+        {
+            ScopeDisplay_EraseColumn(x, reference_trace.y_min[x], reference_trace.y_max[x]);
+        }
+    }
+    /* The erase also took out any live pixels in those rows. */
+    waveform_cache.width = 0U;
+}
+
+void ScopeDisplay_SetReferenceVisible(uint8_t visible)
+{
+    reference_trace.visible = visible ? 1U : 0U;
+}
+
+/* Redrawing the trace's rows through EraseColumn paints the reference from
+   the background and wipes live pixels there, so the next live frame is
+   drawn in full rather than skipped. */
+static void ScopeDisplay_PaintReference(void)
+{
+    if (!reference_trace.active || !reference_trace.visible)
+    {
+        return;
+    }
+    for (uint16_t x = 0U; x < reference_trace.width; x++)
+    {
+        if (reference_trace.y_min[x] <= reference_trace.y_max[x])
+        {
+            ScopeDisplay_EraseColumn(x, reference_trace.y_min[x], reference_trace.y_max[x]);
+        }
+    }
+    waveform_cache.width = 0U;
+}
+
+static uint8_t ScopeDisplay_WaveformUnchanged(const int32_t *new_y, uint16_t width)
+{
+    if (first_draw || width != waveform_cache.width)
+    {
+        return 0U;
+    }
+    const int32_t tolerance = (int32_t)waveform_cache.tolerance_px;
+    for (uint16_t x = 0U; x < width; x++)
+    {
+        int32_t delta = new_y[x] - waveform_cache.y[x];
+        if (delta > tolerance || delta < -tolerance)
+        {
+            return 0U;
+        }
+    }
+    return 1U;
+}
+
+/* Rebuilds the column positions and the vertical scale only when the
+   window, zoom or column count changed since the last frame. */
+static void ScopeDisplay_UpdateMapPlan(const ScopeDisplaySettings *settings,
+                                       uint32_t visible_samples,
+                                       uint16_t draw_width)
 {
-    const int32_t info_panel = (int32_t)ScopeDisplay_InfoPanelHeight();
+    ScopeDisplayMapPlan *plan = &waveform_plan;
+    if (plan->valid &&
+        plan->samples_visible == visible_samples &&
+        plan->draw_width == draw_width &&
+        plan->span_counts == settings->vertical.span_counts &&
+        plan->center_counts == settings->vertical.center_counts)
+    {
+        return;
+    }
+
+    uint32_t start = ScopeProfile_CycleCount();
+
+    /* 16.16 step with the division remainder carried separately, so every
+       position is exactly floor(i * visible * 65536 / width) and no
+       rounding error accumulates across the row. */
+    const uint32_t numerator = visible_samples << 16;
+    const uint32_t step_q16 = numerator / draw_width;
+    const uint32_t step_rem = numerator % draw_width;
+    uint32_t pos_q16 = 0U;
+    uint32_t rem = 0U;
+    for (uint16_t i = 0; i < draw_width; i++)
+    {
+        plan->column_pos_q16[i] = pos_q16;
+        pos_q16 += step_q16;
+        rem += step_rem;
+        if (rem >= draw_width)
+        {
+            rem -= draw_width;
+            pos_q16++;
+        }
+    }
+
     const int32_t waveform_height = (int32_t)ScopeDisplay_WaveformHeight();
     int32_t span = (int32_t)settings->vertical.span_counts;
     if (span <= 0)
     {
         span = (int32_t)scope_display_module.cfg.adc_max_counts;
     }
-    int32_t half_span = span / 2;
-    int32_t lower = settings->vertical.center_counts - half_span;
-    int32_t relative = sample - lower;
-    int32_t y = info_panel + (waveform_height - 1)
-                - (relative * (waveform_height - 1)) / span;
-    return y;
+    plan->window_lower = settings->vertical.center_counts - span / 2;
+    plan->y_bottom = (int32_t)ScopeDisplay_InfoPanelHeight() + (waveform_height - 1);
+    /* Rounded up: with |relative| * span < 2^32 the product then truncates
+       to exactly relative * (height - 1) / span. */
+    plan->y_scale_q32 = (((uint64_t)(uint32_t)(waveform_height - 1) << 32) + (uint32_t)span - 1U) /
+                        (uint32_t)span;
+
+    plan->samples_visible = visible_samples;
+    plan->draw_width = draw_width;
+    plan->span_counts = settings->vertical.span_counts;
+    plan->center_counts = settings->vertical.center_counts;
+    plan->valid = 1U;
+    plan->plan_cycles = ScopeProfile_CycleCount() - start;
+}
+
+static int32_t ScopeDisplay_CountsToY(int32_t sample)
+{
+    int32_t relative = sample - waveform_plan.window_lower;
+    /* Scaled on the magnitude so negative values truncate toward zero like
+       the division they replace. */
+    uint32_t magnitude = (relative < 0) ? (uint32_t)(-relative) : (uint32_t)relative;
+    int32_t offset = (int32_t)(((uint64_t)magnitude * waveform_plan.y_scale_q32) >> 32);
+    return (relative < 0) ? (waveform_plan.y_bottom + offset) : (waveform_plan.y_bottom - offset);
 }
 
 static uint8_t ScopeDisplay_ClipWaveformSegment(int32_t *y0, int32_t *y1)
@@ -297,6 +881,11 @@ static uint16_t ScopeDisplay_BackgroundColor(uint16_t x, uint16_t y)
     {
         return ILI9341_BLACK;
     }
+    if (reference_trace.active && reference_trace.visible && x < reference_trace.width &&
+        y >= reference_trace.y_min[x] && y <= reference_trace.y_max[x])
+    {
+        return REFERENCE_COLOR;
+    }
 
     uint16_t gy = y - info_panel;
     if ((x % scope_display_module.cfg.grid_spacing_px) == 0U ||
@@ -387,55 +976,891 @@ static void ScopeDisplay_DrawCursorLine(uint16_t x, uint16_t color)
     ILI9341_DrawColorSpan(x, y0, span, color);
 }
 
-void ScopeDisplay_DrawMeasurements(uint16_t vmin, uint16_t vmax, uint32_t freq_hz)
+void ScopeDisplay_DrawAnnotations(const ScopeDisplayAnnotation *items,
+                                  uint8_t count,
+                                  const uint16_t *column_sample_map)
 {
     if (!scope_display_module.initialized)
     {
         return;
     }
 
-    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_MEASUREMENTS)
+    const uint16_t top = ScopeDisplay_InfoPanelHeight() + ANNOTATION_TOP_MARGIN;
+    for (uint8_t idx = 0U; idx < annotation_last_count; idx++)
     {
-        ScopeDisplay_ClearInfoPanel();
-        ScopeDisplay_ClearMeasurementInfoCache();
-        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_MEASUREMENTS;
+        ScopeDisplay_RestoreRegion(annotation_last_x[idx], annotation_last_width[idx], top, ANNOTATION_HEIGHT);
     }
+    annotation_last_count = 0U;
 
-    ScopeDisplay_UpdateMeasurements(vmin, vmax, freq_hz);
-}
-
-static void ScopeDisplay_UpdateMeasurements(uint16_t vmin, uint16_t vmax, uint32_t freq_hz)
-{
-    char line1[32];
-    char line2[32];
-    char line3[32];
-    uint32_t vmin_mv = ScopeSignal_AdcToMillivolt(vmin,
-                                                  scope_display_module.cfg.adc_max_counts,
-                                                  scope_display_module.cfg.adc_ref_millivolt);
-    uint32_t vmax_mv = ScopeSignal_AdcToMillivolt(vmax,
-                                                  scope_display_module.cfg.adc_max_counts,
-                                                  scope_display_module.cfg.adc_ref_millivolt);
-    uint32_t vmax_whole = vmax_mv / 1000U;
-    uint32_t vmax_frac = (vmax_mv % 1000U) / 10U;
-    uint32_t vmin_whole = vmin_mv / 1000U;
-    uint32_t vmin_frac = (vmin_mv % 1000U) / 10U;
-
-    snprintf(line1, sizeof(line1), "Vmax: %lu.%02lu V",
-             (unsigned long)vmax_whole,
-             (unsigned long)vmax_frac);
-    snprintf(line2, sizeof(line2), "Vmin: %lu.%02lu V",
-             (unsigned long)vmin_whole,
-             (unsigned long)vmin_frac);
-
-    if (freq_hz == 0U)
+    if (items == NULL || column_sample_map == NULL)
     {
-        snprintf(line3, sizeof(line3), "Freq: ---");
+        return;
+    }
+    if (count > SCOPE_DISPLAY_MAX_ANNOTATIONS)
+    {
+        count = SCOPE_DISPLAY_MAX_ANNOTATIONS;
+    }
+
+    int32_t next_free_x = 0;
+    for (uint8_t idx = 0U; idx < count; idx++)
+    {
+        int32_t x = ScopeDisplay_FindSampleColumn(column_sample_map,
+                                                  items[idx].first_sample,
+                                                  items[idx].last_sample);
+        uint16_t width = (uint16_t)(strlen(items[idx].text) * ANNOTATION_CHAR_WIDTH);
+        if (x < 0 || width == 0U)
+        {
+            continue;
+        }
+        if (x + (int32_t)width > (int32_t)ILI9341_WIDTH)
+        {
+            x = (int32_t)ILI9341_WIDTH - (int32_t)width;
+        }
+        if (x < next_free_x)
+        {
+            continue;
+        }
+
+        ILI9341_DrawString((uint16_t)x, top, items[idx].text, items[idx].color, ILI9341_BLACK, 1U);
+
+        annotation_last_x[annotation_last_count] = (uint16_t)x;
+        annotation_last_width[annotation_last_count] = width;
+        annotation_last_count++;
+        next_free_x = x + (int32_t)width + (int32_t)ANNOTATION_GAP;
+    }
+}
+
+static void ScopeDisplay_RestoreRegion(uint16_t x, uint16_t width, uint16_t y, uint16_t height)
+{
+    uint16_t y_end = (uint16_t)(y + height - 1U);
+    for (uint16_t col = x; col < (uint16_t)(x + width) && col < ILI9341_WIDTH; col++)
+    {
+        ScopeDisplay_EraseColumn(col, y, y_end);
+
+        /* Put back the part of the trace that the label was covering. */
+        uint16_t wave_top = (last_y_min[col] > y) ? last_y_min[col] : y;
+        uint16_t wave_bottom = (last_y_max[col] < y_end) ? last_y_max[col] : y_end;
+        if (!first_draw && wave_top <= wave_bottom)
+        {
+            ScopeDisplay_DrawColumn(col, wave_top, wave_bottom);
+        }
+    }
+}
+
+static int32_t ScopeDisplay_FindSampleColumn(const uint16_t *column_sample_map,
+                                             uint16_t first_sample,
+                                             uint16_t last_sample)
+{
+    uint16_t draw_width = scope_display_module.cfg.frame_samples;
+    if (draw_width > ILI9341_WIDTH)
+    {
+        draw_width = ILI9341_WIDTH;
+    }
+    for (uint16_t x = 0U; x < draw_width; x++)
+    {
+        if (column_sample_map[x] >= first_sample && column_sample_map[x] <= last_sample)
+        {
+            return (int32_t)x;
+        }
+    }
+    return -1;
+}
+
+void ScopeDisplay_DrawMeasurements(const ScopeMeasureResult *result)
+{
+    if (!scope_display_module.initialized || result == NULL)
+    {
+        return;
+    }
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_MEASUREMENTS)
+    {
+        ScopeDisplay_ClearInfoPanel();
+        ScopeDisplay_ClearMeasurementInfoCache();
+        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_MEASUREMENTS;
+    }
+
+    ScopeDisplay_UpdateMeasurements(result);
+}
+
+void ScopeDisplay_DrawStatistics(const ScopeStatsSummary *slots)
+{
+    static const uint16_t line_colors[SCOPE_MEASURE_DISPLAY_SLOTS] = {
+        ILI9341_YELLOW,
+        ILI9341_GREEN,
+        ILI9341_WHITE
+    };
+    char *const last_lines[SCOPE_MEASURE_DISPLAY_SLOTS] = {
+        measurement_last_line1,
+        measurement_last_line2,
+        measurement_last_line3
+    };
+
+    if (!scope_display_module.initialized || slots == NULL)
+    {
+        return;
+    }
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_STATISTICS)
+    {
+        ScopeDisplay_ClearInfoPanel();
+        ScopeDisplay_ClearMeasurementInfoCache();
+        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_STATISTICS;
+    }
+
+    for (uint8_t slot = 0U; slot < SCOPE_MEASURE_DISPLAY_SLOTS; slot++)
+    {
+        char line[32];
+        ScopeMeasureId id = ScopeMeasure_GetDisplaySlot(slot);
+        if (slots[slot].count == 0U)
+        {
+            snprintf(line, sizeof(line), "%s: ---", ScopeMeasure_Label(id));
+        }
+        else
+        {
+            char mean[16];
+            char deviation[16];
+            ScopeDisplay_FormatValue(mean, sizeof(mean), id, slots[slot].mean);
+            ScopeDisplay_FormatValue(deviation, sizeof(deviation), id, slots[slot].stddev);
+            snprintf(line, sizeof(line), "%s %s sd %s", ScopeMeasure_Label(id), mean, deviation);
+        }
+
+        ScopeDisplay_UpdateInfoLine(4U,
+                                    (uint16_t)(4U + 20U * slot),
+                                    line,
+                                    line_colors[slot],
+                                    last_lines[slot],
+                                    sizeof(measurement_last_line1));
+    }
+}
+
+void ScopeDisplay_DrawHistogram(const ScopeDisplaySettings *settings,
+                                const uint32_t *bins,
+                                uint16_t bin_count,
+                                const ScopeHistogramSummary *summary)
+{
+    if (!scope_display_module.initialized || settings == NULL || bins == NULL || bin_count == 0U)
+    {
+        return;
+    }
+
+    const uint16_t info_panel = ScopeDisplay_InfoPanelHeight();
+    const int32_t rows = (int32_t)ScopeDisplay_WaveformHeight();
+    const int32_t adc_max = (int32_t)scope_display_module.cfg.adc_max_counts;
+    const int32_t bin_width = (adc_max + 1) / (int32_t)bin_count;
+    if (rows < 2 || bin_width <= 0)
+    {
+        return;
+    }
+
+    int32_t span = (int32_t)settings->vertical.span_counts;
+    if (span <= 0)
+    {
+        span = adc_max;
+    }
+    const int32_t lower = settings->vertical.center_counts - span / 2;
+
+    /* Each row collects the bins whose counts fall inside its half-row band, the
+       inverse of ScopeDisplay_SampleToY, so zoom and offset apply as for the trace. */
+    uint32_t row_sum[ILI9341_HEIGHT];
+    uint32_t row_max = 0U;
+    for (int32_t r = 0; r < rows; r++)
+    {
+        int32_t level = rows - 1 - r;
+        int32_t c_hi = lower + ((2 * level + 1) * span) / (2 * (rows - 1));
+        int32_t c_lo = lower + ((2 * level - 1) * span) / (2 * (rows - 1)) + 1;
+        c_lo = (c_lo > c_hi) ? c_hi : c_lo;
+        row_sum[r] = 0U;
+        if (c_hi < 0 || c_lo > adc_max)
+        {
+            continue;
+        }
+        c_lo = (c_lo < 0) ? 0 : c_lo;
+        c_hi = (c_hi > adc_max) ? adc_max : c_hi;
+        for (int32_t b = c_lo / bin_width; b <= c_hi / bin_width && b < (int32_t)bin_count; b++)
+        {
+            row_sum[r] += bins[b];
+        }
+        row_max = (row_sum[r] > row_max) ? row_sum[r] : row_max;
+    }
+
+    const uint16_t width = ILI9341_WIDTH;
+    for (int32_t r = 0; r < rows; r++)
+    {
+        uint16_t y = (uint16_t)(info_panel + r);
+        uint16_t length = 0U;
+        if (row_max != 0U)
+        {
+            length = (uint16_t)(((uint64_t)row_sum[r] * width + row_max - 1U) / row_max);
+        }
+        uint16_t last = histogram_last_length[y];
+        if (length > last)
+        {
+            ILI9341_DrawHLine(last, y, (uint16_t)(length - last), scope_display_module.cfg.waveform_color);
+        }
+        else if (length < last)
+        {
+            ScopeDisplay_EraseRow(y, length, (uint16_t)(last - length));
+        }
+        histogram_last_length[y] = length;
+    }
+
+    if (summary != NULL)
+    {
+        ScopeDisplay_UpdateHistogramInfo(summary);
+    }
+}
+
+void ScopeDisplay_DrawEye(const uint8_t *hits, const ScopeEyeStatus *status)
+{
+    /* Intensity grading: darker to brighter as a cell collects more traces. */
+    static const uint16_t shade_colors[] = {
+        0U,
+        0x0200U,
+        0x03E0U,
+        0x07E0U,
+        ILI9341_YELLOW,
+        ILI9341_RED,
+        ILI9341_WHITE
+    };
+
+    if (!scope_display_module.initialized || hits == NULL || status == NULL)
+    {
+        return;
+    }
+
+    const uint16_t info_panel = ScopeDisplay_InfoPanelHeight();
+    const uint16_t cell_w = ILI9341_WIDTH / SCOPE_EYE_COLUMNS;
+    const uint16_t cell_h = ScopeDisplay_WaveformHeight() / SCOPE_EYE_ROWS;
+    if (cell_w == 0U || cell_h == 0U)
+    {
+        return;
+    }
+
+    if (status->generation != eye_last_generation)
+    {
+        for (uint16_t x = 0U; x < ILI9341_WIDTH; x++)
+        {
+            ScopeDisplay_EraseColumn(x, info_panel, ILI9341_HEIGHT - 1U);
+        }
+        memset(eye_last_shade, 0, sizeof(eye_last_shade));
+        eye_last_generation = status->generation;
+    }
+
+    /* Hits only grow between generations, so cells are only ever repainted brighter. */
+    for (uint16_t row = 0U; row < SCOPE_EYE_ROWS; row++)
+    {
+        uint16_t y = (uint16_t)(info_panel + (SCOPE_EYE_ROWS - 1U - row) * cell_h);
+        const uint8_t *line = &hits[(uint32_t)row * SCOPE_EYE_COLUMNS];
+        for (uint16_t col = 0U; col < SCOPE_EYE_COLUMNS; col++)
+        {
+            uint8_t shade = ScopeDisplay_EyeShade(line[col]);
+            if (shade == eye_last_shade[row][col])
+            {
+                continue;
+            }
+            ILI9341_FillRect((uint16_t)(col * cell_w), y, cell_w, cell_h, shade_colors[shade]);
+            eye_last_shade[row][col] = shade;
+        }
+    }
+
+    ScopeDisplay_UpdateEyeInfo(status);
+}
+
+static uint8_t ScopeDisplay_EyeShade(uint8_t hits)
+{
+    if (hits == 0U)
+    {
+        return 0U;
+    }
+    if (hits < 2U)
+    {
+        return 1U;
+    }
+    if (hits < 4U)
+    {
+        return 2U;
+    }
+    if (hits < 16U)
+    {
+        return 3U;
+    }
+    if (hits < 64U)
+    {
+        return 4U;
+    }
+    return (hits < 255U) ? 5U : 6U;
+}
+
+static void ScopeDisplay_UpdateEyeInfo(const ScopeEyeStatus *status)
+{
+    char *const last_lines[3] = {
+        measurement_last_line1,
+        measurement_last_line2,
+        measurement_last_line3
+    };
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_EYE)
+    {
+        ScopeDisplay_ClearInfoPanel();
+        ScopeDisplay_ClearMeasurementInfoCache();
+        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_EYE;
+    }
+
+    const uint32_t sample_rate_hz = ScopeSignal_GetSampleRateHz();
+    char lines[3][32];
+    char value[16];
+    if (status->open)
+    {
+        uint32_t mv = ScopeCalib_SpanToMillivolt(status->height_counts);
+        ScopeDisplay_FormatVoltageString(value, sizeof(value), (int32_t)mv, 0U);
+        snprintf(lines[0], sizeof(lines[0]), "Eye H: %s", value);
+        int64_t width_ns = (sample_rate_hz != 0U)
+                               ? ((int64_t)status->width_q8 * 1000000000LL) / ((int64_t)sample_rate_hz * 256)
+                               : 0;
+        ScopeDisplay_FormatTimeValue(value, sizeof(value), width_ns);
+        snprintf(lines[1], sizeof(lines[1]), "Eye W: %s %u%%", value,
+                 (unsigned int)((status->width_permille + 5U) / 10U));
+    }
+    else
+    {
+        snprintf(lines[0], sizeof(lines[0]), "Eye H: ---");
+        snprintf(lines[1], sizeof(lines[1]), "Eye W: ---");
+    }
+    if (status->ui_q8 != 0U && sample_rate_hz != 0U)
+    {
+        int64_t ui_ns = ((int64_t)status->ui_q8 * 1000000000LL) / ((int64_t)sample_rate_hz * 256);
+        ScopeDisplay_FormatTimeValue(value, sizeof(value), ui_ns);
+        snprintf(lines[2], sizeof(lines[2]), "UI %s n %lu", value, (unsigned long)status->unit_intervals);
+    }
+    else
+    {
+        snprintf(lines[2], sizeof(lines[2]), "UI: no edges");
+    }
+
+    for (uint8_t idx = 0U; idx < 3U; idx++)
+    {
+        ScopeDisplay_UpdateInfoLine(4U,
+                                    (uint16_t)(4U + 20U * idx),
+                                    lines[idx],
+                                    (idx == 0U) ? ILI9341_YELLOW : ((idx == 1U) ? ILI9341_GREEN : ILI9341_WHITE),
+                                    last_lines[idx],
+                                    sizeof(measurement_last_line1));
+    }
+}
+
+void ScopeDisplay_DrawBode(const ScopeFraPoint *points, const ScopeFraStatus *status)
+{
+    if (!scope_display_module.initialized || points == NULL || status == NULL)
+    {
+        return;
+    }
+
+    const uint16_t info_panel = ScopeDisplay_InfoPanelHeight();
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_BODE)
+    {
+        /* Entering the view starts from a fresh grid. */
+        bode_drawn = 0U;
+        bode_last_sweep = status->sweeps;
+    }
+    else if (status->sweeps != bode_last_sweep)
+    {
+        for (uint16_t x = 0U; x < ILI9341_WIDTH; x++)
+        {
+            ScopeDisplay_EraseColumn(x, info_panel, ILI9341_HEIGHT - 1U);
+        }
+        bode_drawn = 0U;
+        bode_last_sweep = status->sweeps;
+    }
+
+    /* Points arrive in frequency order, so each one only adds a segment. */
+    while (bode_drawn < status->points_done)
+    {
+        int32_t x = 0;
+        int32_t y_gain = 0;
+        int32_t y_phase = 0;
+        ScopeDisplay_BodePoint(&points[bode_drawn], bode_drawn, status->point_count, &x, &y_gain, &y_phase);
+        if (bode_drawn == 0U)
+        {
+            ILI9341_DrawPixel((uint16_t)x, (uint16_t)y_phase, ILI9341_CYAN);
+            ILI9341_DrawPixel((uint16_t)x, (uint16_t)y_gain, ILI9341_YELLOW);
+        }
+        else
+        {
+            int32_t x_prev = 0;
+            int32_t y_gain_prev = 0;
+            int32_t y_phase_prev = 0;
+            ScopeDisplay_BodePoint(&points[bode_drawn - 1U], (uint8_t)(bode_drawn - 1U), status->point_count,
+                                   &x_prev, &y_gain_prev, &y_phase_prev);
+            ScopeDisplay_DrawLine(x_prev, y_phase_prev, x, y_phase, ILI9341_CYAN);
+            ScopeDisplay_DrawLine(x_prev, y_gain_prev, x, y_gain, ILI9341_YELLOW);
+        }
+        bode_drawn++;
+    }
+
+    ScopeDisplay_UpdateBodeInfo(points, status);
+}
+
+/* Frequency is log-spaced by index, so x is linear in the point index. */
+static void ScopeDisplay_BodePoint(const ScopeFraPoint *point, uint8_t index, uint8_t count,
+                                   int32_t *x, int32_t *y_gain, int32_t *y_phase)
+{
+    const int32_t top = (int32_t)ScopeDisplay_InfoPanelHeight();
+    const int32_t height = (int32_t)ScopeDisplay_WaveformHeight() - 1;
+    const float db_span = (float)(SCOPE_FRA_PLOT_TOP_DB - SCOPE_FRA_PLOT_BOTTOM_DB);
+
+    *x = (count > 1U) ? ((int32_t)index * (ILI9341_WIDTH - 1)) / (int32_t)(count - 1U) : 0;
+
+    float gain = point->gain_db;
+    if (gain > (float)SCOPE_FRA_PLOT_TOP_DB)
+    {
+        gain = (float)SCOPE_FRA_PLOT_TOP_DB;
+    }
+    else if (gain < (float)SCOPE_FRA_PLOT_BOTTOM_DB)
+    {
+        gain = (float)SCOPE_FRA_PLOT_BOTTOM_DB;
+    }
+    *y_gain = top + (int32_t)(((float)SCOPE_FRA_PLOT_TOP_DB - gain) * (float)height / db_span + 0.5f);
+    *y_phase = top + (int32_t)((180.0f - point->phase_deg) * (float)height / 360.0f + 0.5f);
+}
+
+static void ScopeDisplay_DrawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color)
+{
+    int32_t dx = (x1 > x0) ? (x1 - x0) : (x0 - x1);
+    int32_t dy = (y1 > y0) ? (y0 - y1) : (y1 - y0);
+    int32_t sx = (x0 < x1) ? 1 : -1;
+    int32_t sy = (y0 < y1) ? 1 : -1;
+    int32_t err = dx + dy;
+
+    for (;;)
+    {
+        if (x0 >= 0 && x0 < ILI9341_WIDTH && y0 >= 0 && y0 < ILI9341_HEIGHT)
+        {
+            ILI9341_DrawPixel((uint16_t)x0, (uint16_t)y0, color);
+        }
+        if (x0 == x1 && y0 == y1)
+        {
+            break;
+        }
+        int32_t e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void ScopeDisplay_UpdateBodeInfo(const ScopeFraPoint *points, const ScopeFraStatus *status)
+{
+    char *const last_lines[3] = {
+        measurement_last_line1,
+        measurement_last_line2,
+        measurement_last_line3
+    };
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_BODE)
+    {
+        ScopeDisplay_ClearInfoPanel();
+        ScopeDisplay_ClearMeasurementInfoCache();
+        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_BODE;
+    }
+
+    char lines[3][32];
+    char value[16];
+    if (status->points_done == 0U)
+    {
+        snprintf(lines[0], sizeof(lines[0]), "Bode %s", status->running ? "settling" : "idle");
+        snprintf(lines[1], sizeof(lines[1]), "Gain +%d..%ddB",
+                 SCOPE_FRA_PLOT_TOP_DB, SCOPE_FRA_PLOT_BOTTOM_DB);
+        snprintf(lines[2], sizeof(lines[2]), "Phase +-180deg");
+    }
+    else
+    {
+        const ScopeFraPoint *point = &points[status->points_done - 1U];
+        ScopeDisplay_FormatFrequency(value, sizeof(value), point->freq_centihz / 100U);
+        snprintf(lines[0], sizeof(lines[0]), "%u/%u %s%s",
+                 (unsigned int)status->points_done,
+                 (unsigned int)status->point_count,
+                 value,
+                 status->running ? "" : (status->aborted ? " stop" : " done"));
+        ScopeDisplay_FormatTenths(value, sizeof(value), point->gain_db);
+        snprintf(lines[1], sizeof(lines[1]), "Gain %sdB", value);
+        ScopeDisplay_FormatTenths(value, sizeof(value), point->phase_deg);
+        snprintf(lines[2], sizeof(lines[2]), "Phase %sdeg", value);
+    }
+
+    static const uint16_t colors[3] = { ILI9341_WHITE, ILI9341_YELLOW, ILI9341_CYAN };
+    for (uint8_t idx = 0U; idx < 3U; idx++)
+    {
+        ScopeDisplay_UpdateInfoLine(4U,
+                                    (uint16_t)(4U + 20U * idx),
+                                    lines[idx],
+                                    colors[idx],
+                                    last_lines[idx],
+                                    sizeof(measurement_last_line1));
+    }
+}
+
+static void ScopeDisplay_FormatTenths(char *buf, size_t len, float value)
+{
+    int32_t tenths = (int32_t)((value < 0.0f) ? (value * 10.0f - 0.5f) : (value * 10.0f + 0.5f));
+    uint32_t magnitude = (uint32_t)((tenths < 0) ? -tenths : tenths);
+    snprintf(buf, len, "%s%lu.%lu",
+             (tenths < 0) ? "-" : "+",
+             (unsigned long)(magnitude / 10U),
+             (unsigned long)(magnitude % 10U));
+}
+
+void ScopeDisplay_DrawJitter(const uint32_t *bins,
+                             const float *trend_ns,
+                             uint16_t trend_count,
+                             const ScopeJitterStatus *status)
+{
+    if (!scope_display_module.initialized || bins == NULL || trend_ns == NULL || status == NULL)
+    {
+        return;
+    }
+
+    /* TIE histogram over the upper part of the waveform area, period trend in
+       the lowest grid division. */
+    const uint16_t info_panel = ScopeDisplay_InfoPanelHeight();
+    const uint16_t trend_height = 64U;
+    const uint16_t hist_height = (uint16_t)(ScopeDisplay_WaveformHeight() - trend_height);
+    const uint16_t hist_base = (uint16_t)(info_panel + hist_height - 1U);
+    const uint16_t bar_width = ILI9341_WIDTH / SCOPE_JITTER_BINS;
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_JITTER ||
+        status->generation != jitter_last_generation)
+    {
+        if (scope_display_info_mode == SCOPE_DISPLAY_INFO_MODE_JITTER)
+        {
+            for (uint16_t x = 0U; x < ILI9341_WIDTH; x++)
+            {
+                ScopeDisplay_EraseColumn(x, info_panel, ILI9341_HEIGHT - 1U);
+            }
+        }
+        memset(jitter_last_height, 0, sizeof(jitter_last_height));
+        memset(jitter_trend_last_y0, 0, sizeof(jitter_trend_last_y0));
+        memset(jitter_trend_last_y1, 0, sizeof(jitter_trend_last_y1));
+        jitter_last_generation = status->generation;
+    }
+
+    uint32_t peak = 0U;
+    for (uint16_t bin = 0U; bin < SCOPE_JITTER_BINS; bin++)
+    {
+        peak = (bins[bin] > peak) ? bins[bin] : peak;
+    }
+    for (uint16_t bin = 0U; bin < SCOPE_JITTER_BINS; bin++)
+    {
+        uint16_t height = 0U;
+        if (peak != 0U)
+        {
+            height = (uint16_t)(((uint64_t)bins[bin] * (hist_height - 1U) + peak - 1U) / peak);
+        }
+        uint16_t last = jitter_last_height[bin];
+        uint16_t x = (uint16_t)(bin * bar_width);
+        if (height > last)
+        {
+            ILI9341_FillRect(x, (uint16_t)(hist_base + 1U - height), bar_width,
+                             (uint16_t)(height - last), ILI9341_YELLOW);
+        }
+        else if (height < last)
+        {
+            for (uint16_t col = 0U; col < bar_width; col++)
+            {
+                ScopeDisplay_EraseColumn((uint16_t)(x + col), (uint16_t)(hist_base + 1U - last),
+                                         (uint16_t)(hist_base - height));
+            }
+        }
+        jitter_last_height[bin] = height;
+    }
+
+    ScopeDisplay_DrawJitterTrend(trend_ns, trend_count, (uint16_t)(hist_base + 1U), trend_height);
+    ScopeDisplay_UpdateJitterInfo(status);
+}
+
+static void ScopeDisplay_DrawJitterTrend(const float *trend_ns, uint16_t trend_count, uint16_t top, uint16_t height)
+{
+    if (trend_count > SCOPE_JITTER_TREND_POINTS)
+    {
+        trend_count = SCOPE_JITTER_TREND_POINTS;
+    }
+
+    /* Full scale is the next power of two in ns above the largest deviation,
+       so the scale only steps when the spread really changes. */
+    float largest = 0.0f;
+    for (uint16_t i = 0U; i < trend_count; i++)
+    {
+        float dev = (trend_ns[i] < 0.0f) ? -trend_ns[i] : trend_ns[i];
+        largest = (dev > largest) ? dev : largest;
+    }
+    float full_scale = 1.0f;
+    while (full_scale < largest)
+    {
+        full_scale *= 2.0f;
+    }
+
+    const int32_t half = (int32_t)(height / 2U) - 1;
+    const int32_t center = (int32_t)top + (int32_t)(height / 2U);
+    const uint16_t first_x = (uint16_t)(SCOPE_JITTER_TREND_POINTS - trend_count);
+    int32_t prev_y = 0;
+    for (uint16_t x = 0U; x < SCOPE_JITTER_TREND_POINTS; x++)
+    {
+        uint16_t y0 = 0U;
+        uint16_t y1 = 0U;
+        if (x >= first_x)
+        {
+            int32_t y = center - (int32_t)(trend_ns[x - first_x] * (float)half / full_scale);
+            int32_t lo = (x > first_x && prev_y < y) ? prev_y : y;
+            int32_t hi = (x > first_x && prev_y > y) ? prev_y : y;
+            prev_y = y;
+            y0 = (uint16_t)lo;
+            y1 = (uint16_t)hi;
+        }
+        if (y0 == jitter_trend_last_y0[x] && y1 == jitter_trend_last_y1[x])
+        {
+            continue;
+        }
+        if (jitter_trend_last_y1[x] != 0U)
+        {
+            ScopeDisplay_EraseColumn(x, jitter_trend_last_y0[x], jitter_trend_last_y1[x]);
+        }
+        if (y1 != 0U)
+        {
+            ILI9341_FillRect(x, y0, 1U, (uint16_t)(y1 - y0 + 1U), ILI9341_CYAN);
+        }
+        jitter_trend_last_y0[x] = y0;
+        jitter_trend_last_y1[x] = y1;
+    }
+}
+
+static void ScopeDisplay_UpdateJitterInfo(const ScopeJitterStatus *status)
+{
+    char *const last_lines[3] = {
+        measurement_last_line1,
+        measurement_last_line2,
+        measurement_last_line3
+    };
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_JITTER)
+    {
+        ScopeDisplay_ClearInfoPanel();
+        ScopeDisplay_ClearMeasurementInfoCache();
+        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_JITTER;
+    }
+
+    char lines[3][32];
+    char value[16];
+    char extra[16];
+    if (status->tie_count == 0U)
+    {
+        snprintf(lines[0], sizeof(lines[0]), "TIE: no clock");
+        snprintf(lines[1], sizeof(lines[1]), "Edges %lu", (unsigned long)status->edges);
+    }
+    else
+    {
+        ScopeDisplay_FormatTimeValue(value, sizeof(value), (int64_t)(status->tie_rms_ns + 0.5f));
+        snprintf(lines[0], sizeof(lines[0]), "TIE rms %s", value);
+        ScopeDisplay_FormatTimeValue(value, sizeof(value), (int64_t)(status->tie_pp_ns + 0.5f));
+        snprintf(lines[1], sizeof(lines[1]), "TIE pp %s", value);
+    }
+    if (status->period_ns > 0.0f)
+    {
+        ScopeDisplay_FormatTimeValue(value, sizeof(value), (int64_t)(status->period_ns + 0.5f));
+        ScopeDisplay_FormatTimeValue(extra, sizeof(extra), (int64_t)(status->period_sd_ns + 0.5f));
+        snprintf(lines[2], sizeof(lines[2]), "T %s sd %s", value, extra);
+    }
+    else
+    {
+        snprintf(lines[2], sizeof(lines[2]), "T ---");
+    }
+
+    static const uint16_t colors[3] = { ILI9341_YELLOW, ILI9341_YELLOW, ILI9341_CYAN };
+    for (uint8_t idx = 0U; idx < 3U; idx++)
+    {
+        ScopeDisplay_UpdateInfoLine(4U,
+                                    (uint16_t)(4U + 20U * idx),
+                                    lines[idx],
+                                    colors[idx],
+                                    last_lines[idx],
+                                    sizeof(measurement_last_line1));
+    }
+}
+
+static void ScopeDisplay_EraseRow(uint16_t y, uint16_t x, uint16_t width)
+{
+    const uint16_t spacing = scope_display_module.cfg.grid_spacing_px;
+    if (ScopeDisplay_BackgroundColor(1U, y) == ILI9341_BLUE)
+    {
+        ILI9341_DrawHLine(x, y, width, ILI9341_BLUE);
+        return;
+    }
+
+    ILI9341_DrawHLine(x, y, width, ILI9341_BLACK);
+    uint16_t grid_x = (uint16_t)(((x + spacing - 1U) / spacing) * spacing);
+    for (; grid_x < (uint16_t)(x + width); grid_x += spacing)
+    {
+        ILI9341_DrawPixel(grid_x, y, ILI9341_BLUE);
+    }
+}
+
+static void ScopeDisplay_UpdateHistogramInfo(const ScopeHistogramSummary *summary)
+{
+    char *const last_lines[3] = {
+        measurement_last_line1,
+        measurement_last_line2,
+        measurement_last_line3
+    };
+
+    if (scope_display_info_mode != SCOPE_DISPLAY_INFO_MODE_HISTOGRAM)
+    {
+        ScopeDisplay_ClearInfoPanel();
+        ScopeDisplay_ClearMeasurementInfoCache();
+        scope_display_info_mode = SCOPE_DISPLAY_INFO_MODE_HISTOGRAM;
+    }
+
+    char lines[3][32];
+    if (summary->total == 0U)
+    {
+        snprintf(lines[0], sizeof(lines[0]), "Top: --- Base: ---");
+        snprintf(lines[1], sizeof(lines[1]), "Mean: --- Noise: ---");
+    }
+    else
+    {
+        char top[16];
+        char base[16];
+        char mean[16];
+        ScopeDisplay_FormatVoltageString(top, sizeof(top), (int32_t)ScopeDisplay_CountsToMillivoltF(summary->top), 0U);
+        ScopeDisplay_FormatVoltageString(base, sizeof(base), (int32_t)ScopeDisplay_CountsToMillivoltF(summary->base), 0U);
+        ScopeDisplay_FormatVoltageString(mean, sizeof(mean), (int32_t)ScopeDisplay_CountsToMillivoltF(summary->mean), 0U);
+        uint32_t noise_uv = ScopeCalib_SpanToMillivolt((uint32_t)(summary->noise * 1000.0f + 0.5f));
+        snprintf(lines[0], sizeof(lines[0]), "Top %s Base %s", top, base);
+        snprintf(lines[1], sizeof(lines[1]), "Mean %s N %lu.%01lumV",
+                 mean,
+                 (unsigned long)(noise_uv / 1000U),
+                 (unsigned long)((noise_uv % 1000U) / 100U));
+    }
+    snprintf(lines[2], sizeof(lines[2]), "Hist %u bins %lu",
+             (unsigned int)summary->bin_count,
+             (unsigned long)summary->total);
+
+    for (uint8_t idx = 0U; idx < 3U; idx++)
+    {
+        ScopeDisplay_UpdateInfoLine(4U,
+                                    (uint16_t)(4U + 20U * idx),
+                                    lines[idx],
+                                    (idx == 0U) ? ILI9341_YELLOW : ((idx == 1U) ? ILI9341_GREEN : ILI9341_WHITE),
+                                    last_lines[idx],
+                                    sizeof(measurement_last_line1));
+    }
+}
+
+static uint32_t ScopeDisplay_CountsToMillivoltF(float counts)
+{
+    if (counts <= 0.0f)
+    {
+        return 0U;
+    }
+    return ScopeCalib_CountsToMillivolt((uint32_t)(counts + 0.5f));
+}
+
+static void ScopeDisplay_UpdateMeasurements(const ScopeMeasureResult *result)
+{
+    static const uint16_t line_colors[SCOPE_MEASURE_DISPLAY_SLOTS] = {
+        ILI9341_YELLOW,
+        ILI9341_GREEN,
+        ILI9341_WHITE
+    };
+    char *const last_lines[SCOPE_MEASURE_DISPLAY_SLOTS] = {
+        measurement_last_line1,
+        measurement_last_line2,
+        measurement_last_line3
+    };
+
+    for (uint8_t slot = 0U; slot < SCOPE_MEASURE_DISPLAY_SLOTS; slot++)
+    {
+        char line[32];
+        char value[20];
+        ScopeMeasureId id = ScopeMeasure_GetDisplaySlot(slot);
+        ScopeDisplay_FormatMeasurement(value, sizeof(value), id, result);
+        snprintf(line, sizeof(line), "%s: %s", ScopeMeasure_Label(id), value);
+
+        if (slot == SCOPE_MEASURE_DISPLAY_SLOTS - 1U)
+        {
+            ScopeScaleTarget target = Scope_GetScaleTarget();
+            const char *target_str = (target == SCOPE_SCALE_TARGET_VOLTAGE) ? "V" : "T";
+            size_t len = strlen(line);
+            if (len < sizeof(line))
+            {
+                snprintf(&line[len], sizeof(line) - len, " | Adj: %s", target_str);
+            }
+        }
+
+        ScopeDisplay_UpdateInfoLine(4U,
+                                    (uint16_t)(4U + 20U * slot),
+                                    line,
+                                    line_colors[slot],
+                                    last_lines[slot],
+                                    sizeof(measurement_last_line1));
+    }
+}
+
+static void ScopeDisplay_FormatMeasurement(char *buf, size_t len, ScopeMeasureId id,
+                                           const ScopeMeasureResult *result)
+{
+    if (buf == NULL || len == 0U)
+    {
+        return;
+    }
+
+    if (id >= SCOPE_MEASURE_COUNT || (result->valid_mask & (1UL << id)) == 0U)
+    {
+        snprintf(buf, len, "---");
+        return;
+    }
+
+    ScopeDisplay_FormatValue(buf, len, id, result->values[id]);
+}
+
+static void ScopeDisplay_FormatValue(char *buf, size_t len, ScopeMeasureId id, int32_t value)
+{
+    switch (ScopeMeasure_Unit(id))
+    {
+    case SCOPE_MEASURE_UNIT_MILLIVOLT:
+        ScopeDisplay_FormatVoltageString(buf, len, value, 0U);
+        break;
+    case SCOPE_MEASURE_UNIT_HZ:
+        ScopeDisplay_FormatFrequency(buf, len, (uint32_t)value);
+        break;
+    case SCOPE_MEASURE_UNIT_NS:
+        ScopeDisplay_FormatTimeValue(buf, len, (int64_t)value);
+        break;
+    case SCOPE_MEASURE_UNIT_PERMILLE:
+    default:
+        snprintf(buf, len, "%ld.%01ld %%",
+                 (long)(value / 10),
+                 (long)((value < 0 ? -value : value) % 10));
+        break;
+    }
+}
+
+static void ScopeDisplay_FormatFrequency(char *buf, size_t len, uint32_t freq_hz)
+{
+    if (freq_hz == 0U)
+    {
+        snprintf(buf, len, "---");
     }
     else if (freq_hz >= 1000000U)
     {
         uint32_t whole = freq_hz / 1000000U;
         uint32_t frac = (freq_hz % 1000000U) / 1000U;
-        snprintf(line3, sizeof(line3), "Freq: %lu.%03lu MHz",
+        snprintf(buf, len, "%lu.%03lu MHz",
                  (unsigned long)whole,
                  (unsigned long)frac);
     }
@@ -443,42 +1868,15 @@ static void ScopeDisplay_UpdateMeasurements(uint16_t vmin, uint16_t vmax, uint32
     {
         uint32_t whole = freq_hz / 1000U;
         uint32_t frac = (freq_hz % 1000U) / 10U;
-        snprintf(line3, sizeof(line3), "Freq: %lu.%02lu kHz",
+        snprintf(buf, len, "%lu.%02lu kHz",
                  (unsigned long)whole,
                  (unsigned long)frac);
     }
     else
     {
-        snprintf(line3, sizeof(line3), "Freq: %lu Hz",
+        snprintf(buf, len, "%lu Hz",
                  (unsigned long)freq_hz);
     }
-
-    ScopeScaleTarget target = Scope_GetScaleTarget();
-    const char *target_str = (target == SCOPE_SCALE_TARGET_VOLTAGE) ? "V" : "T";
-    size_t len = strlen(line3);
-    if (len < sizeof(line3))
-    {
-        snprintf(&line3[len], sizeof(line3) - len, " | Adj: %s", target_str);
-    }
-
-    ScopeDisplay_UpdateInfoLine(4U,
-                                4U,
-                                line1,
-                                ILI9341_YELLOW,
-                                measurement_last_line1,
-                                sizeof(measurement_last_line1));
-    ScopeDisplay_UpdateInfoLine(4U,
-                                24U,
-                                line2,
-                                ILI9341_GREEN,
-                                measurement_last_line2,
-                                sizeof(measurement_last_line2));
-    ScopeDisplay_UpdateInfoLine(4U,
-                                44U,
-                                line3,
-                                ILI9341_WHITE,
-                                measurement_last_line3,
-                                sizeof(measurement_last_line3));
 }
 
 static void ScopeDisplay_UpdateInfoLine(uint16_t x, uint16_t y, const char *text,
@@ -657,9 +2055,7 @@ void ScopeDisplay_DrawCursorMeasurements(const ScopeDisplayCursorMeasurements *m
 
     for (uint8_t idx = 0U; idx < measurements->count && idx < 2U; idx++)
     {
-        uint32_t mv = ScopeSignal_AdcToMillivolt(measurements->sample_values[idx],
-                                                 scope_display_module.cfg.adc_max_counts,
-                                                 scope_display_module.cfg.adc_ref_millivolt);
+        uint32_t mv = ScopeCalib_CountsToMillivolt(measurements->sample_values[idx]);
         ScopeDisplay_FormatVoltageString(v_buf[idx], sizeof(v_buf[idx]), (int32_t)mv, 0U);
 
         int32_t sample_idx = (int32_t)measurements->sample_indices[idx];
@@ -676,20 +2072,28 @@ void ScopeDisplay_DrawCursorMeasurements(const ScopeDisplayCursorMeasurements *m
                                                         measurements->sample_rate_hz);
         ScopeDisplay_FormatTimeValue(dt_buf, sizeof(dt_buf), delta_ns);
 
-        uint32_t mv1 = ScopeSignal_AdcToMillivolt(measurements->sample_values[0],
-                                                  scope_display_module.cfg.adc_max_counts,
-                                                  scope_display_module.cfg.adc_ref_millivolt);
-        uint32_t mv2 = ScopeSignal_AdcToMillivolt(measurements->sample_values[1],
-                                                  scope_display_module.cfg.adc_max_counts,
-                                                  scope_display_module.cfg.adc_ref_millivolt);
-        int32_t delta_mv = (int32_t)mv1 - (int32_t)mv2;
+        int32_t delta_counts = (int32_t)measurements->sample_values[0] -
+                               (int32_t)measurements->sample_values[1];
+        int32_t delta_mv = (int32_t)ScopeCalib_SpanToMillivolt((uint32_t)((delta_counts < 0) ? -delta_counts
+                                                                                              : delta_counts));
+        if (delta_counts < 0)
+        {
+            delta_mv = -delta_mv;
+        }
         ScopeDisplay_FormatVoltageString(dv_buf, sizeof(dv_buf), delta_mv, 1U);
     }
 
     snprintf(line1, sizeof(line1), "T1:%s | V1:%s", t_buf[0], v_buf[0]);
     snprintf(line2, sizeof(line2), "T2:%s | V2:%s", t_buf[1], v_buf[1]);
 
-    if (measurements->count >= 2U)
+    if (measurements->history_selected)
+    {
+        snprintf(line3, sizeof(line3), "HIST:-%u of %u REC:%u",
+                 (unsigned int)measurements->history_age,
+                 (unsigned int)measurements->history_count,
+                 (unsigned int)measurements->record_frames);
+    }
+    else if (measurements->count >= 2U)
     {
         snprintf(line3, sizeof(line3), "DT:%s | DV:%s", dt_buf, dv_buf);
     }
@@ -0,0 +1,86 @@
+#include "scope_events.h"
+
+#include <stddef.h>
+
+enum { EVENT_RING_MASK = SCOPE_EVENT_RING_SIZE - 1U };
+
+void ScopeEvents_Init(ScopeEventRing *ring)
+{
+    if (ring == NULL)
+    {
+        return;
+    }
+    /* Slot i is free for the producer that claims position i. */
+    for (uint32_t i = 0U; i < SCOPE_EVENT_RING_SIZE; ++i)
+    {
+        atomic_init(&ring->slots[i].sequence, i);
+    }
+    atomic_init(&ring->enqueue_pos, 0U);
+    atomic_init(&ring->dropped, 0U);
+    ring->dequeue_pos = 0U;
+}
+
+uint8_t ScopeEvents_Push(ScopeEventRing *ring, uint8_t type, int8_t arg, uint32_t timestamp_ms)
+{
+    unsigned int pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    ScopeEventSlot *slot;
+    for (;;)
+    {
+        slot = &ring->slots[pos & EVENT_RING_MASK];
+        unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int32_t diff = (int32_t)(sequence - pos);
+        if (diff == 0)
+        {
+            /* On Cortex-M this is LDREX/STREX: an interrupt that pushes in
+               between clears the monitor and this producer simply retries. */
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1U,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* The consumer has not freed this slot yet: the ring is full. */
+            atomic_fetch_add_explicit(&ring->dropped, 1U, memory_order_relaxed);
+            return 0U;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->event.type = type;
+    slot->event.arg = arg;
+    slot->event.timestamp_ms = timestamp_ms;
+    atomic_store_explicit(&slot->sequence, pos + 1U, memory_order_release);
+    return 1U;
+}
+
+uint8_t ScopeEvents_Pop(ScopeEventRing *ring, ScopeEvent *event)
+{
+    uint32_t pos = ring->dequeue_pos;
+    ScopeEventSlot *slot = &ring->slots[pos & EVENT_RING_MASK];
+    unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+    /* Claimed but not yet published (a producer was preempted mid-push) also
+       reads as empty, so events always come out in claim order. */
+    if ((int32_t)(sequence - (pos + 1U)) < 0)
+    {
+        return 0U;
+    }
+
+    if (event != NULL)
+    {
+        *event = slot->event;
+    }
+    atomic_store_explicit(&slot->sequence, pos + SCOPE_EVENT_RING_SIZE, memory_order_release);
+    ring->dequeue_pos = pos + 1U;
+    return 1U;
+}
+
+uint32_t ScopeEvents_Dropped(ScopeEventRing *ring)
+{
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
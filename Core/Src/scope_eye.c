@@ -0,0 +1,348 @@
+#include "scope_eye.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum
+{
+    EYE_MAX_RUN_UI = 16U,
+    EYE_PHASE_GAIN_SHIFT = 2U,
+    EYE_UI_GAIN_SHIFT = 3U,
+    EYE_UI_SETTLED_SHIFT = 7U,
+    EYE_HIT_MAX = 255U,
+    EYE_CENTRE_COLUMN = SCOPE_EYE_UI_COLUMNS
+};
+
+typedef struct
+{
+    uint32_t baud;
+    uint8_t enabled;
+    uint8_t phase_valid;
+    uint8_t prev_valid;
+    int32_t ui_q8;
+    int32_t boundary_q8;
+    int32_t prev_phase_q8;
+    uint16_t prev_value;
+    uint32_t sample_rate_hz;
+    int32_t lower;
+    uint32_t span;
+    uint32_t unit_intervals;
+    uint32_t generation;
+    uint8_t hits[SCOPE_EYE_ROWS][SCOPE_EYE_COLUMNS];
+} ScopeEyeModule;
+
+static ScopeEyeModule scope_eye_module;
+
+static void ScopeEye_Clear(void);
+static void ScopeEye_Unlock(void);
+static void ScopeEye_UpdateUnitInterval(const ScopeSignalCrossings *crossings);
+static void ScopeEye_TrackEdge(int32_t edge_q8);
+static void ScopeEye_PlotSegment(int32_t phase_q8, uint16_t prev_value, uint16_t value);
+static int32_t ScopeEye_Mod(int32_t value, int32_t modulus);
+static uint8_t ScopeEye_ColumnHit(uint16_t row, uint16_t column);
+
+void ScopeEye_Init(void)
+{
+    memset(&scope_eye_module, 0, sizeof(scope_eye_module));
+}
+
+uint8_t ScopeEye_Configure(uint32_t baud)
+{
+    scope_eye_module.baud = baud;
+    scope_eye_module.ui_q8 = 0;
+    scope_eye_module.sample_rate_hz = 0U;
+    ScopeEye_Unlock();
+    ScopeEye_Clear();
+    return 1U;
+}
+
+void ScopeEye_SetEnabled(uint8_t enabled)
+{
+    scope_eye_module.enabled = enabled ? 1U : 0U;
+    ScopeEye_Unlock();
+    ScopeEye_Clear();
+}
+
+uint8_t ScopeEye_IsEnabled(void)
+{
+    return scope_eye_module.enabled;
+}
+
+void ScopeEye_Reset(void)
+{
+    ScopeEye_Clear();
+}
+
+void ScopeEye_Process(const uint16_t *samples,
+                      uint16_t count,
+                      const ScopeSignalCrossings *crossings,
+                      uint8_t contiguous,
+                      uint32_t sample_rate_hz,
+                      int32_t lower_counts,
+                      uint32_t span_counts)
+{
+    ScopeEyeModule *eye = &scope_eye_module;
+    if (!eye->enabled || samples == NULL || count == 0U || crossings == NULL || span_counts == 0U)
+    {
+        return;
+    }
+
+    if (sample_rate_hz != eye->sample_rate_hz || lower_counts != eye->lower || span_counts != eye->span)
+    {
+        eye->sample_rate_hz = sample_rate_hz;
+        eye->lower = lower_counts;
+        eye->span = span_counts;
+        eye->ui_q8 = 0;
+        ScopeEye_Unlock();
+        ScopeEye_Clear();
+    }
+    if (eye->baud != 0U)
+    {
+        eye->ui_q8 = (int32_t)(((uint64_t)sample_rate_hz << 8) / eye->baud);
+    }
+    if (!contiguous || crossings->truncated)
+    {
+        ScopeEye_Unlock();
+    }
+    if (eye->baud == 0U)
+    {
+        ScopeEye_UpdateUnitInterval(crossings);
+    }
+    if (eye->ui_q8 < (int32_t)(SCOPE_EYE_MIN_SAMPLES_PER_UI << 8))
+    {
+        eye->prev_valid = 0U;
+        return;
+    }
+
+    const ScopeSignalCrossing *edges = crossings->edges;
+    uint16_t e = 0U;
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        int32_t position_q8 = (int32_t)i << 8;
+        while (e < crossings->count && (int32_t)edges[e].position_q8 <= position_q8)
+        {
+            ScopeEye_TrackEdge((int32_t)edges[e].position_q8);
+            e++;
+        }
+        if (!eye->phase_valid)
+        {
+            continue;
+        }
+
+        /* The window opens half a UI before a boundary, so the eye centre lands on
+           column 0 and SCOPE_EYE_UI_COLUMNS and the crossings between them. */
+        int32_t phase_q8 = ScopeEye_Mod(position_q8 - eye->boundary_q8 + eye->ui_q8 / 2, eye->ui_q8);
+        if (eye->prev_valid)
+        {
+            if (phase_q8 < eye->prev_phase_q8)
+            {
+                eye->unit_intervals++;
+            }
+            ScopeEye_PlotSegment(phase_q8, eye->prev_value, samples[i]);
+        }
+        eye->prev_phase_q8 = phase_q8;
+        eye->prev_value = samples[i];
+        eye->prev_valid = 1U;
+    }
+
+    if (eye->phase_valid)
+    {
+        eye->boundary_q8 = ScopeEye_Mod(eye->boundary_q8 - ((int32_t)count << 8), eye->ui_q8) - eye->ui_q8;
+    }
+}
+
+void ScopeEye_GetStatus(ScopeEyeStatus *status)
+{
+    const ScopeEyeModule *eye = &scope_eye_module;
+    if (status == NULL)
+    {
+        return;
+    }
+    memset(status, 0, sizeof(*status));
+    status->baud = eye->baud;
+    status->ui_q8 = (eye->ui_q8 > 0) ? (uint32_t)eye->ui_q8 : 0U;
+    status->unit_intervals = eye->unit_intervals;
+    status->generation = eye->generation;
+    status->locked = eye->phase_valid;
+    if (eye->unit_intervals == 0U)
+    {
+        return;
+    }
+
+    /* Decision threshold: halfway between the extreme traces at the eye centre. */
+    int32_t row_min = -1;
+    int32_t row_max = -1;
+    for (uint16_t row = 0U; row < SCOPE_EYE_ROWS; row++)
+    {
+        if (ScopeEye_ColumnHit(row, EYE_CENTRE_COLUMN))
+        {
+            row_min = (row_min < 0) ? (int32_t)row : row_min;
+            row_max = (int32_t)row;
+        }
+    }
+    if (row_min < 0 || row_max <= row_min)
+    {
+        return;
+    }
+    int32_t threshold = (row_min + row_max) / 2;
+    if (ScopeEye_ColumnHit((uint16_t)threshold, EYE_CENTRE_COLUMN))
+    {
+        return;
+    }
+
+    int32_t upper = threshold;
+    while (upper < row_max && !ScopeEye_ColumnHit((uint16_t)upper, EYE_CENTRE_COLUMN))
+    {
+        upper++;
+    }
+    int32_t lower = threshold;
+    while (lower > row_min && !ScopeEye_ColumnHit((uint16_t)lower, EYE_CENTRE_COLUMN))
+    {
+        lower--;
+    }
+    int32_t left = EYE_CENTRE_COLUMN;
+    while (left > 0 && eye->hits[threshold][left - 1] == 0U)
+    {
+        left--;
+    }
+    int32_t right = EYE_CENTRE_COLUMN;
+    while (right < (int32_t)SCOPE_EYE_COLUMNS - 1 && eye->hits[threshold][right + 1] == 0U)
+    {
+        right++;
+    }
+
+    uint32_t open_columns = (uint32_t)(right - left + 1);
+    status->open = 1U;
+    status->height_counts = ((uint32_t)(upper - lower) * eye->span) / SCOPE_EYE_ROWS;
+    status->width_q8 = (uint32_t)(((uint64_t)open_columns * (uint32_t)eye->ui_q8) / SCOPE_EYE_UI_COLUMNS);
+    status->width_permille = (uint16_t)((open_columns * 1000U) / SCOPE_EYE_UI_COLUMNS);
+}
+
+const uint8_t *ScopeEye_Hits(void)
+{
+    return &scope_eye_module.hits[0][0];
+}
+
+static void ScopeEye_Clear(void)
+{
+    memset(scope_eye_module.hits, 0, sizeof(scope_eye_module.hits));
+    scope_eye_module.unit_intervals = 0U;
+    scope_eye_module.generation++;
+}
+
+static void ScopeEye_Unlock(void)
+{
+    scope_eye_module.phase_valid = 0U;
+    scope_eye_module.prev_valid = 0U;
+}
+
+/* Edge spacings are whole multiples of the UI: seed from the shortest one, then
+   refine with the total span over the total number of UIs it covers. */
+static void ScopeEye_UpdateUnitInterval(const ScopeSignalCrossings *crossings)
+{
+    ScopeEyeModule *eye = &scope_eye_module;
+    if (crossings->count < 2U)
+    {
+        return;
+    }
+
+    int32_t shortest = 0x7FFFFFFF;
+    for (uint16_t k = 1U; k < crossings->count; k++)
+    {
+        int32_t d = (int32_t)(crossings->edges[k].position_q8 - crossings->edges[k - 1U].position_q8);
+        shortest = (d < shortest) ? d : shortest;
+    }
+    if (shortest < (int32_t)(SCOPE_EYE_MIN_SAMPLES_PER_UI << 8))
+    {
+        return;
+    }
+    if (eye->ui_q8 == 0 || shortest * 4 < eye->ui_q8 * 3)
+    {
+        eye->ui_q8 = shortest;
+        ScopeEye_Unlock();
+        ScopeEye_Clear();
+    }
+
+    int32_t span_q8 = 0;
+    int32_t span_ui = 0;
+    for (uint16_t k = 1U; k < crossings->count; k++)
+    {
+        int32_t d = (int32_t)(crossings->edges[k].position_q8 - crossings->edges[k - 1U].position_q8);
+        int32_t n = (d + eye->ui_q8 / 2) / eye->ui_q8;
+        if (n >= 1 && n <= (int32_t)EYE_MAX_RUN_UI)
+        {
+            span_q8 += d;
+            span_ui += n;
+        }
+    }
+    if (span_ui != 0)
+    {
+        /* Traces laid down while the estimate was still moving would smear the
+           eye for good, so start over until it settles. */
+        int32_t error = span_q8 / span_ui - eye->ui_q8;
+        eye->ui_q8 += error / (1 << EYE_UI_GAIN_SHIFT);
+        if ((error < 0 ? -error : error) > (eye->ui_q8 >> EYE_UI_SETTLED_SHIFT))
+        {
+            ScopeEye_Clear();
+        }
+    }
+}
+
+/* First-order phase tracking: each edge pulls the UI grid a quarter of the way
+   towards itself, which follows drift without locking onto single-edge jitter. */
+static void ScopeEye_TrackEdge(int32_t edge_q8)
+{
+    ScopeEyeModule *eye = &scope_eye_module;
+    if (!eye->phase_valid)
+    {
+        eye->boundary_q8 = edge_q8;
+        eye->phase_valid = 1U;
+        eye->prev_valid = 0U;
+        return;
+    }
+
+    int32_t offset = ScopeEye_Mod(edge_q8 - eye->boundary_q8 + eye->ui_q8 / 2, eye->ui_q8) - eye->ui_q8 / 2;
+    eye->boundary_q8 = edge_q8 - offset + offset / (1 << EYE_PHASE_GAIN_SHIFT);
+}
+
+static void ScopeEye_PlotSegment(int32_t phase_q8, uint16_t prev_value, uint16_t value)
+{
+    ScopeEyeModule *eye = &scope_eye_module;
+    const int32_t ui = eye->ui_q8;
+    int32_t x1 = (int32_t)(((int64_t)phase_q8 * SCOPE_EYE_UI_COLUMNS * 256) / ui);
+    int32_t x0 = (int32_t)(((int64_t)(phase_q8 - 256) * SCOPE_EYE_UI_COLUMNS * 256) / ui);
+    if (x1 <= x0)
+    {
+        return;
+    }
+
+    const int32_t dv = (int32_t)value - (int32_t)prev_value;
+    int32_t column = (x0 >= 0) ? (x0 + 255) / 256 : -((-x0) / 256);
+    for (; column * 256 <= x1; column++)
+    {
+        int32_t v = (int32_t)prev_value + (int32_t)(((int64_t)dv * (column * 256 - x0)) / (x1 - x0));
+        int32_t row = (int32_t)(((int64_t)(v - eye->lower) * SCOPE_EYE_ROWS) / (int32_t)eye->span);
+        if (row < 0 || row >= (int32_t)SCOPE_EYE_ROWS)
+        {
+            continue;
+        }
+        int32_t wrapped = ScopeEye_Mod(column, SCOPE_EYE_UI_COLUMNS);
+        uint8_t *first = &eye->hits[row][wrapped];
+        uint8_t *second = &eye->hits[row][wrapped + SCOPE_EYE_UI_COLUMNS];
+        *first = (*first < EYE_HIT_MAX) ? (uint8_t)(*first + 1U) : *first;
+        *second = (*second < EYE_HIT_MAX) ? (uint8_t)(*second + 1U) : *second;
+    }
+}
+
+static int32_t ScopeEye_Mod(int32_t value, int32_t modulus)
+{
+    int32_t r = value % modulus;
+    return (r < 0) ? r + modulus : r;
+}
+
+static uint8_t ScopeEye_ColumnHit(uint16_t row, uint16_t column)
+{
+    const ScopeEyeModule *eye = &scope_eye_module;
+    return (eye->hits[row][column] != 0U || eye->hits[row][column - 1U] != 0U ||
+            eye->hits[row][column + 1U] != 0U) ? 1U : 0U;
+}
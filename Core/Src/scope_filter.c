@@ -0,0 +1,384 @@
+#include "scope_filter.h"
+
+#include "main.h"
+#include "scope.h"
+#include "scope_dsp.h"
+#include "scope_profile.h"
+#include "scope_signal.h"
+
+#include <math.h>
+#include <string.h>
+
+enum
+{
+    FILTER_ADC_MIDSCALE = 2048,
+    FILTER_ADC_MAX = 4095,
+    FILTER_INPUT_SHIFT = 3U,
+    /* Q29 leaves room for a1 up to -2 and still resolves the w0^2 terms
+       of a low cutoff. */
+    FILTER_BIQUAD_Q_BITS = 29U,
+    /* Fraction bits kept below the output in the feedback state; rounding
+       y to whole counts there stalls a low cutoff short of its DC level. */
+    FILTER_BIQUAD_STATE_BITS = 14U,
+    FILTER_FIR_TAPS = 16U,
+    FILTER_FIR_Q_BITS = 15U,
+    FILTER_MIN_CUTOFF_DIVISOR = 400U
+};
+
+typedef struct
+{
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t na1;
+    int32_t na2;
+    int16_t x1;
+    int16_t x2;
+    int32_t y1;
+    int32_t y2;
+} ScopeFilterBiquad;
+
+typedef struct
+{
+    uint32_t taps_reversed[FILTER_FIR_TAPS / 2U];
+    int16_t history[FILTER_FIR_TAPS - 1U];
+} ScopeFilterFir;
+
+typedef struct
+{
+    volatile ScopeFilterType type;
+    uint32_t cutoff_hz;
+    uint32_t designed_rate_hz;
+    uint8_t prime_pending;
+    ScopeFilterBiquad biquad;
+    ScopeFilterFir fir;
+    uint32_t cycles_per_frame;
+    uint32_t cycles_per_sample_x100;
+} ScopeFilterModule;
+
+static ScopeFilterModule scope_filter_module;
+static int16_t scope_filter_work[FILTER_FIR_TAPS - 1U + SCOPE_FRAME_SAMPLES];
+
+static uint8_t ScopeFilter_Design(uint32_t sample_rate_hz);
+static void ScopeFilter_DesignBiquad(ScopeFilterType type, float w0);
+static void ScopeFilter_DesignFir(float cutoff_norm);
+static void ScopeFilter_Prime(int16_t x0);
+static void ScopeFilter_RunBiquad(uint16_t *samples, uint16_t count);
+static void ScopeFilter_RunFir(uint16_t *samples, uint16_t count);
+static inline int16_t ScopeFilter_ToInternal(uint16_t sample);
+static inline uint16_t ScopeFilter_ToSample(int32_t value);
+
+void ScopeFilter_Init(void)
+{
+    memset(&scope_filter_module, 0, sizeof(scope_filter_module));
+    scope_filter_module.type = SCOPE_FILTER_OFF;
+}
+
+uint8_t ScopeFilter_Configure(ScopeFilterType type, uint32_t cutoff_hz)
+{
+    if (type == SCOPE_FILTER_OFF)
+    {
+        scope_filter_module.type = SCOPE_FILTER_OFF;
+        scope_filter_module.cutoff_hz = 0U;
+        scope_filter_module.cycles_per_frame = 0U;
+        scope_filter_module.cycles_per_sample_x100 = 0U;
+        return 1U;
+    }
+
+    if (type > SCOPE_FILTER_FIR_LOWPASS || cutoff_hz == 0U)
+    {
+        return 0U;
+    }
+
+    uint32_t sample_rate = ScopeSignal_GetSampleRateHz();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ScopeFilterType previous_type = scope_filter_module.type;
+    uint32_t previous_cutoff = scope_filter_module.cutoff_hz;
+    scope_filter_module.type = type;
+    scope_filter_module.cutoff_hz = cutoff_hz;
+    uint8_t designed = ScopeFilter_Design(sample_rate);
+    if (!designed)
+    {
+        scope_filter_module.type = previous_type;
+        scope_filter_module.cutoff_hz = previous_cutoff;
+        if (previous_type != SCOPE_FILTER_OFF)
+        {
+            ScopeFilter_Design(sample_rate);
+        }
+    }
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+    return designed;
+}
+
+void ScopeFilter_Service(uint32_t sample_rate_hz)
+{
+    if (scope_filter_module.type == SCOPE_FILTER_OFF ||
+        sample_rate_hz == scope_filter_module.designed_rate_hz)
+    {
+        return;
+    }
+
+    /* Masked so the interrupt never runs half a coefficient set; a design
+       takes tens of microseconds, well inside a half-buffer. */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!ScopeFilter_Design(sample_rate_hz))
+    {
+        scope_filter_module.type = SCOPE_FILTER_OFF;
+    }
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+}
+
+void ScopeFilter_ProcessFromISR(uint16_t *samples, uint16_t count)
+{
+    if (scope_filter_module.type == SCOPE_FILTER_OFF || samples == NULL || count == 0U)
+    {
+        return;
+    }
+
+    if (count > SCOPE_FRAME_SAMPLES)
+    {
+        count = SCOPE_FRAME_SAMPLES;
+    }
+
+    uint32_t start = ScopeProfile_CycleCount();
+    if (scope_filter_module.prime_pending)
+    {
+        ScopeFilter_Prime(ScopeFilter_ToInternal(samples[0]));
+        scope_filter_module.prime_pending = 0U;
+    }
+
+    if (scope_filter_module.type == SCOPE_FILTER_FIR_LOWPASS)
+    {
+        ScopeFilter_RunFir(samples, count);
+    }
+    else
+    {
+        ScopeFilter_RunBiquad(samples, count);
+    }
+
+    uint32_t cycles = ScopeProfile_CycleCount() - start;
+    scope_filter_module.cycles_per_frame = cycles;
+    scope_filter_module.cycles_per_sample_x100 = (cycles * 100U) / count;
+}
+
+void ScopeFilter_GetStatus(ScopeFilterStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    status->type = scope_filter_module.type;
+    status->cutoff_hz = scope_filter_module.cutoff_hz;
+    status->sample_rate_hz = scope_filter_module.designed_rate_hz;
+    status->cycles_per_frame = scope_filter_module.cycles_per_frame;
+    status->cycles_per_sample_x100 = scope_filter_module.cycles_per_sample_x100;
+}
+
+static uint8_t ScopeFilter_Design(uint32_t sample_rate_hz)
+{
+    uint32_t cutoff = scope_filter_module.cutoff_hz;
+    if (sample_rate_hz == 0U || cutoff >= sample_rate_hz / 2U ||
+        cutoff < sample_rate_hz / FILTER_MIN_CUTOFF_DIVISOR)
+    {
+        return 0U;
+    }
+
+    float cutoff_norm = (float)cutoff / (float)sample_rate_hz;
+    if (scope_filter_module.type == SCOPE_FILTER_FIR_LOWPASS)
+    {
+        ScopeFilter_DesignFir(cutoff_norm);
+    }
+    else
+    {
+        ScopeFilter_DesignBiquad(scope_filter_module.type, 2.0f * (float)M_PI * cutoff_norm);
+    }
+
+    scope_filter_module.designed_rate_hz = sample_rate_hz;
+    scope_filter_module.prime_pending = 1U;
+    return 1U;
+}
+
+static void ScopeFilter_DesignBiquad(ScopeFilterType type, float w0)
+{
+    /* RBJ cookbook sections, normalised by a0 and quantised to Q29. */
+    float cos_w0 = cosf(w0);
+    float q = (type == SCOPE_FILTER_BANDPASS) ? 1.0f : 0.70710678f;
+    float alpha = sinf(w0) / (2.0f * q);
+    float b0;
+    float b1;
+    float b2;
+
+    if (type == SCOPE_FILTER_HIGHPASS)
+    {
+        b0 = (1.0f + cos_w0) / 2.0f;
+        b1 = -(1.0f + cos_w0);
+        b2 = b0;
+    }
+    else if (type == SCOPE_FILTER_BANDPASS)
+    {
+        b0 = alpha;
+        b1 = 0.0f;
+        b2 = -alpha;
+    }
+    else
+    {
+        b0 = (1.0f - cos_w0) / 2.0f;
+        b1 = 1.0f - cos_w0;
+        b2 = b0;
+    }
+
+    float a0 = 1.0f + alpha;
+    float a1 = -2.0f * cos_w0;
+    float a2 = 1.0f - alpha;
+    const float scale = (float)(1UL << FILTER_BIQUAD_Q_BITS) / a0;
+
+    ScopeFilterBiquad *bq = &scope_filter_module.biquad;
+    bq->b0 = (int32_t)lrintf(b0 * scale);
+    bq->b1 = (int32_t)lrintf(b1 * scale);
+    bq->b2 = (int32_t)lrintf(b2 * scale);
+    bq->na1 = (int32_t)lrintf(-a1 * scale);
+    bq->na2 = (int32_t)lrintf(-a2 * scale);
+}
+
+static void ScopeFilter_DesignFir(float cutoff_norm)
+{
+    /* Hamming-windowed sinc, normalised for unity DC gain before quantisation. */
+    float taps[FILTER_FIR_TAPS];
+    float sum = 0.0f;
+    const float center = (float)(FILTER_FIR_TAPS - 1U) / 2.0f;
+    for (uint32_t n = 0U; n < FILTER_FIR_TAPS; n++)
+    {
+        float t = (float)n - center;
+        float sinc = 2.0f * cutoff_norm;
+        if (t != 0.0f)
+        {
+            sinc = sinf(2.0f * (float)M_PI * cutoff_norm * t) / ((float)M_PI * t);
+        }
+        float window = 0.54f - 0.46f * cosf(2.0f * (float)M_PI * (float)n /
+                                            (float)(FILTER_FIR_TAPS - 1U));
+        taps[n] = sinc * window;
+        sum += taps[n];
+    }
+
+    const float scale = (float)(1UL << FILTER_FIR_Q_BITS) / sum;
+    for (uint32_t pair = 0U; pair < FILTER_FIR_TAPS / 2U; pair++)
+    {
+        /* Reversed order so ascending memory pairs line up with the delay line. */
+        int32_t low = (int32_t)lrintf(taps[FILTER_FIR_TAPS - 1U - 2U * pair] * scale);
+        int32_t high = (int32_t)lrintf(taps[FILTER_FIR_TAPS - 2U - 2U * pair] * scale);
+        scope_filter_module.fir.taps_reversed[pair] =
+            ScopeDsp_Pack16(ScopeDsp_SaturateQ15(low), ScopeDsp_SaturateQ15(high));
+    }
+}
+
+static void ScopeFilter_Prime(int16_t x0)
+{
+    ScopeFilterBiquad *bq = &scope_filter_module.biquad;
+    bq->x1 = x0;
+    bq->x2 = x0;
+    bq->y1 = (scope_filter_module.type == SCOPE_FILTER_LOWPASS) ?
+             (int32_t)x0 * (1L << FILTER_BIQUAD_STATE_BITS) : 0;
+    bq->y2 = bq->y1;
+
+    for (uint32_t idx = 0U; idx < FILTER_FIR_TAPS - 1U; idx++)
+    {
+        scope_filter_module.fir.history[idx] = x0;
+    }
+}
+
+static void ScopeFilter_RunBiquad(uint16_t *samples, uint16_t count)
+{
+    /* DF1 with 64-bit accumulation (SMLAL on the M4): the feedforward
+       products are lifted to the state's fraction bits, so the truncation
+       that feeds back is 2^-14 of an internal count and the DC level of even
+       the lowest cutoff settles within a fraction of an ADC count. */
+    ScopeFilterBiquad *bq = &scope_filter_module.biquad;
+    const int32_t b0 = bq->b0;
+    const int32_t b1 = bq->b1;
+    const int32_t b2 = bq->b2;
+    const int32_t na1 = bq->na1;
+    const int32_t na2 = bq->na2;
+    const int32_t state_limit = (int32_t)INT16_MAX * (1L << FILTER_BIQUAD_STATE_BITS);
+    int16_t x1 = bq->x1;
+    int16_t x2 = bq->x2;
+    int32_t y1 = bq->y1;
+    int32_t y2 = bq->y2;
+
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        int16_t x0 = ScopeFilter_ToInternal(samples[i]);
+        int64_t acc = (int64_t)b0 * x0 + (int64_t)b1 * x1 + (int64_t)b2 * x2;
+        acc *= (1L << FILTER_BIQUAD_STATE_BITS);
+        acc += (int64_t)na1 * y1 + (int64_t)na2 * y2;
+        acc += 1LL << (FILTER_BIQUAD_Q_BITS - 1U);
+        int64_t y = acc >> FILTER_BIQUAD_Q_BITS;
+        int32_t y0 = (int32_t)((y > state_limit) ? state_limit :
+                               (y < -state_limit) ? -state_limit : y);
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        samples[i] = ScopeFilter_ToSample((y0 + (1L << (FILTER_BIQUAD_STATE_BITS - 1U))) >>
+                                          FILTER_BIQUAD_STATE_BITS);
+    }
+
+    bq->x1 = x1;
+    bq->x2 = x2;
+    bq->y1 = y1;
+    bq->y2 = y2;
+}
+
+static void ScopeFilter_RunFir(uint16_t *samples, uint16_t count)
+{
+    ScopeFilterFir *fir = &scope_filter_module.fir;
+    const uint32_t history_len = FILTER_FIR_TAPS - 1U;
+
+    memcpy(scope_filter_work, fir->history, sizeof(fir->history));
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        scope_filter_work[history_len + i] = ScopeFilter_ToInternal(samples[i]);
+    }
+
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        const int16_t *window = &scope_filter_work[i];
+        int32_t acc = 1L << (FILTER_FIR_Q_BITS - 1U);
+        for (uint32_t pair = 0U; pair < FILTER_FIR_TAPS / 2U; pair++)
+        {
+            acc = ScopeDsp_DualMac(ScopeDsp_ReadPair(&window[2U * pair]),
+                                   fir->taps_reversed[pair],
+                                   acc);
+        }
+        samples[i] = ScopeFilter_ToSample(acc >> FILTER_FIR_Q_BITS);
+    }
+
+    memcpy(fir->history, &scope_filter_work[count], sizeof(fir->history));
+}
+
+static inline int16_t ScopeFilter_ToInternal(uint16_t sample)
+{
+    return (int16_t)(((int32_t)sample - FILTER_ADC_MIDSCALE) * (1 << FILTER_INPUT_SHIFT));
+}
+
+static inline uint16_t ScopeFilter_ToSample(int32_t value)
+{
+    int32_t sample = (value / (1 << FILTER_INPUT_SHIFT)) + FILTER_ADC_MIDSCALE;
+    if (sample < 0)
+    {
+        sample = 0;
+    }
+    else if (sample > FILTER_ADC_MAX)
+    {
+        sample = FILTER_ADC_MAX;
+    }
+    return (uint16_t)sample;
+}
@@ -0,0 +1,75 @@
+#include "scope_flash.h"
+
+#include "main.h"
+
+#include <stddef.h>
+
+enum { FLASH_CRC32_POLY = 0xEDB88320U };
+
+uint32_t ScopeFlash_Crc32(uint32_t crc, const void *data, uint32_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    crc = ~crc;
+    for (uint32_t i = 0U; i < length; ++i)
+    {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0U; bit < 8U; ++bit)
+        {
+            crc = (crc >> 1) ^ (FLASH_CRC32_POLY & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+uint8_t ScopeFlash_IsErased(uint32_t address, uint32_t length)
+{
+    const uint32_t *words = (const uint32_t *)(uintptr_t)address;
+    for (uint32_t i = 0U; i < length / sizeof(uint32_t); ++i)
+    {
+        if (words[i] != 0xFFFFFFFFU)
+        {
+            return 0U;
+        }
+    }
+    return 1U;
+}
+
+uint8_t ScopeFlash_EraseSector(uint32_t sector)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .Sector = sector,
+        .NbSectors = 1U,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3
+    };
+    uint32_t bad_sector = 0U;
+
+    /* About a second per 128 KB sector; acquisition frames that arrive
+       meanwhile are counted as overruns. */
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &bad_sector);
+    HAL_FLASH_Lock();
+    return (status == HAL_OK) ? 1U : 0U;
+}
+
+uint8_t ScopeFlash_ProgramWords(uint32_t address, const uint32_t *words, uint32_t count)
+{
+    if (words == NULL || (address & 3U) != 0U)
+    {
+        return 0U;
+    }
+
+    uint8_t ok = 1U;
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0U; ok && i < count; ++i)
+    {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,
+                              address + i * sizeof(uint32_t),
+                              words[i]) != HAL_OK)
+        {
+            ok = 0U;
+        }
+    }
+    HAL_FLASH_Lock();
+    return ok;
+}
@@ -0,0 +1,375 @@
+#include "scope_fra.h"
+
+#include "main.h"
+#include "scope.h"
+#include "scope_buffer.h"
+#include "scope_calib.h"
+#include "scope_decim.h"
+#include "scope_lockin.h"
+#include "scope_profile.h"
+#include "scope_signal.h"
+#include "tim.h"
+#include "waveform_control.h"
+
+#include <math.h>
+#include <string.h>
+
+enum
+{
+    FRA_SINE_STEPS = 64U,
+    FRA_DMA_SAMPLES = 2U * SCOPE_FRAME_SAMPLES,
+    FRA_DAC_AMPLITUDE_COUNTS = 2047U,
+    FRA_ADC_FULL_SCALE = 4095U,
+    /* A pending half-transfer interrupt may still precede the frame the
+       restart cut in two, so the first clean frame is two sequences on. */
+    FRA_RESTART_FRAMES = 2U,
+    /* Whole frames of the new tone (five cycles each) before capturing. */
+    FRA_SETTLE_FRAMES = 2U,
+    FRA_CAPTURE_FRAMES = 4U
+};
+
+typedef struct
+{
+    uint8_t running;
+    uint8_t aborted;
+    uint8_t done_pending;
+    uint8_t point_count;
+    uint8_t point_index;
+    uint8_t points_done;
+    uint8_t reported;
+    uint8_t frames_captured;
+    uint32_t start_hz;
+    uint32_t stop_hz;
+    uint32_t target_hz[SCOPE_FRA_MAX_POINTS];
+    /* First frame sequence that counts toward the point being measured. */
+    uint32_t first_sequence;
+    /* Phase of the DAC fundamental at the first sample of every frame. */
+    float reference_deg;
+    float acc_re;
+    float acc_im;
+    float millivolt_per_count;
+    float dac_amplitude_mv;
+    /* State the sweep borrowed and gives back when it ends. */
+    uint32_t saved_sine_hz;
+    uint32_t saved_psc;
+    uint32_t saved_arr;
+    uint16_t saved_decimation;
+    uint8_t saved_lockin;
+    uint32_t start_ms;
+    uint32_t last_ms;
+    uint32_t elapsed_ms;
+    uint32_t sweeps;
+    uint32_t cycles_per_point;
+} ScopeFraModule;
+
+static ScopeFraModule scope_fra_module;
+static ScopeFraPoint scope_fra_points[SCOPE_FRA_MAX_POINTS];
+static float scope_fra_coeff;
+static float scope_fra_cos;
+static float scope_fra_sin;
+
+static uint8_t ScopeFra_Tune(uint8_t index);
+static void ScopeFra_Accumulate(const uint16_t *samples, uint16_t count);
+static void ScopeFra_Finalize(uint8_t index, float re, float im, float reference_deg, uint32_t samples);
+static void ScopeFra_Finish(uint8_t aborted);
+
+void ScopeFra_Init(void)
+{
+    memset(&scope_fra_module, 0, sizeof(scope_fra_module));
+    memset(scope_fra_points, 0, sizeof(scope_fra_points));
+
+    /* The ADC runs off the DAC timer settings, so the tone always sits at one
+       64th of the sample rate: a fixed Goertzel bin with exact coefficients. */
+    float omega = 6.28318530718f / (float)FRA_SINE_STEPS;
+    scope_fra_cos = cosf(omega);
+    scope_fra_sin = sinf(omega);
+    scope_fra_coeff = 2.0f * scope_fra_cos;
+}
+
+uint8_t ScopeFra_Start(uint32_t start_hz, uint32_t stop_hz, uint8_t points, uint32_t now_ms)
+{
+    ScopeFraModule *m = &scope_fra_module;
+    if (start_hz < SCOPE_FRA_MIN_HZ || stop_hz > SCOPE_FRA_MAX_HZ || start_hz >= stop_hz ||
+        points < SCOPE_FRA_MIN_POINTS || points > SCOPE_FRA_MAX_POINTS)
+    {
+        return 0U;
+    }
+
+    ScopeFra_Stop();
+
+    m->saved_sine_hz = WaveformControl_GetSineFrequency();
+    ScopeSignal_GetTimerPeriod(&m->saved_psc, &m->saved_arr);
+    m->saved_decimation = ScopeDecim_GetRatio();
+    m->saved_lockin = ScopeLockin_IsEnabled();
+    /* The sweep restarts both timers for every point, which would silently
+       shift the lock-in reference, and needs raw frames at the ADC rate. */
+    (void)ScopeLockin_SetEnabled(0U);
+    (void)ScopeDecim_Configure(1U);
+
+    float ratio = (float)stop_hz / (float)start_hz;
+    for (uint8_t i = 0U; i < points; ++i)
+    {
+        float hz = (float)start_hz * powf(ratio, (float)i / (float)(points - 1U));
+        m->target_hz[i] = (uint32_t)lrintf(hz);
+    }
+
+    /* DAC and ADC share the analog reference, so the stimulus amplitude is
+       known in millivolts without measuring it. */
+    ScopeCalibStatus calib;
+    ScopeCalib_GetStatus(&calib);
+    m->millivolt_per_count = (float)ScopeCalib_SpanToMillivolt(1UL << 16) / 65536.0f;
+    m->dac_amplitude_mv = (float)calib.vdda_millivolt * (float)FRA_DAC_AMPLITUDE_COUNTS /
+                          (float)FRA_ADC_FULL_SCALE;
+
+    memset(scope_fra_points, 0, sizeof(scope_fra_points));
+    m->start_hz = start_hz;
+    m->stop_hz = stop_hz;
+    m->point_count = points;
+    m->point_index = 0U;
+    m->points_done = 0U;
+    m->reported = 0U;
+    m->frames_captured = 0U;
+    m->acc_re = 0.0f;
+    m->acc_im = 0.0f;
+    m->aborted = 0U;
+    m->done_pending = 0U;
+    m->start_ms = now_ms;
+    m->last_ms = now_ms;
+    m->elapsed_ms = 0U;
+    m->sweeps++;
+    m->running = 1U;
+
+    if (!ScopeFra_Tune(0U))
+    {
+        ScopeFra_Finish(1U);
+        return 0U;
+    }
+    return 1U;
+}
+
+void ScopeFra_Stop(void)
+{
+    if (scope_fra_module.running)
+    {
+        ScopeFra_Finish(1U);
+    }
+}
+
+uint8_t ScopeFra_IsRunning(void)
+{
+    return scope_fra_module.running;
+}
+
+uint8_t ScopeFra_Step(const uint16_t *samples, uint16_t count, uint32_t sequence, uint32_t now_ms)
+{
+    ScopeFraModule *m = &scope_fra_module;
+    if (!m->running || samples == NULL)
+    {
+        return 0U;
+    }
+    m->last_ms = now_ms;
+    if ((int32_t)(sequence - m->first_sequence) < 0)
+    {
+        return 0U;
+    }
+
+    /* Frames hold a whole number of cycles so the bin leaks nothing. */
+    count = (uint16_t)(count - count % FRA_SINE_STEPS);
+    if (count == 0U)
+    {
+        return 0U;
+    }
+
+    if (m->frames_captured + 1U < FRA_CAPTURE_FRAMES)
+    {
+        ScopeFra_Accumulate(samples, count);
+        m->frames_captured++;
+        return 0U;
+    }
+
+    /* Last frame of this point: move the stimulus on first, so the next point
+       settles while this one is finished, drawn and reported. The frame is
+       already copied out of the DMA buffer. */
+    uint8_t index = m->point_index;
+    float reference_deg = m->reference_deg;
+    uint32_t start = ScopeProfile_CycleCount();
+    uint8_t more = (uint8_t)(index + 1U < m->point_count);
+    if (more && !ScopeFra_Tune((uint8_t)(index + 1U)))
+    {
+        ScopeFra_Finish(1U);
+        return 0U;
+    }
+
+    ScopeFra_Accumulate(samples, count);
+    float re = m->acc_re;
+    float im = m->acc_im;
+    m->acc_re = 0.0f;
+    m->acc_im = 0.0f;
+    m->frames_captured = 0U;
+    ScopeFra_Finalize(index, re, im, reference_deg, (uint32_t)count * FRA_CAPTURE_FRAMES);
+    m->points_done = (uint8_t)(index + 1U);
+    m->cycles_per_point = ScopeProfile_CycleCount() - start;
+
+    if (more)
+    {
+        m->point_index = (uint8_t)(index + 1U);
+    }
+    else
+    {
+        ScopeFra_Finish(0U);
+    }
+    return 1U;
+}
+
+const ScopeFraPoint *ScopeFra_Points(void)
+{
+    return scope_fra_points;
+}
+
+void ScopeFra_GetStatus(ScopeFraStatus *status)
+{
+    const ScopeFraModule *m = &scope_fra_module;
+    if (status == NULL)
+    {
+        return;
+    }
+    status->running = m->running;
+    status->aborted = m->aborted;
+    status->point_count = m->point_count;
+    status->points_done = m->points_done;
+    status->start_hz = m->start_hz;
+    status->stop_hz = m->stop_hz;
+    status->sweeps = m->sweeps;
+    status->elapsed_ms = m->running ? (m->last_ms - m->start_ms) : m->elapsed_ms;
+    status->cycles_per_point = m->cycles_per_point;
+}
+
+uint8_t ScopeFra_TakePoint(ScopeFraPoint *point, uint8_t *index)
+{
+    ScopeFraModule *m = &scope_fra_module;
+    if (m->reported >= m->points_done)
+    {
+        return 0U;
+    }
+    if (point != NULL)
+    {
+        *point = scope_fra_points[m->reported];
+    }
+    if (index != NULL)
+    {
+        *index = m->reported;
+    }
+    m->reported++;
+    return 1U;
+}
+
+uint8_t ScopeFra_TakeDone(ScopeFraStatus *status)
+{
+    /* Reported after the last point line, so the table always precedes it. */
+    if (!scope_fra_module.done_pending || scope_fra_module.reported < scope_fra_module.points_done)
+    {
+        return 0U;
+    }
+    scope_fra_module.done_pending = 0U;
+    ScopeFra_GetStatus(status);
+    return 1U;
+}
+
+static uint8_t ScopeFra_Tune(uint8_t index)
+{
+    ScopeFraModule *m = &scope_fra_module;
+    if (!WaveformControl_SetSineFrequency(m->target_hz[index]))
+    {
+        return 0U;
+    }
+    /* Same timer settings as the DAC: exactly 64 samples per cycle, and a
+       frame of 320 starts every cycle over at the same phase. */
+    if (!ScopeSignal_SetTimerPeriod(htim4.Instance->PSC, htim4.Instance->ARR))
+    {
+        return 0U;
+    }
+
+    uint32_t dac_remaining = 0U;
+    uint32_t adc_remaining = 0U;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ScopeSignal_RestartWithDac(&dac_remaining, &adc_remaining);
+    uint32_t next_sequence = ScopeBuffer_GetNextSequence();
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+
+    /* Sample n after the restart lands on DMA index adc_next + n and sees the
+       DAC fundamental at phase (n + dac_next - 1.5) / 64 of a cycle (see the
+       lock-in). Frames start on DMA indices that are multiples of 64, so
+       n = -adc_next there, modulo a cycle. */
+    uint32_t dac_next = (FRA_SINE_STEPS - dac_remaining) % FRA_SINE_STEPS;
+    uint32_t adc_next = (FRA_DMA_SAMPLES - adc_remaining) % FRA_DMA_SAMPLES;
+    float steps = (float)dac_next - 1.5f - (float)(adc_next % FRA_SINE_STEPS);
+    m->reference_deg = steps * (360.0f / (float)FRA_SINE_STEPS);
+    m->first_sequence = next_sequence + FRA_RESTART_FRAMES + FRA_SETTLE_FRAMES;
+
+    scope_fra_points[index].freq_centihz =
+        (uint32_t)(((uint64_t)ScopeSignal_GetAdcRateHz() * 100U + FRA_SINE_STEPS / 2U) / FRA_SINE_STEPS);
+    return 1U;
+}
+
+static void ScopeFra_Accumulate(const uint16_t *samples, uint16_t count)
+{
+    /* DC lands in bin zero, which the whole-cycle window keeps orthogonal to
+       the tone, so raw counts go in unchanged. */
+    float s1 = 0.0f;
+    float s2 = 0.0f;
+    for (uint16_t i = 0U; i < count; ++i)
+    {
+        float s0 = (float)samples[i] + scope_fra_coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    /* With a whole number of cycles in the window, X = e^(jw) * s1 - s2. */
+    scope_fra_module.acc_re += s1 * scope_fra_cos - s2;
+    scope_fra_module.acc_im += s1 * scope_fra_sin;
+}
+
+static void ScopeFra_Finalize(uint8_t index, float re, float im, float reference_deg, uint32_t samples)
+{
+    ScopeFraModule *m = &scope_fra_module;
+    ScopeFraPoint *point = &scope_fra_points[index];
+
+    /* For x = A sin(wn + phi): |X| = A N / 2 and arg X = phi - 90 deg. */
+    float amplitude_counts = 2.0f * sqrtf(re * re + im * im) / (float)samples;
+    point->amplitude_mv = amplitude_counts * m->millivolt_per_count;
+    float gain = (m->dac_amplitude_mv > 0.0f) ? point->amplitude_mv / m->dac_amplitude_mv : 0.0f;
+    point->gain_db = (gain > 1.0e-5f) ? 20.0f * log10f(gain) : -100.0f;
+
+    float phase = atan2f(im, re) * 57.2957795f + 90.0f - reference_deg;
+    phase = fmodf(phase, 360.0f);
+    if (phase > 180.0f)
+    {
+        phase -= 360.0f;
+    }
+    else if (phase <= -180.0f)
+    {
+        phase += 360.0f;
+    }
+    point->phase_deg = phase;
+}
+
+static void ScopeFra_Finish(uint8_t aborted)
+{
+    ScopeFraModule *m = &scope_fra_module;
+    m->running = 0U;
+    m->aborted = aborted;
+    m->done_pending = 1U;
+    m->elapsed_ms = m->last_ms - m->start_ms;
+
+    /* Back to the timebase, stimulus and processing the sweep started from. */
+    if (m->saved_sine_hz != 0U)
+    {
+        (void)WaveformControl_SetSineFrequency(m->saved_sine_hz);
+    }
+    (void)ScopeSignal_SetTimerPeriod(m->saved_psc, m->saved_arr);
+    (void)ScopeDecim_Configure(m->saved_decimation);
+    (void)ScopeLockin_SetEnabled(m->saved_lockin);
+}
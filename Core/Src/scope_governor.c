@@ -0,0 +1,148 @@
+#include "scope_governor.h"
+
+#include "main.h"
+#include "scope_buffer.h"
+
+#include <stddef.h>
+
+enum
+{
+    /* A redraw blocks the main loop on SPI; keep at least half of the loop
+       for analysis so the two-frame DMA queue keeps draining. */
+    GOVERNOR_MAX_RENDER_PERCENT = 50U,
+    /* Render and analysis costs are smoothed over about eight frames. */
+    GOVERNOR_AVERAGE_SHIFT = 3U
+};
+
+typedef struct
+{
+    uint16_t target_fps;
+    uint8_t rendered_once;
+    uint32_t last_render_ms;
+    uint32_t acquired_base;
+    uint32_t dropped_base;
+    uint32_t analyzed;
+    uint32_t rendered;
+    uint32_t analysis_cycles;
+    uint32_t render_cycles;
+    uint32_t max_render_cycles;
+} ScopeGovernorModule;
+
+static ScopeGovernorModule scope_governor_module;
+
+static uint32_t ScopeGovernor_Smooth(uint32_t average, uint32_t sample);
+static uint32_t ScopeGovernor_IntervalMs(void);
+
+void ScopeGovernor_Init(void)
+{
+    scope_governor_module.target_fps = SCOPE_GOVERNOR_DEFAULT_FPS;
+    ScopeGovernor_Reset();
+}
+
+void ScopeGovernor_Reset(void)
+{
+    ScopeGovernorModule *m = &scope_governor_module;
+    m->rendered_once = 0U;
+    m->last_render_ms = 0U;
+    m->acquired_base = ScopeBuffer_GetNextSequence();
+    m->dropped_base = ScopeBuffer_GetOverrunCount();
+    m->analyzed = 0U;
+    m->rendered = 0U;
+    m->analysis_cycles = 0U;
+    m->render_cycles = 0U;
+    m->max_render_cycles = 0U;
+}
+
+uint8_t ScopeGovernor_SetTargetFps(uint16_t fps)
+{
+    if (fps < SCOPE_GOVERNOR_MIN_FPS || fps > SCOPE_GOVERNOR_MAX_FPS)
+    {
+        return 0U;
+    }
+    scope_governor_module.target_fps = fps;
+    return 1U;
+}
+
+uint16_t ScopeGovernor_GetTargetFps(void)
+{
+    return scope_governor_module.target_fps;
+}
+
+void ScopeGovernor_FrameAnalyzed(uint32_t cycles)
+{
+    ScopeGovernorModule *m = &scope_governor_module;
+    m->analyzed++;
+    m->analysis_cycles = ScopeGovernor_Smooth(m->analysis_cycles, cycles);
+}
+
+uint8_t ScopeGovernor_RenderDue(uint32_t now_ms)
+{
+    const ScopeGovernorModule *m = &scope_governor_module;
+    if (!m->rendered_once)
+    {
+        return 1U;
+    }
+    return ((now_ms - m->last_render_ms) >= ScopeGovernor_IntervalMs()) ? 1U : 0U;
+}
+
+void ScopeGovernor_RenderDone(uint32_t now_ms, uint32_t cycles)
+{
+    ScopeGovernorModule *m = &scope_governor_module;
+    /* Stamped with the start of the redraw so the cadence does not slip by
+       the redraw time itself. */
+    m->last_render_ms = now_ms;
+    m->rendered_once = 1U;
+    m->rendered++;
+    m->render_cycles = ScopeGovernor_Smooth(m->render_cycles, cycles);
+    if (cycles > m->max_render_cycles)
+    {
+        m->max_render_cycles = cycles;
+    }
+}
+
+void ScopeGovernor_GetStatus(ScopeGovernorStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    const ScopeGovernorModule *m = &scope_governor_module;
+    status->target_fps = m->target_fps;
+    status->interval_ms = ScopeGovernor_IntervalMs();
+    status->acquired = ScopeBuffer_GetNextSequence() - m->acquired_base;
+    status->analyzed = m->analyzed;
+    status->rendered = m->rendered;
+    status->dropped = ScopeBuffer_GetOverrunCount() - m->dropped_base;
+    status->analysis_cycles = m->analysis_cycles;
+    status->render_cycles = m->render_cycles;
+    status->max_render_cycles = m->max_render_cycles;
+}
+
+static uint32_t ScopeGovernor_Smooth(uint32_t average, uint32_t sample)
+{
+    if (average == 0U)
+    {
+        return sample;
+    }
+    return average - (average >> GOVERNOR_AVERAGE_SHIFT) + (sample >> GOVERNOR_AVERAGE_SHIFT);
+}
+
+static uint32_t ScopeGovernor_IntervalMs(void)
+{
+    const ScopeGovernorModule *m = &scope_governor_module;
+    uint32_t interval_ms = (1000U + m->target_fps - 1U) / m->target_fps;
+
+    /* When redraws get expensive (zoomed-out traces, full statistics panel)
+       the frame rate backs off instead of eating into analysis time. */
+    uint32_t cycles_per_ms = SystemCoreClock / 1000U;
+    if (cycles_per_ms != 0U)
+    {
+        uint32_t render_ms = (m->render_cycles + cycles_per_ms - 1U) / cycles_per_ms;
+        uint32_t floor_ms = render_ms * 100U / GOVERNOR_MAX_RENDER_PERCENT;
+        if (floor_ms > interval_ms)
+        {
+            interval_ms = floor_ms;
+        }
+    }
+    return interval_ms;
+}
@@ -0,0 +1,358 @@
+#include "scope_histogram.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+enum
+{
+    HISTOGRAM_SAMPLE_MASK = SCOPE_HISTOGRAM_MAX_BINS - 1U,
+    HISTOGRAM_TOTAL_LIMIT = 0x40000000U,
+    HISTOGRAM_NOISE_WINDOW_WIDTHS = 3U,
+    LEVEL_BINS = 64U,
+    LEVEL_REFINE_BINS = 1U
+};
+
+typedef struct
+{
+    uint32_t bins[SCOPE_HISTOGRAM_MAX_BINS];
+    uint32_t total;
+    uint16_t bin_count;
+    uint8_t shift;
+    uint8_t enabled;
+} ScopeHistogramModule;
+
+static ScopeHistogramModule scope_histogram_module;
+
+static uint16_t ScopeHistogram_ModeBin(const uint32_t *bins, uint16_t first, uint16_t last);
+static void ScopeHistogram_PeakExtent(const uint32_t *bins, uint16_t mode, uint16_t first, uint16_t last,
+                                      uint16_t *lo, uint16_t *hi);
+static float ScopeHistogram_WeightedCentre(const uint32_t *bins, uint16_t lo, uint16_t hi);
+static float ScopeHistogram_PeakDeviation(const uint32_t *bins, uint16_t lo, uint16_t hi, float centre,
+                                          float *weight);
+static void ScopeHistogram_Halve(void);
+
+void ScopeHistogram_Init(void)
+{
+    scope_histogram_module.enabled = 0U;
+    (void)ScopeHistogram_Configure(SCOPE_HISTOGRAM_MAX_BINS);
+}
+
+uint8_t ScopeHistogram_Configure(uint16_t bin_count)
+{
+    if (bin_count < SCOPE_HISTOGRAM_MIN_BINS || bin_count > SCOPE_HISTOGRAM_MAX_BINS ||
+        (bin_count & (bin_count - 1U)) != 0U)
+    {
+        return 0U;
+    }
+
+    uint8_t shift = 0U;
+    while ((uint16_t)(SCOPE_HISTOGRAM_MAX_BINS >> shift) != bin_count)
+    {
+        shift++;
+    }
+    scope_histogram_module.shift = shift;
+    scope_histogram_module.bin_count = bin_count;
+    ScopeHistogram_Reset();
+    return 1U;
+}
+
+void ScopeHistogram_Reset(void)
+{
+    memset(scope_histogram_module.bins, 0, sizeof(scope_histogram_module.bins));
+    scope_histogram_module.total = 0U;
+}
+
+void ScopeHistogram_SetEnabled(uint8_t enabled)
+{
+    scope_histogram_module.enabled = enabled ? 1U : 0U;
+}
+
+uint8_t ScopeHistogram_IsEnabled(void)
+{
+    return scope_histogram_module.enabled;
+}
+
+void ScopeHistogram_Accumulate(const uint16_t *samples, uint16_t count)
+{
+    ScopeHistogramModule *hist = &scope_histogram_module;
+    if (!hist->enabled || samples == NULL || count == 0U)
+    {
+        return;
+    }
+    if (hist->total >= HISTOGRAM_TOTAL_LIMIT)
+    {
+        ScopeHistogram_Halve();
+    }
+
+    uint32_t *bins = hist->bins;
+    const uint32_t shift = hist->shift;
+    const uint16_t *p = samples;
+    uint16_t n = count;
+
+    while (n >= 4U)
+    {
+        uint32_t a = (uint32_t)(p[0] & HISTOGRAM_SAMPLE_MASK) >> shift;
+        uint32_t b = (uint32_t)(p[1] & HISTOGRAM_SAMPLE_MASK) >> shift;
+        uint32_t c = (uint32_t)(p[2] & HISTOGRAM_SAMPLE_MASK) >> shift;
+        uint32_t d = (uint32_t)(p[3] & HISTOGRAM_SAMPLE_MASK) >> shift;
+        bins[a]++;
+        bins[b]++;
+        bins[c]++;
+        bins[d]++;
+        p += 4;
+        n -= 4U;
+    }
+    while (n != 0U)
+    {
+        bins[(uint32_t)(*p & HISTOGRAM_SAMPLE_MASK) >> shift]++;
+        p++;
+        n--;
+    }
+    hist->total += count;
+}
+
+uint8_t ScopeHistogram_Analyze(ScopeHistogramSummary *summary)
+{
+    const ScopeHistogramModule *hist = &scope_histogram_module;
+    if (summary == NULL)
+    {
+        return 0U;
+    }
+    memset(summary, 0, sizeof(*summary));
+    summary->bin_count = hist->bin_count;
+    if (hist->total == 0U)
+    {
+        return 0U;
+    }
+
+    const uint32_t *bins = hist->bins;
+    uint16_t first = 0U;
+    while (bins[first] == 0U)
+    {
+        first++;
+    }
+    uint16_t last = (uint16_t)(hist->bin_count - 1U);
+    while (bins[last] == 0U)
+    {
+        last--;
+    }
+
+    uint64_t sum = 0U;
+    for (uint16_t i = first; i <= last; i++)
+    {
+        sum += (uint64_t)bins[i] * i;
+    }
+    const float total = (float)hist->total;
+    const float mean_bin = (float)sum / total;
+
+    float var_acc = 0.0f;
+    for (uint16_t i = first; i <= last; i++)
+    {
+        float d_mean = (float)i - mean_bin;
+        var_acc += (float)bins[i] * d_mean * d_mean;
+    }
+
+    /* Histogram-mode levels: the most populated bin on either side of the midpoint
+       between the extremes, refined to the weighted centre of its half-height
+       plateau. The two are separate levels only if a valley lies between them. */
+    uint16_t mid = (uint16_t)(((uint32_t)first + last) / 2U);
+    uint16_t base_mode = ScopeHistogram_ModeBin(bins, first, mid);
+    uint16_t top_mode = (last > mid) ? ScopeHistogram_ModeBin(bins, (uint16_t)(mid + 1U), last) : base_mode;
+    uint16_t base_lo = base_mode;
+    uint16_t base_hi = base_mode;
+    uint16_t top_lo = top_mode;
+    uint16_t top_hi = top_mode;
+    ScopeHistogram_PeakExtent(bins, base_mode, first, mid, &base_lo, &base_hi);
+    if (top_mode != base_mode)
+    {
+        ScopeHistogram_PeakExtent(bins, top_mode, (uint16_t)(mid + 1U), last, &top_lo, &top_hi);
+    }
+
+    uint8_t bimodal = 0U;
+    if (top_lo > base_hi + 1U)
+    {
+        uint32_t valley = 0xFFFFFFFFU;
+        for (uint16_t i = (uint16_t)(base_hi + 1U); i < top_lo; i++)
+        {
+            valley = (bins[i] < valley) ? bins[i] : valley;
+        }
+        uint32_t smaller_peak = (bins[top_mode] < bins[base_mode]) ? bins[top_mode] : bins[base_mode];
+        bimodal = (valley * 2U < smaller_peak) ? 1U : 0U;
+    }
+
+    const float width = (float)(1UL << hist->shift);
+    const float centre = (width - 1.0f) * 0.5f;
+    summary->mean = mean_bin * width + centre;
+    summary->stddev = sqrtf(var_acc / total) * width;
+    summary->bimodal = bimodal;
+    if (bimodal)
+    {
+        float top_bin = ScopeHistogram_WeightedCentre(bins, top_lo, top_hi);
+        float base_bin = ScopeHistogram_WeightedCentre(bins, base_lo, base_hi);
+        float top_weight = 0.0f;
+        float base_weight = 0.0f;
+        float top_dev = ScopeHistogram_PeakDeviation(bins, top_lo, top_hi, top_bin, &top_weight);
+        float base_dev = ScopeHistogram_PeakDeviation(bins, base_lo, base_hi, base_bin, &base_weight);
+        float pooled = (top_weight + base_weight > 0.0f) ? (top_dev + base_dev) / (top_weight + base_weight) : 0.0f;
+        summary->top = (uint16_t)(top_bin * width + centre + 0.5f);
+        summary->base = (uint16_t)(base_bin * width + centre + 0.5f);
+        summary->noise = sqrtf(pooled) * width;
+    }
+    else
+    {
+        summary->top = (uint16_t)(summary->mean + 0.5f);
+        summary->base = summary->top;
+        summary->noise = summary->stddev;
+    }
+
+    summary->total = hist->total;
+    summary->min = (uint16_t)((uint32_t)first << hist->shift);
+    summary->max = (uint16_t)(((uint32_t)(last + 1U) << hist->shift) - 1U);
+    return 1U;
+}
+
+const uint32_t *ScopeHistogram_Bins(uint16_t *bin_count)
+{
+    if (bin_count != NULL)
+    {
+        *bin_count = scope_histogram_module.bin_count;
+    }
+    return scope_histogram_module.bins;
+}
+
+uint8_t ScopeHistogram_EstimateLevels(const uint16_t *samples,
+                                      uint16_t count,
+                                      uint16_t frame_min,
+                                      uint16_t frame_max,
+                                      uint16_t *top,
+                                      uint16_t *base)
+{
+    if (samples == NULL || count == 0U || top == NULL || base == NULL || frame_max <= frame_min)
+    {
+        return 0U;
+    }
+
+    /* A coarse per-frame histogram over the frame's own range; the scale keeps
+       (v - min) * scale inside 32 bits because v - min never exceeds the range. */
+    uint32_t range = (uint32_t)frame_max - frame_min;
+    uint32_t scale = ((uint32_t)(LEVEL_BINS - 1U) << 16) / range;
+    uint32_t bins[LEVEL_BINS] = {0};
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        uint32_t v = samples[i];
+        v = (v < frame_min) ? 0U : ((v > frame_max) ? range : v - frame_min);
+        bins[(v * scale) >> 16]++;
+    }
+
+    uint32_t base_mode = ScopeHistogram_ModeBin(bins, 0U, LEVEL_BINS / 2U - 1U);
+    uint32_t top_mode = ScopeHistogram_ModeBin(bins, LEVEL_BINS / 2U, LEVEL_BINS - 1U);
+
+    uint32_t top_sum = 0U;
+    uint32_t top_count = 0U;
+    uint32_t base_sum = 0U;
+    uint32_t base_count = 0U;
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        uint32_t v = samples[i];
+        uint32_t rel = (v < frame_min) ? 0U : ((v > frame_max) ? range : v - frame_min);
+        uint32_t bin = (rel * scale) >> 16;
+        if (bin + LEVEL_REFINE_BINS >= top_mode && bin <= top_mode + LEVEL_REFINE_BINS)
+        {
+            top_sum += v;
+            top_count++;
+        }
+        else if (bin + LEVEL_REFINE_BINS >= base_mode && bin <= base_mode + LEVEL_REFINE_BINS)
+        {
+            base_sum += v;
+            base_count++;
+        }
+    }
+    if (top_count == 0U || base_count == 0U)
+    {
+        return 0U;
+    }
+
+    *top = (uint16_t)((top_sum + top_count / 2U) / top_count);
+    *base = (uint16_t)((base_sum + base_count / 2U) / base_count);
+    return (*top > *base) ? 1U : 0U;
+}
+
+static uint16_t ScopeHistogram_ModeBin(const uint32_t *bins, uint16_t first, uint16_t last)
+{
+    uint16_t mode = first;
+    for (uint16_t i = first; i <= last; i++)
+    {
+        if (bins[i] > bins[mode])
+        {
+            mode = i;
+        }
+    }
+    return mode;
+}
+
+static void ScopeHistogram_PeakExtent(const uint32_t *bins, uint16_t mode, uint16_t first, uint16_t last,
+                                      uint16_t *lo, uint16_t *hi)
+{
+    const uint32_t half = bins[mode] / 2U;
+    uint16_t l = mode;
+    uint16_t h = mode;
+    while (l > first && bins[l - 1U] >= half)
+    {
+        l--;
+    }
+    while (h < last && bins[h + 1U] >= half)
+    {
+        h++;
+    }
+    *lo = l;
+    *hi = h;
+}
+
+static float ScopeHistogram_WeightedCentre(const uint32_t *bins, uint16_t lo, uint16_t hi)
+{
+    float weight = 0.0f;
+    float moment = 0.0f;
+    for (uint16_t i = lo; i <= hi; i++)
+    {
+        weight += (float)bins[i];
+        moment += (float)bins[i] * (float)i;
+    }
+    return (weight > 0.0f) ? moment / weight : (float)lo;
+}
+
+/* Sum of squared deviations inside a few plateau widths of the level, which keeps
+   edge samples and overshoot out of the noise figure. */
+static float ScopeHistogram_PeakDeviation(const uint32_t *bins, uint16_t lo, uint16_t hi, float centre,
+                                          float *weight)
+{
+    uint32_t reach = ((uint32_t)hi - lo + 2U) / 2U * HISTOGRAM_NOISE_WINDOW_WIDTHS;
+    uint32_t start = (lo > reach) ? lo - reach : 0U;
+    uint32_t end = hi + reach;
+    if (end >= scope_histogram_module.bin_count)
+    {
+        end = scope_histogram_module.bin_count - 1U;
+    }
+
+    float acc = 0.0f;
+    float w = 0.0f;
+    for (uint32_t i = start; i <= end; i++)
+    {
+        float d = (float)i - centre;
+        w += (float)bins[i];
+        acc += (float)bins[i] * d * d;
+    }
+    *weight = w;
+    return acc;
+}
+
+static void ScopeHistogram_Halve(void)
+{
+    uint32_t total = 0U;
+    for (uint16_t i = 0U; i < scope_histogram_module.bin_count; i++)
+    {
+        scope_histogram_module.bins[i] >>= 1;
+        total += scope_histogram_module.bins[i];
+    }
+    scope_histogram_module.total = total;
+}
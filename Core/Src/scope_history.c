@@ -0,0 +1,163 @@
+#include "scope_history.h"
+
+#include <stddef.h>
+
+typedef struct
+{
+    ScopeHistoryInfo info;
+    uint8_t packed[SCOPE_HISTORY_PACKED_BYTES];
+} ScopeHistorySlot;
+
+#define SCOPE_HISTORY_DEPTH (SCOPE_HISTORY_BYTES / sizeof(ScopeHistorySlot))
+
+typedef struct
+{
+    uint16_t head;
+    uint16_t count;
+    uint32_t sample_rate_hz;
+} ScopeHistoryModule;
+
+static ScopeHistoryModule scope_history_module;
+static ScopeHistorySlot scope_history_slots[SCOPE_HISTORY_DEPTH];
+
+static void ScopeHistory_Pack(uint8_t *dst, const uint16_t *samples, uint16_t count);
+static void ScopeHistory_Unpack(uint16_t *samples, const uint8_t *src, uint16_t count);
+static uint16_t ScopeHistory_UnpackAt(const uint8_t *packed, uint16_t index);
+static const ScopeHistorySlot *ScopeHistory_Slot(uint16_t age);
+
+void ScopeHistory_Init(void)
+{
+    ScopeHistory_Reset();
+}
+
+void ScopeHistory_Reset(void)
+{
+    scope_history_module.head = 0U;
+    scope_history_module.count = 0U;
+    scope_history_module.sample_rate_hz = 0U;
+}
+
+void ScopeHistory_Push(const uint16_t *samples, const ScopeHistoryInfo *info, uint32_t sample_rate_hz)
+{
+    ScopeHistoryModule *m = &scope_history_module;
+    if (samples == NULL || info == NULL || info->sample_count == 0U)
+    {
+        return;
+    }
+    if (sample_rate_hz != m->sample_rate_hz)
+    {
+        ScopeHistory_Reset();
+        m->sample_rate_hz = sample_rate_hz;
+    }
+
+    ScopeHistorySlot *slot = &scope_history_slots[m->head];
+    slot->info = *info;
+    if (slot->info.sample_count > SCOPE_FRAME_SAMPLES)
+    {
+        slot->info.sample_count = SCOPE_FRAME_SAMPLES;
+    }
+    ScopeHistory_Pack(slot->packed, samples, slot->info.sample_count);
+
+    m->head = (uint16_t)((m->head + 1U) % SCOPE_HISTORY_DEPTH);
+    if (m->count < SCOPE_HISTORY_DEPTH)
+    {
+        m->count++;
+    }
+}
+
+uint16_t ScopeHistory_Count(void)
+{
+    return scope_history_module.count;
+}
+
+uint16_t ScopeHistory_Depth(void)
+{
+    return (uint16_t)SCOPE_HISTORY_DEPTH;
+}
+
+uint8_t ScopeHistory_Get(uint16_t age, uint16_t *samples, ScopeHistoryInfo *info)
+{
+    const ScopeHistorySlot *slot = ScopeHistory_Slot(age);
+    if (slot == NULL || (samples == NULL && info == NULL))
+    {
+        return 0U;
+    }
+    if (samples != NULL)
+    {
+        ScopeHistory_Unpack(samples, slot->packed, slot->info.sample_count);
+    }
+    if (info != NULL)
+    {
+        *info = slot->info;
+    }
+    return 1U;
+}
+
+uint8_t ScopeHistory_GetRange(uint16_t age, uint16_t first, uint16_t count, uint16_t *samples)
+{
+    const ScopeHistorySlot *slot = ScopeHistory_Slot(age);
+    if (slot == NULL || samples == NULL || (uint32_t)first + count > slot->info.sample_count)
+    {
+        return 0U;
+    }
+    for (uint16_t i = 0U; i < count; ++i)
+    {
+        samples[i] = ScopeHistory_UnpackAt(slot->packed, (uint16_t)(first + i));
+    }
+    return 1U;
+}
+
+static const ScopeHistorySlot *ScopeHistory_Slot(uint16_t age)
+{
+    const ScopeHistoryModule *m = &scope_history_module;
+    if (age >= m->count)
+    {
+        return NULL;
+    }
+    uint16_t index = (uint16_t)((m->head + SCOPE_HISTORY_DEPTH - 1U - age) % SCOPE_HISTORY_DEPTH);
+    return &scope_history_slots[index];
+}
+
+static void ScopeHistory_Pack(uint8_t *dst, const uint16_t *samples, uint16_t count)
+{
+    uint16_t i = 0U;
+    for (; i + 1U < count; i += 2U)
+    {
+        uint16_t a = samples[i] & 0x0FFFU;
+        uint16_t b = samples[i + 1U] & 0x0FFFU;
+        *dst++ = (uint8_t)a;
+        *dst++ = (uint8_t)((a >> 8) | (b << 4));
+        *dst++ = (uint8_t)(b >> 4);
+    }
+    if (i < count)
+    {
+        uint16_t a = samples[i] & 0x0FFFU;
+        *dst++ = (uint8_t)a;
+        *dst = (uint8_t)(a >> 8);
+    }
+}
+
+static void ScopeHistory_Unpack(uint16_t *samples, const uint8_t *src, uint16_t count)
+{
+    uint16_t i = 0U;
+    for (; i + 1U < count; i += 2U)
+    {
+        samples[i] = (uint16_t)(src[0] | ((uint16_t)(src[1] & 0x0FU) << 8));
+        samples[i + 1U] = (uint16_t)((src[1] >> 4) | ((uint16_t)src[2] << 4));
+        src += 3;
+    }
+    if (i < count)
+    {
+        samples[i] = (uint16_t)(src[0] | ((uint16_t)(src[1] & 0x0FU) << 8));
+    }
+}
+
+static uint16_t ScopeHistory_UnpackAt(const uint8_t *packed, uint16_t index)
+{
+    const uint8_t *src = &packed[(index / 2U) * 3U];
+    if ((index & 1U) == 0U)
+    {
+        return (uint16_t)(src[0] | ((uint16_t)(src[1] & 0x0FU) << 8));
+    }
+    return (uint16_t)((src[1] >> 4) | ((uint16_t)src[2] << 4));
+}
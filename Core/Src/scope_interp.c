@@ -0,0 +1,127 @@
+#include "scope_interp.h"
+
+#include <math.h>
+#include <stddef.h>
+
+enum
+{
+    INTERP_PHASE_BITS = 6U,
+    INTERP_PHASES = 1U << INTERP_PHASE_BITS,
+    /* Taps n-3 .. n+4 around the interval [n, n+1]. */
+    INTERP_TAPS = 8U,
+    INTERP_TAPS_BEFORE = 3U,
+    INTERP_COEF_SHIFT = 14U,
+    INTERP_LINEAR_BITS = 12U
+};
+
+static ScopeInterpMode scope_interp_mode = SCOPE_INTERP_SINC;
+/* Blackman-windowed sin(x)/x, one row per fractional phase, each row scaled
+   to a DC gain of exactly 1.0 in Q14 so flat signals stay flat. */
+static int16_t scope_interp_coef[INTERP_PHASES][INTERP_TAPS];
+
+void ScopeInterp_Init(void)
+{
+    const float half_width = (float)INTERP_TAPS / 2.0f;
+    for (uint32_t phase = 0U; phase < INTERP_PHASES; ++phase)
+    {
+        float frac = (float)phase / (float)INTERP_PHASES;
+        float taps[INTERP_TAPS];
+        float sum = 0.0f;
+        for (uint32_t k = 0U; k < INTERP_TAPS; ++k)
+        {
+            float x = (float)k - (float)INTERP_TAPS_BEFORE - frac;
+            float sinc = (fabsf(x) < 1e-6f) ? 1.0f : sinf((float)M_PI * x) / ((float)M_PI * x);
+            float window = 0.0f;
+            if (fabsf(x) < half_width)
+            {
+                float angle = (float)M_PI * x / half_width;
+                window = 0.42f + 0.5f * cosf(angle) + 0.08f * cosf(2.0f * angle);
+            }
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+
+        /* Rounding error goes into the largest tap so every row sums to 1.0. */
+        int32_t total = 0;
+        uint32_t peak = 0U;
+        for (uint32_t k = 0U; k < INTERP_TAPS; ++k)
+        {
+            scope_interp_coef[phase][k] =
+                (int16_t)lrintf(taps[k] / sum * (float)(1U << INTERP_COEF_SHIFT));
+            total += scope_interp_coef[phase][k];
+            if (scope_interp_coef[phase][k] > scope_interp_coef[phase][peak])
+            {
+                peak = k;
+            }
+        }
+        scope_interp_coef[phase][peak] =
+            (int16_t)(scope_interp_coef[phase][peak] + ((int32_t)(1U << INTERP_COEF_SHIFT) - total));
+    }
+}
+
+void ScopeInterp_SetMode(ScopeInterpMode mode)
+{
+    if (mode > SCOPE_INTERP_SINC)
+    {
+        return;
+    }
+    scope_interp_mode = mode;
+}
+
+ScopeInterpMode ScopeInterp_GetMode(void)
+{
+    return scope_interp_mode;
+}
+
+int32_t ScopeInterp_Sample(const uint16_t *samples, uint16_t count, uint16_t index, uint32_t frac_q16)
+{
+    if (samples == NULL || count == 0U)
+    {
+        return 0;
+    }
+    if (index >= count)
+    {
+        index = (uint16_t)(count - 1U);
+    }
+    frac_q16 &= 0xFFFFU;
+
+    if (scope_interp_mode == SCOPE_INTERP_OFF || frac_q16 == 0U)
+    {
+        return (int32_t)samples[index];
+    }
+
+    if (scope_interp_mode == SCOPE_INTERP_LINEAR)
+    {
+        int32_t s0 = (int32_t)samples[index];
+        int32_t s1 = (int32_t)samples[(index + 1U < count) ? index + 1U : 0U];
+        int32_t frac = (int32_t)(frac_q16 >> (16U - INTERP_LINEAR_BITS));
+        return s0 + (((s1 - s0) * frac + (1 << (INTERP_LINEAR_BITS - 1U))) >> INTERP_LINEAR_BITS);
+    }
+
+    const int16_t *coef = scope_interp_coef[frac_q16 >> (16U - INTERP_PHASE_BITS)];
+    int32_t first = (int32_t)index - (int32_t)INTERP_TAPS_BEFORE;
+    int32_t acc = 0;
+    if (first >= 0 && first + (int32_t)INTERP_TAPS <= (int32_t)count)
+    {
+        const uint16_t *src = &samples[first];
+        for (uint32_t k = 0U; k < INTERP_TAPS; ++k)
+        {
+            acc += (int32_t)src[k] * coef[k];
+        }
+    }
+    else
+    {
+        /* Near the ends of the record the taps wrap like the window, which
+           puts sample 0 in the column after the last sample. */
+        for (uint32_t k = 0U; k < INTERP_TAPS; ++k)
+        {
+            int32_t n = (first + (int32_t)k) % (int32_t)count;
+            if (n < 0)
+            {
+                n += (int32_t)count;
+            }
+            acc += (int32_t)samples[n] * coef[k];
+        }
+    }
+    return (acc + (1 << (INTERP_COEF_SHIFT - 1U))) >> INTERP_COEF_SHIFT;
+}
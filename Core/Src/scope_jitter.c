@@ -0,0 +1,507 @@
+#include "scope_jitter.h"
+
+#include "main.h"
+#include "scope_profile.h"
+#include "scope_signal.h"
+
+#include <math.h>
+#include <string.h>
+
+enum
+{
+    JITTER_RING_SIZE = 1024U,
+    JITTER_RING_MASK = JITTER_RING_SIZE - 1U,
+    JITTER_MIN_AMPLITUDE = 20U,
+    JITTER_HYSTERESIS_DIVISOR = 8U,
+    JITTER_ENVELOPE_DECAY_SHIFT = 4U,
+    /* Timestamps are Q8 sample positions with bit 0 reused as a flag: set when
+       edges were dropped just before this one. */
+    JITTER_GAP_FLAG = 1U,
+    JITTER_MAX_SPAN_Q8 = 0x80000000U,
+    /* The first fit sizes the bins so its peak TIE fills a quarter of them. */
+    JITTER_SCALE_DIVISOR = SCOPE_JITTER_BINS / 4U,
+    JITTER_MIN_BIN_Q8 = 2U
+};
+
+/* Interrupt side: streaming edge extraction over every DMA half-buffer. */
+typedef struct
+{
+    volatile uint8_t enabled;
+    uint8_t primed;
+    uint8_t high;
+    uint8_t candidate_valid;
+    uint8_t gap;
+    uint16_t prev;
+    uint16_t level_mid;
+    uint16_t level_low;
+    uint16_t level_high;
+    uint16_t envelope_min;
+    uint16_t envelope_max;
+    uint8_t envelope_valid;
+    uint32_t clock;
+    uint32_t candidate_q8;
+    volatile uint16_t head;
+    volatile uint32_t dropped;
+    uint32_t cycles_per_buffer;
+    uint32_t max_cycles_per_buffer;
+} ScopeJitterCapture;
+
+/* Main-loop side: clock recovery, TIE and period statistics. */
+typedef struct
+{
+    volatile uint16_t tail;
+    uint32_t adc_rate_hz;
+    uint8_t have_last;
+    uint32_t last_edge_q8;
+    uint32_t block_start_q8;
+    uint16_t block_count;
+    uint32_t block[SCOPE_JITTER_BLOCK_EDGES];
+    double period_q8;
+    double bin_q8;
+    uint32_t generation;
+    uint32_t edges;
+    uint32_t resyncs;
+    uint32_t tie_count;
+    double tie_sum;
+    double tie_sumsq;
+    double tie_min;
+    double tie_max;
+    uint32_t period_count;
+    double period_sum;
+    double period_sumsq;
+    uint32_t trend[SCOPE_JITTER_TREND_POINTS];
+    uint16_t trend_head;
+    uint16_t trend_count;
+} ScopeJitterModule;
+
+static ScopeJitterCapture scope_jitter_capture;
+static ScopeJitterModule scope_jitter_module;
+static uint32_t scope_jitter_ring[JITTER_RING_SIZE];
+static uint32_t scope_jitter_hist[SCOPE_JITTER_BINS];
+
+static void ScopeJitter_UpdateLevels(uint16_t frame_min, uint16_t frame_max);
+static void ScopeJitter_ClearAnalysis(void);
+static void ScopeJitter_Resync(void);
+static void ScopeJitter_AddEdge(uint32_t edge_q8);
+static void ScopeJitter_FitBlock(void);
+static float ScopeJitter_Q8ToNs(double value_q8);
+
+void ScopeJitter_Init(void)
+{
+    memset(&scope_jitter_capture, 0, sizeof(scope_jitter_capture));
+    memset(&scope_jitter_module, 0, sizeof(scope_jitter_module));
+    ScopeJitter_ClearAnalysis();
+}
+
+void ScopeJitter_SetEnabled(uint8_t enabled)
+{
+    ScopeJitterCapture *cap = &scope_jitter_capture;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (enabled && !cap->enabled)
+    {
+        cap->primed = 0U;
+        cap->high = 0U;
+        cap->candidate_valid = 0U;
+        cap->gap = 1U;
+        cap->envelope_valid = 0U;
+        cap->level_mid = 0U;
+        cap->max_cycles_per_buffer = 0U;
+        scope_jitter_module.tail = cap->head;
+    }
+    cap->enabled = enabled ? 1U : 0U;
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+
+    if (enabled)
+    {
+        ScopeJitter_ClearAnalysis();
+    }
+}
+
+uint8_t ScopeJitter_IsEnabled(void)
+{
+    return scope_jitter_capture.enabled;
+}
+
+void ScopeJitter_Reset(void)
+{
+    ScopeJitter_ClearAnalysis();
+}
+
+void ScopeJitter_ProcessFromISR(const uint16_t *samples, uint16_t count)
+{
+    ScopeJitterCapture *cap = &scope_jitter_capture;
+    if (!cap->enabled || samples == NULL || count == 0U)
+    {
+        return;
+    }
+
+    uint32_t start = ScopeProfile_CycleCount();
+    const uint16_t mid = cap->level_mid;
+    const uint16_t low = cap->level_low;
+    const uint16_t high_level = cap->level_high;
+    uint16_t prev = cap->primed ? cap->prev : samples[0];
+    uint8_t high = cap->high;
+    uint8_t candidate_valid = cap->candidate_valid;
+    uint32_t candidate = cap->candidate_q8;
+    uint16_t head = cap->head;
+    uint16_t vmin = 0xFFFFU;
+    uint16_t vmax = 0U;
+
+    for (uint16_t i = 0U; i < count; ++i)
+    {
+        uint16_t v = samples[i];
+        vmin = (v < vmin) ? v : vmin;
+        vmax = (v > vmax) ? v : vmax;
+        if (!high)
+        {
+            /* The timestamp is the last upward mid-level crossing; the edge only
+               counts once the hysteresis band is cleared. */
+            if (prev < mid && v >= mid)
+            {
+                uint32_t frac = ((uint32_t)(mid - prev) << 8) / (uint32_t)(v - prev);
+                candidate = ((cap->clock + i - 1U) << 8) + frac;
+                candidate_valid = 1U;
+            }
+            if (v >= high_level && candidate_valid && mid != 0U)
+            {
+                high = 1U;
+                candidate_valid = 0U;
+                uint16_t next = (uint16_t)((head + 1U) & JITTER_RING_MASK);
+                if (next == scope_jitter_module.tail)
+                {
+                    cap->dropped++;
+                    cap->gap = 1U;
+                }
+                else
+                {
+                    scope_jitter_ring[head] = (candidate & ~JITTER_GAP_FLAG) | (cap->gap ? JITTER_GAP_FLAG : 0U);
+                    cap->gap = 0U;
+                    head = next;
+                }
+            }
+        }
+        else if (v <= low)
+        {
+            high = 0U;
+            candidate_valid = 0U;
+        }
+        prev = v;
+    }
+
+    /* Publish the entries before the index that makes them visible. */
+    __DMB();
+    cap->head = head;
+    cap->prev = prev;
+    cap->primed = 1U;
+    cap->high = high;
+    cap->candidate_valid = candidate_valid;
+    cap->candidate_q8 = candidate;
+    cap->clock += count;
+    ScopeJitter_UpdateLevels(vmin, vmax);
+
+    cap->cycles_per_buffer = ScopeProfile_CycleCount() - start;
+    if (cap->cycles_per_buffer > cap->max_cycles_per_buffer)
+    {
+        cap->max_cycles_per_buffer = cap->cycles_per_buffer;
+    }
+}
+
+void ScopeJitter_Service(void)
+{
+    ScopeJitterModule *m = &scope_jitter_module;
+    if (!scope_jitter_capture.enabled)
+    {
+        return;
+    }
+
+    /* Timestamps are in ADC samples; a retune changes their meaning. */
+    uint32_t rate = ScopeSignal_GetAdcRateHz();
+    if (rate != m->adc_rate_hz)
+    {
+        ScopeJitter_ClearAnalysis();
+        m->adc_rate_hz = rate;
+    }
+
+    uint16_t tail = m->tail;
+    uint16_t head = scope_jitter_capture.head;
+    __DMB();
+    while (tail != head)
+    {
+        ScopeJitter_AddEdge(scope_jitter_ring[tail]);
+        tail = (uint16_t)((tail + 1U) & JITTER_RING_MASK);
+    }
+    m->tail = tail;
+}
+
+const uint32_t *ScopeJitter_Histogram(void)
+{
+    return scope_jitter_hist;
+}
+
+uint16_t ScopeJitter_GetTrend(float *deviation_ns, uint16_t max_points)
+{
+    const ScopeJitterModule *m = &scope_jitter_module;
+    if (deviation_ns == NULL || m->period_q8 <= 0.0)
+    {
+        return 0U;
+    }
+    uint16_t count = (m->trend_count < max_points) ? m->trend_count : max_points;
+    uint16_t index = (uint16_t)((m->trend_head + SCOPE_JITTER_TREND_POINTS - count) % SCOPE_JITTER_TREND_POINTS);
+    for (uint16_t i = 0U; i < count; ++i)
+    {
+        deviation_ns[i] = ScopeJitter_Q8ToNs((double)m->trend[index] - m->period_q8);
+        index = (uint16_t)((index + 1U) % SCOPE_JITTER_TREND_POINTS);
+    }
+    return count;
+}
+
+void ScopeJitter_GetStatus(ScopeJitterStatus *status)
+{
+    const ScopeJitterModule *m = &scope_jitter_module;
+    if (status == NULL)
+    {
+        return;
+    }
+    memset(status, 0, sizeof(*status));
+    status->enabled = scope_jitter_capture.enabled;
+    status->scaled = (m->bin_q8 > 0.0) ? 1U : 0U;
+    status->generation = m->generation;
+    status->edges = m->edges;
+    status->tie_count = m->tie_count;
+    status->dropped = scope_jitter_capture.dropped;
+    status->resyncs = m->resyncs;
+    status->adc_rate_hz = m->adc_rate_hz;
+    status->period_ns = ScopeJitter_Q8ToNs(m->period_q8);
+    status->bin_ns = ScopeJitter_Q8ToNs(m->bin_q8);
+    if (m->tie_count != 0U)
+    {
+        double mean = m->tie_sum / (double)m->tie_count;
+        double var = m->tie_sumsq / (double)m->tie_count - mean * mean;
+        status->tie_rms_ns = ScopeJitter_Q8ToNs(sqrt((var > 0.0) ? var : 0.0));
+        status->tie_pp_ns = ScopeJitter_Q8ToNs(m->tie_max - m->tie_min);
+    }
+    if (m->period_count > 1U)
+    {
+        double mean = m->period_sum / (double)m->period_count;
+        double var = m->period_sumsq / (double)m->period_count - mean * mean;
+        status->period_sd_ns = ScopeJitter_Q8ToNs(sqrt((var > 0.0) ? var : 0.0));
+    }
+    status->cycles_per_buffer = scope_jitter_capture.cycles_per_buffer;
+    status->max_cycles_per_buffer = scope_jitter_capture.max_cycles_per_buffer;
+}
+
+static void ScopeJitter_UpdateLevels(uint16_t frame_min, uint16_t frame_max)
+{
+    ScopeJitterCapture *cap = &scope_jitter_capture;
+
+    /* Same envelope as the software trigger: new extremes count at once and
+       relax slowly, so a half-buffer shorter than a cycle keeps the levels. */
+    if (!cap->envelope_valid)
+    {
+        cap->envelope_min = frame_min;
+        cap->envelope_max = frame_max;
+        cap->envelope_valid = 1U;
+    }
+    else
+    {
+        if (frame_max >= cap->envelope_max)
+        {
+            cap->envelope_max = frame_max;
+        }
+        else
+        {
+            cap->envelope_max -= (uint16_t)((cap->envelope_max - frame_max) >> JITTER_ENVELOPE_DECAY_SHIFT);
+        }
+        if (frame_min <= cap->envelope_min)
+        {
+            cap->envelope_min = frame_min;
+        }
+        else
+        {
+            cap->envelope_min += (uint16_t)((frame_min - cap->envelope_min) >> JITTER_ENVELOPE_DECAY_SHIFT);
+        }
+    }
+
+    uint32_t amplitude = (uint32_t)cap->envelope_max - cap->envelope_min;
+    if (cap->envelope_max < cap->envelope_min || amplitude < JITTER_MIN_AMPLITUDE)
+    {
+        cap->level_mid = 0U;
+        return;
+    }
+    uint32_t mid = cap->envelope_min + amplitude / 2U;
+    uint32_t hysteresis = amplitude / JITTER_HYSTERESIS_DIVISOR;
+    cap->level_mid = (uint16_t)mid;
+    cap->level_low = (uint16_t)(mid - hysteresis);
+    cap->level_high = (uint16_t)(mid + hysteresis);
+}
+
+static void ScopeJitter_ClearAnalysis(void)
+{
+    ScopeJitterModule *m = &scope_jitter_module;
+    m->have_last = 0U;
+    m->block_count = 0U;
+    m->period_q8 = 0.0;
+    m->bin_q8 = 0.0;
+    m->edges = 0U;
+    m->resyncs = 0U;
+    m->tie_count = 0U;
+    m->tie_sum = 0.0;
+    m->tie_sumsq = 0.0;
+    m->tie_min = 0.0;
+    m->tie_max = 0.0;
+    m->period_count = 0U;
+    m->period_sum = 0.0;
+    m->period_sumsq = 0.0;
+    m->trend_head = 0U;
+    m->trend_count = 0U;
+    m->generation++;
+    memset(scope_jitter_hist, 0, sizeof(scope_jitter_hist));
+}
+
+static void ScopeJitter_Resync(void)
+{
+    scope_jitter_module.have_last = 0U;
+    scope_jitter_module.block_count = 0U;
+    scope_jitter_module.resyncs++;
+}
+
+static void ScopeJitter_AddEdge(uint32_t edge_q8)
+{
+    ScopeJitterModule *m = &scope_jitter_module;
+    if ((edge_q8 & JITTER_GAP_FLAG) != 0U)
+    {
+        ScopeJitter_Resync();
+    }
+    edge_q8 &= ~JITTER_GAP_FLAG;
+    m->edges++;
+
+    if (m->have_last)
+    {
+        /* Differences modulo 2^32 stay exact across timestamp wrap-around. */
+        uint32_t interval = edge_q8 - m->last_edge_q8;
+        if (interval == 0U || interval >= JITTER_MAX_SPAN_Q8 ||
+            (m->block_count != 0U && edge_q8 - m->block_start_q8 >= JITTER_MAX_SPAN_Q8))
+        {
+            ScopeJitter_Resync();
+        }
+        else
+        {
+            m->period_count++;
+            m->period_sum += (double)interval;
+            m->period_sumsq += (double)interval * (double)interval;
+            m->trend[m->trend_head] = interval;
+            m->trend_head = (uint16_t)((m->trend_head + 1U) % SCOPE_JITTER_TREND_POINTS);
+            if (m->trend_count < SCOPE_JITTER_TREND_POINTS)
+            {
+                m->trend_count++;
+            }
+        }
+    }
+    m->have_last = 1U;
+    m->last_edge_q8 = edge_q8;
+
+    if (m->block_count == 0U)
+    {
+        m->block_start_q8 = edge_q8;
+    }
+    m->block[m->block_count++] = edge_q8 - m->block_start_q8;
+    if (m->block_count == SCOPE_JITTER_BLOCK_EDGES)
+    {
+        ScopeJitter_FitBlock();
+        m->block_count = 0U;
+    }
+}
+
+/* The ideal clock for a block is the least-squares line through its edge times
+   against their cycle numbers; TIE is each edge's distance from that line. */
+static void ScopeJitter_FitBlock(void)
+{
+    ScopeJitterModule *m = &scope_jitter_module;
+    const uint16_t n = m->block_count;
+    const uint32_t *t = m->block;
+
+    /* Cycle numbers come from the previous fit, so a missed or extra edge
+       does not shear the line; the first block assumes none. */
+    double estimate = (m->period_q8 > 0.0) ? m->period_q8 : (double)t[n - 1U] / (double)(n - 1U);
+    if (estimate <= 0.0)
+    {
+        return;
+    }
+
+    double sk = 0.0;
+    double skk = 0.0;
+    double st = 0.0;
+    double skt = 0.0;
+    for (uint16_t i = 0U; i < n; ++i)
+    {
+        double k = floor((double)t[i] / estimate + 0.5);
+        sk += k;
+        skk += k * k;
+        st += (double)t[i];
+        skt += k * (double)t[i];
+    }
+    double den = (double)n * skk - sk * sk;
+    if (den <= 0.0)
+    {
+        return;
+    }
+    double period = ((double)n * skt - sk * st) / den;
+    double offset = (st - period * sk) / (double)n;
+    if (period <= 0.0)
+    {
+        return;
+    }
+    m->period_q8 = period;
+
+    if (m->bin_q8 <= 0.0)
+    {
+        double peak = 0.0;
+        for (uint16_t i = 0U; i < n; ++i)
+        {
+            double k = floor((double)t[i] / estimate + 0.5);
+            double r = fabs((double)t[i] - (offset + period * k));
+            peak = (r > peak) ? r : peak;
+        }
+        double bin = JITTER_MIN_BIN_Q8;
+        while (bin * JITTER_SCALE_DIVISOR < peak)
+        {
+            bin *= 2.0;
+        }
+        m->bin_q8 = bin;
+    }
+
+    for (uint16_t i = 0U; i < n; ++i)
+    {
+        double k = floor((double)t[i] / estimate + 0.5);
+        double r = (double)t[i] - (offset + period * k);
+        int32_t bin = (int32_t)floor(r / m->bin_q8) + (int32_t)(SCOPE_JITTER_BINS / 2U);
+        bin = (bin < 0) ? 0 : bin;
+        bin = (bin >= (int32_t)SCOPE_JITTER_BINS) ? (int32_t)SCOPE_JITTER_BINS - 1 : bin;
+        scope_jitter_hist[bin]++;
+
+        if (m->tie_count == 0U)
+        {
+            m->tie_min = r;
+            m->tie_max = r;
+        }
+        m->tie_min = (r < m->tie_min) ? r : m->tie_min;
+        m->tie_max = (r > m->tie_max) ? r : m->tie_max;
+        m->tie_sum += r;
+        m->tie_sumsq += r * r;
+        m->tie_count++;
+    }
+}
+
+static float ScopeJitter_Q8ToNs(double value_q8)
+{
+    uint32_t rate = scope_jitter_module.adc_rate_hz;
+    if (rate == 0U)
+    {
+        return 0.0f;
+    }
+    return (float)(value_q8 * 1.0e9 / (256.0 * (double)rate));
+}
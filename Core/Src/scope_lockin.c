@@ -0,0 +1,288 @@
+#include "scope_lockin.h"
+
+#include "main.h"
+#include "scope.h"
+#include "scope_profile.h"
+#include "scope_signal.h"
+#include "tim.h"
+
+#include <math.h>
+#include <string.h>
+
+enum
+{
+    LOCKIN_SINE_STEPS = 64U,
+    LOCKIN_TABLE_SIZE = 256U,
+    LOCKIN_DMA_SAMPLES = 2U * SCOPE_FRAME_SAMPLES,
+    LOCKIN_MIN_MIX_SAMPLES = 32U,
+    LOCKIN_MAX_FILTER_SHIFT = 16U,
+    LOCKIN_RUNNING = 0xFFFFU
+};
+
+typedef struct
+{
+    uint8_t enabled;
+    volatile uint8_t locked;
+    uint8_t filter_shift;
+    uint32_t time_constant_ms;
+    /* Timer settings the lock was taken with; any retune of either timer
+       breaks the phase relation and is caught in the interrupt. */
+    uint32_t tim3_psc;
+    uint32_t tim3_arr;
+    uint32_t tim4_psc;
+    uint32_t tim4_arr;
+    uint32_t adc_ticks;
+    uint32_t dac_ticks;
+    /* Reference phase of the next sample in half timer ticks, modulo one sine
+       period (128 * dac_ticks); exact, so the lock never drifts. */
+    uint64_t phase_half_ticks;
+    uint64_t period_half_ticks;
+    uint32_t phase_step;
+    uint16_t start_index;
+    int32_t filtered_i;
+    int32_t filtered_q;
+    uint8_t filter_primed;
+    uint32_t buffers;
+    uint32_t relocks;
+    uint32_t cycles_per_buffer;
+} ScopeLockinModule;
+
+static ScopeLockinModule scope_lockin_module;
+static int16_t scope_lockin_sine[LOCKIN_TABLE_SIZE];
+
+static uint8_t ScopeLockin_Lock(void);
+static void ScopeLockin_UpdateFilterShift(void);
+
+void ScopeLockin_Init(void)
+{
+    memset(&scope_lockin_module, 0, sizeof(scope_lockin_module));
+    scope_lockin_module.time_constant_ms = SCOPE_LOCKIN_DEFAULT_TC_MS;
+    for (uint32_t i = 0U; i < LOCKIN_TABLE_SIZE; ++i)
+    {
+        float angle = 6.28318530718f * (float)i / (float)LOCKIN_TABLE_SIZE;
+        scope_lockin_sine[i] = (int16_t)lrintf(32767.0f * sinf(angle));
+    }
+}
+
+uint8_t ScopeLockin_SetEnabled(uint8_t enabled)
+{
+    scope_lockin_module.locked = 0U;
+    scope_lockin_module.enabled = enabled ? 1U : 0U;
+    if (!scope_lockin_module.enabled)
+    {
+        return 1U;
+    }
+    return ScopeLockin_Lock();
+}
+
+uint8_t ScopeLockin_IsEnabled(void)
+{
+    return scope_lockin_module.enabled;
+}
+
+uint8_t ScopeLockin_SetTimeConstantMs(uint32_t time_constant_ms)
+{
+    if (time_constant_ms == 0U)
+    {
+        return 0U;
+    }
+    scope_lockin_module.time_constant_ms = time_constant_ms;
+    ScopeLockin_UpdateFilterShift();
+    return 1U;
+}
+
+void ScopeLockin_ProcessFromISR(const uint16_t *samples, uint16_t count, uint8_t buffer_index)
+{
+    ScopeLockinModule *m = &scope_lockin_module;
+    if (!m->enabled || !m->locked)
+    {
+        return;
+    }
+    if (htim3.Instance->PSC != m->tim3_psc || htim3.Instance->ARR != m->tim3_arr ||
+        htim4.Instance->PSC != m->tim4_psc || htim4.Instance->ARR != m->tim4_arr)
+    {
+        m->locked = 0U;
+        return;
+    }
+
+    uint16_t first = 0U;
+    if (m->start_index != LOCKIN_RUNNING)
+    {
+        /* Only samples taken after the synchronized timer restart carry the
+           known phase; the half-buffer before it is ignored. */
+        uint16_t base = (uint16_t)(buffer_index * count);
+        if (m->start_index < base || m->start_index >= base + count)
+        {
+            return;
+        }
+        first = (uint16_t)(m->start_index - base);
+        m->start_index = LOCKIN_RUNNING;
+    }
+
+    uint32_t start = ScopeProfile_CycleCount();
+    uint16_t mixed = (uint16_t)(count - first);
+    uint32_t phase = (uint32_t)((m->phase_half_ticks << 32) / m->period_half_ticks);
+    m->phase_half_ticks = (m->phase_half_ticks + 2ULL * mixed * m->adc_ticks) % m->period_half_ticks;
+
+    uint32_t sum = 0U;
+    for (uint16_t k = first; k < count; ++k)
+    {
+        sum += samples[k];
+    }
+    int32_t mean = (int32_t)((sum + mixed / 2U) / mixed);
+
+    /* x*sin and x*cos of the reference (Q15), one table lookup each; the
+       buffer mean is removed first so DC does not leak into the products. */
+    int64_t acc_i = 0;
+    int64_t acc_q = 0;
+    const uint32_t step = m->phase_step;
+    for (uint16_t k = first; k < count; ++k)
+    {
+        int32_t x = (int32_t)samples[k] - mean;
+        uint32_t index = phase >> 24;
+        acc_i += (int64_t)(x * scope_lockin_sine[index]);
+        acc_q += (int64_t)(x * scope_lockin_sine[(index + LOCKIN_TABLE_SIZE / 4U) & (LOCKIN_TABLE_SIZE - 1U)]);
+        phase += step;
+    }
+
+    if (mixed >= LOCKIN_MIN_MIX_SAMPLES)
+    {
+        int32_t avg_i = (int32_t)(acc_i / mixed);
+        int32_t avg_q = (int32_t)(acc_q / mixed);
+        if (!m->filter_primed)
+        {
+            m->filtered_i = avg_i;
+            m->filtered_q = avg_q;
+            m->filter_primed = 1U;
+        }
+        else
+        {
+            m->filtered_i += (avg_i - m->filtered_i) >> m->filter_shift;
+            m->filtered_q += (avg_q - m->filtered_q) >> m->filter_shift;
+        }
+        m->buffers++;
+    }
+    m->cycles_per_buffer = ScopeProfile_CycleCount() - start;
+}
+
+void ScopeLockin_Service(void)
+{
+    if (scope_lockin_module.enabled && !scope_lockin_module.locked)
+    {
+        if (!ScopeLockin_Lock())
+        {
+            scope_lockin_module.enabled = 0U;
+        }
+    }
+}
+
+void ScopeLockin_GetStatus(ScopeLockinStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    int32_t filtered_i = scope_lockin_module.filtered_i;
+    int32_t filtered_q = scope_lockin_module.filtered_q;
+    status->enabled = scope_lockin_module.enabled;
+    status->locked = scope_lockin_module.locked && scope_lockin_module.filter_primed;
+    status->buffers = scope_lockin_module.buffers;
+    status->relocks = scope_lockin_module.relocks;
+    status->cycles_per_buffer = scope_lockin_module.cycles_per_buffer;
+    uint32_t adc_ticks = scope_lockin_module.adc_ticks;
+    uint32_t dac_ticks = scope_lockin_module.dac_ticks;
+    uint8_t shift = scope_lockin_module.filter_shift;
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+
+    uint32_t adc_rate = ScopeSignal_GetAdcRateHz();
+    status->reference_centihz = (dac_ticks != 0U)
+                                    ? (uint32_t)(((uint64_t)adc_rate * adc_ticks * 100U) /
+                                                 ((uint64_t)dac_ticks * LOCKIN_SINE_STEPS))
+                                    : 0U;
+    status->time_constant_ms = (adc_rate != 0U)
+                                   ? (uint32_t)((((uint64_t)SCOPE_FRAME_SAMPLES * 1000U) << shift) / adc_rate)
+                                   : 0U;
+
+    /* Each average is A/2 * cos or sin of the phase, scaled by the Q15
+       reference. */
+    status->in_phase_counts = 2.0f * (float)filtered_i / 32767.0f;
+    status->quadrature_counts = 2.0f * (float)filtered_q / 32767.0f;
+    status->amplitude_counts = sqrtf(status->in_phase_counts * status->in_phase_counts +
+                                     status->quadrature_counts * status->quadrature_counts);
+    status->phase_deg = atan2f(status->quadrature_counts, status->in_phase_counts) * 57.2957795f;
+}
+
+static uint8_t ScopeLockin_Lock(void)
+{
+    ScopeLockinModule *m = &scope_lockin_module;
+    uint32_t tim3_psc = htim3.Instance->PSC;
+    uint32_t tim3_arr = htim3.Instance->ARR;
+    uint32_t tim4_psc = htim4.Instance->PSC;
+    uint32_t tim4_arr = htim4.Instance->ARR;
+    uint32_t adc_ticks = (tim3_psc + 1U) * (tim3_arr + 1U);
+    uint32_t dac_ticks = (tim4_psc + 1U) * (tim4_arr + 1U);
+    uint64_t period = 2ULL * LOCKIN_SINE_STEPS * dac_ticks;
+
+    /* Both timers run from the APB1 timer clock, so a fixed tick relation
+       holds forever once their counters are restarted together. */
+    if ((uint64_t)dac_ticks * LOCKIN_SINE_STEPS < (uint64_t)adc_ticks * SCOPE_LOCKIN_MIN_SAMPLES_PER_CYCLE ||
+        period >= (1ULL << 31))
+    {
+        return 0U;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t dac_remaining = 0U;
+    uint32_t adc_remaining = 0U;
+    ScopeSignal_RestartWithDac(&dac_remaining, &adc_remaining);
+
+    /* The DAC holding register already carries the entry before the next DMA
+       index, and the ADC writes its next sample at the DMA position. */
+    uint32_t dac_next = (LOCKIN_SINE_STEPS - dac_remaining) % LOCKIN_SINE_STEPS;
+    uint32_t adc_next = (LOCKIN_DMA_SAMPLES - adc_remaining) % LOCKIN_DMA_SAMPLES;
+
+    m->tim3_psc = tim3_psc;
+    m->tim3_arr = tim3_arr;
+    m->tim4_psc = tim4_psc;
+    m->tim4_arr = tim4_arr;
+    m->adc_ticks = adc_ticks;
+    m->dac_ticks = dac_ticks;
+    m->period_half_ticks = period;
+    /* DAC output during [j*T4, (j+1)*T4) is entry dac_next - 1 + j; its
+       fundamental is the zero-order hold delayed by half a step, i.e. phase
+       (t/T4 + dac_next - 1.5) / 64 of a cycle. */
+    m->phase_half_ticks = ((2ULL * dac_next + 2ULL * LOCKIN_SINE_STEPS - 3ULL) * dac_ticks) % period;
+    m->phase_step = (uint32_t)((((uint64_t)adc_ticks * 2ULL) << 32) / period);
+    m->start_index = (uint16_t)adc_next;
+    m->filter_primed = 0U;
+    m->relocks++;
+    m->locked = 1U;
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+
+    ScopeLockin_UpdateFilterShift();
+    return 1U;
+}
+
+static void ScopeLockin_UpdateFilterShift(void)
+{
+    /* One-pole filter at the half-buffer rate: 2^shift buffers per time
+       constant. */
+    uint64_t buffers = ((uint64_t)scope_lockin_module.time_constant_ms * ScopeSignal_GetAdcRateHz()) /
+                       ((uint64_t)SCOPE_FRAME_SAMPLES * 1000U);
+    uint8_t shift = 0U;
+    while (shift < LOCKIN_MAX_FILTER_SHIFT && (2ULL << shift) <= buffers)
+    {
+        shift++;
+    }
+    scope_lockin_module.filter_shift = shift;
+}
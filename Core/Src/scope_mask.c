@@ -0,0 +1,196 @@
+#include "scope_mask.h"
+
+#include "scope_dsp.h"
+#include "scope_profile.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum { MASK_PAIRS = (SCOPE_MASK_COLUMNS + 1U) / 2U };
+
+typedef struct
+{
+    uint32_t lower[MASK_PAIRS];
+    uint32_t upper[MASK_PAIRS];
+    uint16_t columns;
+    ScopeMaskWindow window;
+    ScopeMaskStatus status;
+} ScopeMaskModule;
+
+static ScopeMaskModule scope_mask_module;
+
+static void ScopeMask_SetBand(uint16_t column, uint16_t lower, uint16_t upper);
+static uint16_t ScopeMask_CountFailingColumns(const uint32_t *values, uint16_t pairs);
+
+void ScopeMask_Init(void)
+{
+    memset(&scope_mask_module, 0, sizeof(scope_mask_module));
+}
+
+uint8_t ScopeMask_Build(const uint16_t *samples,
+                        const uint16_t *column_map,
+                        uint16_t columns,
+                        const ScopeMaskWindow *window,
+                        uint16_t tolerance_counts,
+                        uint16_t tolerance_columns)
+{
+    if (samples == NULL || column_map == NULL || window == NULL ||
+        columns == 0U || columns > SCOPE_MASK_COLUMNS)
+    {
+        return 0U;
+    }
+
+    for (uint16_t x = 0U; x < columns; x++)
+    {
+        uint16_t first = (x > tolerance_columns) ? (uint16_t)(x - tolerance_columns) : 0U;
+        uint16_t last = (uint16_t)(x + tolerance_columns);
+        if (last >= columns)
+        {
+            last = (uint16_t)(columns - 1U);
+        }
+
+        /* Widening the band by the neighbouring columns keeps steep edges, which
+           move by a column with every bit of trigger jitter, from failing. */
+        uint16_t band_min = 0xFFFFU;
+        uint16_t band_max = 0U;
+        for (uint16_t col = first; col <= last; col++)
+        {
+            uint16_t v = samples[column_map[col]];
+            band_min = (v < band_min) ? v : band_min;
+            band_max = (v > band_max) ? v : band_max;
+        }
+
+        uint16_t lower = (band_min > tolerance_counts) ? (uint16_t)(band_min - tolerance_counts) : 0U;
+        uint16_t upper = ((uint32_t)band_max + tolerance_counts < 0xFFFFU) ? (uint16_t)(band_max + tolerance_counts)
+                                                                             : 0xFFFFU;
+        ScopeMask_SetBand(x, lower, upper);
+    }
+    if ((columns & 1U) != 0U)
+    {
+        ScopeMask_SetBand(columns, 0U, 0xFFFFU);
+    }
+
+    scope_mask_module.columns = columns;
+    scope_mask_module.window = *window;
+    scope_mask_module.status.valid = 1U;
+    scope_mask_module.status.window_mismatch = 0U;
+    ScopeMask_ResetCounters();
+    return 1U;
+}
+
+void ScopeMask_SetEnabled(uint8_t enabled)
+{
+    scope_mask_module.status.enabled = (enabled && scope_mask_module.status.valid) ? 1U : 0U;
+}
+
+uint8_t ScopeMask_IsEnabled(void)
+{
+    return scope_mask_module.status.enabled;
+}
+
+void ScopeMask_SetStopOnFail(uint8_t stop)
+{
+    scope_mask_module.status.stop_on_fail = stop ? 1U : 0U;
+}
+
+uint8_t ScopeMask_IsStopOnFail(void)
+{
+    return scope_mask_module.status.stop_on_fail;
+}
+
+void ScopeMask_ResetCounters(void)
+{
+    scope_mask_module.status.tested = 0U;
+    scope_mask_module.status.passed = 0U;
+    scope_mask_module.status.failed = 0U;
+    scope_mask_module.status.last_fail_columns = 0U;
+}
+
+uint8_t ScopeMask_Test(const uint16_t *samples,
+                       const uint16_t *column_map,
+                       uint16_t columns,
+                       const ScopeMaskWindow *window)
+{
+    ScopeMaskModule *mask = &scope_mask_module;
+    if (!mask->status.enabled || samples == NULL || column_map == NULL || window == NULL)
+    {
+        return 0U;
+    }
+
+    /* After a zoom, pan or timebase change the same column holds another
+       instant, so every frame would fail against the captured bands. */
+    mask->status.window_mismatch = (window->sample_rate_hz != mask->window.sample_rate_hz ||
+                                    window->samples_visible != mask->window.samples_visible ||
+                                    window->center_sample != mask->window.center_sample) ? 1U : 0U;
+    if (mask->status.window_mismatch)
+    {
+        return 0U;
+    }
+
+    uint32_t start_cycles = ScopeProfile_CycleCount();
+    if (columns > mask->columns)
+    {
+        columns = mask->columns;
+    }
+
+    uint32_t values[MASK_PAIRS];
+    uint16_t pairs = (uint16_t)((columns + 1U) / 2U);
+    uint32_t violation = 0U;
+    for (uint16_t pair = 0U; pair < pairs; pair++)
+    {
+        uint16_t x = (uint16_t)(pair * 2U);
+        uint32_t low_value = samples[column_map[x]];
+        uint32_t high_value = ((uint16_t)(x + 1U) < columns) ? samples[column_map[x + 1U]]
+                                                              : (mask->lower[pair] >> 16);
+        uint32_t value = low_value | (high_value << 16);
+        values[pair] = value;
+
+        /* Both halves saturate to zero while the column is inside its band. */
+        violation |= ScopeDsp_SubSaturateU16x2(mask->lower[pair], value);
+        violation |= ScopeDsp_SubSaturateU16x2(value, mask->upper[pair]);
+    }
+
+    uint8_t failed = (violation != 0U) ? 1U : 0U;
+    mask->status.tested++;
+    if (failed)
+    {
+        mask->status.failed++;
+        mask->status.last_fail_columns = ScopeMask_CountFailingColumns(values, pairs);
+    }
+    else
+    {
+        mask->status.passed++;
+    }
+    mask->status.cycles = ScopeProfile_CycleCount() - start_cycles;
+    return failed;
+}
+
+void ScopeMask_GetStatus(ScopeMaskStatus *status)
+{
+    if (status != NULL)
+    {
+        *status = scope_mask_module.status;
+    }
+}
+
+static void ScopeMask_SetBand(uint16_t column, uint16_t lower, uint16_t upper)
+{
+    uint16_t pair = (uint16_t)(column / 2U);
+    uint32_t shift = (column & 1U) ? 16U : 0U;
+    uint32_t keep = ~(0xFFFFUL << shift);
+    scope_mask_module.lower[pair] = (scope_mask_module.lower[pair] & keep) | ((uint32_t)lower << shift);
+    scope_mask_module.upper[pair] = (scope_mask_module.upper[pair] & keep) | ((uint32_t)upper << shift);
+}
+
+static uint16_t ScopeMask_CountFailingColumns(const uint32_t *values, uint16_t pairs)
+{
+    uint16_t failing = 0U;
+    for (uint16_t pair = 0U; pair < pairs; pair++)
+    {
+        uint32_t outside = ScopeDsp_SubSaturateU16x2(scope_mask_module.lower[pair], values[pair]) |
+                           ScopeDsp_SubSaturateU16x2(values[pair], scope_mask_module.upper[pair]);
+        failing += ((outside & 0xFFFFU) != 0U) ? 1U : 0U;
+        failing += ((outside >> 16) != 0U) ? 1U : 0U;
+    }
+    return failing;
+}
@@ -0,0 +1,568 @@
+#include "scope_measure.h"
+
+#include "scope_calib.h"
+#include "scope_histogram.h"
+#include "scope_profile.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum
+{
+    MEASURE_EDGE_LOW_PERCENT = 10U,
+    MEASURE_EDGE_HIGH_PERCENT = 90U,
+    MEASURE_SCAN_MASK = (1UL << SCOPE_MEASURE_MEAN) |
+                        (1UL << SCOPE_MEASURE_RMS) |
+                        (1UL << SCOPE_MEASURE_RISE) |
+                        (1UL << SCOPE_MEASURE_FALL) |
+                        (1UL << SCOPE_MEASURE_OVERSHOOT),
+    MEASURE_CROSSING_MASK = (1UL << SCOPE_MEASURE_FREQ) |
+                            (1UL << SCOPE_MEASURE_PERIOD) |
+                            (1UL << SCOPE_MEASURE_DUTY_POS) |
+                            (1UL << SCOPE_MEASURE_DUTY_NEG) |
+                            (1UL << SCOPE_MEASURE_WIDTH_POS) |
+                            (1UL << SCOPE_MEASURE_WIDTH_NEG)
+};
+
+typedef struct
+{
+    const char *label;
+    const char *name;
+    ScopeMeasureUnit unit;
+} ScopeMeasureDescriptor;
+
+static const ScopeMeasureDescriptor scope_measure_descriptors[SCOPE_MEASURE_COUNT] = {
+    [SCOPE_MEASURE_VMAX] = {"Vmax", "vmax", SCOPE_MEASURE_UNIT_MILLIVOLT},
+    [SCOPE_MEASURE_VMIN] = {"Vmin", "vmin", SCOPE_MEASURE_UNIT_MILLIVOLT},
+    [SCOPE_MEASURE_VPP] = {"Vpp", "vpp", SCOPE_MEASURE_UNIT_MILLIVOLT},
+    [SCOPE_MEASURE_MEAN] = {"Mean", "mean", SCOPE_MEASURE_UNIT_MILLIVOLT},
+    [SCOPE_MEASURE_RMS] = {"RMS", "rms", SCOPE_MEASURE_UNIT_MILLIVOLT},
+    [SCOPE_MEASURE_FREQ] = {"Freq", "freq", SCOPE_MEASURE_UNIT_HZ},
+    [SCOPE_MEASURE_PERIOD] = {"Per", "per", SCOPE_MEASURE_UNIT_NS},
+    [SCOPE_MEASURE_DUTY_POS] = {"Duty+", "duty+", SCOPE_MEASURE_UNIT_PERMILLE},
+    [SCOPE_MEASURE_DUTY_NEG] = {"Duty-", "duty-", SCOPE_MEASURE_UNIT_PERMILLE},
+    [SCOPE_MEASURE_WIDTH_POS] = {"Wid+", "wid+", SCOPE_MEASURE_UNIT_NS},
+    [SCOPE_MEASURE_WIDTH_NEG] = {"Wid-", "wid-", SCOPE_MEASURE_UNIT_NS},
+    [SCOPE_MEASURE_RISE] = {"Rise", "rise", SCOPE_MEASURE_UNIT_NS},
+    [SCOPE_MEASURE_FALL] = {"Fall", "fall", SCOPE_MEASURE_UNIT_NS},
+    [SCOPE_MEASURE_OVERSHOOT] = {"Ovsh", "ovsh", SCOPE_MEASURE_UNIT_PERMILLE}
+};
+
+typedef struct
+{
+    uint64_t sum_sq;
+    uint32_t sum;
+    uint16_t top;
+    uint16_t base;
+    uint32_t rise_total_q8;
+    uint32_t rise_count;
+    uint32_t fall_total_q8;
+    uint32_t fall_count;
+} ScopeMeasureScan;
+
+typedef struct
+{
+    ScopeMeasureId display_slots[SCOPE_MEASURE_DISPLAY_SLOTS];
+    uint8_t report_pending;
+    uint8_t report_ready;
+    ScopeMeasureResult report;
+    uint32_t last_cycles;
+} ScopeMeasureModule;
+
+static ScopeMeasureModule scope_measure_module;
+
+static void ScopeMeasure_ResolveLevels(const ScopeMeasureInput *input, ScopeMeasureScan *scan);
+static void ScopeMeasure_ScanRecord(const ScopeMeasureInput *input, ScopeMeasureScan *scan);
+static void ScopeMeasure_FromScan(const ScopeMeasureInput *input,
+                                  const ScopeMeasureScan *scan,
+                                  uint32_t mask,
+                                  ScopeMeasureResult *result);
+static void ScopeMeasure_FromCrossings(const ScopeMeasureInput *input,
+                                       uint32_t mask,
+                                       ScopeMeasureResult *result);
+static void ScopeMeasure_PeriodFromAutocorrelation(const ScopeMeasureInput *input,
+                                                   uint32_t mask,
+                                                   ScopeMeasureResult *result);
+static void ScopeMeasure_SetValue(ScopeMeasureResult *result,
+                                  uint32_t mask,
+                                  ScopeMeasureId id,
+                                  int32_t value);
+static int32_t ScopeMeasure_Q8SamplesToNs(uint32_t samples_q8, uint32_t sample_rate_hz);
+static uint32_t ScopeMeasure_Sqrt(uint32_t value);
+
+void ScopeMeasure_Init(void)
+{
+    memset(&scope_measure_module, 0, sizeof(scope_measure_module));
+    scope_measure_module.display_slots[0] = SCOPE_MEASURE_VMAX;
+    scope_measure_module.display_slots[1] = SCOPE_MEASURE_VMIN;
+    scope_measure_module.display_slots[2] = SCOPE_MEASURE_FREQ;
+}
+
+void ScopeMeasure_Compute(const ScopeMeasureInput *input,
+                          uint32_t mask,
+                          ScopeMeasureResult *result)
+{
+    if (result == NULL)
+    {
+        return;
+    }
+
+    uint32_t start = ScopeProfile_CycleCount();
+    memset(result, 0, sizeof(*result));
+
+    if (input == NULL || input->samples == NULL || input->count < 2U ||
+        input->frame_max < input->frame_min)
+    {
+        return;
+    }
+
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_VMAX,
+                          (int32_t)ScopeCalib_CountsToMillivolt(input->frame_max));
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_VMIN,
+                          (int32_t)ScopeCalib_CountsToMillivolt(input->frame_min));
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_VPP,
+                          (int32_t)ScopeCalib_SpanToMillivolt((uint32_t)input->frame_max - input->frame_min));
+
+    if ((mask & MEASURE_SCAN_MASK) != 0U)
+    {
+        ScopeMeasureScan scan;
+        ScopeMeasure_ScanRecord(input, &scan);
+        ScopeMeasure_FromScan(input, &scan, mask, result);
+    }
+
+    if ((mask & MEASURE_CROSSING_MASK) != 0U)
+    {
+        ScopeMeasure_FromCrossings(input, mask, result);
+    }
+
+    result->cycles = ScopeProfile_CycleCount() - start;
+    scope_measure_module.last_cycles = result->cycles;
+}
+
+uint32_t ScopeMeasure_DisplayMask(void)
+{
+    uint32_t mask = 0U;
+    for (uint8_t slot = 0U; slot < SCOPE_MEASURE_DISPLAY_SLOTS; slot++)
+    {
+        mask |= 1UL << scope_measure_module.display_slots[slot];
+    }
+    return mask;
+}
+
+uint32_t ScopeMeasure_ActiveMask(void)
+{
+    uint32_t mask = ScopeMeasure_DisplayMask();
+    if (scope_measure_module.report_pending)
+    {
+        mask |= SCOPE_MEASURE_ALL_MASK;
+    }
+    return mask;
+}
+
+uint8_t ScopeMeasure_SetDisplaySlot(uint8_t slot, ScopeMeasureId id)
+{
+    if (slot >= SCOPE_MEASURE_DISPLAY_SLOTS || id >= SCOPE_MEASURE_COUNT)
+    {
+        return 0U;
+    }
+    scope_measure_module.display_slots[slot] = id;
+    return 1U;
+}
+
+ScopeMeasureId ScopeMeasure_GetDisplaySlot(uint8_t slot)
+{
+    if (slot >= SCOPE_MEASURE_DISPLAY_SLOTS)
+    {
+        return SCOPE_MEASURE_COUNT;
+    }
+    return scope_measure_module.display_slots[slot];
+}
+
+void ScopeMeasure_RequestReport(void)
+{
+    scope_measure_module.report_pending = 1U;
+}
+
+uint8_t ScopeMeasure_IsReportPending(void)
+{
+    return scope_measure_module.report_pending;
+}
+
+void ScopeMeasure_PublishReport(const ScopeMeasureResult *result)
+{
+    if (result == NULL || !scope_measure_module.report_pending)
+    {
+        return;
+    }
+    scope_measure_module.report = *result;
+    scope_measure_module.report_pending = 0U;
+    scope_measure_module.report_ready = 1U;
+}
+
+uint8_t ScopeMeasure_TakeReport(ScopeMeasureResult *result)
+{
+    if (!scope_measure_module.report_ready || result == NULL)
+    {
+        return 0U;
+    }
+    *result = scope_measure_module.report;
+    scope_measure_module.report_ready = 0U;
+    return 1U;
+}
+
+uint32_t ScopeMeasure_GetLastCycles(void)
+{
+    return scope_measure_module.last_cycles;
+}
+
+const char *ScopeMeasure_Label(ScopeMeasureId id)
+{
+    if (id >= SCOPE_MEASURE_COUNT)
+    {
+        return "---";
+    }
+    return scope_measure_descriptors[id].label;
+}
+
+ScopeMeasureUnit ScopeMeasure_Unit(ScopeMeasureId id)
+{
+    if (id >= SCOPE_MEASURE_COUNT)
+    {
+        return SCOPE_MEASURE_UNIT_MILLIVOLT;
+    }
+    return scope_measure_descriptors[id].unit;
+}
+
+uint8_t ScopeMeasure_FindByName(const char *name, ScopeMeasureId *out_id)
+{
+    if (name == NULL || out_id == NULL)
+    {
+        return 0U;
+    }
+
+    for (uint8_t id = 0U; id < SCOPE_MEASURE_COUNT; id++)
+    {
+        const char *ref = scope_measure_descriptors[id].name;
+        const char *cand = name;
+        while (*ref != '\0')
+        {
+            char c = *cand;
+            if (c >= 'A' && c <= 'Z')
+            {
+                c = (char)(c - 'A' + 'a');
+            }
+            if (c != *ref)
+            {
+                break;
+            }
+            ref++;
+            cand++;
+        }
+        if (*ref == '\0' && *cand == '\0')
+        {
+            *out_id = (ScopeMeasureId)id;
+            return 1U;
+        }
+    }
+    return 0U;
+}
+
+static void ScopeMeasure_ResolveLevels(const ScopeMeasureInput *input, ScopeMeasureScan *scan)
+{
+    if (input->top_counts > input->base_counts)
+    {
+        scan->top = input->top_counts;
+        scan->base = input->base_counts;
+        return;
+    }
+    if (!ScopeHistogram_EstimateLevels(input->samples,
+                                       input->count,
+                                       input->frame_min,
+                                       input->frame_max,
+                                       &scan->top,
+                                       &scan->base))
+    {
+        scan->top = input->frame_max;
+        scan->base = input->frame_min;
+    }
+}
+
+static void ScopeMeasure_ScanRecord(const ScopeMeasureInput *input, ScopeMeasureScan *scan)
+{
+    memset(scan, 0, sizeof(*scan));
+    ScopeMeasure_ResolveLevels(input, scan);
+
+    /* Edge thresholds sit between the histogram top and base levels, so ringing
+       and noise spikes on the extremes do not move them. */
+    const uint16_t *buf = input->samples;
+    const uint16_t len = input->count;
+    const uint32_t amplitude = (uint32_t)scan->top - scan->base;
+    const uint16_t lo = (uint16_t)(scan->base + (amplitude * MEASURE_EDGE_LOW_PERCENT) / 100U);
+    const uint16_t hi = (uint16_t)(scan->base + (amplitude * MEASURE_EDGE_HIGH_PERCENT) / 100U);
+
+    uint32_t rise_start_q8 = 0U;
+    uint32_t fall_start_q8 = 0U;
+    uint8_t rise_armed = 0U;
+    uint8_t fall_armed = 0U;
+
+    for (uint16_t i = 0U; i < len; i++)
+    {
+        uint16_t v = buf[i];
+        scan->sum += v;
+        scan->sum_sq += (uint32_t)v * v;
+
+        if (i == 0U || lo >= hi)
+        {
+            continue;
+        }
+
+        uint16_t prev = buf[i - 1U];
+        if (prev < lo && v >= lo)
+        {
+            rise_start_q8 = ScopeSignal_InterpolateCrossingQ8(i, prev, v, lo);
+            rise_armed = 1U;
+        }
+        if (prev < hi && v >= hi && rise_armed)
+        {
+            uint32_t end_q8 = ScopeSignal_InterpolateCrossingQ8(i, prev, v, hi);
+            scan->rise_total_q8 += end_q8 - rise_start_q8;
+            scan->rise_count++;
+            rise_armed = 0U;
+        }
+        if (prev > hi && v <= hi)
+        {
+            fall_start_q8 = ScopeSignal_InterpolateCrossingQ8(i, prev, v, hi);
+            fall_armed = 1U;
+        }
+        if (prev > lo && v <= lo && fall_armed)
+        {
+            uint32_t end_q8 = ScopeSignal_InterpolateCrossingQ8(i, prev, v, lo);
+            scan->fall_total_q8 += end_q8 - fall_start_q8;
+            scan->fall_count++;
+            fall_armed = 0U;
+        }
+    }
+}
+
+static void ScopeMeasure_FromScan(const ScopeMeasureInput *input,
+                                  const ScopeMeasureScan *scan,
+                                  uint32_t mask,
+                                  ScopeMeasureResult *result)
+{
+    uint32_t len = input->count;
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_MEAN,
+                          (int32_t)ScopeCalib_CountsToMillivolt((scan->sum + len / 2U) / len));
+
+    /* RMS of the offset-corrected samples: sum((v - z)^2) expanded, so the
+       scan stays a plain sum and sum of squares. */
+    int64_t zero = ScopeCalib_OffsetCounts();
+    int64_t sum_sq = (int64_t)scan->sum_sq - 2 * zero * (int64_t)scan->sum + zero * zero * (int64_t)len;
+    uint32_t mean_sq = (sum_sq > 0) ? (uint32_t)((uint64_t)sum_sq / len) : 0U;
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_RMS,
+                          (int32_t)ScopeCalib_SpanToMillivolt(ScopeMeasure_Sqrt(mean_sq)));
+
+    if (scan->rise_count != 0U)
+    {
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_RISE,
+                              ScopeMeasure_Q8SamplesToNs(scan->rise_total_q8 / scan->rise_count,
+                                                         input->sample_rate_hz));
+    }
+    if (scan->fall_count != 0U)
+    {
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_FALL,
+                              ScopeMeasure_Q8SamplesToNs(scan->fall_total_q8 / scan->fall_count,
+                                                         input->sample_rate_hz));
+    }
+
+    if (scan->top > scan->base && input->frame_max >= scan->top)
+    {
+        uint32_t overshoot = ((uint32_t)(input->frame_max - scan->top) * 1000U) / (scan->top - scan->base);
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_OVERSHOOT, (int32_t)overshoot);
+    }
+}
+
+static void ScopeMeasure_FromCrossings(const ScopeMeasureInput *input,
+                                       uint32_t mask,
+                                       ScopeMeasureResult *result)
+{
+    const ScopeSignalCrossings *crossings = input->crossings;
+    if (crossings == NULL)
+    {
+        return;
+    }
+
+    uint32_t first_rise_q8 = 0U;
+    uint32_t last_rise_q8 = 0U;
+    uint32_t rise_count = 0U;
+    uint32_t high_total_q8 = 0U;
+    uint32_t high_count = 0U;
+    uint32_t low_total_q8 = 0U;
+    uint32_t low_count = 0U;
+    uint32_t high_in_cycles_q8 = 0U;
+    uint32_t min_cycle_q8 = 0xFFFFFFFFU;
+    uint32_t max_cycle_q8 = 0U;
+
+    for (uint16_t i = 0U; i < crossings->count; i++)
+    {
+        const ScopeSignalCrossing *edge = &crossings->edges[i];
+        if (edge->rising)
+        {
+            if (rise_count == 0U)
+            {
+                first_rise_q8 = edge->position_q8;
+            }
+            else
+            {
+                uint32_t cycle_q8 = edge->position_q8 - last_rise_q8;
+                min_cycle_q8 = (cycle_q8 < min_cycle_q8) ? cycle_q8 : min_cycle_q8;
+                max_cycle_q8 = (cycle_q8 > max_cycle_q8) ? cycle_q8 : max_cycle_q8;
+            }
+            last_rise_q8 = edge->position_q8;
+            rise_count++;
+        }
+
+        if (i + 1U >= crossings->count)
+        {
+            continue;
+        }
+
+        uint32_t width_q8 = crossings->edges[i + 1U].position_q8 - edge->position_q8;
+        if (edge->rising)
+        {
+            high_total_q8 += width_q8;
+            high_count++;
+        }
+        else
+        {
+            low_total_q8 += width_q8;
+            low_count++;
+        }
+    }
+
+    if (high_count != 0U)
+    {
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_WIDTH_POS,
+                              ScopeMeasure_Q8SamplesToNs(high_total_q8 / high_count,
+                                                         input->sample_rate_hz));
+    }
+    if (low_count != 0U)
+    {
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_WIDTH_NEG,
+                              ScopeMeasure_Q8SamplesToNs(low_total_q8 / low_count,
+                                                         input->sample_rate_hz));
+    }
+
+    /* Irregular rising-edge spacing means harmonics or noise add midpoint crossings;
+       period and frequency then come from the autocorrelation instead. */
+    if (rise_count < 2U || last_rise_q8 <= first_rise_q8 ||
+        max_cycle_q8 > min_cycle_q8 + min_cycle_q8 / 2U)
+    {
+        ScopeMeasure_PeriodFromAutocorrelation(input, mask, result);
+        return;
+    }
+
+    /* Duty cycle only counts complete cycles between the first and last rising edge. */
+    for (uint16_t i = 0U; i + 1U < crossings->count; i++)
+    {
+        const ScopeSignalCrossing *edge = &crossings->edges[i];
+        if (edge->rising && edge->position_q8 >= first_rise_q8 &&
+            edge->position_q8 < last_rise_q8)
+        {
+            high_in_cycles_q8 += crossings->edges[i + 1U].position_q8 - edge->position_q8;
+        }
+    }
+
+    uint32_t span_q8 = last_rise_q8 - first_rise_q8;
+    uint32_t period_q8 = span_q8 / (rise_count - 1U);
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_PERIOD,
+                          ScopeMeasure_Q8SamplesToNs(period_q8, input->sample_rate_hz));
+    if (input->sample_rate_hz != 0U)
+    {
+        uint64_t freq = ((uint64_t)input->sample_rate_hz * 256U * (rise_count - 1U) + span_q8 / 2U) /
+                        span_q8;
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_FREQ, (int32_t)freq);
+    }
+
+    uint32_t duty = (uint32_t)(((uint64_t)high_in_cycles_q8 * 1000U) / span_q8);
+    if (duty > 1000U)
+    {
+        duty = 1000U;
+    }
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_DUTY_POS, (int32_t)duty);
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_DUTY_NEG, (int32_t)(1000U - duty));
+}
+
+static void ScopeMeasure_PeriodFromAutocorrelation(const ScopeMeasureInput *input,
+                                                   uint32_t mask,
+                                                   ScopeMeasureResult *result)
+{
+    if ((mask & ((1UL << SCOPE_MEASURE_PERIOD) | (1UL << SCOPE_MEASURE_FREQ))) == 0U ||
+        (uint32_t)(input->frame_max - input->frame_min) < input->min_amplitude_counts)
+    {
+        return;
+    }
+
+    uint32_t period_q8 = ScopeSignal_EstimatePeriodAcfQ8(input->samples, input->count);
+    if (period_q8 == 0U)
+    {
+        return;
+    }
+    ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_PERIOD,
+                          ScopeMeasure_Q8SamplesToNs(period_q8, input->sample_rate_hz));
+    if (input->sample_rate_hz != 0U)
+    {
+        uint64_t freq = ((uint64_t)input->sample_rate_hz * 256U + period_q8 / 2U) / period_q8;
+        ScopeMeasure_SetValue(result, mask, SCOPE_MEASURE_FREQ, (int32_t)freq);
+    }
+}
+
+static void ScopeMeasure_SetValue(ScopeMeasureResult *result,
+                                  uint32_t mask,
+                                  ScopeMeasureId id,
+                                  int32_t value)
+{
+    if ((mask & (1UL << id)) == 0U)
+    {
+        return;
+    }
+    result->values[id] = value;
+    result->valid_mask |= 1UL << id;
+}
+
+static int32_t ScopeMeasure_Q8SamplesToNs(uint32_t samples_q8, uint32_t sample_rate_hz)
+{
+    if (sample_rate_hz == 0U)
+    {
+        return 0;
+    }
+    uint64_t ns = ((uint64_t)samples_q8 * 1000000000ULL) / ((uint64_t)sample_rate_hz * 256U);
+    if (ns > 0x7FFFFFFFULL)
+    {
+        ns = 0x7FFFFFFFULL;
+    }
+    return (int32_t)ns;
+}
+
+static uint32_t ScopeMeasure_Sqrt(uint32_t value)
+{
+    uint32_t root = 0U;
+    uint32_t bit = 1UL << 30;
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0U)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
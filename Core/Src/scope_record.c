@@ -0,0 +1,336 @@
+#include "scope_record.h"
+
+#include "scope.h"
+#include "scope_history.h"
+#include "scope_profile.h"
+
+#include <stddef.h>
+
+enum
+{
+    /* Samples under one level-0 entry; a frame holds a whole number of
+       them, so no block straddles two history slots. */
+    RECORD_BLOCK_SAMPLES = 32U,
+    RECORD_BLOCKS_PER_FRAME = SCOPE_FRAME_SAMPLES / RECORD_BLOCK_SAMPLES,
+    RECORD_MAX_BLOCKS = SCOPE_RECORD_MAX_FRAMES * RECORD_BLOCKS_PER_FRAME,
+    /* 1920 blocks halve down to one entry in twelve levels. */
+    RECORD_MAX_LEVELS = 12U,
+    RECORD_PYRAMID_ENTRIES = 2U * RECORD_MAX_BLOCKS + RECORD_MAX_LEVELS
+};
+
+typedef struct
+{
+    uint16_t min;
+    uint16_t max;
+} ScopeRecordSpan;
+
+typedef struct
+{
+    uint16_t frames;
+    uint16_t length;
+    uint16_t newest_age;
+    uint8_t levels;
+    uint16_t level_offset[RECORD_MAX_LEVELS];
+    uint32_t build_cycles;
+} ScopeRecordModule;
+
+static ScopeRecordModule scope_record_module;
+/* Level 0 is the min/max of each block, every level above merges pairs of
+   the one below; an odd entry at the end of a level stands alone. */
+static ScopeRecordSpan scope_record_pyramid[RECORD_PYRAMID_ENTRIES];
+
+static void ScopeRecord_BuildLevels(void);
+static void ScopeRecord_ScanRange(uint32_t first, uint32_t end, ScopeRecordSpan *span);
+static void ScopeRecord_ScanSamples(uint32_t first, uint32_t end, ScopeRecordSpan *span);
+static void ScopeRecord_Merge(ScopeRecordSpan *span, const ScopeRecordSpan *other);
+static uint16_t ScopeRecord_FrameAge(uint16_t frame);
+
+uint16_t ScopeRecord_Build(uint16_t age)
+{
+    ScopeRecordModule *m = &scope_record_module;
+    uint32_t start = ScopeProfile_CycleCount();
+    ScopeRecord_Clear();
+
+    ScopeHistoryInfo info;
+    if (!ScopeHistory_Get(age, NULL, &info) || info.sample_count != SCOPE_FRAME_SAMPLES)
+    {
+        return 0U;
+    }
+    uint16_t frames = 1U;
+    uint32_t sequence = info.sequence;
+    while (frames < SCOPE_RECORD_MAX_FRAMES &&
+           ScopeHistory_Get((uint16_t)(age + frames), NULL, &info) &&
+           info.sample_count == SCOPE_FRAME_SAMPLES &&
+           info.sequence == sequence - 1U)
+    {
+        sequence = info.sequence;
+        frames++;
+    }
+
+    m->frames = frames;
+    m->newest_age = age;
+    m->length = (uint16_t)(frames * SCOPE_FRAME_SAMPLES);
+
+    uint16_t samples[SCOPE_FRAME_SAMPLES];
+    ScopeRecordSpan *blocks = scope_record_pyramid;
+    for (uint16_t frame = 0U; frame < frames; ++frame)
+    {
+        (void)ScopeHistory_Get(ScopeRecord_FrameAge(frame), samples, NULL);
+        const uint16_t *block = samples;
+        for (uint16_t b = 0U; b < RECORD_BLOCKS_PER_FRAME; ++b)
+        {
+            ScopeRecordSpan span = {block[0], block[0]};
+            for (uint16_t i = 1U; i < RECORD_BLOCK_SAMPLES; ++i)
+            {
+                if (block[i] < span.min)
+                {
+                    span.min = block[i];
+                }
+                else if (block[i] > span.max)
+                {
+                    span.max = block[i];
+                }
+            }
+            *blocks++ = span;
+            block += RECORD_BLOCK_SAMPLES;
+        }
+    }
+    ScopeRecord_BuildLevels();
+    m->build_cycles = ScopeProfile_CycleCount() - start;
+    return frames;
+}
+
+void ScopeRecord_Clear(void)
+{
+    ScopeRecordModule *m = &scope_record_module;
+    m->frames = 0U;
+    m->length = 0U;
+    m->newest_age = 0U;
+    m->levels = 0U;
+}
+
+uint16_t ScopeRecord_Length(void)
+{
+    return scope_record_module.length;
+}
+
+uint8_t ScopeRecord_Contains(uint16_t age)
+{
+    const ScopeRecordModule *m = &scope_record_module;
+    return (m->frames != 0U && age >= m->newest_age && age - m->newest_age < m->frames) ? 1U : 0U;
+}
+
+uint16_t ScopeRecord_FrameStart(uint16_t age)
+{
+    const ScopeRecordModule *m = &scope_record_module;
+    if (!ScopeRecord_Contains(age))
+    {
+        return 0U;
+    }
+    return (uint16_t)((m->frames - 1U - (age - m->newest_age)) * SCOPE_FRAME_SAMPLES);
+}
+
+uint16_t ScopeRecord_Sample(uint16_t index)
+{
+    uint16_t sample = 0U;
+    ScopeRecord_Read(index, 1U, &sample);
+    return sample;
+}
+
+void ScopeRecord_Read(uint16_t first, uint16_t count, uint16_t *samples)
+{
+    const ScopeRecordModule *m = &scope_record_module;
+    if (m->length == 0U || samples == NULL)
+    {
+        return;
+    }
+
+    uint32_t index = first % m->length;
+    while (count > 0U)
+    {
+        uint16_t frame = (uint16_t)(index / SCOPE_FRAME_SAMPLES);
+        uint16_t offset = (uint16_t)(index - (uint32_t)frame * SCOPE_FRAME_SAMPLES);
+        uint16_t chunk = (uint16_t)(SCOPE_FRAME_SAMPLES - offset);
+        if (chunk > count)
+        {
+            chunk = count;
+        }
+        (void)ScopeHistory_GetRange(ScopeRecord_FrameAge(frame), offset, chunk, samples);
+        samples += chunk;
+        count = (uint16_t)(count - chunk);
+        index += chunk;
+        if (index >= m->length)
+        {
+            index = 0U;
+        }
+    }
+}
+
+void ScopeRecord_Envelope(const uint16_t *column_sample_map,
+                          uint16_t columns,
+                          uint16_t visible_samples,
+                          uint16_t *column_min,
+                          uint16_t *column_max)
+{
+    const ScopeRecordModule *m = &scope_record_module;
+    if (m->length == 0U || column_sample_map == NULL || columns == 0U ||
+        column_min == NULL || column_max == NULL)
+    {
+        return;
+    }
+
+    uint32_t length = m->length;
+    uint32_t window_end = column_sample_map[0] + (uint32_t)visible_samples;
+    if (window_end >= length)
+    {
+        window_end -= length;
+    }
+    for (uint16_t i = 0U; i < columns; ++i)
+    {
+        uint32_t first = column_sample_map[i];
+        uint32_t next = (i + 1U < columns) ? column_sample_map[i + 1U] : window_end;
+        uint32_t count = (next >= first) ? next - first : next + length - first;
+        if (count == 0U)
+        {
+            count = 1U;
+        }
+
+        /* A column that runs off the end of the record continues at its
+           start, as the trace does. */
+        ScopeRecordSpan span = {0xFFFFU, 0U};
+        if (first + count > length)
+        {
+            ScopeRecord_ScanRange(first, length, &span);
+            ScopeRecord_ScanRange(0U, first + count - length, &span);
+        }
+        else
+        {
+            ScopeRecord_ScanRange(first, first + count, &span);
+        }
+        column_min[i] = span.min;
+        column_max[i] = span.max;
+    }
+}
+
+void ScopeRecord_GetStatus(ScopeRecordStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    const ScopeRecordModule *m = &scope_record_module;
+    status->frames = m->frames;
+    status->length = m->length;
+    status->newest_age = m->newest_age;
+    status->levels = m->levels;
+    status->build_cycles = m->build_cycles;
+}
+
+static void ScopeRecord_BuildLevels(void)
+{
+    ScopeRecordModule *m = &scope_record_module;
+    uint16_t count = (uint16_t)(m->frames * RECORD_BLOCKS_PER_FRAME);
+    uint16_t offset = 0U;
+    m->levels = 0U;
+    while (m->levels < RECORD_MAX_LEVELS)
+    {
+        m->level_offset[m->levels] = offset;
+        m->levels++;
+        if (count <= 1U)
+        {
+            break;
+        }
+
+        const ScopeRecordSpan *below = &scope_record_pyramid[offset];
+        ScopeRecordSpan *above = &scope_record_pyramid[offset + count];
+        uint16_t above_count = (uint16_t)((count + 1U) / 2U);
+        for (uint16_t i = 0U; i < above_count; ++i)
+        {
+            above[i] = below[2U * i];
+            if (2U * i + 1U < count)
+            {
+                ScopeRecord_Merge(&above[i], &below[2U * i + 1U]);
+            }
+        }
+        offset = (uint16_t)(offset + count);
+        count = above_count;
+    }
+}
+
+/* Exact min/max of [first, end): loose samples up to the first block
+   boundary and after the last one, and at most two entries per level for
+   the whole blocks in between. */
+static void ScopeRecord_ScanRange(uint32_t first, uint32_t end, ScopeRecordSpan *span)
+{
+    const ScopeRecordModule *m = &scope_record_module;
+    uint32_t block = (first + RECORD_BLOCK_SAMPLES - 1U) / RECORD_BLOCK_SAMPLES;
+    uint32_t block_end = end / RECORD_BLOCK_SAMPLES;
+    if (block >= block_end)
+    {
+        ScopeRecord_ScanSamples(first, end, span);
+        return;
+    }
+
+    ScopeRecord_ScanSamples(first, block * RECORD_BLOCK_SAMPLES, span);
+    ScopeRecord_ScanSamples(block_end * RECORD_BLOCK_SAMPLES, end, span);
+    for (uint8_t level = 0U; level < m->levels && block < block_end; ++level)
+    {
+        const ScopeRecordSpan *entries = &scope_record_pyramid[m->level_offset[level]];
+        if (block & 1U)
+        {
+            ScopeRecord_Merge(span, &entries[block]);
+            block++;
+        }
+        if (block_end & 1U)
+        {
+            block_end--;
+            ScopeRecord_Merge(span, &entries[block_end]);
+        }
+        block >>= 1;
+        block_end >>= 1;
+    }
+}
+
+static void ScopeRecord_ScanSamples(uint32_t first, uint32_t end, ScopeRecordSpan *span)
+{
+    uint16_t samples[RECORD_BLOCK_SAMPLES];
+    while (first < end)
+    {
+        uint16_t count = (uint16_t)(end - first);
+        if (count > RECORD_BLOCK_SAMPLES)
+        {
+            count = RECORD_BLOCK_SAMPLES;
+        }
+        ScopeRecord_Read((uint16_t)first, count, samples);
+        for (uint16_t i = 0U; i < count; ++i)
+        {
+            if (samples[i] < span->min)
+            {
+                span->min = samples[i];
+            }
+            if (samples[i] > span->max)
+            {
+                span->max = samples[i];
+            }
+        }
+        first += count;
+    }
+}
+
+static void ScopeRecord_Merge(ScopeRecordSpan *span, const ScopeRecordSpan *other)
+{
+    if (other->min < span->min)
+    {
+        span->min = other->min;
+    }
+    if (other->max > span->max)
+    {
+        span->max = other->max;
+    }
+}
+
+static uint16_t ScopeRecord_FrameAge(uint16_t frame)
+{
+    const ScopeRecordModule *m = &scope_record_module;
+    return (uint16_t)(m->newest_age + m->frames - 1U - frame);
+}
@@ -0,0 +1,436 @@
+#include "scope_reference.h"
+
+#include "main.h"
+#include "scope.h"
+#include "scope_flash.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define REFERENCE_SECTOR_ADDRESS 0x08100000U
+#define REFERENCE_FIRST_SECTOR FLASH_SECTOR_12
+#define REFERENCE_SECTOR_MAGIC 0x31534652U /* "RFS1" */
+#define REFERENCE_RECORD_MAGIC 0x31464552U /* "REF1" */
+#define REFERENCE_COMMIT_WORD 0x454E4F44U /* "DONE" */
+
+enum
+{
+    REFERENCE_SECTOR_COUNT = 2U,
+    /* A 12-bit delta zigzags to at most 13 bits: two 7-bit groups. */
+    REFERENCE_MAX_PAYLOAD_BYTES = SCOPE_FRAME_SAMPLES * 2U,
+    REFERENCE_VARINT_MAX_BYTES = 2U,
+    REFERENCE_SAMPLE_MAX = 0x0FFFU
+};
+
+/* Programmed last when a sector takes over, so a compaction cut short
+   leaves the old sector in charge. */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t check;
+    uint32_t reserved;
+} ScopeReferenceSectorHeader;
+
+/* Followed by the payload padded to a word, then the commit word. */
+typedef struct
+{
+    uint32_t magic;
+    uint8_t slot;
+    uint8_t reserved;
+    uint16_t payload_bytes;
+    uint16_t sample_count;
+    uint16_t trigger_index;
+    uint32_t sample_rate_hz;
+    uint32_t samples_visible;
+    int32_t center_sample;
+    uint32_t span_counts;
+    int32_t center_counts;
+    uint32_t payload_crc;
+    uint32_t header_crc;
+} ScopeReferenceRecord;
+
+typedef struct
+{
+    /* -1 until the first save formats a sector. */
+    int8_t active;
+    uint8_t tail_blocked;
+    uint32_t generation;
+    uint32_t write_offset;
+    /* Offset of the newest committed record per slot; 0 when empty. */
+    uint32_t slot_offset[SCOPE_REFERENCE_SLOTS];
+    uint32_t compactions;
+    uint32_t torn_records;
+} ScopeReferenceModule;
+
+static ScopeReferenceModule scope_reference_module;
+static uint32_t reference_payload_words[(REFERENCE_MAX_PAYLOAD_BYTES + 3U) / 4U];
+
+static uint32_t ScopeReference_SectorBase(uint8_t sector);
+static uint8_t ScopeReference_SectorValid(uint8_t sector, uint32_t *generation);
+static void ScopeReference_Scan(uint8_t sector);
+static uint32_t ScopeReference_RecordBytes(const ScopeReferenceRecord *record);
+static uint8_t ScopeReference_RecordValid(const ScopeReferenceRecord *record);
+static uint8_t ScopeReference_Append(const ScopeReferenceRecord *record, const uint32_t *payload);
+static uint8_t ScopeReference_Compact(void);
+static uint16_t ScopeReference_Encode(const uint16_t *samples, uint16_t count, uint8_t *out);
+
+void ScopeReference_Init(void)
+{
+    memset(&scope_reference_module, 0, sizeof(scope_reference_module));
+    scope_reference_module.active = -1;
+
+    uint32_t generation[REFERENCE_SECTOR_COUNT] = {0U};
+    uint8_t valid0 = ScopeReference_SectorValid(0U, &generation[0]);
+    uint8_t valid1 = ScopeReference_SectorValid(1U, &generation[1]);
+    if (valid0 && valid1)
+    {
+        /* Both headers survive until the next compaction erases the older. */
+        ScopeReference_Scan(((int32_t)(generation[1] - generation[0]) > 0) ? 1U : 0U);
+    }
+    else if (valid0 || valid1)
+    {
+        ScopeReference_Scan(valid0 ? 0U : 1U);
+    }
+}
+
+uint8_t ScopeReference_Save(uint8_t slot, const uint16_t *samples, const ScopeReferenceInfo *info)
+{
+    if (slot >= SCOPE_REFERENCE_SLOTS || info == NULL ||
+        (info->sample_count > 0U && samples == NULL) ||
+        info->sample_count > SCOPE_FRAME_SAMPLES)
+    {
+        return 0U;
+    }
+
+    ScopeReferenceRecord record = {
+        .magic = REFERENCE_RECORD_MAGIC,
+        .slot = slot,
+        .reserved = 0xFFU,
+        .sample_count = info->sample_count,
+        .trigger_index = info->trigger_index,
+        .sample_rate_hz = info->sample_rate_hz,
+        .samples_visible = info->settings.horizontal.samples_visible,
+        .center_sample = info->settings.horizontal.center_sample,
+        .span_counts = info->settings.vertical.span_counts,
+        .center_counts = info->settings.vertical.center_counts
+    };
+
+    /* Unused tail bytes stay erased, so they cost no programming time. */
+    memset(reference_payload_words, 0xFF, sizeof(reference_payload_words));
+    record.payload_bytes = ScopeReference_Encode(samples, info->sample_count,
+                                                 (uint8_t *)reference_payload_words);
+    record.payload_crc = ScopeFlash_Crc32(0U, reference_payload_words, record.payload_bytes);
+    record.header_crc = ScopeFlash_Crc32(0U, &record, offsetof(ScopeReferenceRecord, header_crc));
+
+    if (ScopeReference_Append(&record, reference_payload_words))
+    {
+        return 1U;
+    }
+    /* Full or behind a torn record: keep the newest copy of every slot,
+       this one's included, in the other sector and try once more. */
+    return (uint8_t)(ScopeReference_Compact() &&
+                     ScopeReference_Append(&record, reference_payload_words));
+}
+
+uint8_t ScopeReference_Erase(uint8_t slot)
+{
+    if (slot >= SCOPE_REFERENCE_SLOTS)
+    {
+        return 0U;
+    }
+    if (scope_reference_module.slot_offset[slot] == 0U)
+    {
+        return 1U;
+    }
+    /* An empty record supersedes the stored one. */
+    ScopeReferenceInfo empty = {0};
+    return ScopeReference_Save(slot, NULL, &empty);
+}
+
+uint8_t ScopeReference_Open(uint8_t slot, ScopeReferenceInfo *info, ScopeReferenceReader *reader)
+{
+    if (slot >= SCOPE_REFERENCE_SLOTS ||
+        scope_reference_module.active < 0 ||
+        scope_reference_module.slot_offset[slot] == 0U)
+    {
+        return 0U;
+    }
+
+    uint32_t address = ScopeReference_SectorBase((uint8_t)scope_reference_module.active) +
+                       scope_reference_module.slot_offset[slot];
+    const ScopeReferenceRecord *record = (const ScopeReferenceRecord *)(uintptr_t)address;
+    if (info != NULL)
+    {
+        info->sample_count = record->sample_count;
+        info->trigger_index = record->trigger_index;
+        info->sample_rate_hz = record->sample_rate_hz;
+        info->settings.horizontal.samples_visible = record->samples_visible;
+        info->settings.horizontal.center_sample = record->center_sample;
+        info->settings.vertical.span_counts = record->span_counts;
+        info->settings.vertical.center_counts = record->center_counts;
+        info->payload_bytes = record->payload_bytes;
+    }
+    if (reader != NULL)
+    {
+        reader->next = (const uint8_t *)(record + 1);
+        reader->end = reader->next + record->payload_bytes;
+        reader->remaining = record->sample_count;
+        reader->previous = 0;
+    }
+    return 1U;
+}
+
+uint8_t ScopeReference_Next(ScopeReferenceReader *reader, uint16_t *sample)
+{
+    if (reader == NULL || reader->remaining == 0U)
+    {
+        return 0U;
+    }
+
+    uint32_t zigzag = 0U;
+    uint8_t shift = 0U;
+    for (;;)
+    {
+        if (reader->next >= reader->end || shift >= 7U * REFERENCE_VARINT_MAX_BYTES)
+        {
+            reader->remaining = 0U;
+            return 0U;
+        }
+        uint8_t byte = *reader->next++;
+        zigzag |= (uint32_t)(byte & 0x7FU) << shift;
+        shift += 7U;
+        if ((byte & 0x80U) == 0U)
+        {
+            break;
+        }
+    }
+
+    int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1U);
+    reader->previous += delta;
+    reader->remaining--;
+    if (sample != NULL)
+    {
+        *sample = (uint16_t)reader->previous;
+    }
+    return 1U;
+}
+
+void ScopeReference_GetStatus(ScopeReferenceStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    memset(status, 0, sizeof(*status));
+    for (uint8_t slot = 0U; slot < SCOPE_REFERENCE_SLOTS; ++slot)
+    {
+        if (scope_reference_module.slot_offset[slot] != 0U)
+        {
+            status->stored_mask |= (uint8_t)(1U << slot);
+        }
+    }
+    status->compactions = scope_reference_module.compactions;
+    status->torn_records = scope_reference_module.torn_records;
+    if (scope_reference_module.active < 0)
+    {
+        status->free_bytes = SCOPE_FLASH_SECTOR_BYTES - sizeof(ScopeReferenceSectorHeader);
+        return;
+    }
+    status->sector = (uint8_t)(REFERENCE_FIRST_SECTOR + (uint8_t)scope_reference_module.active);
+    status->generation = scope_reference_module.generation;
+    status->used_bytes = scope_reference_module.write_offset;
+    status->free_bytes = scope_reference_module.tail_blocked
+                             ? 0U
+                             : SCOPE_FLASH_SECTOR_BYTES - scope_reference_module.write_offset;
+}
+
+static uint32_t ScopeReference_SectorBase(uint8_t sector)
+{
+    return REFERENCE_SECTOR_ADDRESS + (uint32_t)sector * SCOPE_FLASH_SECTOR_BYTES;
+}
+
+static uint8_t ScopeReference_SectorValid(uint8_t sector, uint32_t *generation)
+{
+    const ScopeReferenceSectorHeader *header =
+        (const ScopeReferenceSectorHeader *)(uintptr_t)ScopeReference_SectorBase(sector);
+    if (header->magic != REFERENCE_SECTOR_MAGIC ||
+        header->check != ScopeFlash_Crc32(0U, header, offsetof(ScopeReferenceSectorHeader, check)))
+    {
+        return 0U;
+    }
+    *generation = header->generation;
+    return 1U;
+}
+
+/* One pass from the sector header to the first erased word: the last
+   committed record of each slot wins. */
+static void ScopeReference_Scan(uint8_t sector)
+{
+    const uint32_t base = ScopeReference_SectorBase(sector);
+    const ScopeReferenceSectorHeader *header = (const ScopeReferenceSectorHeader *)(uintptr_t)base;
+    scope_reference_module.active = (int8_t)sector;
+    scope_reference_module.generation = header->generation;
+    scope_reference_module.tail_blocked = 0U;
+    memset(scope_reference_module.slot_offset, 0, sizeof(scope_reference_module.slot_offset));
+
+    uint32_t offset = sizeof(ScopeReferenceSectorHeader);
+    while (offset + sizeof(ScopeReferenceRecord) + sizeof(uint32_t) <= SCOPE_FLASH_SECTOR_BYTES)
+    {
+        const ScopeReferenceRecord *record = (const ScopeReferenceRecord *)(uintptr_t)(base + offset);
+        if (record->magic == 0xFFFFFFFFU)
+        {
+            break;
+        }
+        if (!ScopeReference_RecordValid(record))
+        {
+            /* A header torn mid-write has no trustworthy length: nothing
+               more can be appended here until the next compaction. */
+            scope_reference_module.tail_blocked = 1U;
+            scope_reference_module.torn_records++;
+            break;
+        }
+
+        uint32_t size = ScopeReference_RecordBytes(record);
+        if (offset + size > SCOPE_FLASH_SECTOR_BYTES)
+        {
+            scope_reference_module.tail_blocked = 1U;
+            break;
+        }
+        const uint32_t commit = *(const uint32_t *)(uintptr_t)(base + offset + size - sizeof(uint32_t));
+        const uint8_t *payload = (const uint8_t *)(record + 1);
+        if (commit == REFERENCE_COMMIT_WORD &&
+            record->payload_crc == ScopeFlash_Crc32(0U, payload, record->payload_bytes))
+        {
+            scope_reference_module.slot_offset[record->slot] = (record->sample_count > 0U) ? offset : 0U;
+        }
+        else
+        {
+            scope_reference_module.torn_records++;
+        }
+        offset += size;
+    }
+    scope_reference_module.write_offset = offset;
+}
+
+static uint32_t ScopeReference_RecordBytes(const ScopeReferenceRecord *record)
+{
+    return sizeof(ScopeReferenceRecord) + (((uint32_t)record->payload_bytes + 3U) & ~3U) + sizeof(uint32_t);
+}
+
+static uint8_t ScopeReference_RecordValid(const ScopeReferenceRecord *record)
+{
+    return (uint8_t)(record->magic == REFERENCE_RECORD_MAGIC &&
+                     record->header_crc == ScopeFlash_Crc32(0U, record, offsetof(ScopeReferenceRecord, header_crc)) &&
+                     record->slot < SCOPE_REFERENCE_SLOTS &&
+                     record->sample_count <= SCOPE_FRAME_SAMPLES &&
+                     record->payload_bytes <= REFERENCE_MAX_PAYLOAD_BYTES);
+}
+
+static uint8_t ScopeReference_Append(const ScopeReferenceRecord *record, const uint32_t *payload)
+{
+    if (scope_reference_module.active < 0 || scope_reference_module.tail_blocked)
+    {
+        return 0U;
+    }
+    const uint32_t size = ScopeReference_RecordBytes(record);
+    const uint32_t offset = scope_reference_module.write_offset;
+    if (offset + size > SCOPE_FLASH_SECTOR_BYTES)
+    {
+        return 0U;
+    }
+    const uint32_t address = ScopeReference_SectorBase((uint8_t)scope_reference_module.active) + offset;
+    if (!ScopeFlash_IsErased(address, size))
+    {
+        scope_reference_module.tail_blocked = 1U;
+        return 0U;
+    }
+
+    /* Header, payload, commit word: the record only counts once the last
+       word is down. Anything started is skipped by the next scan. */
+    const uint32_t header_words = sizeof(ScopeReferenceRecord) / sizeof(uint32_t);
+    const uint32_t payload_words = ((uint32_t)record->payload_bytes + 3U) / 4U;
+    const uint32_t commit = REFERENCE_COMMIT_WORD;
+    scope_reference_module.write_offset = offset + size;
+    if (!ScopeFlash_ProgramWords(address, (const uint32_t *)record, header_words) ||
+        !ScopeFlash_ProgramWords(address + sizeof(ScopeReferenceRecord), payload, payload_words) ||
+        !ScopeFlash_ProgramWords(address + size - sizeof(uint32_t), &commit, 1U))
+    {
+        scope_reference_module.torn_records++;
+        return 0U;
+    }
+    scope_reference_module.slot_offset[record->slot] = (record->sample_count > 0U) ? offset : 0U;
+    return 1U;
+}
+
+/* Copies the newest record of every slot into the other sector, then
+   programs its header with the next generation. The old sector is only
+   erased when it becomes the target of a later compaction. */
+static uint8_t ScopeReference_Compact(void)
+{
+    const int8_t source = scope_reference_module.active;
+    const uint8_t target = (source == 0) ? 1U : 0U;
+    const uint32_t target_base = ScopeReference_SectorBase(target);
+
+    if (!ScopeFlash_IsErased(target_base, SCOPE_FLASH_SECTOR_BYTES) &&
+        !ScopeFlash_EraseSector(REFERENCE_FIRST_SECTOR + target))
+    {
+        return 0U;
+    }
+
+    uint32_t offset = sizeof(ScopeReferenceSectorHeader);
+    for (uint8_t slot = 0U; source >= 0 && slot < SCOPE_REFERENCE_SLOTS; ++slot)
+    {
+        if (scope_reference_module.slot_offset[slot] == 0U)
+        {
+            continue;
+        }
+        uint32_t address = ScopeReference_SectorBase((uint8_t)source) + scope_reference_module.slot_offset[slot];
+        uint32_t size = ScopeReference_RecordBytes((const ScopeReferenceRecord *)(uintptr_t)address);
+        if (!ScopeFlash_ProgramWords(target_base + offset, (const uint32_t *)(uintptr_t)address, size / sizeof(uint32_t)))
+        {
+            return 0U;
+        }
+        offset += size;
+    }
+
+    ScopeReferenceSectorHeader header = {
+        .magic = REFERENCE_SECTOR_MAGIC,
+        .generation = scope_reference_module.generation + 1U,
+        .reserved = 0xFFFFFFFFU
+    };
+    header.check = ScopeFlash_Crc32(0U, &header, offsetof(ScopeReferenceSectorHeader, check));
+    if (!ScopeFlash_ProgramWords(target_base, (const uint32_t *)&header, sizeof(header) / sizeof(uint32_t)))
+    {
+        return 0U;
+    }
+
+    if (source >= 0)
+    {
+        scope_reference_module.compactions++;
+    }
+    ScopeReference_Scan(target);
+    return 1U;
+}
+
+/* Zigzag delta per sample as a little-endian base-128 varint: slowly
+   moving traces and noise take one byte, the steepest edge two. */
+static uint16_t ScopeReference_Encode(const uint16_t *samples, uint16_t count, uint8_t *out)
+{
+    uint16_t length = 0U;
+    int32_t previous = 0;
+    for (uint16_t i = 0U; i < count; ++i)
+    {
+        int32_t value = (samples[i] > REFERENCE_SAMPLE_MAX) ? (int32_t)REFERENCE_SAMPLE_MAX : (int32_t)samples[i];
+        int32_t delta = value - previous;
+        previous = value;
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        while (zigzag >= 0x80U)
+        {
+            out[length++] = (uint8_t)(zigzag | 0x80U);
+            zigzag >>= 7;
+        }
+        out[length++] = (uint8_t)zigzag;
+    }
+    return length;
+}
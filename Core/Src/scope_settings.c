@@ -0,0 +1,422 @@
+#include "scope_settings.h"
+
+#include "main.h"
+#include "scope.h"
+#include "scope_calib.h"
+#include "scope_decim.h"
+#include "scope_flash.h"
+#include "scope_fra.h"
+#include "scope_signal.h"
+#include "waveform_control.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define SETTINGS_SECTOR_ADDRESS 0x08140000U
+#define SETTINGS_FIRST_SECTOR FLASH_SECTOR_14
+/* Bumped with the record layout: a sector of older records reads as
+   unformatted, so the board boots on defaults instead of misparsing it. */
+#define SETTINGS_SECTOR_MAGIC 0x324E524AU /* "JRN2" */
+#define SETTINGS_RECORD_MAGIC 0x32544553U /* "SET2" */
+
+enum
+{
+    SETTINGS_SECTOR_COUNT = 2U,
+    /* A change must sit this long before it is written, and writes are at
+       least this far apart: holding a zoom button costs one record. */
+    SETTINGS_QUIET_MS = 2000U,
+    SETTINGS_MIN_INTERVAL_MS = 5000U
+};
+
+/* Everything restored at boot. No padding, so states compare with memcmp. */
+typedef struct
+{
+    uint32_t adc_prescaler;
+    uint32_t adc_period;
+    uint32_t span_counts;
+    int32_t center_counts;
+    uint32_t samples_visible;
+    int32_t center_sample;
+    uint32_t square_hz;
+    uint32_t sine_hz;
+    uint32_t gain_q16;
+    int16_t offset_counts;
+    uint16_t decim_ratio;
+    uint8_t scale_target;
+    uint8_t reserved[3];
+} ScopeSettingsState;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t check;
+    uint32_t reserved;
+} ScopeSettingsSectorHeader;
+
+/* Fixed size, CRC programmed last: a torn record fails its check and only
+   costs its own slot. */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;
+    ScopeSettingsState state;
+    uint32_t crc;
+} ScopeSettingsRecord;
+
+enum
+{
+    SETTINGS_RECORDS_PER_SECTOR =
+        (SCOPE_FLASH_SECTOR_BYTES - sizeof(ScopeSettingsSectorHeader)) / sizeof(ScopeSettingsRecord)
+};
+
+typedef struct
+{
+    /* -1 until the first write formats a sector. */
+    int8_t active;
+    uint8_t restored;
+    uint8_t have_saved;
+    uint8_t pending;
+    /* The sector the next compaction opens is erased and ready. */
+    uint8_t spare_blank;
+    uint32_t generation;
+    uint32_t next_index;
+    uint32_t sequence;
+    ScopeSettingsState saved;
+    ScopeSettingsState seen;
+    uint32_t last_change_ms;
+    uint32_t last_write_ms;
+    uint32_t writes;
+    uint32_t coalesced;
+    uint32_t compactions;
+    uint32_t torn_records;
+} ScopeSettingsModule;
+
+static ScopeSettingsModule scope_settings_module;
+
+static uint32_t ScopeSettings_SectorBase(uint8_t sector);
+static uint8_t ScopeSettings_SectorValid(uint8_t sector, uint32_t *generation);
+static const ScopeSettingsRecord *ScopeSettings_Scan(uint8_t sector);
+static uint8_t ScopeSettings_RecordValid(const ScopeSettingsRecord *record);
+static void ScopeSettings_Capture(ScopeSettingsState *state);
+static void ScopeSettings_Apply(const ScopeSettingsState *state);
+static uint8_t ScopeSettings_Write(const ScopeSettingsState *state, uint32_t now_ms);
+static uint8_t ScopeSettings_Append(const ScopeSettingsRecord *record);
+static uint8_t ScopeSettings_StartSector(const ScopeSettingsRecord *record);
+static void ScopeSettings_PrepareSpare(void);
+
+void ScopeSettings_Init(uint32_t now_ms)
+{
+    memset(&scope_settings_module, 0, sizeof(scope_settings_module));
+    scope_settings_module.active = -1;
+
+    uint32_t generation[SETTINGS_SECTOR_COUNT] = {0U};
+    uint8_t valid0 = ScopeSettings_SectorValid(0U, &generation[0]);
+    uint8_t valid1 = ScopeSettings_SectorValid(1U, &generation[1]);
+    const ScopeSettingsRecord *latest = NULL;
+    if (valid0 && valid1)
+    {
+        latest = ScopeSettings_Scan(((int32_t)(generation[1] - generation[0]) > 0) ? 1U : 0U);
+    }
+    else if (valid0 || valid1)
+    {
+        latest = ScopeSettings_Scan(valid0 ? 0U : 1U);
+    }
+
+    if (latest != NULL)
+    {
+        ScopeSettings_Apply(&latest->state);
+        scope_settings_module.saved = latest->state;
+        scope_settings_module.sequence = latest->sequence;
+        scope_settings_module.have_saved = 1U;
+        scope_settings_module.restored = 1U;
+    }
+    ScopeSettings_PrepareSpare();
+    /* Whatever the modules accepted is the baseline; anything they clamped
+       differs from the record and is rewritten once it settles. */
+    ScopeSettings_Capture(&scope_settings_module.seen);
+    scope_settings_module.last_change_ms = now_ms;
+    scope_settings_module.last_write_ms = now_ms;
+}
+
+void ScopeSettings_Service(uint32_t now_ms)
+{
+    /* A sweep retunes the sine point by point and puts it back at the end. */
+    if (ScopeFra_IsRunning())
+    {
+        return;
+    }
+
+    ScopeSettingsState current;
+    ScopeSettings_Capture(&current);
+    if (memcmp(&current, &scope_settings_module.seen, sizeof(current)) != 0)
+    {
+        if (scope_settings_module.pending)
+        {
+            scope_settings_module.coalesced++;
+        }
+        scope_settings_module.seen = current;
+        scope_settings_module.last_change_ms = now_ms;
+    }
+    scope_settings_module.pending = (uint8_t)!ScopeSettings_IsSaved();
+
+    if (!scope_settings_module.pending ||
+        now_ms - scope_settings_module.last_change_ms < SETTINGS_QUIET_MS ||
+        now_ms - scope_settings_module.last_write_ms < SETTINGS_MIN_INTERVAL_MS)
+    {
+        return;
+    }
+    (void)ScopeSettings_Write(&scope_settings_module.seen, now_ms);
+}
+
+uint8_t ScopeSettings_Flush(void)
+{
+    ScopeSettings_Capture(&scope_settings_module.seen);
+    if (ScopeSettings_IsSaved())
+    {
+        scope_settings_module.pending = 0U;
+        return 1U;
+    }
+    return ScopeSettings_Write(&scope_settings_module.seen, HAL_GetTick());
+}
+
+uint8_t ScopeSettings_IsSaved(void)
+{
+    return (uint8_t)(scope_settings_module.have_saved &&
+                     memcmp(&scope_settings_module.seen, &scope_settings_module.saved,
+                            sizeof(ScopeSettingsState)) == 0);
+}
+
+void ScopeSettings_GetStatus(ScopeSettingsStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    memset(status, 0, sizeof(*status));
+    status->restored = scope_settings_module.restored;
+    status->pending = scope_settings_module.pending;
+    status->spare_blank = scope_settings_module.spare_blank;
+    status->writes = scope_settings_module.writes;
+    status->coalesced = scope_settings_module.coalesced;
+    status->compactions = scope_settings_module.compactions;
+    status->torn_records = scope_settings_module.torn_records;
+    status->free_records = SETTINGS_RECORDS_PER_SECTOR;
+    if (scope_settings_module.active < 0)
+    {
+        return;
+    }
+    status->sector = (uint8_t)(SETTINGS_FIRST_SECTOR + (uint8_t)scope_settings_module.active);
+    status->generation = scope_settings_module.generation;
+    status->records = scope_settings_module.next_index;
+    status->free_records = SETTINGS_RECORDS_PER_SECTOR - scope_settings_module.next_index;
+}
+
+static uint32_t ScopeSettings_SectorBase(uint8_t sector)
+{
+    return SETTINGS_SECTOR_ADDRESS + (uint32_t)sector * SCOPE_FLASH_SECTOR_BYTES;
+}
+
+static uint8_t ScopeSettings_SectorValid(uint8_t sector, uint32_t *generation)
+{
+    const ScopeSettingsSectorHeader *header =
+        (const ScopeSettingsSectorHeader *)(uintptr_t)ScopeSettings_SectorBase(sector);
+    if (header->magic != SETTINGS_SECTOR_MAGIC ||
+        header->check != ScopeFlash_Crc32(0U, header, offsetof(ScopeSettingsSectorHeader, check)))
+    {
+        return 0U;
+    }
+    *generation = header->generation;
+    return 1U;
+}
+
+/* Forward over the magic words to the first erased slot, then back to the
+   newest record whose CRC holds: one CRC in the common case. */
+static const ScopeSettingsRecord *ScopeSettings_Scan(uint8_t sector)
+{
+    const ScopeSettingsSectorHeader *header =
+        (const ScopeSettingsSectorHeader *)(uintptr_t)ScopeSettings_SectorBase(sector);
+    const ScopeSettingsRecord *records = (const ScopeSettingsRecord *)(header + 1);
+    scope_settings_module.active = (int8_t)sector;
+    scope_settings_module.generation = header->generation;
+
+    uint32_t count = 0U;
+    while (count < SETTINGS_RECORDS_PER_SECTOR && records[count].magic != 0xFFFFFFFFU)
+    {
+        count++;
+    }
+    scope_settings_module.next_index = count;
+
+    while (count > 0U)
+    {
+        count--;
+        if (ScopeSettings_RecordValid(&records[count]))
+        {
+            return &records[count];
+        }
+        scope_settings_module.torn_records++;
+    }
+    return NULL;
+}
+
+static uint8_t ScopeSettings_RecordValid(const ScopeSettingsRecord *record)
+{
+    return (uint8_t)(record->magic == SETTINGS_RECORD_MAGIC &&
+                     record->crc == ScopeFlash_Crc32(0U, record, offsetof(ScopeSettingsRecord, crc)));
+}
+
+static void ScopeSettings_Capture(ScopeSettingsState *state)
+{
+    ScopePersistentSettings scope_settings;
+    ScopeCalibStatus calib;
+    Scope_GetPersistentSettings(&scope_settings);
+    ScopeCalib_GetStatus(&calib);
+
+    memset(state, 0, sizeof(*state));
+    ScopeSignal_GetTimerPeriod(&state->adc_prescaler, &state->adc_period);
+    state->decim_ratio = ScopeDecim_GetRatio();
+    state->span_counts = scope_settings.span_counts;
+    state->center_counts = scope_settings.center_counts;
+    state->samples_visible = scope_settings.samples_visible;
+    state->center_sample = scope_settings.center_sample;
+    state->scale_target = (uint8_t)scope_settings.scale_target;
+    state->square_hz = WaveformControl_GetSquareFrequency();
+    state->sine_hz = WaveformControl_GetSineFrequency();
+    state->gain_q16 = calib.gain_q16;
+    state->offset_counts = calib.offset_counts;
+}
+
+/* Each module range-checks its own part; a rejected value keeps its default.
+   The rate goes first: decimation is checked against it, and the window is
+   clamped to the record length it implies. */
+static void ScopeSettings_Apply(const ScopeSettingsState *state)
+{
+    (void)ScopeSignal_SetTimerPeriod(state->adc_prescaler, state->adc_period);
+    (void)ScopeDecim_Configure(state->decim_ratio);
+
+
+    ScopePersistentSettings scope_settings = {
+        .span_counts = state->span_counts,
+        .center_counts = state->center_counts,
+        .samples_visible = state->samples_visible,
+        .center_sample = state->center_sample,
+        .scale_target = (ScopeScaleTarget)state->scale_target
+    };
+    Scope_RestorePersistentSettings(&scope_settings);
+    (void)WaveformControl_SetSquareFrequency(state->square_hz);
+    (void)WaveformControl_SetSineFrequency(state->sine_hz);
+    (void)ScopeCalib_Restore(state->offset_counts, state->gain_q16);
+}
+
+static uint8_t ScopeSettings_Write(const ScopeSettingsState *state, uint32_t now_ms)
+{
+    ScopeSettingsRecord record = {
+        .magic = SETTINGS_RECORD_MAGIC,
+        .sequence = scope_settings_module.sequence + 1U,
+        .state = *state
+    };
+    record.crc = ScopeFlash_Crc32(0U, &record, offsetof(ScopeSettingsRecord, crc));
+
+    /* Retried at the next interval whatever happens here. */
+    scope_settings_module.last_write_ms = now_ms;
+    uint8_t ok = ScopeSettings_Append(&record);
+    if (!ok)
+    {
+        ok = ScopeSettings_StartSector(&record);
+    }
+    if (!ok)
+    {
+        return 0U;
+    }
+
+    scope_settings_module.saved = *state;
+    scope_settings_module.sequence = record.sequence;
+    scope_settings_module.have_saved = 1U;
+    scope_settings_module.pending = 0U;
+    scope_settings_module.writes++;
+    return 1U;
+}
+
+static uint8_t ScopeSettings_Append(const ScopeSettingsRecord *record)
+{
+    if (scope_settings_module.active < 0 ||
+        scope_settings_module.next_index >= SETTINGS_RECORDS_PER_SECTOR)
+    {
+        return 0U;
+    }
+    const uint32_t address = ScopeSettings_SectorBase((uint8_t)scope_settings_module.active) +
+                             sizeof(ScopeSettingsSectorHeader) +
+                             scope_settings_module.next_index * sizeof(ScopeSettingsRecord);
+    /* The slot is used up whether or not the record makes it. */
+    scope_settings_module.next_index++;
+    if (!ScopeFlash_IsErased(address, sizeof(ScopeSettingsRecord)) ||
+        !ScopeFlash_ProgramWords(address, (const uint32_t *)record,
+                                 sizeof(ScopeSettingsRecord) / sizeof(uint32_t)))
+    {
+        scope_settings_module.torn_records++;
+        return 0U;
+    }
+    return 1U;
+}
+
+/* Compaction: only the newest record matters, so it simply opens the other
+   sector. The header goes in after the record, so until then the old
+   sector and its last record stay in charge. Alternating the two sectors
+   spreads erases evenly, one per sector-full of records. The spare is
+   erased at boot, never here: a second-long erase would stall the render
+   loop and overrun acquisition. Until the next boot clears the sector just
+   left behind, the change stays pending. */
+static uint8_t ScopeSettings_StartSector(const ScopeSettingsRecord *record)
+{
+    const uint8_t target = (scope_settings_module.active == 0) ? 1U : 0U;
+    const uint32_t base = ScopeSettings_SectorBase(target);
+    if (!scope_settings_module.spare_blank)
+    {
+        return 0U;
+    }
+    /* Whatever happens below, the sector is no longer known to be blank. */
+    scope_settings_module.spare_blank = 0U;
+
+    ScopeSettingsSectorHeader header = {
+        .magic = SETTINGS_SECTOR_MAGIC,
+        .generation = scope_settings_module.generation + 1U,
+        .reserved = 0xFFFFFFFFU
+    };
+    header.check = ScopeFlash_Crc32(0U, &header, offsetof(ScopeSettingsSectorHeader, check));
+    if (!ScopeFlash_ProgramWords(base + sizeof(header), (const uint32_t *)record,
+                                 sizeof(ScopeSettingsRecord) / sizeof(uint32_t)) ||
+        !ScopeFlash_ProgramWords(base, (const uint32_t *)&header, sizeof(header) / sizeof(uint32_t)))
+    {
+        return 0U;
+    }
+
+    if (scope_settings_module.active >= 0)
+    {
+        scope_settings_module.compactions++;
+    }
+    scope_settings_module.active = (int8_t)target;
+    scope_settings_module.generation = header.generation;
+    scope_settings_module.next_index = 1U;
+    return 1U;
+}
+
+/* Runs before acquisition starts, so the erase costs boot time only. Every
+   sector but the active one is wiped; with no journal yet that is both, and
+   the first write may land in either. */
+static void ScopeSettings_PrepareSpare(void)
+{
+    uint8_t blank = 1U;
+    for (uint8_t sector = 0U; sector < SETTINGS_SECTOR_COUNT; sector++)
+    {
+        if ((int8_t)sector == scope_settings_module.active)
+        {
+            continue;
+        }
+        if (!ScopeFlash_IsErased(ScopeSettings_SectorBase(sector), SCOPE_FLASH_SECTOR_BYTES) &&
+            !ScopeFlash_EraseSector(SETTINGS_FIRST_SECTOR + sector))
+        {
+            blank = 0U;
+        }
+    }
+    scope_settings_module.spare_blank = blank;
+}
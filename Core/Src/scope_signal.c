@@ -1,11 +1,40 @@
 #include "scope_signal.h"
 
+#include "adc.h"
+#include "dac.h"
 #include "main.h"
+#include "scope_dsp.h"
+#include "scope_profile.h"
 #include "tim.h"
 
+enum
+{
+    ACF_MAX_SAMPLES = 320U,
+    ACF_DECIMATION = 4U,
+    ACF_MAX_COARSE_LAGS = ACF_MAX_SAMPLES / ACF_DECIMATION,
+    ACF_SHORT_LAGS = 16U,
+    ACF_MIN_OVERLAP_DIVISOR = 3U,
+    /* Longer than one triggered regular conversion, so the ADC DMA counter is
+       settled before it is read with the timers stopped. */
+    SIGNAL_RESTART_QUIET_CYCLES = 400U
+};
+
+static const float ACF_MIN_CLARITY = 0.5f;
+static const float ACF_PEAK_RATIO = 0.85f;
+
 static uint32_t scope_sample_rate_hz = 0U;
+static uint32_t scope_adc_rate_hz = 0U;
+static uint16_t scope_decimation = 1U;
+static int16_t scope_acf_work[ACF_MAX_SAMPLES];
+static int16_t scope_acf_coarse[ACF_MAX_COARSE_LAGS];
+static uint32_t scope_acf_energy[ACF_MAX_SAMPLES + 1U];
+static uint32_t scope_acf_coarse_energy[ACF_MAX_COARSE_LAGS + 1U];
 
 static uint32_t ScopeSignal_ComputeSampleRateHz(void);
+static void ScopeSignal_UpdateRates(void);
+static uint32_t ScopeSignal_TimerClockHz(void);
+static uint16_t ScopeSignal_PickAcfPeak(const float *nsdf, uint16_t points);
+static float ScopeSignal_Nsdf(const int16_t *x, uint16_t len, uint16_t lag, const uint32_t *energy);
 
 uint16_t ScopeSignal_FindTriggerIndex(uint16_t *buf,
                                       uint16_t len,
@@ -56,12 +85,21 @@ uint16_t ScopeSignal_FindTriggerIndex(uint16_t *buf,
     }
 
     uint16_t thr = (uint16_t)((vmin + vmax) / 2U);
+    return ScopeSignal_FindRisingCrossing(buf, len, thr);
+}
+
+uint16_t ScopeSignal_FindRisingCrossing(const uint16_t *buf, uint16_t len, uint16_t threshold)
+{
+    if (buf == NULL)
+    {
+        return 0U;
+    }
 
     for (uint16_t i = 1; i < len; i++)
     {
         uint16_t v_prev = buf[i - 1U];
         uint16_t v_now = buf[i];
-        if (v_prev < thr && v_now >= thr)
+        if (v_prev < threshold && v_now >= threshold)
         {
             return i;
         }
@@ -138,16 +176,392 @@ uint32_t ScopeSignal_EstimatePeriodSamples(uint16_t *buf,
     return avg_period;
 }
 
+uint32_t ScopeSignal_EstimatePeriodAcfQ8(const uint16_t *buf, uint16_t len)
+{
+    if (buf == NULL || len < ACF_SHORT_LAGS * 3U)
+    {
+        return 0U;
+    }
+    if (len > ACF_MAX_SAMPLES)
+    {
+        len = ACF_MAX_SAMPLES;
+    }
+
+    uint32_t sum = 0U;
+    for (uint16_t i = 0U; i < len; i++)
+    {
+        sum += buf[i];
+    }
+    int32_t mean = (int32_t)((sum + len / 2U) / len);
+    scope_acf_energy[0] = 0U;
+    for (uint16_t i = 0U; i < len; i++)
+    {
+        int16_t value = (int16_t)((int32_t)buf[i] - mean);
+        scope_acf_work[i] = value;
+        scope_acf_energy[i + 1U] = scope_acf_energy[i] + (uint32_t)((int32_t)value * value);
+    }
+
+    /* Short lags are evaluated at full rate; longer ones on a 4x decimated copy,
+       whose averaging also keeps noise and ringing from adding spurious peaks. */
+    uint16_t coarse_len = (uint16_t)(len / ACF_DECIMATION);
+    scope_acf_coarse_energy[0] = 0U;
+    for (uint16_t j = 0U; j < coarse_len; j++)
+    {
+        int32_t acc = 0;
+        for (uint16_t k = 0U; k < ACF_DECIMATION; k++)
+        {
+            acc += scope_acf_work[j * ACF_DECIMATION + k];
+        }
+        int16_t value = (int16_t)(acc / (int32_t)ACF_DECIMATION);
+        scope_acf_coarse[j] = value;
+        scope_acf_coarse_energy[j + 1U] = scope_acf_coarse_energy[j] + (uint32_t)((int32_t)value * value);
+    }
+
+    uint16_t lags[ACF_MAX_COARSE_LAGS + ACF_SHORT_LAGS];
+    float values[ACF_MAX_COARSE_LAGS + ACF_SHORT_LAGS];
+    uint16_t points = 0U;
+    for (uint16_t lag = 1U; lag <= ACF_SHORT_LAGS; lag++)
+    {
+        lags[points] = lag;
+        values[points] = ScopeSignal_Nsdf(scope_acf_work, len, lag, scope_acf_energy);
+        points++;
+    }
+    uint16_t coarse_last = (uint16_t)(coarse_len - coarse_len / ACF_MIN_OVERLAP_DIVISOR);
+    for (uint16_t lag = ACF_SHORT_LAGS / ACF_DECIMATION + 1U; lag <= coarse_last; lag++)
+    {
+        lags[points] = (uint16_t)(lag * ACF_DECIMATION);
+        values[points] = ScopeSignal_Nsdf(scope_acf_coarse, coarse_len, lag, scope_acf_coarse_energy);
+        points++;
+    }
+
+    uint16_t peak = ScopeSignal_PickAcfPeak(values, points);
+    if (peak == 0U)
+    {
+        return 0U;
+    }
+
+    uint16_t center = lags[peak];
+    uint16_t window = (center <= ACF_SHORT_LAGS) ? 1U : ACF_DECIMATION;
+    uint16_t fine_first = (center > window + 1U) ? (uint16_t)(center - window) : 2U;
+    uint16_t fine_last = (uint16_t)(center + window);
+    if (fine_last + 1U >= len)
+    {
+        fine_last = (uint16_t)(len - 2U);
+    }
+    if (fine_first > fine_last)
+    {
+        return 0U;
+    }
+
+    uint16_t best_lag = fine_first;
+    float best = -2.0f;
+    for (uint16_t lag = fine_first; lag <= fine_last; lag++)
+    {
+        float value = ScopeSignal_Nsdf(scope_acf_work, len, lag, scope_acf_energy);
+        if (value > best)
+        {
+            best = value;
+            best_lag = lag;
+        }
+    }
+
+    float before = ScopeSignal_Nsdf(scope_acf_work, len, (uint16_t)(best_lag - 1U), scope_acf_energy);
+    float after = ScopeSignal_Nsdf(scope_acf_work, len, (uint16_t)(best_lag + 1U), scope_acf_energy);
+    float curvature = before - 2.0f * best + after;
+    float offset = 0.0f;
+    if (curvature < 0.0f)
+    {
+        offset = 0.5f * (before - after) / curvature;
+        if (offset > 0.5f)
+        {
+            offset = 0.5f;
+        }
+        else if (offset < -0.5f)
+        {
+            offset = -0.5f;
+        }
+    }
+
+    return (uint32_t)(((float)best_lag + offset) * 256.0f + 0.5f);
+}
+
+uint32_t ScopeSignal_EstimatePeriodRobustQ8(uint16_t *buf,
+                                            uint16_t len,
+                                            uint16_t trig_idx,
+                                            uint16_t frame_min,
+                                            uint16_t frame_max,
+                                            uint16_t trigger_min_delta)
+{
+    uint32_t crossing_period = ScopeSignal_EstimatePeriodSamples(buf,
+                                                                 len,
+                                                                 trig_idx,
+                                                                 frame_min,
+                                                                 frame_max,
+                                                                 trigger_min_delta);
+    if ((uint16_t)(frame_max - frame_min) < trigger_min_delta)
+    {
+        return 0U;
+    }
+
+    uint32_t acf_period_q8 = ScopeSignal_EstimatePeriodAcfQ8(buf, len);
+    if (crossing_period == 0U)
+    {
+        return acf_period_q8;
+    }
+
+    /* Extra midpoint crossings from harmonics or noise make the crossing estimate
+       a fraction of the true period; trust the autocorrelation when they disagree. */
+    uint32_t crossing_q8 = crossing_period << 8;
+    if (acf_period_q8 != 0U)
+    {
+        uint32_t diff = (crossing_q8 > acf_period_q8) ? (crossing_q8 - acf_period_q8)
+                                                      : (acf_period_q8 - crossing_q8);
+        if (diff * 4U > acf_period_q8)
+        {
+            return acf_period_q8;
+        }
+    }
+    return crossing_q8;
+}
+
+uint16_t ScopeSignal_FindCrossings(const uint16_t *buf,
+                                   uint16_t len,
+                                   uint16_t threshold,
+                                   uint16_t hysteresis,
+                                   ScopeSignalCrossings *out)
+{
+    if (out == NULL)
+    {
+        return 0U;
+    }
+
+    out->count = 0U;
+    out->threshold = threshold;
+    out->initial_high = 0U;
+    out->truncated = 0U;
+
+    if (buf == NULL || len < 2U)
+    {
+        return 0U;
+    }
+
+    int32_t upper = (int32_t)threshold + (int32_t)hysteresis;
+    int32_t lower = (int32_t)threshold - (int32_t)hysteresis;
+    uint8_t high = (buf[0] >= threshold) ? 1U : 0U;
+    out->initial_high = high;
+
+    /* An edge is only accepted once the signal clears the hysteresis band, but its
+       position is taken from the most recent pass through the threshold itself. */
+    uint32_t candidate_q8 = 0U;
+    for (uint16_t i = 1U; i < len; i++)
+    {
+        uint16_t v_prev = buf[i - 1U];
+        uint16_t v_now = buf[i];
+
+        if (!high)
+        {
+            if (v_prev < threshold && v_now >= threshold)
+            {
+                candidate_q8 = ScopeSignal_InterpolateCrossingQ8(i, v_prev, v_now, threshold);
+            }
+            if ((int32_t)v_now >= upper)
+            {
+                high = 1U;
+                if (out->count >= SCOPE_SIGNAL_MAX_CROSSINGS)
+                {
+                    out->truncated = 1U;
+                    break;
+                }
+                out->edges[out->count].position_q8 = candidate_q8;
+                out->edges[out->count].rising = 1U;
+                out->count++;
+            }
+        }
+        else
+        {
+            if (v_prev >= threshold && v_now < threshold)
+            {
+                candidate_q8 = ScopeSignal_InterpolateCrossingQ8(i, v_prev, v_now, threshold);
+            }
+            if ((int32_t)v_now < lower)
+            {
+                high = 0U;
+                if (out->count >= SCOPE_SIGNAL_MAX_CROSSINGS)
+                {
+                    out->truncated = 1U;
+                    break;
+                }
+                out->edges[out->count].position_q8 = candidate_q8;
+                out->edges[out->count].rising = 0U;
+                out->count++;
+            }
+        }
+    }
+
+    return out->count;
+}
+
+uint32_t ScopeSignal_InterpolateCrossingQ8(uint16_t index,
+                                           uint16_t v_prev,
+                                           uint16_t v_now,
+                                           uint16_t threshold)
+{
+    uint32_t base_q8 = ((uint32_t)index - 1U) << 8;
+    int32_t step = (int32_t)v_now - (int32_t)v_prev;
+    if (step == 0)
+    {
+        return base_q8 + 256U;
+    }
+    int32_t frac = (((int32_t)threshold - (int32_t)v_prev) * 256) / step;
+    if (frac < 0)
+    {
+        frac = 0;
+    }
+    else if (frac > 256)
+    {
+        frac = 256;
+    }
+    return base_q8 + (uint32_t)frac;
+}
+
 uint32_t ScopeSignal_GetSampleRateHz(void)
 {
     if (scope_sample_rate_hz == 0U)
     {
-        scope_sample_rate_hz = ScopeSignal_ComputeSampleRateHz();
+        ScopeSignal_UpdateRates();
     }
     return scope_sample_rate_hz;
 }
 
-static uint32_t ScopeSignal_ComputeSampleRateHz(void)
+uint32_t ScopeSignal_GetAdcRateHz(void)
+{
+    if (scope_adc_rate_hz == 0U)
+    {
+        ScopeSignal_UpdateRates();
+    }
+    return scope_adc_rate_hz;
+}
+
+void ScopeSignal_SetDecimation(uint16_t ratio)
+{
+    scope_decimation = (ratio == 0U) ? 1U : ratio;
+    ScopeSignal_UpdateRates();
+}
+
+uint8_t ScopeSignal_SetSampleRateHz(uint32_t rate_hz)
+{
+    uint32_t tim_clk = ScopeSignal_TimerClockHz();
+    if (rate_hz == 0U || tim_clk == 0U || rate_hz > tim_clk / 2U)
+    {
+        return 0U;
+    }
+
+    uint32_t ticks = (tim_clk + rate_hz / 2U) / rate_hz;
+    uint32_t psc = (ticks - 1U) / 65536U;
+    uint32_t arr = ticks / (psc + 1U);
+    if (arr < 2U)
+    {
+        return 0U;
+    }
+
+    return ScopeSignal_SetTimerPeriod(psc, arr - 1U);
+}
+
+uint8_t ScopeSignal_SetTimerPeriod(uint32_t prescaler, uint32_t period)
+{
+    if (prescaler > 0xFFFFU || period < 1U || period > 0xFFFFU)
+    {
+        return 0U;
+    }
+
+    htim3.Init.Prescaler = prescaler;
+    htim3.Init.Period = period;
+    __HAL_TIM_SET_PRESCALER(&htim3, prescaler);
+    __HAL_TIM_SET_AUTORELOAD(&htim3, period);
+    /* Reload the prescaler now and restart the count, so the new period never
+       runs past a stale auto-reload value. */
+    htim3.Instance->EGR = TIM_EGR_UG;
+
+    ScopeSignal_UpdateRates();
+    return 1U;
+}
+
+void ScopeSignal_GetTimerPeriod(uint32_t *prescaler, uint32_t *period)
+{
+    if (prescaler != NULL)
+    {
+        *prescaler = htim3.Instance->PSC;
+    }
+    if (period != NULL)
+    {
+        *period = htim3.Instance->ARR;
+    }
+}
+
+void ScopeSignal_RestartWithDac(uint32_t *dac_remaining, uint32_t *adc_remaining)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    htim3.Instance->CR1 &= ~TIM_CR1_CEN;
+    htim4.Instance->CR1 &= ~TIM_CR1_CEN;
+    uint32_t quiet_start = ScopeProfile_CycleCount();
+    while ((uint32_t)(ScopeProfile_CycleCount() - quiet_start) < SIGNAL_RESTART_QUIET_CYCLES)
+    {
+    }
+
+    if (dac_remaining != NULL)
+    {
+        *dac_remaining = __HAL_DMA_GET_COUNTER(hdac.DMA_Handle1);
+    }
+    if (adc_remaining != NULL)
+    {
+        *adc_remaining = __HAL_DMA_GET_COUNTER(hadc1.DMA_Handle);
+    }
+
+    /* Update events reset both prescalers and counters; their TRGO takes one
+       ADC sample and latches one DAC entry at t = 0, two cycles apart. */
+    htim3.Instance->EGR = TIM_EGR_UG;
+    htim4.Instance->EGR = TIM_EGR_UG;
+    htim3.Instance->CR1 |= TIM_CR1_CEN;
+    htim4.Instance->CR1 |= TIM_CR1_CEN;
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+}
+
+uint32_t ScopeSignal_TimeToTimerTicks(uint32_t time_ns, uint32_t *period_ticks)
+{
+    uint32_t tim_clk = ScopeSignal_TimerClockHz();
+    uint32_t psc = (uint32_t)htim3.Init.Prescaler + 1U;
+    if (period_ticks != NULL)
+    {
+        *period_ticks = (uint32_t)htim3.Init.Period + 1U;
+    }
+    if (tim_clk == 0U)
+    {
+        return 0U;
+    }
+
+    uint64_t ticks = ((uint64_t)time_ns * tim_clk + (uint64_t)psc * 1000000000ULL - 1U) /
+                     ((uint64_t)psc * 1000000000ULL);
+    return (ticks > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)ticks;
+}
+
+uint32_t ScopeSignal_GetTimerCount(void)
+{
+    return htim3.Instance->CNT;
+}
+
+/* The record rate is what every analysis pass sees: the ADC rate divided by
+   the decimation ratio when the decimator sits between DMA and the record. */
+static void ScopeSignal_UpdateRates(void)
+{
+    scope_adc_rate_hz = ScopeSignal_ComputeSampleRateHz();
+    scope_sample_rate_hz = (scope_adc_rate_hz + scope_decimation / 2U) / scope_decimation;
+}
+
+static uint32_t ScopeSignal_TimerClockHz(void)
 {
     uint32_t tim_clk = HAL_RCC_GetPCLK1Freq();
     if (tim_clk == 0U)
@@ -162,6 +576,16 @@ static uint32_t ScopeSignal_ComputeSampleRateHz(void)
     {
         tim_clk *= 2U;
     }
+    return tim_clk;
+}
+
+static uint32_t ScopeSignal_ComputeSampleRateHz(void)
+{
+    uint32_t tim_clk = ScopeSignal_TimerClockHz();
+    if (tim_clk == 0U)
+    {
+        return 0U;
+    }
 
     uint32_t psc = (uint32_t)htim3.Init.Prescaler + 1U;
     uint32_t arr = (uint32_t)htim3.Init.Period + 1U;
@@ -173,15 +597,76 @@ static uint32_t ScopeSignal_ComputeSampleRateHz(void)
     return tim_clk / (psc * arr);
 }
 
-uint32_t ScopeSignal_AdcToMillivolt(uint16_t sample,
-                                    uint16_t adc_max_counts,
-                                    uint16_t adc_ref_millivolt)
+static float ScopeSignal_Nsdf(const int16_t *x, uint16_t len, uint16_t lag, const uint32_t *energy)
 {
-    if (adc_max_counts == 0U)
+    uint16_t overlap = (uint16_t)(len - lag);
+    int32_t acc = 0;
+    uint16_t i = 0U;
+    for (; i + 1U < overlap; i += 2U)
+    {
+        acc = ScopeDsp_DualMac(ScopeDsp_ReadPair(&x[i]), ScopeDsp_ReadPair(&x[i + lag]), acc);
+    }
+    if (i < overlap)
+    {
+        acc += (int32_t)x[i] * x[i + lag];
+    }
+
+    /* McLeod normalisation: the overlapping energy of both windows, so the value
+       stays in [-1, 1] for every lag instead of decaying with the overlap. */
+    uint32_t norm = energy[overlap] + (energy[len] - energy[lag]);
+    if (norm == 0U)
+    {
+        return 0.0f;
+    }
+    return (2.0f * (float)acc) / (float)norm;
+}
+
+static uint16_t ScopeSignal_PickAcfPeak(const float *nsdf, uint16_t points)
+{
+    uint16_t best_index = 0U;
+    float best_value = 0.0f;
+    float global_max = 0.0f;
+    uint8_t in_region = 0U;
+
+    /* Skip the lobe around lag zero, then keep the maximum of every positive
+       region; the first of those close to the global maximum is the period. */
+    uint16_t idx = 0U;
+    while (idx < points && nsdf[idx] > 0.0f)
+    {
+        idx++;
+    }
+    for (uint16_t scan = idx; scan < points; scan++)
+    {
+        if (nsdf[scan] > global_max)
+        {
+            global_max = nsdf[scan];
+        }
+    }
+    if (global_max < ACF_MIN_CLARITY)
     {
         return 0U;
     }
 
-    uint32_t rounding = adc_max_counts / 2U;
-    return ((uint32_t)sample * adc_ref_millivolt + rounding) / adc_max_counts;
+    float cutoff = global_max * ACF_PEAK_RATIO;
+    for (; idx < points; idx++)
+    {
+        if (nsdf[idx] > 0.0f)
+        {
+            if (!in_region || nsdf[idx] > best_value)
+            {
+                best_index = idx;
+                best_value = nsdf[idx];
+            }
+            in_region = 1U;
+        }
+        else if (in_region)
+        {
+            if (best_value >= cutoff)
+            {
+                return best_index;
+            }
+            in_region = 0U;
+        }
+    }
+    return (in_region && best_value >= cutoff) ? best_index : 0U;
 }
@@ -0,0 +1,115 @@
+#include "scope_stats.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct
+{
+    /* Double: with a float mantissa, delta / count drops below the mean's
+       resolution after a few million frames, and large values such as a
+       frequency in Hz lose digits long before that. One soft-float update
+       per measurement per frame is cheap. */
+    double mean;
+    double m2;
+    int32_t current;
+    int32_t min;
+    int32_t max;
+    uint32_t count;
+} ScopeStatsAccumulator;
+
+typedef struct
+{
+    ScopeStatsAccumulator entries[SCOPE_MEASURE_COUNT];
+    uint8_t panel_visible;
+} ScopeStatsModule;
+
+static ScopeStatsModule scope_stats_module;
+
+static void ScopeStats_Clear(void);
+
+void ScopeStats_Init(void)
+{
+    scope_stats_module.panel_visible = 0U;
+    ScopeStats_Clear();
+}
+
+void ScopeStats_Reset(void)
+{
+    ScopeStats_Clear();
+}
+
+void ScopeStats_Accumulate(const ScopeMeasureResult *result)
+{
+    if (result == NULL)
+    {
+        return;
+    }
+
+    uint32_t pending = result->valid_mask & SCOPE_MEASURE_ALL_MASK;
+    while (pending != 0U)
+    {
+        uint32_t id = (uint32_t)__builtin_ctz(pending);
+        pending &= pending - 1U;
+
+        ScopeStatsAccumulator *acc = &scope_stats_module.entries[id];
+        int32_t value = result->values[id];
+        acc->current = value;
+        if (acc->count == 0U || value < acc->min)
+        {
+            acc->min = value;
+        }
+        if (acc->count == 0U || value > acc->max)
+        {
+            acc->max = value;
+        }
+
+        /* Welford update, so the variance is not lost to cancellation as it
+           would be in a plain sum of squares. */
+        acc->count++;
+        double delta = (double)value - acc->mean;
+        acc->mean += delta / (double)acc->count;
+        acc->m2 += delta * ((double)value - acc->mean);
+    }
+}
+
+uint8_t ScopeStats_Get(ScopeMeasureId id, ScopeStatsSummary *summary)
+{
+    if (id >= SCOPE_MEASURE_COUNT || summary == NULL)
+    {
+        return 0U;
+    }
+
+    const ScopeStatsAccumulator *acc = &scope_stats_module.entries[id];
+    memset(summary, 0, sizeof(*summary));
+    summary->count = acc->count;
+    if (acc->count == 0U)
+    {
+        return 0U;
+    }
+
+    summary->current = acc->current;
+    summary->min = acc->min;
+    summary->max = acc->max;
+    summary->mean = (int32_t)lround(acc->mean);
+    if (acc->count > 1U && acc->m2 > 0.0)
+    {
+        summary->stddev = (int32_t)lround(sqrt(acc->m2 / (double)(acc->count - 1U)));
+    }
+    return 1U;
+}
+
+void ScopeStats_SetPanelVisible(uint8_t visible)
+{
+    scope_stats_module.panel_visible = visible ? 1U : 0U;
+}
+
+uint8_t ScopeStats_IsPanelVisible(void)
+{
+    return scope_stats_module.panel_visible;
+}
+
+static void ScopeStats_Clear(void)
+{
+    memset(scope_stats_module.entries, 0, sizeof(scope_stats_module.entries));
+}
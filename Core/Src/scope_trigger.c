@@ -0,0 +1,349 @@
+#include "scope_trigger.h"
+
+#include "main.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum
+{
+    TRIGGER_MIN_AMPLITUDE = 20U,
+    TRIGGER_HYSTERESIS_DIVISOR = 20U,
+    TRIGGER_RUNT_LOW_PERCENT = 25U,
+    TRIGGER_RUNT_HIGH_PERCENT = 75U,
+    TRIGGER_ENVELOPE_DECAY_SHIFT = 6U
+};
+
+typedef enum
+{
+    TRIGGER_ZONE_LOW = 0,
+    TRIGGER_ZONE_MIDDLE,
+    TRIGGER_ZONE_HIGH
+} ScopeTriggerZone;
+
+typedef struct
+{
+    ScopeTriggerConfig cfg;
+    uint32_t sample_rate_hz;
+    uint32_t width_samples;
+    uint8_t synced;
+    uint8_t high;
+    uint8_t pulse_open;
+    uint8_t runt_armed;
+    uint8_t timeout_fired;
+    ScopeTriggerZone zone;
+    uint32_t clock;
+    uint32_t pulse_start;
+    uint32_t last_edge;
+    uint16_t envelope_min;
+    uint16_t envelope_max;
+    uint8_t envelope_valid;
+    uint16_t level_low;
+    uint16_t level_high;
+    volatile uint32_t events;
+    uint32_t resyncs;
+} ScopeTriggerModule;
+
+static ScopeTriggerModule scope_trigger_module;
+
+static void ScopeTrigger_Resync(void);
+static void ScopeTrigger_UpdateWidth(void);
+static void ScopeTrigger_UpdateLevels(uint16_t frame_min, uint16_t frame_max);
+static inline uint16_t ScopeTrigger_Orient(uint16_t sample);
+
+void ScopeTrigger_Init(void)
+{
+    memset(&scope_trigger_module, 0, sizeof(scope_trigger_module));
+    scope_trigger_module.cfg.type = SCOPE_TRIGGER_EDGE;
+    scope_trigger_module.cfg.polarity = SCOPE_TRIGGER_POLARITY_POSITIVE;
+    scope_trigger_module.cfg.auto_levels = 1U;
+}
+
+uint8_t ScopeTrigger_Configure(const ScopeTriggerConfig *cfg)
+{
+    if (cfg == NULL || cfg->type > SCOPE_TRIGGER_TIMEOUT ||
+        cfg->polarity > SCOPE_TRIGGER_POLARITY_NEGATIVE)
+    {
+        return 0U;
+    }
+    if ((cfg->type == SCOPE_TRIGGER_PULSE_LESS ||
+         cfg->type == SCOPE_TRIGGER_PULSE_GREATER ||
+         cfg->type == SCOPE_TRIGGER_TIMEOUT) && cfg->width_ns == 0U)
+    {
+        return 0U;
+    }
+    if (!cfg->auto_levels && cfg->level_low >= cfg->level_high)
+    {
+        return 0U;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    scope_trigger_module.cfg = *cfg;
+    scope_trigger_module.envelope_valid = 0U;
+    scope_trigger_module.level_low = cfg->auto_levels ? 0U : cfg->level_low;
+    scope_trigger_module.level_high = cfg->auto_levels ? 0U : cfg->level_high;
+    scope_trigger_module.events = 0U;
+    ScopeTrigger_UpdateWidth();
+    ScopeTrigger_Resync();
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+    return 1U;
+}
+
+void ScopeTrigger_GetConfig(ScopeTriggerConfig *cfg)
+{
+    if (cfg != NULL)
+    {
+        *cfg = scope_trigger_module.cfg;
+    }
+}
+
+ScopeTriggerType ScopeTrigger_GetType(void)
+{
+    return scope_trigger_module.cfg.type;
+}
+
+void ScopeTrigger_GetStatus(ScopeTriggerStatus *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+    status->events = scope_trigger_module.events;
+    status->resyncs = scope_trigger_module.resyncs;
+    status->level_low = scope_trigger_module.level_low;
+    status->level_high = scope_trigger_module.level_high;
+}
+
+void ScopeTrigger_Service(uint32_t sample_rate_hz)
+{
+    ScopeTriggerModule *trg = &scope_trigger_module;
+    if (sample_rate_hz == trg->sample_rate_hz)
+    {
+        return;
+    }
+
+    /* Widths already measured were counted at the old rate. */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    trg->sample_rate_hz = sample_rate_hz;
+    ScopeTrigger_UpdateWidth();
+    ScopeTrigger_Resync();
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+}
+
+uint16_t ScopeTrigger_ProcessFromISR(const uint16_t *samples, uint16_t count)
+{
+    ScopeTriggerModule *trg = &scope_trigger_module;
+    if (samples == NULL || count == 0U || trg->cfg.type == SCOPE_TRIGGER_EDGE ||
+        trg->sample_rate_hz == 0U)
+    {
+        return SCOPE_TRIGGER_NO_EVENT;
+    }
+
+    uint16_t frame_min = 0xFFFFU;
+    uint16_t frame_max = 0U;
+    uint16_t fired_index = SCOPE_TRIGGER_NO_EVENT;
+    if (trg->level_high <= trg->level_low)
+    {
+        for (uint16_t i = 0U; i < count; i++)
+        {
+            frame_min = (samples[i] < frame_min) ? samples[i] : frame_min;
+            frame_max = (samples[i] > frame_max) ? samples[i] : frame_max;
+        }
+        trg->clock += count;
+        ScopeTrigger_UpdateLevels(frame_min, frame_max);
+        return SCOPE_TRIGGER_NO_EVENT;
+    }
+
+    /* Negative polarity mirrors the samples so every state machine below only has
+       to reason about positive pulses. */
+    uint16_t lo = trg->level_low;
+    uint16_t hi = trg->level_high;
+    if (trg->cfg.polarity == SCOPE_TRIGGER_POLARITY_NEGATIVE)
+    {
+        lo = ScopeTrigger_Orient(trg->level_high);
+        hi = ScopeTrigger_Orient(trg->level_low);
+    }
+
+    if (!trg->synced)
+    {
+        uint16_t first = ScopeTrigger_Orient(samples[0]);
+        trg->high = (first >= hi) ? 1U : 0U;
+        trg->zone = (first >= hi) ? TRIGGER_ZONE_HIGH
+                                  : ((first < lo) ? TRIGGER_ZONE_LOW : TRIGGER_ZONE_MIDDLE);
+        trg->last_edge = trg->clock;
+        trg->synced = 1U;
+    }
+
+    const uint32_t width_samples = trg->width_samples;
+    const ScopeTriggerType type = trg->cfg.type;
+    for (uint16_t i = 0U; i < count; i++)
+    {
+        frame_min = (samples[i] < frame_min) ? samples[i] : frame_min;
+        frame_max = (samples[i] > frame_max) ? samples[i] : frame_max;
+        uint16_t v = ScopeTrigger_Orient(samples[i]);
+        uint32_t now = trg->clock + i;
+        uint8_t event = 0U;
+
+        if (type == SCOPE_TRIGGER_RUNT)
+        {
+            ScopeTriggerZone zone = (v >= hi) ? TRIGGER_ZONE_HIGH
+                                              : ((v < lo) ? TRIGGER_ZONE_LOW : TRIGGER_ZONE_MIDDLE);
+            if (zone != trg->zone)
+            {
+                if (zone == TRIGGER_ZONE_MIDDLE && trg->zone == TRIGGER_ZONE_LOW)
+                {
+                    trg->runt_armed = 1U;
+                }
+                else if (zone == TRIGGER_ZONE_HIGH)
+                {
+                    trg->runt_armed = 0U;
+                }
+                else if (zone == TRIGGER_ZONE_LOW && trg->runt_armed)
+                {
+                    trg->runt_armed = 0U;
+                    event = 1U;
+                }
+                trg->zone = zone;
+            }
+        }
+        else if (!trg->high && v >= hi)
+        {
+            trg->high = 1U;
+            trg->pulse_open = 1U;
+            trg->pulse_start = now;
+            trg->last_edge = now;
+            trg->timeout_fired = 0U;
+        }
+        else if (trg->high && v < lo)
+        {
+            trg->high = 0U;
+            trg->last_edge = now;
+            trg->timeout_fired = 0U;
+            if (trg->pulse_open)
+            {
+                uint32_t width = now - trg->pulse_start;
+                if ((type == SCOPE_TRIGGER_PULSE_LESS && width < width_samples) ||
+                    (type == SCOPE_TRIGGER_PULSE_GREATER && width > width_samples))
+                {
+                    event = 1U;
+                }
+            }
+            trg->pulse_open = 0U;
+        }
+        else if (type == SCOPE_TRIGGER_TIMEOUT && !trg->timeout_fired &&
+                 (now - trg->last_edge) >= width_samples)
+        {
+            trg->timeout_fired = 1U;
+            event = 1U;
+        }
+
+        if (event)
+        {
+            trg->events++;
+            if (fired_index == SCOPE_TRIGGER_NO_EVENT)
+            {
+                fired_index = i;
+            }
+        }
+    }
+
+    trg->clock += count;
+    ScopeTrigger_UpdateLevels(frame_min, frame_max);
+    return fired_index;
+}
+
+static void ScopeTrigger_Resync(void)
+{
+    scope_trigger_module.synced = 0U;
+    scope_trigger_module.pulse_open = 0U;
+    scope_trigger_module.runt_armed = 0U;
+    scope_trigger_module.timeout_fired = 0U;
+    scope_trigger_module.resyncs++;
+}
+
+static void ScopeTrigger_UpdateWidth(void)
+{
+    ScopeTriggerModule *trg = &scope_trigger_module;
+    trg->width_samples = (uint32_t)(((uint64_t)trg->cfg.width_ns * trg->sample_rate_hz) / 1000000000ULL);
+    if (trg->width_samples == 0U)
+    {
+        trg->width_samples = 1U;
+    }
+}
+
+static void ScopeTrigger_UpdateLevels(uint16_t frame_min, uint16_t frame_max)
+{
+    ScopeTriggerModule *trg = &scope_trigger_module;
+    if (!trg->cfg.auto_levels)
+    {
+        trg->level_low = trg->cfg.level_low;
+        trg->level_high = trg->cfg.level_high;
+        return;
+    }
+
+    /* The envelope follows new extremes immediately and relaxes slowly, so a frame
+       holding only runt pulses does not pull the auto levels down onto them. */
+    if (!trg->envelope_valid)
+    {
+        trg->envelope_min = frame_min;
+        trg->envelope_max = frame_max;
+        trg->envelope_valid = 1U;
+    }
+    else
+    {
+        if (frame_max >= trg->envelope_max)
+        {
+            trg->envelope_max = frame_max;
+        }
+        else
+        {
+            trg->envelope_max -= (uint16_t)((trg->envelope_max - frame_max) >> TRIGGER_ENVELOPE_DECAY_SHIFT);
+        }
+        if (frame_min <= trg->envelope_min)
+        {
+            trg->envelope_min = frame_min;
+        }
+        else
+        {
+            trg->envelope_min += (uint16_t)((frame_min - trg->envelope_min) >> TRIGGER_ENVELOPE_DECAY_SHIFT);
+        }
+    }
+
+    uint32_t amplitude = (uint32_t)trg->envelope_max - trg->envelope_min;
+    if (trg->envelope_max < trg->envelope_min || amplitude < TRIGGER_MIN_AMPLITUDE)
+    {
+        trg->level_low = 0U;
+        trg->level_high = 0U;
+        return;
+    }
+
+    if (trg->cfg.type == SCOPE_TRIGGER_RUNT)
+    {
+        trg->level_low = (uint16_t)(trg->envelope_min + (amplitude * TRIGGER_RUNT_LOW_PERCENT) / 100U);
+        trg->level_high = (uint16_t)(trg->envelope_min + (amplitude * TRIGGER_RUNT_HIGH_PERCENT) / 100U);
+    }
+    else
+    {
+        uint32_t mid = trg->envelope_min + amplitude / 2U;
+        uint32_t hysteresis = amplitude / TRIGGER_HYSTERESIS_DIVISOR;
+        trg->level_low = (uint16_t)(mid - hysteresis);
+        trg->level_high = (uint16_t)(mid + hysteresis);
+    }
+}
+
+static inline uint16_t ScopeTrigger_Orient(uint16_t sample)
+{
+    if (scope_trigger_module.cfg.polarity == SCOPE_TRIGGER_POLARITY_NEGATIVE)
+    {
+        return (uint16_t)(0xFFFFU - sample);
+    }
+    return sample;
+}
@@ -19,23 +19,134 @@
 
 #include "uart_command.h"
 #include "waveform_control.h"
+#include "scope_autoset.h"
+#include "scope_calib.h"
+#include "scope_decim.h"
+#include "scope_display.h"
+#include "scope_eye.h"
+#include "scope_filter.h"
+#include "scope_fra.h"
+#include "scope_governor.h"
+#include "scope_histogram.h"
+#include "scope_interp.h"
+#include "scope_jitter.h"
+#include "scope_lockin.h"
+#include "scope_decode.h"
+#include "scope_mask.h"
+#include "scope_measure.h"
+#include "scope_reference.h"
+#include "scope_settings.h"
+#include "scope_signal.h"
+#include "scope_stats.h"
+#include "scope_trigger.h"
+#include "scope.h"
 #include "usart.h"
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
+typedef struct
+{
+    const char *name;
+    uint8_t (*handler)(char *args);
+} UartCommandEntry;
+
+enum
+{
+    UART_TX_QUEUE_SIZE = 512U,
+    /* A full queue drains in 45 ms at 115200 baud; a reply still stuck
+       after this long means the link is wedged, and it is dropped. */
+    UART_TX_TIMEOUT_MS = 100U,
+    UART_DECODE_BYTES_PER_LINE = 8U,
+    UART_DECODE_LINE_RESERVE = 48U,
+    UART_MASK_DEFAULT_TOLERANCE_MV = 100U,
+    UART_MASK_DEFAULT_TOLERANCE_COLUMNS = 2U
+};
+
 static uint8_t uart_rx_byte = 0U;
-static char uart_rx_buffer[16];
-static char uart_cmd_buffer[16];
+static char uart_rx_buffer[32];
+static char uart_cmd_buffer[32];
 static volatile uint8_t uart_line_ready = 0U;
 static uint8_t uart_rx_len = 0U;
+static uint8_t uart_tx_queue[UART_TX_QUEUE_SIZE];
+static volatile uint16_t uart_tx_head = 0U;
+static volatile uint16_t uart_tx_tail = 0U;
+static volatile uint16_t uart_tx_inflight = 0U;
+static volatile uint8_t uart_tx_busy = 0U;
+static uint32_t uart_tx_dropped = 0U;
 
 static void SendUartText(const char *text);
+static uint8_t QueueUartText(const char *text, uint8_t wait);
+static uint16_t UartTxFreeSpace(void);
+static void UartTxKick(void);
+static void SendDecodeStream(void);
 static void ProcessUartLine(void);
+static char *SkipBlanks(char *text);
+static uint8_t MatchCommandWord(char *line, const char *word, char **args);
+static uint8_t HandleFrequencyCommand(char *line);
+static uint8_t HandleMeasureCommand(char *args);
+static uint8_t HandleShowCommand(char *args);
+static uint8_t HandleFilterCommand(char *args);
+static uint8_t HandleTriggerCommand(char *args);
+static uint8_t HandleDecodeCommand(char *args);
+static uint8_t HandleStatsCommand(char *args);
+static uint8_t HandleMaskCommand(char *args);
+static uint8_t HandleAutosetCommand(char *args);
+static void SendAutosetReport(const ScopeAutosetResult *result);
+static uint8_t HandleHistogramCommand(char *args);
+static uint8_t HandleEyeCommand(char *args);
+static uint8_t HandleCalibCommand(char *args);
+static uint8_t HandleDecimateCommand(char *args);
+static uint8_t HandleLockinCommand(char *args);
+static uint8_t HandleFraCommand(char *args);
+static uint8_t HandleJitterCommand(char *args);
+static uint8_t HandleEventCommand(char *args);
+static uint8_t HandleFpsCommand(char *args);
+static uint8_t HandleInterpCommand(char *args);
+static uint8_t HandleReferenceCommand(char *args);
+static uint8_t HandleConfigCommand(char *args);
+static void SendFraPoint(const ScopeFraPoint *point, uint8_t index, uint8_t count);
+static void SendFraDone(const ScopeFraStatus *status);
+static void SendHistogramReport(void);
+static uint32_t CountsToTenthMillivolt(float counts);
+static uint8_t ParseOnOff(char *text, uint8_t *value);
+static void SendStatsReport(void);
+static void FormatMeasureValue(char *buf, size_t len, ScopeMeasureId id, int32_t value);
+static uint8_t ParseUnsigned(char **text, uint32_t *value);
+static void SendMeasureReport(const ScopeMeasureResult *result);
+
+static const UartCommandEntry uart_commands[] = {
+    {"meas", HandleMeasureCommand},
+    {"show", HandleShowCommand},
+    {"filt", HandleFilterCommand},
+    {"trig", HandleTriggerCommand},
+    {"dec", HandleDecodeCommand},
+    {"stats", HandleStatsCommand},
+    {"mask", HandleMaskCommand},
+    {"auto", HandleAutosetCommand},
+    {"hist", HandleHistogramCommand},
+    {"eye", HandleEyeCommand},
+    {"cal", HandleCalibCommand},
+    {"deci", HandleDecimateCommand},
+    {"lock", HandleLockinCommand},
+    {"fra", HandleFraCommand},
+    {"jit", HandleJitterCommand},
+    {"evt", HandleEventCommand},
+    {"fps", HandleFpsCommand},
+    {"interp", HandleInterpCommand},
+    {"ref", HandleReferenceCommand},
+    {"cfg", HandleConfigCommand}
+};
 
 void UartCommand_Init(void)
 {
     uart_rx_len = 0U;
     uart_line_ready = 0U;
+    uart_tx_head = 0U;
+    uart_tx_tail = 0U;
+    uart_tx_busy = 0U;
+    uart_tx_dropped = 0U;
     HAL_UART_Receive_IT(&huart3, &uart_rx_byte, 1U);
 }
 
@@ -51,6 +162,34 @@ void UartCommand_Process(void)
         uart_line_ready = 0U;
         ProcessUartLine();
     }
+
+    ScopeMeasureResult report;
+    if (ScopeMeasure_TakeReport(&report))
+    {
+        SendMeasureReport(&report);
+    }
+
+    ScopeAutosetResult autoset;
+    if (ScopeAutoset_TakeReport(&autoset))
+    {
+        SendAutosetReport(&autoset);
+    }
+
+    ScopeFraPoint fra_point;
+    uint8_t fra_index = 0U;
+    while (ScopeFra_TakePoint(&fra_point, &fra_index))
+    {
+        ScopeFraStatus fra_status;
+        ScopeFra_GetStatus(&fra_status);
+        SendFraPoint(&fra_point, fra_index, fra_status.point_count);
+    }
+    ScopeFraStatus fra_done;
+    if (ScopeFra_TakeDone(&fra_done))
+    {
+        SendFraDone(&fra_done);
+    }
+
+    SendDecodeStream();
 }
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
@@ -86,68 +225,1316 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
     }
 }
 
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART3)
+    {
+        uart_tx_tail = (uint16_t)((uart_tx_tail + uart_tx_inflight) % UART_TX_QUEUE_SIZE);
+        uart_tx_inflight = 0U;
+        uart_tx_busy = 0U;
+        UartTxKick();
+    }
+}
+
 static void SendUartText(const char *text)
+{
+    (void)QueueUartText(text, 1U);
+}
+
+static uint8_t QueueUartText(const char *text, uint8_t wait)
 {
     if (text == NULL)
     {
-        return;
+        return 0U;
+    }
+
+    size_t len = strlen(text);
+    if (len == 0U || len >= UART_TX_QUEUE_SIZE)
+    {
+        return 0U;
+    }
+
+    /* Replies wait for the interrupt-driven drain, kicking it in case a
+       transmit failed to start, but only for so long; streamed data is
+       dropped at once so the acquisition loop never stalls on the 115200
+       baud link. */
+    const uint32_t start_ms = HAL_GetTick();
+    while (UartTxFreeSpace() < len)
+    {
+        UartTxKick();
+        if (!wait || HAL_GetTick() - start_ms >= UART_TX_TIMEOUT_MS)
+        {
+            uart_tx_dropped++;
+            return 0U;
+        }
+    }
+
+    uint16_t head = uart_tx_head;
+    for (size_t idx = 0U; idx < len; idx++)
+    {
+        uart_tx_queue[head] = (uint8_t)text[idx];
+        head = (uint16_t)((head + 1U) % UART_TX_QUEUE_SIZE);
+    }
+    uart_tx_head = head;
+    UartTxKick();
+    return 1U;
+}
+
+static uint16_t UartTxFreeSpace(void)
+{
+    uint16_t head = uart_tx_head;
+    uint16_t tail = uart_tx_tail;
+    return (uint16_t)((tail + UART_TX_QUEUE_SIZE - head - 1U) % UART_TX_QUEUE_SIZE);
+}
+
+static void UartTxKick(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!uart_tx_busy && uart_tx_head != uart_tx_tail)
+    {
+        uint16_t tail = uart_tx_tail;
+        uint16_t chunk = (uart_tx_head > tail) ? (uint16_t)(uart_tx_head - tail)
+                                               : (uint16_t)(UART_TX_QUEUE_SIZE - tail);
+        uart_tx_busy = 1U;
+        uart_tx_inflight = chunk;
+        if (HAL_UART_Transmit_IT(&huart3, &uart_tx_queue[tail], chunk) != HAL_OK)
+        {
+            uart_tx_busy = 0U;
+            uart_tx_inflight = 0U;
+        }
+    }
+    if (primask == 0U)
+    {
+        __enable_irq();
     }
-    HAL_UART_Transmit(&huart3, (uint8_t *)text, strlen(text), 100U);
 }
 
 static void ProcessUartLine(void)
 {
-    char *line = uart_cmd_buffer;
+    char *line = SkipBlanks(uart_cmd_buffer);
     if (line[0] == '\0')
     {
         return;
     }
 
-    char *end_ptr;
-    while (*line == ' ' || *line == '\t')
+    uint8_t ok = 0U;
+    uint8_t matched = 0U;
+    const uint32_t command_count = sizeof(uart_commands) / sizeof(uart_commands[0]);
+    for (uint32_t idx = 0U; idx < command_count; idx++)
+    {
+        char *args = NULL;
+        if (MatchCommandWord(line, uart_commands[idx].name, &args))
+        {
+            ok = uart_commands[idx].handler(args);
+            matched = 1U;
+            break;
+        }
+    }
+
+    if (!matched)
+    {
+        ok = HandleFrequencyCommand(line);
+    }
+
+    if (ok != 0U)
+    {
+        SendUartText("OK\r\n");
+    }
+    else
     {
-        line++;
+        SendUartText("ERR\r\n");
     }
+}
 
+static char *SkipBlanks(char *text)
+{
+    while (*text == ' ' || *text == '\t')
+    {
+        text++;
+    }
+    return text;
+}
+
+static uint8_t MatchCommandWord(char *line, const char *word, char **args)
+{
+    size_t len = strlen(word);
+    for (size_t idx = 0U; idx < len; idx++)
+    {
+        char c = line[idx];
+        if (c >= 'A' && c <= 'Z')
+        {
+            c = (char)(c - 'A' + 'a');
+        }
+        if (c != word[idx])
+        {
+            return 0U;
+        }
+    }
+
+    char next = line[len];
+    if (next != '\0' && next != ' ' && next != '\t')
+    {
+        return 0U;
+    }
+
+    *args = SkipBlanks(&line[len]);
+    return 1U;
+}
+
+static uint8_t HandleFrequencyCommand(char *line)
+{
+    char *end_ptr;
     uint8_t set_sine = 0U;
     if (*line == 's' || *line == 'S')
     {
         set_sine = 1U;
-        line++;
-        while (*line == ' ' || *line == '\t')
+        line = SkipBlanks(line + 1);
+    }
+
+    unsigned long value = strtoul(line, &end_ptr, 10);
+    end_ptr = SkipBlanks(end_ptr);
+
+    if (end_ptr == line || *end_ptr != '\0')
+    {
+        return 0U;
+    }
+
+    if (set_sine != 0U)
+    {
+        return WaveformControl_SetSineFrequency((uint32_t)value);
+    }
+    return WaveformControl_SetSquareFrequency((uint32_t)value);
+}
+
+static uint8_t HandleMeasureCommand(char *args)
+{
+    if (*args != '\0')
+    {
+        return 0U;
+    }
+    ScopeMeasure_RequestReport();
+    return 1U;
+}
+
+static uint8_t HandleShowCommand(char *args)
+{
+    char *end_ptr;
+    unsigned long slot = strtoul(args, &end_ptr, 10);
+    if (end_ptr == args || slot == 0U || slot > SCOPE_MEASURE_DISPLAY_SLOTS)
+    {
+        return 0U;
+    }
+
+    char *name = SkipBlanks(end_ptr);
+    char *name_end = name;
+    while (*name_end != '\0' && *name_end != ' ' && *name_end != '\t')
+    {
+        name_end++;
+    }
+    if (*SkipBlanks(name_end) != '\0')
+    {
+        return 0U;
+    }
+    *name_end = '\0';
+
+    ScopeMeasureId id;
+    if (!ScopeMeasure_FindByName(name, &id))
+    {
+        return 0U;
+    }
+    return ScopeMeasure_SetDisplaySlot((uint8_t)(slot - 1U), id);
+}
+
+static uint8_t HandleFilterCommand(char *args)
+{
+    static const struct
+    {
+        const char *name;
+        ScopeFilterType type;
+    } filter_names[] = {
+        {"off", SCOPE_FILTER_OFF},
+        {"lp", SCOPE_FILTER_LOWPASS},
+        {"hp", SCOPE_FILTER_HIGHPASS},
+        {"bp", SCOPE_FILTER_BANDPASS},
+        {"fir", SCOPE_FILTER_FIR_LOWPASS}
+    };
+
+    if (*args == '\0')
+    {
+        ScopeFilterStatus status;
+        ScopeFilter_GetStatus(&status);
+        const char *name = "off";
+        for (uint32_t idx = 0U; idx < sizeof(filter_names) / sizeof(filter_names[0]); idx++)
         {
-            line++;
+            if (filter_names[idx].type == status.type)
+            {
+                name = filter_names[idx].name;
+            }
         }
+        /* 82 characters with every field at its widest. */
+        char line[96];
+        snprintf(line, sizeof(line), "filt=%s fc=%luHz fs=%luHz cyc=%lu cyc/sample=%lu.%02lu\r\n",
+                 name,
+                 (unsigned long)status.cutoff_hz,
+                 (unsigned long)status.sample_rate_hz,
+                 (unsigned long)status.cycles_per_frame,
+                 (unsigned long)(status.cycles_per_sample_x100 / 100U),
+                 (unsigned long)(status.cycles_per_sample_x100 % 100U));
+        SendUartText(line);
+        return 1U;
     }
 
-    unsigned long value = strtoul(line, &end_ptr, 10);
-    while (*end_ptr == ' ' || *end_ptr == '\t')
+    for (uint32_t idx = 0U; idx < sizeof(filter_names) / sizeof(filter_names[0]); idx++)
     {
-        end_ptr++;
+        char *cutoff_text = NULL;
+        if (!MatchCommandWord(args, filter_names[idx].name, &cutoff_text))
+        {
+            continue;
+        }
+        if (filter_names[idx].type == SCOPE_FILTER_OFF)
+        {
+            return (*cutoff_text == '\0') ? ScopeFilter_Configure(SCOPE_FILTER_OFF, 0U) : 0U;
+        }
+
+        char *end_ptr;
+        unsigned long cutoff = strtoul(cutoff_text, &end_ptr, 10);
+        if (end_ptr == cutoff_text || *SkipBlanks(end_ptr) != '\0')
+        {
+            return 0U;
+        }
+        return ScopeFilter_Configure(filter_names[idx].type, (uint32_t)cutoff);
     }
+    return 0U;
+}
 
-    if (end_ptr == line || *end_ptr != '\0')
+static uint8_t HandleTriggerCommand(char *args)
+{
+    static const struct
     {
-        SendUartText("ERR\r\n");
-        return;
+        const char *name;
+        ScopeTriggerType type;
+        uint8_t needs_width;
+    } trigger_names[] = {
+        {"edge", SCOPE_TRIGGER_EDGE, 0U},
+        {"plt", SCOPE_TRIGGER_PULSE_LESS, 1U},
+        {"pgt", SCOPE_TRIGGER_PULSE_GREATER, 1U},
+        {"runt", SCOPE_TRIGGER_RUNT, 0U},
+        {"tmo", SCOPE_TRIGGER_TIMEOUT, 1U}
+    };
+
+    ScopeTriggerConfig cfg;
+    ScopeTrigger_GetConfig(&cfg);
+
+    if (*args == '\0')
+    {
+        ScopeTriggerStatus status;
+        ScopeTrigger_GetStatus(&status);
+        const char *name = "edge";
+        for (uint32_t idx = 0U; idx < sizeof(trigger_names) / sizeof(trigger_names[0]); idx++)
+        {
+            if (trigger_names[idx].type == cfg.type)
+            {
+                name = trigger_names[idx].name;
+            }
+        }
+        char line[80];
+        snprintf(line, sizeof(line), "trig=%s pol=%c w=%luus lo=%lumV hi=%lumV%s ev=%lu\r\n",
+                 name,
+                 (cfg.polarity == SCOPE_TRIGGER_POLARITY_NEGATIVE) ? '-' : '+',
+                 (unsigned long)(cfg.width_ns / 1000U),
+                 (unsigned long)ScopeCalib_CountsToMillivolt(status.level_low),
+                 (unsigned long)ScopeCalib_CountsToMillivolt(status.level_high),
+                 cfg.auto_levels ? "(auto)" : "",
+                 (unsigned long)status.events);
+        SendUartText(line);
+        return 1U;
     }
 
-    uint8_t ok = 0U;
-    if (set_sine != 0U)
+    char *rest = NULL;
+    if (MatchCommandWord(args, "pol", &rest))
     {
-        ok = WaveformControl_SetSineFrequency((uint32_t)value);
+        if ((rest[0] != '+' && rest[0] != '-') || *SkipBlanks(&rest[1]) != '\0')
+        {
+            return 0U;
+        }
+        cfg.polarity = (rest[0] == '-') ? SCOPE_TRIGGER_POLARITY_NEGATIVE : SCOPE_TRIGGER_POLARITY_POSITIVE;
+        return ScopeTrigger_Configure(&cfg);
     }
-    else
+
+    if (MatchCommandWord(args, "lvl", &rest))
     {
-        ok = WaveformControl_SetSquareFrequency((uint32_t)value);
+        char *auto_rest = NULL;
+        if (MatchCommandWord(rest, "auto", &auto_rest))
+        {
+            if (*auto_rest != '\0')
+            {
+                return 0U;
+            }
+            cfg.auto_levels = 1U;
+            return ScopeTrigger_Configure(&cfg);
+        }
+
+        uint32_t low_mv = 0U;
+        uint32_t high_mv = 0U;
+        if (!ParseUnsigned(&rest, &low_mv) || !ParseUnsigned(&rest, &high_mv) || *rest != '\0')
+        {
+            return 0U;
+        }
+        cfg.auto_levels = 0U;
+        cfg.level_low = ScopeCalib_MillivoltToCounts(low_mv);
+        cfg.level_high = ScopeCalib_MillivoltToCounts(high_mv);
+        return ScopeTrigger_Configure(&cfg);
     }
 
-    if (ok != 0U)
+    for (uint32_t idx = 0U; idx < sizeof(trigger_names) / sizeof(trigger_names[0]); idx++)
     {
-        SendUartText("OK\r\n");
+        if (!MatchCommandWord(args, trigger_names[idx].name, &rest))
+        {
+            continue;
+        }
+        if (trigger_names[idx].needs_width)
+        {
+            uint32_t width_us = 0U;
+            if (!ParseUnsigned(&rest, &width_us) || *rest != '\0' || width_us > 4000000U)
+            {
+                return 0U;
+            }
+            cfg.width_ns = width_us * 1000U;
+        }
+        else if (*rest != '\0')
+        {
+            return 0U;
+        }
+        cfg.type = trigger_names[idx].type;
+        return ScopeTrigger_Configure(&cfg);
+    }
+    return 0U;
+}
+
+static uint8_t HandleDecodeCommand(char *args)
+{
+    if (*args == '\0')
+    {
+        ScopeDecodeStatus status;
+        ScopeDecode_GetStatus(&status);
+        char line[96];
+        if (status.baud == 0U)
+        {
+            snprintf(line, sizeof(line), "dec=off\r\n");
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "dec=uart baud=%lu bytes=%lu ferr=%lu resync=%lu drop=%lu%s\r\n",
+                     (unsigned long)status.baud,
+                     (unsigned long)status.bytes,
+                     (unsigned long)status.framing_errors,
+                     (unsigned long)status.resyncs,
+                     (unsigned long)status.stream_drops,
+                     status.rate_ok ? "" : " (baud > fs/8)");
+        }
+        SendUartText(line);
+        return 1U;
+    }
+
+    char *rest = NULL;
+    if (MatchCommandWord(args, "off", &rest))
+    {
+        return (*rest == '\0') ? ScopeDecode_Configure(0U) : 0U;
+    }
+    if (MatchCommandWord(args, "uart", &rest))
+    {
+        uint32_t baud = 0U;
+        if (!ParseUnsigned(&rest, &baud) || *rest != '\0' || baud == 0U ||
+            (uint64_t)baud * SCOPE_DECODE_MIN_SAMPLES_PER_BIT > ScopeSignal_GetSampleRateHz())
+        {
+            return 0U;
+        }
+        return ScopeDecode_Configure(baud);
+    }
+    return 0U;
+}
+
+static uint8_t HandleAutosetCommand(char *args)
+{
+    if (*args != '\0')
+    {
+        return 0U;
+    }
+    Scope_RequestAutoSet();
+    return 1U;
+}
+
+static void SendAutosetReport(const ScopeAutosetResult *result)
+{
+    char line[128];
+    uint32_t vpp_mv = ScopeCalib_SpanToMillivolt((uint32_t)result->signal_max - result->signal_min);
+    if (!result->period_found)
+    {
+        snprintf(line, sizeof(line), "auto: fs=%luHz no period vpp=%lumV tries=%u %lums\r\n",
+                 (unsigned long)result->sample_rate_hz,
+                 (unsigned long)vpp_mv,
+                 (unsigned int)result->rates_tried,
+                 (unsigned long)result->elapsed_ms);
     }
     else
     {
-        SendUartText("ERR\r\n");
+        uint32_t period_x100 = (uint32_t)(((uint64_t)result->period_q8 * 100U + 128U) >> 8);
+        snprintf(line, sizeof(line),
+                 "auto: fs=%luHz period=%lu.%02lu smp f=%luHz vpp=%lumV trig=%lumV tries=%u %lums\r\n",
+                 (unsigned long)result->sample_rate_hz,
+                 (unsigned long)(period_x100 / 100U),
+                 (unsigned long)(period_x100 % 100U),
+                 (unsigned long)result->freq_hz,
+                 (unsigned long)vpp_mv,
+                 (unsigned long)ScopeCalib_CountsToMillivolt(result->trigger_level),
+                 (unsigned int)result->rates_tried,
+                 (unsigned long)result->elapsed_ms);
+    }
+    SendUartText(line);
+}
+
+static uint8_t ParseUnsigned(char **text, uint32_t *value)
+{
+    char *end_ptr;
+    unsigned long parsed = strtoul(*text, &end_ptr, 10);
+    if (end_ptr == *text)
+    {
+        return 0U;
+    }
+    *value = (uint32_t)parsed;
+    *text = SkipBlanks(end_ptr);
+    return 1U;
+}
+
+static void SendDecodeStream(void)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    while (UartTxFreeSpace() >= UART_DECODE_LINE_RESERVE)
+    {
+        char line[UART_DECODE_LINE_RESERVE];
+        size_t pos = 0U;
+        ScopeDecodeByte byte;
+        uint8_t taken = 0U;
+
+        memcpy(line, "dec:", 4U);
+        pos = 4U;
+        while (taken < UART_DECODE_BYTES_PER_LINE && ScopeDecode_PopStream(&byte))
+        {
+            line[pos++] = ' ';
+            line[pos++] = hex_digits[byte.value >> 4];
+            line[pos++] = hex_digits[byte.value & 0x0FU];
+            if (byte.framing_error)
+            {
+                line[pos++] = '!';
+            }
+            taken++;
+        }
+        if (taken == 0U)
+        {
+            return;
+        }
+        line[pos++] = '\r';
+        line[pos++] = '\n';
+        line[pos] = '\0';
+        (void)QueueUartText(line, 0U);
+    }
+}
+
+static uint8_t HandleStatsCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        SendStatsReport();
+        return 1U;
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeStats_Reset();
+        return 1U;
+    }
+    if (MatchCommandWord(args, "show", &rest) && *rest == '\0')
+    {
+        ScopeStats_SetPanelVisible(1U);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "hide", &rest) && *rest == '\0')
+    {
+        ScopeStats_SetPanelVisible(0U);
+        return 1U;
+    }
+    return 0U;
+}
+
+static uint8_t HandleHistogramCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        SendHistogramReport();
+        return 1U;
     }
+    if (MatchCommandWord(args, "on", &rest))
+    {
+        if (*rest != '\0')
+        {
+            uint32_t bins = 0U;
+            if (!ParseUnsigned(&rest, &bins) || *rest != '\0' || bins > SCOPE_HISTOGRAM_MAX_BINS ||
+                !ScopeHistogram_Configure((uint16_t)bins))
+            {
+                return 0U;
+            }
+        }
+        Scope_RequestView(SCOPE_VIEW_HISTOGRAM);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "off", &rest) && *rest == '\0')
+    {
+        Scope_RequestView(SCOPE_VIEW_WAVEFORM);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeHistogram_Reset();
+        return 1U;
+    }
+    return 0U;
+}
+
+static uint8_t HandleEyeCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        ScopeEyeStatus status;
+        ScopeEye_GetStatus(&status);
+        uint32_t fs = ScopeSignal_GetSampleRateHz();
+        uint32_t ui_ns = (fs != 0U) ? (uint32_t)(((uint64_t)status.ui_q8 * 1000000000ULL) / ((uint64_t)fs * 256U)) : 0U;
+        uint32_t width_ns = (fs != 0U) ? (uint32_t)(((uint64_t)status.width_q8 * 1000000000ULL) / ((uint64_t)fs * 256U)) : 0U;
+        char line[128];
+        snprintf(line, sizeof(line), "eye=%s ui=%luns%s n=%lu height=%lumV width=%luns (%u.%u%%UI)%s\r\n",
+                 ScopeEye_IsEnabled() ? "on" : "off",
+                 (unsigned long)ui_ns,
+                 (status.baud != 0U) ? " (fixed)" : "",
+                 (unsigned long)status.unit_intervals,
+                 (unsigned long)ScopeCalib_SpanToMillivolt(status.height_counts),
+                 (unsigned long)width_ns,
+                 (unsigned int)(status.width_permille / 10U),
+                 (unsigned int)(status.width_permille % 10U),
+                 status.open ? "" : " closed");
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "on", &rest))
+    {
+        uint32_t baud = 0U;
+        if (*rest != '\0' &&
+            (!ParseUnsigned(&rest, &baud) || *rest != '\0' || baud == 0U ||
+             (uint64_t)baud * SCOPE_EYE_MIN_SAMPLES_PER_UI > ScopeSignal_GetSampleRateHz()))
+        {
+            return 0U;
+        }
+        (void)ScopeEye_Configure(baud);
+        Scope_RequestView(SCOPE_VIEW_EYE);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "off", &rest) && *rest == '\0')
+    {
+        Scope_RequestView(SCOPE_VIEW_WAVEFORM);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeEye_Reset();
+        return 1U;
+    }
+    return 0U;
+}
+
+static uint8_t HandleCalibCommand(char *args)
+{
+    char *rest = NULL;
+    uint16_t mean = 0U;
+    if (*args == '\0')
+    {
+        ScopeCalibStatus status;
+        ScopeCalib_GetStatus(&status);
+        uint32_t gain_ppm = (uint32_t)(((uint64_t)status.gain_q16 * 1000000U + 32768U) >> 16);
+        char line[128];
+        snprintf(line, sizeof(line),
+                 "cal: vdda=%lumV vref=%u/%u refresh=%s n=%lu zero=%d gain=%lu.%06lu%s\r\n",
+                 (unsigned long)status.vdda_millivolt,
+                 (unsigned int)status.vrefint_counts,
+                 (unsigned int)status.vrefint_factory_counts,
+                 status.refresh_active ? "on" : "boot",
+                 (unsigned long)status.refresh_count,
+                 (int)status.offset_counts,
+                 (unsigned long)(gain_ppm / 1000000U),
+                 (unsigned long)(gain_ppm % 1000000U),
+                 status.stored ? "" : " (unsaved)");
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "zero", &rest) && *rest == '\0')
+    {
+        return (uint8_t)(Scope_GetFrameMean(&mean) && ScopeCalib_SetZero(mean));
+    }
+    if (MatchCommandWord(args, "gain", &rest))
+    {
+        uint32_t millivolt = 0U;
+        if (!ParseUnsigned(&rest, &millivolt) || *rest != '\0')
+        {
+            return 0U;
+        }
+        return (uint8_t)(Scope_GetFrameMean(&mean) && ScopeCalib_SetGain(mean, millivolt));
+    }
+    if (MatchCommandWord(args, "save", &rest) && *rest == '\0')
+    {
+        return ScopeCalib_Save();
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeCalib_ResetBoard();
+        return 1U;
+    }
+    return 0U;
+}
+
+static uint8_t HandleDecimateCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        ScopeDecimStatus status;
+        ScopeDecim_GetStatus(&status);
+        char line[128];
+        snprintf(line, sizeof(line), "deci=%u adc=%luHz record=%luHz frames=%lu cyc=%lu/buf max=%lu\r\n",
+                 (unsigned int)status.ratio,
+                 (unsigned long)status.input_rate_hz,
+                 (unsigned long)status.output_rate_hz,
+                 (unsigned long)status.frames,
+                 (unsigned long)status.cycles_per_buffer,
+                 (unsigned long)status.max_cycles_per_buffer);
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "off", &rest) && *rest == '\0')
+    {
+        return ScopeDecim_Configure(1U);
+    }
+
+    uint32_t ratio = 0U;
+    uint32_t adc_hz = 0U;
+    rest = args;
+    if (!ParseUnsigned(&rest, &ratio) || ratio < SCOPE_DECIM_MIN_RATIO || ratio > SCOPE_DECIM_MAX_RATIO)
+    {
+        return 0U;
+    }
+    if (*rest != '\0')
+    {
+        if (!ParseUnsigned(&rest, &adc_hz) || *rest != '\0' || adc_hz > SCOPE_DECIM_MAX_INPUT_HZ)
+        {
+            return 0U;
+        }
+        /* Drop any running decimation first so the retune is checked against
+           the new input rate. */
+        (void)ScopeDecim_Configure(1U);
+        if (!ScopeSignal_SetSampleRateHz(adc_hz))
+        {
+            return 0U;
+        }
+    }
+    return ScopeDecim_Configure((uint16_t)ratio);
+}
+
+static uint8_t HandleLockinCommand(char *args)
+{
+    char *rest = NULL;
+    uint8_t flag = 0U;
+    if (*args == '\0')
+    {
+        ScopeLockinStatus status;
+        ScopeLockin_GetStatus(&status);
+        char line[192];
+        if (!status.locked)
+        {
+            snprintf(line, sizeof(line), "lock=%s unlocked\r\n", status.enabled ? "on" : "off");
+            SendUartText(line);
+            return 1U;
+        }
+        uint32_t amp_x10 = CountsToTenthMillivolt(status.amplitude_counts);
+        uint32_t i_x10 = CountsToTenthMillivolt(fabsf(status.in_phase_counts));
+        uint32_t q_x10 = CountsToTenthMillivolt(fabsf(status.quadrature_counts));
+        int32_t phase_x100 = (int32_t)lrintf(status.phase_deg * 100.0f);
+        uint32_t phase_abs = (uint32_t)((phase_x100 < 0) ? -phase_x100 : phase_x100);
+        snprintf(line, sizeof(line),
+                 "lock=on f=%lu.%02luHz amp=%lu.%lumV ph=%s%lu.%02lu i=%s%lu.%lumV q=%s%lu.%lumV tc=%lums n=%lu cyc=%lu\r\n",
+                 (unsigned long)(status.reference_centihz / 100U),
+                 (unsigned long)(status.reference_centihz % 100U),
+                 (unsigned long)(amp_x10 / 10U), (unsigned long)(amp_x10 % 10U),
+                 (phase_x100 < 0) ? "-" : "",
+                 (unsigned long)(phase_abs / 100U), (unsigned long)(phase_abs % 100U),
+                 (status.in_phase_counts < 0.0f) ? "-" : "",
+                 (unsigned long)(i_x10 / 10U), (unsigned long)(i_x10 % 10U),
+                 (status.quadrature_counts < 0.0f) ? "-" : "",
+                 (unsigned long)(q_x10 / 10U), (unsigned long)(q_x10 % 10U),
+                 (unsigned long)status.time_constant_ms,
+                 (unsigned long)status.buffers,
+                 (unsigned long)status.cycles_per_buffer);
+        SendUartText(line);
+        return 1U;
+    }
+    if (ParseOnOff(args, &flag))
+    {
+        return ScopeLockin_SetEnabled(flag);
+    }
+    if (MatchCommandWord(args, "tc", &rest))
+    {
+        uint32_t time_constant_ms = 0U;
+        if (!ParseUnsigned(&rest, &time_constant_ms) || *rest != '\0')
+        {
+            return 0U;
+        }
+        return ScopeLockin_SetTimeConstantMs(time_constant_ms);
+    }
+    return 0U;
+}
+
+static uint8_t HandleFraCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        /* Dump whatever the last sweep measured, the table first. */
+        ScopeFraStatus status;
+        ScopeFra_GetStatus(&status);
+        const ScopeFraPoint *points = ScopeFra_Points();
+        for (uint8_t i = 0U; i < status.points_done; ++i)
+        {
+            SendFraPoint(&points[i], i, status.point_count);
+        }
+        SendFraDone(&status);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "stop", &rest) && *rest == '\0')
+    {
+        ScopeFra_Stop();
+        return 1U;
+    }
+    if (MatchCommandWord(args, "off", &rest) && *rest == '\0')
+    {
+        /* Leaving the plot stops a sweep still in progress. */
+        Scope_RequestView(SCOPE_VIEW_WAVEFORM);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "run", &rest))
+    {
+        uint32_t start_hz = SCOPE_FRA_MIN_HZ;
+        uint32_t stop_hz = SCOPE_FRA_MAX_HZ;
+        uint32_t points = SCOPE_FRA_DEFAULT_POINTS;
+        if (*rest != '\0')
+        {
+            if (!ParseUnsigned(&rest, &start_hz) || !ParseUnsigned(&rest, &stop_hz))
+            {
+                return 0U;
+            }
+            if (*rest != '\0' && (!ParseUnsigned(&rest, &points) || *rest != '\0'))
+            {
+                return 0U;
+            }
+        }
+        if (points > SCOPE_FRA_MAX_POINTS ||
+            !ScopeFra_Start(start_hz, stop_hz, (uint8_t)points, HAL_GetTick()))
+        {
+            return 0U;
+        }
+        Scope_RequestView(SCOPE_VIEW_BODE);
+        return 1U;
+    }
+    return 0U;
+}
+
+static void SendFraPoint(const ScopeFraPoint *point, uint8_t index, uint8_t count)
+{
+    char line[112];
+    int32_t gain_x100 = (int32_t)lrintf(point->gain_db * 100.0f);
+    int32_t phase_x100 = (int32_t)lrintf(point->phase_deg * 100.0f);
+    uint32_t gain_abs = (uint32_t)((gain_x100 < 0) ? -gain_x100 : gain_x100);
+    uint32_t phase_abs = (uint32_t)((phase_x100 < 0) ? -phase_x100 : phase_x100);
+    uint32_t amp_x10 = (uint32_t)lrintf(point->amplitude_mv * 10.0f);
+    snprintf(line, sizeof(line),
+             "fra: %u/%u f=%lu.%02luHz gain=%s%lu.%02ludB ph=%s%lu.%02lu amp=%lu.%lumV\r\n",
+             (unsigned int)(index + 1U),
+             (unsigned int)count,
+             (unsigned long)(point->freq_centihz / 100U),
+             (unsigned long)(point->freq_centihz % 100U),
+             (gain_x100 < 0) ? "-" : "",
+             (unsigned long)(gain_abs / 100U), (unsigned long)(gain_abs % 100U),
+             (phase_x100 < 0) ? "-" : "",
+             (unsigned long)(phase_abs / 100U), (unsigned long)(phase_abs % 100U),
+             (unsigned long)(amp_x10 / 10U), (unsigned long)(amp_x10 % 10U));
+    SendUartText(line);
+}
+
+static void SendFraDone(const ScopeFraStatus *status)
+{
+    char line[96];
+    snprintf(line, sizeof(line), "fra: %s %u/%u points %lu..%luHz %lums cyc=%lu/point\r\n",
+             status->running ? "running" : (status->aborted ? "stopped" : "done"),
+             (unsigned int)status->points_done,
+             (unsigned int)status->point_count,
+             (unsigned long)status->start_hz,
+             (unsigned long)status->stop_hz,
+             (unsigned long)status->elapsed_ms,
+             (unsigned long)status->cycles_per_point);
+    SendUartText(line);
+}
+
+static uint8_t HandleJitterCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        ScopeJitterStatus status;
+        ScopeJitter_GetStatus(&status);
+        uint32_t period_x10 = (uint32_t)lrintf(status.period_ns * 10.0f);
+        uint32_t rms_x10 = (uint32_t)lrintf(status.tie_rms_ns * 10.0f);
+        uint32_t pp_x10 = (uint32_t)lrintf(status.tie_pp_ns * 10.0f);
+        uint32_t sd_x10 = (uint32_t)lrintf(status.period_sd_ns * 10.0f);
+        uint32_t bin_x10 = (uint32_t)lrintf(status.bin_ns * 10.0f);
+        char line[192];
+        snprintf(line, sizeof(line),
+                 "jit=%s edges=%lu tie_n=%lu period=%lu.%luns tie_rms=%lu.%luns tie_pp=%lu.%luns "
+                 "period_sd=%lu.%luns bin=%lu.%luns drop=%lu resync=%lu cyc=%lu/buf max=%lu\r\n",
+                 status.enabled ? "on" : "off",
+                 (unsigned long)status.edges,
+                 (unsigned long)status.tie_count,
+                 (unsigned long)(period_x10 / 10U), (unsigned long)(period_x10 % 10U),
+                 (unsigned long)(rms_x10 / 10U), (unsigned long)(rms_x10 % 10U),
+                 (unsigned long)(pp_x10 / 10U), (unsigned long)(pp_x10 % 10U),
+                 (unsigned long)(sd_x10 / 10U), (unsigned long)(sd_x10 % 10U),
+                 (unsigned long)(bin_x10 / 10U), (unsigned long)(bin_x10 % 10U),
+                 (unsigned long)status.dropped,
+                 (unsigned long)status.resyncs,
+                 (unsigned long)status.cycles_per_buffer,
+                 (unsigned long)status.max_cycles_per_buffer);
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "on", &rest) && *rest == '\0')
+    {
+        Scope_RequestView(SCOPE_VIEW_JITTER);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "off", &rest) && *rest == '\0')
+    {
+        Scope_RequestView(SCOPE_VIEW_WAVEFORM);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeJitter_Reset();
+        return 1U;
+    }
+    return 0U;
+}
+
+static uint8_t HandleEventCommand(char *args)
+{
+    if (*args != '\0')
+    {
+        return 0U;
+    }
+    ScopeEventStats stats;
+    Scope_GetEventStats(&stats);
+    char line[96];
+    snprintf(line, sizeof(line), "evt=%lu drop=%lu max_latency=%lums tx_drop=%lu\r\n",
+             (unsigned long)stats.events,
+             (unsigned long)stats.dropped,
+             (unsigned long)stats.max_latency_ms,
+             (unsigned long)uart_tx_dropped);
+    SendUartText(line);
+    return 1U;
+}
+
+static uint8_t HandleFpsCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        ScopeGovernorStatus status;
+        ScopeDisplayRedrawStats redraw;
+        ScopeGovernor_GetStatus(&status);
+        ScopeDisplay_GetRedrawStats(&redraw);
+        uint32_t fps_x10 = (status.interval_ms != 0U) ? (10000U / status.interval_ms) : 0U;
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "fps=%u actual<=%lu.%lu acq=%lu ana=%lu ren=%lu drop=%lu "
+                 "ana_cyc=%lu ren_cyc=%lu max=%lu trace=%lu skip=%lu tol=%upx "
+                 "map_cyc=%lu max=%lu plan_cyc=%lu\r\n",
+                 (unsigned int)status.target_fps,
+                 (unsigned long)(fps_x10 / 10U), (unsigned long)(fps_x10 % 10U),
+                 (unsigned long)status.acquired,
+                 (unsigned long)status.analyzed,
+                 (unsigned long)status.rendered,
+                 (unsigned long)status.dropped,
+                 (unsigned long)status.analysis_cycles,
+                 (unsigned long)status.render_cycles,
+                 (unsigned long)status.max_render_cycles,
+                 (unsigned long)redraw.drawn,
+                 (unsigned long)redraw.skipped,
+                 (unsigned int)redraw.tolerance_px,
+                 (unsigned long)redraw.map_cycles,
+                 (unsigned long)redraw.max_map_cycles,
+                 (unsigned long)redraw.plan_cycles);
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeGovernor_Reset();
+        ScopeDisplay_ResetRedrawStats();
+        return 1U;
+    }
+    if (MatchCommandWord(args, "tol", &rest))
+    {
+        uint32_t tolerance_px = 0U;
+        if (!ParseUnsigned(&rest, &tolerance_px) || *rest != '\0' || tolerance_px > 8U)
+        {
+            return 0U;
+        }
+        ScopeDisplay_SetRedrawTolerance((uint8_t)tolerance_px);
+        return 1U;
+    }
+    uint32_t fps = 0U;
+    rest = args;
+    if (!ParseUnsigned(&rest, &fps) || *rest != '\0' || fps > 0xFFFFU)
+    {
+        return 0U;
+    }
+    return ScopeGovernor_SetTargetFps((uint16_t)fps);
+}
+
+static uint8_t HandleInterpCommand(char *args)
+{
+    static const char *const names[] = {"off", "lin", "sinc"};
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        char line[32];
+        snprintf(line, sizeof(line), "interp=%s\r\n", names[ScopeInterp_GetMode()]);
+        SendUartText(line);
+        return 1U;
+    }
+    for (uint8_t mode = 0U; mode < (uint8_t)(sizeof(names) / sizeof(names[0])); ++mode)
+    {
+        if (MatchCommandWord(args, names[mode], &rest) && *rest == '\0')
+        {
+            ScopeInterp_SetMode((ScopeInterpMode)mode);
+            return 1U;
+        }
+    }
+    return 0U;
+}
+
+static uint8_t HandleReferenceCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        ScopeReferenceStatus status;
+        ScopeReference_GetStatus(&status);
+        char stored[2U * SCOPE_REFERENCE_SLOTS + 1U] = "-";
+        size_t used = 0U;
+        for (uint8_t slot = 0U; slot < SCOPE_REFERENCE_SLOTS; ++slot)
+        {
+            if ((status.stored_mask & (1U << slot)) != 0U)
+            {
+                used += (size_t)snprintf(stored + used, sizeof(stored) - used, "%s%u",
+                                         (used > 0U) ? "," : "", (unsigned int)slot);
+            }
+        }
+        int8_t shown = Scope_GetShownReference();
+        char shown_text[24] = "off";
+        if (shown >= 0)
+        {
+            snprintf(shown_text, sizeof(shown_text), "%d%s", (int)shown,
+                     Scope_IsReferenceRateMismatched() ? " (rate mismatch)" : "");
+        }
+        char line[160];
+        snprintf(line, sizeof(line),
+                 "ref=%s stored=%s sector=%u gen=%lu used=%lu free=%lu compact=%lu torn=%lu\r\n",
+                 shown_text,
+                 stored,
+                 (unsigned int)status.sector,
+                 (unsigned long)status.generation,
+                 (unsigned long)status.used_bytes,
+                 (unsigned long)status.free_bytes,
+                 (unsigned long)status.compactions,
+                 (unsigned long)status.torn_records);
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "off", &rest) && *rest == '\0')
+    {
+        Scope_HideReference();
+        return 1U;
+    }
+
+    uint8_t (*action)(uint8_t) = NULL;
+    if (MatchCommandWord(args, "save", &rest))
+    {
+        action = Scope_SaveReference;
+    }
+    else if (MatchCommandWord(args, "show", &rest))
+    {
+        action = Scope_ShowReference;
+    }
+    else if (MatchCommandWord(args, "del", &rest))
+    {
+        action = Scope_EraseReference;
+    }
+    uint32_t slot = 0U;
+    if (action == NULL || !ParseUnsigned(&rest, &slot) || *rest != '\0' || slot >= SCOPE_REFERENCE_SLOTS)
+    {
+        return 0U;
+    }
+    return action((uint8_t)slot);
+}
+
+static uint8_t HandleConfigCommand(char *args)
+{
+    char *rest = NULL;
+    if (*args == '\0')
+    {
+        ScopeSettingsStatus status;
+        ScopeSettings_GetStatus(&status);
+        char line[160];
+        snprintf(line, sizeof(line),
+                 "cfg=%s%s sector=%u gen=%lu records=%lu free=%lu spare=%s writes=%lu coalesced=%lu compact=%lu torn=%lu\r\n",
+                 status.restored ? "restored" : "defaults",
+                 status.pending ? " (pending)" : "",
+                 (unsigned int)status.sector,
+                 (unsigned long)status.generation,
+                 (unsigned long)status.records,
+                 (unsigned long)status.free_records,
+                 status.spare_blank ? "blank" : "dirty",
+                 (unsigned long)status.writes,
+                 (unsigned long)status.coalesced,
+                 (unsigned long)status.compactions,
+                 (unsigned long)status.torn_records);
+        SendUartText(line);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "save", &rest) && *rest == '\0')
+    {
+        return ScopeSettings_Flush();
+    }
+    return 0U;
+}
+
+static void SendHistogramReport(void)
+{
+    ScopeHistogramSummary summary;
+    char line[128];
+    if (!ScopeHistogram_Analyze(&summary))
+    {
+        snprintf(line, sizeof(line), "hist=%s bins=%u n=0\r\n",
+                 ScopeHistogram_IsEnabled() ? "on" : "off",
+                 (unsigned int)summary.bin_count);
+        SendUartText(line);
+        return;
+    }
+
+    uint32_t mean = CountsToTenthMillivolt(summary.mean - (float)ScopeCalib_OffsetCounts());
+    uint32_t sd = CountsToTenthMillivolt(summary.stddev);
+    uint32_t noise = CountsToTenthMillivolt(summary.noise);
+    snprintf(line, sizeof(line),
+             "hist=%s bins=%u n=%lu mean=%lu.%lumV sd=%lu.%lumV top=%lumV base=%lumV noise=%lu.%lumV%s\r\n",
+             ScopeHistogram_IsEnabled() ? "on" : "off",
+             (unsigned int)summary.bin_count,
+             (unsigned long)summary.total,
+             (unsigned long)(mean / 10U), (unsigned long)(mean % 10U),
+             (unsigned long)(sd / 10U), (unsigned long)(sd % 10U),
+             (unsigned long)ScopeCalib_CountsToMillivolt(summary.top),
+             (unsigned long)ScopeCalib_CountsToMillivolt(summary.base),
+             (unsigned long)(noise / 10U), (unsigned long)(noise % 10U),
+             summary.bimodal ? "" : " (one level)");
+    SendUartText(line);
+}
+
+static uint32_t CountsToTenthMillivolt(float counts)
+{
+    float scaled = counts * 10.0f + 0.5f;
+    if (scaled <= 0.0f)
+    {
+        return 0U;
+    }
+    if (scaled > 65535.0f)
+    {
+        scaled = 65535.0f;
+    }
+    return ScopeCalib_SpanToMillivolt((uint32_t)scaled);
+}
+
+static uint8_t HandleMaskCommand(char *args)
+{
+    char *rest = NULL;
+    uint8_t flag = 0U;
+
+    if (*args == '\0')
+    {
+        ScopeMaskStatus status;
+        ScopeMask_GetStatus(&status);
+        char line[96];
+        snprintf(line, sizeof(line), "mask=%s stop=%s pass=%lu fail=%lu cols=%u cyc=%lu\r\n",
+                 !status.valid ? "none" : (!status.enabled ? "off" : (status.window_mismatch ? "paused" : "on")),
+                 status.stop_on_fail ? "on" : "off",
+                 (unsigned long)status.passed,
+                 (unsigned long)status.failed,
+                 (unsigned int)status.last_fail_columns,
+                 (unsigned long)status.cycles);
+        SendUartText(line);
+        return 1U;
+    }
+
+    if (MatchCommandWord(args, "cap", &rest))
+    {
+        uint32_t tolerance_mv = UART_MASK_DEFAULT_TOLERANCE_MV;
+        uint32_t tolerance_columns = UART_MASK_DEFAULT_TOLERANCE_COLUMNS;
+        if (*rest != '\0' && !ParseUnsigned(&rest, &tolerance_mv))
+        {
+            return 0U;
+        }
+        if (*rest != '\0' && !ParseUnsigned(&rest, &tolerance_columns))
+        {
+            return 0U;
+        }
+        if (*rest != '\0' || tolerance_columns > 32U)
+        {
+            return 0U;
+        }
+        if (!Scope_CaptureMask(tolerance_mv, (uint16_t)tolerance_columns))
+        {
+            return 0U;
+        }
+        ScopeMask_SetEnabled(1U);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "stop", &rest))
+    {
+        if (!ParseOnOff(rest, &flag))
+        {
+            return 0U;
+        }
+        ScopeMask_SetStopOnFail(flag);
+        return 1U;
+    }
+    if (MatchCommandWord(args, "reset", &rest) && *rest == '\0')
+    {
+        ScopeMask_ResetCounters();
+        return 1U;
+    }
+    if (ParseOnOff(args, &flag))
+    {
+        ScopeMask_SetEnabled(flag);
+        return (ScopeMask_IsEnabled() == flag) ? 1U : 0U;
+    }
+    return 0U;
+}
+
+static uint8_t ParseOnOff(char *text, uint8_t *value)
+{
+    char *rest = NULL;
+    if (MatchCommandWord(text, "on", &rest) && *rest == '\0')
+    {
+        *value = 1U;
+        return 1U;
+    }
+    if (MatchCommandWord(text, "off", &rest) && *rest == '\0')
+    {
+        *value = 0U;
+        return 1U;
+    }
+    return 0U;
+}
+
+static void SendStatsReport(void)
+{
+    for (uint8_t id = 0U; id < SCOPE_MEASURE_COUNT; id++)
+    {
+        ScopeStatsSummary summary;
+        if (!ScopeStats_Get((ScopeMeasureId)id, &summary))
+        {
+            continue;
+        }
+
+        char current[16];
+        char min[16];
+        char max[16];
+        char mean[16];
+        char deviation[16];
+        FormatMeasureValue(current, sizeof(current), (ScopeMeasureId)id, summary.current);
+        FormatMeasureValue(min, sizeof(min), (ScopeMeasureId)id, summary.min);
+        FormatMeasureValue(max, sizeof(max), (ScopeMeasureId)id, summary.max);
+        FormatMeasureValue(mean, sizeof(mean), (ScopeMeasureId)id, summary.mean);
+        FormatMeasureValue(deviation, sizeof(deviation), (ScopeMeasureId)id, summary.stddev);
+
+        char line[112];
+        snprintf(line, sizeof(line), "%s cur=%s min=%s max=%s mean=%s sd=%s n=%lu\r\n",
+                 ScopeMeasure_Label((ScopeMeasureId)id),
+                 current,
+                 min,
+                 max,
+                 mean,
+                 deviation,
+                 (unsigned long)summary.count);
+        SendUartText(line);
+    }
+}
+
+static void FormatMeasureValue(char *buf, size_t len, ScopeMeasureId id, int32_t value)
+{
+    long v = (long)value;
+    switch (ScopeMeasure_Unit(id))
+    {
+    case SCOPE_MEASURE_UNIT_MILLIVOLT:
+        snprintf(buf, len, "%ldmV", v);
+        break;
+    case SCOPE_MEASURE_UNIT_HZ:
+        snprintf(buf, len, "%ldHz", v);
+        break;
+    case SCOPE_MEASURE_UNIT_NS:
+        snprintf(buf, len, "%ldns", v);
+        break;
+    case SCOPE_MEASURE_UNIT_PERMILLE:
+    default:
+        snprintf(buf, len, "%s%ld.%ld%%", (v < 0) ? "-" : "", labs(v) / 10L, labs(v) % 10L);
+        break;
+    }
+}
+
+static void SendMeasureReport(const ScopeMeasureResult *result)
+{
+    char line[40];
+    for (uint8_t id = 0U; id < SCOPE_MEASURE_COUNT; id++)
+    {
+        const char *label = ScopeMeasure_Label((ScopeMeasureId)id);
+        if ((result->valid_mask & (1UL << id)) == 0U)
+        {
+            snprintf(line, sizeof(line), "%s=---\r\n", label);
+            SendUartText(line);
+            continue;
+        }
+
+        char value[16];
+        FormatMeasureValue(value, sizeof(value), (ScopeMeasureId)id, result->values[id]);
+        snprintf(line, sizeof(line), "%s=%s\r\n", label, value);
+        SendUartText(line);
+    }
+
+    snprintf(line, sizeof(line), "cycles=%lu\r\n", (unsigned long)result->cycles);
+    SendUartText(line);
 }
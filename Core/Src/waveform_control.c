@@ -44,6 +44,8 @@ static const uint16_t sine_lut[SINE_SAMPLE_COUNT] = {
 
 static uint8_t dac_started = 0U;
 static uint8_t square_started = 0U;
+static uint32_t sine_frequency_hz = 0U;
+static uint32_t square_frequency_hz = 0U;
 
 static uint32_t ComputeTim1ClockHz(void);
 static uint32_t ComputeTim4ClockHz(void);
@@ -91,6 +93,16 @@ uint8_t WaveformControl_SetSineFrequency(uint32_t target_hz)
     return ApplySineFrequency(target_hz);
 }
 
+uint32_t WaveformControl_GetSineFrequency(void)
+{
+    return sine_frequency_hz;
+}
+
+uint32_t WaveformControl_GetSquareFrequency(void)
+{
+    return square_frequency_hz;
+}
+
 uint8_t WaveformControl_SetFrequency(uint32_t target_hz)
 {
     return WaveformControl_SetSquareFrequency(target_hz);
@@ -202,6 +214,7 @@ static uint8_t ApplySquareFrequency(uint32_t target_hz)
     HAL_TIM_GenerateEvent(&htim1, TIM_EVENTSOURCE_UPDATE);
     HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1);
 
+    square_frequency_hz = target_hz;
     return 1U;
 }
 
@@ -240,5 +253,6 @@ static uint8_t ApplySineFrequency(uint32_t target_hz)
     HAL_TIM_GenerateEvent(&htim4, TIM_EVENTSOURCE_UPDATE);
     __HAL_TIM_ENABLE(&htim4);
 
+    sine_frequency_hz = target_hz;
     return 1U;
 }
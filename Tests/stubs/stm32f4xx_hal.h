@@ -0,0 +1,126 @@
+#ifndef TESTS_STUBS_STM32F4XX_HAL_H_
+#define TESTS_STUBS_STM32F4XX_HAL_H_
+
+/* Host stand-in for the HAL header that main.h pulls in: just the CMSIS
+   intrinsics, core registers and handle types the modules under test and
+   their headers use. */
+
+#include <stdint.h>
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0U;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+static inline void __enable_irq(void)
+{
+}
+
+static inline void __DMB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline int32_t __SSAT(int32_t value, uint32_t bits)
+{
+    const int32_t max = (int32_t)((1U << (bits - 1U)) - 1U);
+    const int32_t min = -max - 1;
+    return (value > max) ? max : ((value < min) ? min : value);
+}
+
+/* The cycle counter stays at zero, so profiled sections cost nothing. */
+typedef struct
+{
+    volatile uint32_t CYCCNT;
+} TestDwt;
+
+static TestDwt test_dwt __attribute__((unused));
+#define DWT (&test_dwt)
+
+/* Named by spi.h and ili9341.h, which scope.h drags in for the frame
+   width; never used. */
+typedef struct
+{
+    uint32_t unused;
+} SPI_HandleTypeDef;
+
+/* Just the registers and handle fields scope_signal.c touches for the
+   sampling timer; a test that links it defines the handles. */
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t EGR;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    uint32_t Prescaler;
+    uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+typedef struct
+{
+    volatile uint32_t NDTR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+    DMA_Stream_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    DMA_HandleTypeDef *DMA_Handle;
+} ADC_HandleTypeDef;
+
+typedef struct
+{
+    DMA_HandleTypeDef *DMA_Handle1;
+} DAC_HandleTypeDef;
+
+#define TIM_CR1_CEN 0x1U
+#define TIM_EGR_UG 0x1U
+#define __HAL_TIM_SET_PRESCALER(handle, value) ((handle)->Instance->PSC = (value))
+#define __HAL_TIM_SET_AUTORELOAD(handle, value) \
+    do                                          \
+    {                                           \
+        (handle)->Instance->ARR = (value);      \
+        (handle)->Init.Period = (value);        \
+    } while (0)
+#define __HAL_DMA_GET_COUNTER(handle) ((handle)->Instance->NDTR)
+
+/* As configured in main.c: APB1 at 48 MHz, divided from HCLK, so the
+   timers on it run at twice that. */
+typedef struct
+{
+    uint32_t APB1CLKDivider;
+} RCC_ClkInitTypeDef;
+
+#define RCC_HCLK_DIV1 0x0U
+#define RCC_HCLK_DIV2 0x1000U
+
+static inline uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return 48000000U;
+}
+
+static inline void HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef *config, uint32_t *latency)
+{
+    config->APB1CLKDivider = RCC_HCLK_DIV2;
+    *latency = 0U;
+}
+
+#endif /* TESTS_STUBS_STM32F4XX_HAL_H_ */
@@ -0,0 +1,37 @@
+#ifndef TESTS_TEST_CHECK_H_
+#define TESTS_TEST_CHECK_H_
+
+#include <stdio.h>
+
+static unsigned int test_failures;
+
+#define CHECK(cond)                                                        \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                               \
+        }                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                          \
+    do                                                                      \
+    {                                                                       \
+        long long check_a = (long long)(actual);                            \
+        long long check_e = (long long)(expected);                          \
+        if (check_a != check_e)                                             \
+        {                                                                   \
+            printf("%s:%d: %s == %lld, expected %lld\n",                    \
+                   __FILE__, __LINE__, #actual, check_a, check_e);          \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+static inline int test_report(const char *name)
+{
+    printf("%s: %s\n", name, test_failures ? "FAILED" : "ok");
+    return test_failures ? 1 : 0;
+}
+
+#endif /* TESTS_TEST_CHECK_H_ */
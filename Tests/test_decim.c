@@ -0,0 +1,191 @@
+#include "scope_decim.h"
+
+#include "scope.h"
+#include "scope_signal.h"
+#include "test_check.h"
+
+#include <math.h>
+#include <string.h>
+
+enum
+{
+    CHUNK = 256U,
+    ADC_RATE_HZ = 400000U,
+    RATIO = 16U
+};
+
+static uint32_t adc_rate_hz = ADC_RATE_HZ;
+static uint16_t decimation = 1U;
+
+/* Stand-ins for the rate bookkeeping in scope_signal.c. */
+uint32_t ScopeSignal_GetAdcRateHz(void)
+{
+    return adc_rate_hz;
+}
+
+uint32_t ScopeSignal_GetSampleRateHz(void)
+{
+    return adc_rate_hz / decimation;
+}
+
+void ScopeSignal_SetDecimation(uint16_t ratio)
+{
+    decimation = ratio;
+}
+
+typedef double (*Waveform)(uint32_t index, void *arg);
+
+/* Feeds the waveform in DMA-sized chunks until `frames` frames came out;
+   the last one is copied to `out`. */
+static void Run(Waveform wave, void *arg, uint32_t frames, uint16_t *out)
+{
+    uint16_t chunk[CHUNK];
+    uint32_t index = 0U;
+    uint32_t seen = 0U;
+    while (seen < frames)
+    {
+        for (uint32_t i = 0U; i < CHUNK; ++i)
+        {
+            double v = floor(wave(index++, arg) + 0.5);
+            chunk[i] = (uint16_t)((v < 0.0) ? 0.0 : ((v > 4095.0) ? 4095.0 : v));
+        }
+        uint16_t *frame = ScopeDecim_ProcessFromISR(chunk, CHUNK);
+        if (frame != NULL)
+        {
+            CHECK(frame != chunk);
+            memcpy(out, frame, SCOPE_FRAME_SAMPLES * sizeof(out[0]));
+            seen++;
+        }
+    }
+}
+
+static double Dc(uint32_t index, void *arg)
+{
+    (void)index;
+    return *(const double *)arg;
+}
+
+typedef struct
+{
+    double period;
+    double amplitude;
+} Tone;
+
+static double Sine(uint32_t index, void *arg)
+{
+    const Tone *tone = arg;
+    return 2048.0 + tone->amplitude * sin(2.0 * M_PI * (double)index / tone->period);
+}
+
+static void Span(const uint16_t *frame, uint16_t *min, uint16_t *max)
+{
+    *min = 0xFFFFU;
+    *max = 0U;
+    for (uint32_t i = 0U; i < SCOPE_FRAME_SAMPLES; ++i)
+    {
+        *min = (frame[i] < *min) ? frame[i] : *min;
+        *max = (frame[i] > *max) ? frame[i] : *max;
+    }
+}
+
+static void TestConfigure(void)
+{
+    ScopeDecim_Init();
+    CHECK_EQ(ScopeDecim_GetRatio(), 1U);
+    CHECK_EQ(decimation, 1U);
+
+    uint16_t chunk[CHUNK] = {0};
+    CHECK(ScopeDecim_ProcessFromISR(chunk, CHUNK) == chunk);
+
+    CHECK(!ScopeDecim_Configure(SCOPE_DECIM_MAX_RATIO + 1U));
+    /* 400 kHz / 4096 is below the 100 Hz output floor. */
+    CHECK(!ScopeDecim_Configure(SCOPE_DECIM_MAX_RATIO));
+    adc_rate_hz = 2000000U;
+    CHECK(!ScopeDecim_Configure(RATIO));
+    adc_rate_hz = ADC_RATE_HZ;
+    CHECK_EQ(ScopeDecim_GetRatio(), 1U);
+
+    CHECK(ScopeDecim_Configure(RATIO));
+    CHECK_EQ(ScopeDecim_GetRatio(), RATIO);
+    CHECK_EQ(decimation, RATIO);
+    CHECK(ScopeDecim_Configure(0U));
+    CHECK_EQ(ScopeDecim_GetRatio(), 1U);
+}
+
+static void TestDcGain(void)
+{
+    /* The normalisation and compensator have unity DC gain, so a constant
+       input comes out exact at every ratio, full scale included. */
+    static const uint16_t ratios[] = {2U, 3U, 16U, 100U, 1000U};
+    static const double levels[] = {0.0, 1.0, 1234.0, 4095.0};
+    uint16_t frame[SCOPE_FRAME_SAMPLES];
+    for (uint32_t r = 0U; r < sizeof(ratios) / sizeof(ratios[0]); ++r)
+    {
+        for (uint32_t l = 0U; l < sizeof(levels) / sizeof(levels[0]); ++l)
+        {
+            CHECK(ScopeDecim_Configure(ratios[r]));
+            double level = levels[l];
+            Run(Dc, &level, 1U, frame);
+            uint16_t min;
+            uint16_t max;
+            Span(frame, &min, &max);
+            CHECK_EQ(min, (uint16_t)level);
+            CHECK_EQ(max, (uint16_t)level);
+        }
+    }
+
+    ScopeDecimStatus status;
+    ScopeDecim_GetStatus(&status);
+    CHECK_EQ(status.ratio, 1000U);
+    CHECK_EQ(status.frames, 1U);
+    CHECK_EQ(status.output_rate_hz, ADC_RATE_HZ / 1000U);
+}
+
+static void TestPassband(void)
+{
+    /* A tenth of the output rate keeps its amplitude within about 1%. */
+    CHECK(ScopeDecim_Configure(RATIO));
+    Tone tone = {.period = 10.0 * RATIO, .amplitude = 1500.0};
+    uint16_t frame[SCOPE_FRAME_SAMPLES];
+    Run(Sine, &tone, 2U, frame);
+    /* Ten outputs per cycle rarely land on the peaks, so take the amplitude
+       from the RMS over the 32 whole cycles in a frame. */
+    double sum = 0.0;
+    for (uint32_t i = 0U; i < SCOPE_FRAME_SAMPLES; ++i)
+    {
+        double ac = (double)frame[i] - 2048.0;
+        sum += ac * ac;
+    }
+    double amplitude = sqrt(2.0 * sum / SCOPE_FRAME_SAMPLES);
+    CHECK(fabs(amplitude - tone.amplitude) < 0.01 * tone.amplitude);
+}
+
+static void TestAliasRejection(void)
+{
+    /* Tones at the output rate and twice it sit in the CIC nulls and would
+       otherwise alias onto DC; near the null they are still strongly
+       attenuated. */
+    static const double periods[] = {RATIO, RATIO / 2.0, RATIO * 0.9};
+    static const uint16_t max_ripple[] = {2U, 2U, 20U};
+    uint16_t frame[SCOPE_FRAME_SAMPLES];
+    for (uint32_t p = 0U; p < sizeof(periods) / sizeof(periods[0]); ++p)
+    {
+        CHECK(ScopeDecim_Configure(RATIO));
+        Tone tone = {.period = periods[p], .amplitude = 2000.0};
+        Run(Sine, &tone, 2U, frame);
+        uint16_t min;
+        uint16_t max;
+        Span(frame, &min, &max);
+        CHECK(max - min <= max_ripple[p]);
+        CHECK(min >= 2038U && max <= 2058U);
+    }
+}
+
+int main(void)
+{
+    TestConfigure();
+    TestDcGain();
+    TestPassband();
+    TestAliasRejection();
+    return test_report("test_decim");
+}
@@ -0,0 +1,251 @@
+#include "scope_decode.h"
+
+#include "test_check.h"
+
+#include <string.h>
+
+enum
+{
+    FRAME = 320U,
+    MAX_FRAMES = 4U,
+    RATE_HZ = 96000U,
+    /* Ten samples per bit. */
+    BAUD = 9600U,
+    SAMPLES_PER_BIT = RATE_HZ / BAUD
+};
+
+/* Line level per sample, idle high. */
+typedef struct
+{
+    uint8_t level[MAX_FRAMES * FRAME];
+    uint32_t length;
+} Line;
+
+static void Line_Idle(Line *line, uint32_t samples)
+{
+    while (samples-- > 0U && line->length < MAX_FRAMES * FRAME)
+    {
+        line->level[line->length++] = 1U;
+    }
+}
+
+/* Start bit, eight data bits LSB first, stop bit. */
+static void Line_Byte(Line *line, uint8_t value, uint8_t stop_level)
+{
+    uint8_t bits[10];
+    bits[0] = 0U;
+    for (uint32_t i = 0U; i < 8U; ++i)
+    {
+        bits[i + 1U] = (uint8_t)((value >> i) & 1U);
+    }
+    bits[9] = stop_level;
+    for (uint32_t b = 0U; b < 10U; ++b)
+    {
+        for (uint32_t s = 0U; s < SAMPLES_PER_BIT && line->length < MAX_FRAMES * FRAME; ++s)
+        {
+            line->level[line->length++] = bits[b];
+        }
+    }
+}
+
+/* Crossings of one frame as ScopeSignal_FindCrossings would list them: the
+   level of the first sample, then every change at the sample it shows up. */
+static void Crossings(const Line *line, uint32_t first, ScopeSignalCrossings *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->initial_high = line->level[first];
+    for (uint32_t i = 1U; i < FRAME; ++i)
+    {
+        uint8_t now = line->level[first + i];
+        if (now != line->level[first + i - 1U] && out->count < SCOPE_SIGNAL_MAX_CROSSINGS)
+        {
+            out->edges[out->count].position_q8 = i << 8;
+            out->edges[out->count].rising = now;
+            out->count++;
+        }
+    }
+}
+
+static void Decode(const Line *line, uint32_t frame, uint8_t contiguous, ScopeDecodeFrame *out)
+{
+    ScopeSignalCrossings crossings;
+    Crossings(line, frame * FRAME, &crossings);
+    ScopeDecode_Process(&crossings, FRAME, 1U, contiguous, RATE_HZ, out);
+}
+
+static void Drain(void)
+{
+    ScopeDecodeByte byte;
+    while (ScopeDecode_PopStream(&byte))
+    {
+    }
+}
+
+static void TestBytesInOneFrame(void)
+{
+    Line line = {0};
+    Line_Idle(&line, 15U);
+    Line_Byte(&line, 0xA5U, 1U);
+    Line_Idle(&line, 7U);
+    Line_Byte(&line, 0x3CU, 1U);
+    Line_Idle(&line, MAX_FRAMES * FRAME);
+
+    ScopeDecode_Init();
+    CHECK(ScopeDecode_Configure(BAUD));
+    ScopeDecodeFrame out;
+    Decode(&line, 0U, 1U, &out);
+    CHECK_EQ(out.count, 2U);
+    CHECK_EQ(out.bytes[0].value, 0xA5U);
+    CHECK_EQ(out.bytes[0].framing_error, 0U);
+    CHECK_EQ(out.bytes[0].start_index, 15U);
+    CHECK_EQ(out.bytes[1].value, 0x3CU);
+    CHECK_EQ(out.bytes[1].framing_error, 0U);
+
+    ScopeDecodeByte byte;
+    CHECK(ScopeDecode_PopStream(&byte));
+    CHECK_EQ(byte.value, 0xA5U);
+    CHECK(ScopeDecode_PopStream(&byte));
+    CHECK_EQ(byte.value, 0x3CU);
+    CHECK(!ScopeDecode_PopStream(&byte));
+}
+
+static void TestByteAcrossFrames(void)
+{
+    /* The start bit lands 40 samples before the frame boundary, so the byte
+       is finished from the next frame's crossings. */
+    Line line = {0};
+    Line_Idle(&line, FRAME - 40U);
+    Line_Byte(&line, 0x5AU, 1U);
+    Line_Idle(&line, MAX_FRAMES * FRAME);
+
+    ScopeDecode_Init();
+    CHECK(ScopeDecode_Configure(BAUD));
+    ScopeDecodeFrame out;
+    Decode(&line, 0U, 1U, &out);
+    CHECK_EQ(out.count, 0U);
+    Decode(&line, 1U, 1U, &out);
+    CHECK_EQ(out.count, 1U);
+    CHECK_EQ(out.bytes[0].value, 0x5AU);
+    CHECK_EQ(out.bytes[0].framing_error, 0U);
+    /* Started in the previous frame: clamped to this frame's first sample. */
+    CHECK_EQ(out.bytes[0].start_index, 0U);
+
+    ScopeDecodeStatus status;
+    ScopeDecode_GetStatus(&status);
+    CHECK_EQ(status.bytes, 1U);
+    CHECK_EQ(status.resyncs, 0U);
+    Drain();
+}
+
+static void TestGapResyncs(void)
+{
+    /* Same line, but the frames are not contiguous: the half byte is
+       dropped instead of being joined to unrelated samples. */
+    Line line = {0};
+    Line_Idle(&line, FRAME - 40U);
+    Line_Byte(&line, 0x5AU, 1U);
+    Line_Idle(&line, MAX_FRAMES * FRAME);
+
+    ScopeDecode_Init();
+    CHECK(ScopeDecode_Configure(BAUD));
+    ScopeDecodeFrame out;
+    Decode(&line, 0U, 1U, &out);
+    Decode(&line, 1U, 0U, &out);
+    ScopeDecodeStatus status;
+    ScopeDecode_GetStatus(&status);
+    CHECK_EQ(status.resyncs, 1U);
+    CHECK(out.count == 0U || out.bytes[0].value != 0x5AU);
+    Drain();
+}
+
+static void TestFramingError(void)
+{
+    Line line = {0};
+    Line_Idle(&line, 20U);
+    Line_Byte(&line, 0x81U, 0U);
+    Line_Idle(&line, MAX_FRAMES * FRAME);
+
+    ScopeDecode_Init();
+    CHECK(ScopeDecode_Configure(BAUD));
+    ScopeDecodeFrame out;
+    Decode(&line, 0U, 1U, &out);
+    CHECK(out.count >= 1U);
+    CHECK_EQ(out.bytes[0].value, 0x81U);
+    CHECK_EQ(out.bytes[0].framing_error, 1U);
+    ScopeDecodeStatus status;
+    ScopeDecode_GetStatus(&status);
+    CHECK_EQ(status.framing_errors, 1U);
+    Drain();
+}
+
+static void TestRateTooLow(void)
+{
+    /* Fewer than eight samples per bit: nothing is decoded and the status
+       says why. */
+    Line line = {0};
+    Line_Idle(&line, 20U);
+    Line_Byte(&line, 0x55U, 1U);
+    Line_Idle(&line, MAX_FRAMES * FRAME);
+
+    ScopeDecode_Init();
+    CHECK(ScopeDecode_Configure(RATE_HZ / 4U));
+    ScopeDecodeFrame out;
+    Decode(&line, 0U, 1U, &out);
+    CHECK_EQ(out.count, 0U);
+    ScopeDecodeStatus status;
+    ScopeDecode_GetStatus(&status);
+    CHECK_EQ(status.rate_ok, 0U);
+    CHECK_EQ(status.bytes, 0U);
+}
+
+static void TestStreamOverflow(void)
+{
+    /* The same line played eight times gives more bytes than the stream
+       holds; nothing is popped until the end, so the excess must be counted
+       rather than written over unread bytes. */
+    Line line = {0};
+    Line_Idle(&line, 2U);
+    while (line.length + 10U * SAMPLES_PER_BIT + 2U <= MAX_FRAMES * FRAME)
+    {
+        Line_Byte(&line, 0x11U, 1U);
+        Line_Idle(&line, 2U);
+    }
+    Line_Idle(&line, MAX_FRAMES * FRAME);
+
+    ScopeDecode_Init();
+    CHECK(ScopeDecode_Configure(BAUD));
+    ScopeDecodeFrame out;
+    uint32_t decoded = 0U;
+    for (uint32_t pass = 0U; pass < 8U; ++pass)
+    {
+        for (uint32_t frame = 0U; frame < MAX_FRAMES; ++frame)
+        {
+            Decode(&line, frame, 1U, &out);
+            decoded += out.count;
+        }
+    }
+    ScopeDecodeStatus status;
+    ScopeDecode_GetStatus(&status);
+    CHECK_EQ(status.bytes, decoded);
+    CHECK(status.stream_drops > 0U);
+
+    uint32_t popped = 0U;
+    ScopeDecodeByte byte;
+    while (ScopeDecode_PopStream(&byte))
+    {
+        CHECK_EQ(byte.value, 0x11U);
+        popped++;
+    }
+    CHECK_EQ(popped + status.stream_drops, status.bytes);
+}
+
+int main(void)
+{
+    TestBytesInOneFrame();
+    TestByteAcrossFrames();
+    TestGapResyncs();
+    TestFramingError();
+    TestRateTooLow();
+    TestStreamOverflow();
+    return test_report("test_decode");
+}
@@ -0,0 +1,143 @@
+#include "scope_events.h"
+
+#include "test_check.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+enum
+{
+    PRODUCERS = 4U,
+    PUSHES_PER_PRODUCER = 200000U
+};
+
+typedef struct
+{
+    uint8_t id;
+    uint32_t accepted;
+    uint32_t rejected;
+} Producer;
+
+static ScopeEventRing ring;
+static atomic_uint producers_done;
+
+/* Each producer numbers the events the ring accepted from it, so the
+   consumer must see exactly 0, 1, 2, ... from every producer. */
+static void *Produce(void *arg)
+{
+    Producer *p = arg;
+    for (uint32_t i = 0U; i < PUSHES_PER_PRODUCER; ++i)
+    {
+        if (ScopeEvents_Push(&ring, p->id, (int8_t)p->id, p->accepted))
+        {
+            p->accepted++;
+        }
+        else
+        {
+            p->rejected++;
+        }
+        if ((i & 0x7U) == 0U)
+        {
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(&producers_done, 1U);
+    return NULL;
+}
+
+static void TestConcurrentProducers(void)
+{
+    pthread_t threads[PRODUCERS];
+    Producer producers[PRODUCERS];
+    uint32_t next[PRODUCERS] = {0};
+    uint32_t out_of_order = 0U;
+    uint32_t foreign = 0U;
+
+    ScopeEvents_Init(&ring);
+    atomic_init(&producers_done, 0U);
+    for (uint32_t i = 0U; i < PRODUCERS; ++i)
+    {
+        producers[i] = (Producer){.id = (uint8_t)i};
+        CHECK_EQ(pthread_create(&threads[i], NULL, Produce, &producers[i]), 0);
+    }
+
+    /* Single consumer; it stalls now and then so the ring fills up. */
+    uint32_t popped = 0U;
+    for (;;)
+    {
+        uint8_t finished = (atomic_load(&producers_done) == PRODUCERS) ? 1U : 0U;
+        ScopeEvent event;
+        uint8_t got = 0U;
+        while (ScopeEvents_Pop(&ring, &event))
+        {
+            got = 1U;
+            popped++;
+            if (event.type >= PRODUCERS || event.arg != (int8_t)event.type)
+            {
+                foreign++;
+                continue;
+            }
+            if (event.timestamp_ms != next[event.type])
+            {
+                out_of_order++;
+            }
+            next[event.type] = event.timestamp_ms + 1U;
+            if ((popped & 0x3FFU) == 0U)
+            {
+                sched_yield();
+            }
+        }
+        if (finished && !got)
+        {
+            break;
+        }
+    }
+
+    uint32_t rejected = 0U;
+    for (uint32_t i = 0U; i < PRODUCERS; ++i)
+    {
+        CHECK_EQ(pthread_join(threads[i], NULL), 0);
+        CHECK_EQ(next[i], producers[i].accepted);
+        rejected += producers[i].rejected;
+    }
+    CHECK_EQ(foreign, 0U);
+    CHECK_EQ(out_of_order, 0U);
+    CHECK_EQ(ScopeEvents_Dropped(&ring), rejected);
+    printf("test_events: %u popped, %u dropped\n", (unsigned int)popped, (unsigned int)rejected);
+}
+
+static void TestFullRing(void)
+{
+    ScopeEvents_Init(&ring);
+    for (uint32_t i = 0U; i < SCOPE_EVENT_RING_SIZE; ++i)
+    {
+        CHECK(ScopeEvents_Push(&ring, SCOPE_EVENT_ZOOM_TIME, 1, i));
+    }
+    CHECK(!ScopeEvents_Push(&ring, SCOPE_EVENT_ZOOM_TIME, 1, 99U));
+    CHECK(!ScopeEvents_Push(&ring, SCOPE_EVENT_ZOOM_TIME, 1, 99U));
+    CHECK_EQ(ScopeEvents_Dropped(&ring), 2U);
+
+    ScopeEvent event;
+    CHECK(ScopeEvents_Pop(&ring, &event));
+    CHECK_EQ(event.timestamp_ms, 0U);
+    CHECK(ScopeEvents_Push(&ring, SCOPE_EVENT_VIEW, 2, 100U));
+    for (uint32_t i = 1U; i < SCOPE_EVENT_RING_SIZE; ++i)
+    {
+        CHECK(ScopeEvents_Pop(&ring, &event));
+        CHECK_EQ(event.timestamp_ms, i);
+    }
+    CHECK(ScopeEvents_Pop(&ring, &event));
+    CHECK_EQ(event.type, SCOPE_EVENT_VIEW);
+    CHECK_EQ(event.arg, 2);
+    CHECK_EQ(event.timestamp_ms, 100U);
+    CHECK(!ScopeEvents_Pop(&ring, &event));
+    CHECK_EQ(ScopeEvents_Dropped(&ring), 2U);
+}
+
+int main(void)
+{
+    TestFullRing();
+    TestConcurrentProducers();
+    return test_report("test_events");
+}
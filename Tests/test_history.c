@@ -0,0 +1,158 @@
+#include "scope_history.h"
+
+#include "test_check.h"
+
+#include <string.h>
+
+enum
+{
+    RATE_HZ = 100000U
+};
+
+/* A different pseudo-random 12-bit frame for every sequence number. */
+static void Frame(uint32_t sequence, uint16_t *samples)
+{
+    uint32_t state = sequence * 2654435761U + 1U;
+    for (uint32_t i = 0U; i < SCOPE_FRAME_SAMPLES; ++i)
+    {
+        state = state * 1664525U + 1013904223U;
+        samples[i] = (uint16_t)(state >> 20);
+    }
+}
+
+static void Push(uint32_t sequence, uint16_t count, uint32_t rate_hz)
+{
+    uint16_t samples[SCOPE_FRAME_SAMPLES];
+    Frame(sequence, samples);
+    ScopeHistoryInfo info = {
+        .sequence = sequence,
+        .sample_count = count,
+        .trigger_index = (uint16_t)(sequence % SCOPE_FRAME_SAMPLES),
+        .frame_min = 0U,
+        .frame_max = 4095U
+    };
+    ScopeHistory_Push(samples, &info, rate_hz);
+}
+
+static void TestPackRoundTrip(void)
+{
+    /* Every 12-bit value in both halves of a packed pair. */
+    ScopeHistory_Init();
+    for (uint32_t base = 0U; base < 4096U; base += SCOPE_FRAME_SAMPLES)
+    {
+        uint16_t samples[SCOPE_FRAME_SAMPLES];
+        for (uint32_t i = 0U; i < SCOPE_FRAME_SAMPLES; ++i)
+        {
+            samples[i] = (uint16_t)((base + i) & 0x0FFFU);
+        }
+        ScopeHistoryInfo info = {.sequence = base, .sample_count = SCOPE_FRAME_SAMPLES};
+        ScopeHistory_Push(samples, &info, RATE_HZ);
+
+        uint16_t back[SCOPE_FRAME_SAMPLES];
+        CHECK(ScopeHistory_Get(0U, back, NULL));
+        CHECK(memcmp(samples, back, sizeof(samples)) == 0);
+        for (uint32_t i = 0U; i < SCOPE_FRAME_SAMPLES; ++i)
+        {
+            samples[i] = (uint16_t)(0x0FFFU - samples[i]);
+        }
+        ScopeHistory_Push(samples, &info, RATE_HZ);
+        CHECK(ScopeHistory_Get(0U, back, NULL));
+        CHECK(memcmp(samples, back, sizeof(samples)) == 0);
+    }
+}
+
+static void TestOddCountAndRange(void)
+{
+    /* An odd count leaves the last sample alone in its pair. */
+    ScopeHistory_Init();
+    Push(7U, SCOPE_FRAME_SAMPLES - 1U, RATE_HZ);
+
+    uint16_t expect[SCOPE_FRAME_SAMPLES];
+    Frame(7U, expect);
+    uint16_t back[SCOPE_FRAME_SAMPLES];
+    ScopeHistoryInfo info;
+    CHECK(ScopeHistory_Get(0U, back, &info));
+    CHECK_EQ(info.sample_count, SCOPE_FRAME_SAMPLES - 1U);
+    CHECK_EQ(info.sequence, 7U);
+    CHECK(memcmp(expect, back, (SCOPE_FRAME_SAMPLES - 1U) * sizeof(back[0])) == 0);
+
+    /* Ranges starting on either half of a pair read the same values. */
+    for (uint16_t first = 0U; first < 6U; ++first)
+    {
+        uint16_t range[64];
+        CHECK(ScopeHistory_GetRange(0U, first, 64U, range));
+        CHECK(memcmp(&expect[first], range, sizeof(range)) == 0);
+    }
+    uint16_t range[2];
+    CHECK(ScopeHistory_GetRange(0U, SCOPE_FRAME_SAMPLES - 2U, 1U, range));
+    CHECK_EQ(range[0], expect[SCOPE_FRAME_SAMPLES - 2U]);
+    CHECK(!ScopeHistory_GetRange(0U, SCOPE_FRAME_SAMPLES - 2U, 2U, range));
+    CHECK(!ScopeHistory_GetRange(1U, 0U, 1U, range));
+}
+
+static void TestRingOrder(void)
+{
+    ScopeHistory_Init();
+    uint16_t depth = ScopeHistory_Depth();
+    CHECK(depth * (sizeof(ScopeHistoryInfo) + SCOPE_HISTORY_PACKED_BYTES) <= SCOPE_HISTORY_BYTES);
+    CHECK_EQ(ScopeHistory_Count(), 0U);
+    CHECK(!ScopeHistory_Get(0U, NULL, NULL));
+
+    uint32_t pushed = depth + 5U;
+    for (uint32_t seq = 1U; seq <= pushed; ++seq)
+    {
+        Push(seq, SCOPE_FRAME_SAMPLES, RATE_HZ);
+    }
+    CHECK_EQ(ScopeHistory_Count(), depth);
+
+    /* Age 0 is the newest; the oldest five were overwritten. */
+    for (uint16_t age = 0U; age < depth; age = (uint16_t)(age + 13U))
+    {
+        ScopeHistoryInfo info;
+        uint16_t back[SCOPE_FRAME_SAMPLES];
+        uint16_t expect[SCOPE_FRAME_SAMPLES];
+        CHECK(ScopeHistory_Get(age, back, &info));
+        CHECK_EQ(info.sequence, pushed - age);
+        CHECK_EQ(info.trigger_index, (pushed - age) % SCOPE_FRAME_SAMPLES);
+        Frame(pushed - age, expect);
+        CHECK(memcmp(expect, back, sizeof(back)) == 0);
+    }
+    ScopeHistoryInfo info;
+    CHECK(ScopeHistory_Get((uint16_t)(depth - 1U), NULL, &info));
+    CHECK_EQ(info.sequence, 6U);
+    CHECK(!ScopeHistory_Get(depth, NULL, &info));
+}
+
+static void TestRateChangeAndLimits(void)
+{
+    ScopeHistory_Init();
+    Push(1U, SCOPE_FRAME_SAMPLES, RATE_HZ);
+    Push(2U, SCOPE_FRAME_SAMPLES, RATE_HZ);
+    CHECK_EQ(ScopeHistory_Count(), 2U);
+
+    /* Frames from the old timebase go once the rate changes. */
+    Push(3U, SCOPE_FRAME_SAMPLES, RATE_HZ * 2U);
+    CHECK_EQ(ScopeHistory_Count(), 1U);
+    ScopeHistoryInfo info;
+    CHECK(ScopeHistory_Get(0U, NULL, &info));
+    CHECK_EQ(info.sequence, 3U);
+
+    /* Empty frames are ignored, oversized ones clamped. */
+    Push(4U, 0U, RATE_HZ * 2U);
+    CHECK_EQ(ScopeHistory_Count(), 1U);
+    Push(5U, SCOPE_FRAME_SAMPLES + 10U, RATE_HZ * 2U);
+    CHECK(ScopeHistory_Get(0U, NULL, &info));
+    CHECK_EQ(info.sample_count, SCOPE_FRAME_SAMPLES);
+
+    ScopeHistory_Reset();
+    CHECK_EQ(ScopeHistory_Count(), 0U);
+}
+
+int main(void)
+{
+    TestPackRoundTrip();
+    TestOddCountAndRange();
+    TestRingOrder();
+    TestRateChangeAndLimits();
+    return test_report("test_history");
+}
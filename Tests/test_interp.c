@@ -0,0 +1,137 @@
+#include "scope_interp.h"
+
+#include "test_check.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+enum
+{
+    /* Sixteen cycles of eight samples: the record is periodic, so a wrapped
+       tap sees the same value the signal would have had. */
+    SAMPLES_PER_CYCLE = 8U,
+    RECORD = 16U * SAMPLES_PER_CYCLE,
+    /* Sinc phases are in 1/64 sample steps. */
+    PHASE_STEP_Q16 = 65536U / 64U
+};
+
+static const double center = 2048.0;
+static const double amplitude = 1500.0;
+
+static double Sine(double position)
+{
+    return center + amplitude * sin(2.0 * M_PI * position / SAMPLES_PER_CYCLE);
+}
+
+static void BuildSine(uint16_t *samples)
+{
+    for (uint32_t i = 0U; i < RECORD; ++i)
+    {
+        samples[i] = (uint16_t)floor(Sine((double)i) + 0.5);
+    }
+}
+
+static void TestOffAndWholeSamples(void)
+{
+    uint16_t samples[RECORD];
+    BuildSine(samples);
+
+    ScopeInterp_SetMode(SCOPE_INTERP_OFF);
+    CHECK_EQ(ScopeInterp_GetMode(), SCOPE_INTERP_OFF);
+    CHECK_EQ(ScopeInterp_Sample(samples, RECORD, 5U, 40000U), samples[5]);
+    /* Past the end clamps to the last sample. */
+    CHECK_EQ(ScopeInterp_Sample(samples, RECORD, RECORD + 3U, 0U), samples[RECORD - 1U]);
+    CHECK_EQ(ScopeInterp_Sample(NULL, RECORD, 0U, 0U), 0);
+
+    ScopeInterp_SetMode((ScopeInterpMode)7);
+    CHECK_EQ(ScopeInterp_GetMode(), SCOPE_INTERP_OFF);
+
+    /* On a sample every mode returns it unchanged. */
+    ScopeInterp_SetMode(SCOPE_INTERP_SINC);
+    for (uint32_t i = 0U; i < RECORD; ++i)
+    {
+        CHECK_EQ(ScopeInterp_Sample(samples, RECORD, (uint16_t)i, 0U), samples[i]);
+    }
+}
+
+static void TestSincTracksSine(void)
+{
+    /* At 8 samples per cycle the windowed sinc stays within three counts
+       of the true curve everywhere, the seam included; the straight
+       line between samples misses the crests by tens of counts. */
+    uint16_t samples[RECORD];
+    BuildSine(samples);
+    double sinc_error = 0.0;
+    double linear_error = 0.0;
+    for (uint32_t i = 0U; i < RECORD; ++i)
+    {
+        for (uint32_t frac = PHASE_STEP_Q16; frac < 65536U; frac += PHASE_STEP_Q16)
+        {
+            double truth = Sine((double)i + (double)frac / 65536.0);
+            ScopeInterp_SetMode(SCOPE_INTERP_SINC);
+            double e = fabs((double)ScopeInterp_Sample(samples, RECORD, (uint16_t)i, frac) - truth);
+            sinc_error = (e > sinc_error) ? e : sinc_error;
+            ScopeInterp_SetMode(SCOPE_INTERP_LINEAR);
+            e = fabs((double)ScopeInterp_Sample(samples, RECORD, (uint16_t)i, frac) - truth);
+            linear_error = (e > linear_error) ? e : linear_error;
+        }
+    }
+    CHECK(sinc_error < 3.0);
+    CHECK(linear_error > 50.0);
+}
+
+static void TestSeamWraps(void)
+{
+    /* The last sample is drawn next to sample 0, so both modes interpolate
+       towards it rather than towards a repeated end sample. */
+    uint16_t samples[16];
+    for (uint32_t i = 0U; i < 16U; ++i)
+    {
+        samples[i] = 1000U;
+    }
+    samples[15] = 2000U;
+    samples[0] = 0U;
+
+    ScopeInterp_SetMode(SCOPE_INTERP_LINEAR);
+    CHECK_EQ(ScopeInterp_Sample(samples, 16U, 15U, 32768U), 1000);
+    CHECK_EQ(ScopeInterp_Sample(samples, 16U, 14U, 32768U), 1500);
+
+    /* The sinc midpoint is symmetric about the seam as well: the taps on
+       either side are mirror images around 1000. */
+    ScopeInterp_SetMode(SCOPE_INTERP_SINC);
+    CHECK(abs(ScopeInterp_Sample(samples, 16U, 15U, 32768U) - 1000) <= 1);
+}
+
+static void TestFlatStaysFlat(void)
+{
+    /* Every phase row has unity gain, also on records shorter than the
+       eight taps, where one sample is used several times. */
+    uint16_t flat[RECORD];
+    for (uint32_t i = 0U; i < RECORD; ++i)
+    {
+        flat[i] = 500U;
+    }
+    static const uint16_t lengths[] = {1U, 4U, 9U, RECORD};
+    ScopeInterp_SetMode(SCOPE_INTERP_SINC);
+    for (uint32_t l = 0U; l < sizeof(lengths) / sizeof(lengths[0]); ++l)
+    {
+        for (uint16_t i = 0U; i < lengths[l]; ++i)
+        {
+            for (uint32_t frac = 0U; frac < 65536U; frac += 4099U)
+            {
+                CHECK_EQ(ScopeInterp_Sample(flat, lengths[l], i, frac), 500);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    ScopeInterp_Init();
+    CHECK_EQ(ScopeInterp_GetMode(), SCOPE_INTERP_SINC);
+    TestOffAndWholeSamples();
+    TestSincTracksSine();
+    TestSeamWraps();
+    TestFlatStaysFlat();
+    return test_report("test_interp");
+}
@@ -0,0 +1,200 @@
+#include "scope_jitter.h"
+
+#include "scope_signal.h"
+#include "test_check.h"
+
+#include <math.h>
+
+enum
+{
+    CHUNK = 256U,
+    ADC_RATE_HZ = 1000000U,
+    LEVEL_LOW = 1000U,
+    LEVEL_HIGH = 3000U,
+    /* Edges ramp linearly over this many samples, so interpolating the
+       mid-level crossing between two samples is exact. */
+    RAMP_SAMPLES = 4U,
+    SIGNAL_SAMPLES = 96U * 1024U
+};
+
+/* 25.3 samples: 25.3 us at 1 MHz. */
+static const double period_samples = 25.3;
+
+static uint32_t adc_rate_hz = ADC_RATE_HZ;
+static uint16_t signal[SIGNAL_SAMPLES];
+
+/* Stand-in for the rate bookkeeping in scope_signal.c. */
+uint32_t ScopeSignal_GetAdcRateHz(void)
+{
+    return adc_rate_hz;
+}
+
+static double Ramp(double x)
+{
+    x = x / RAMP_SAMPLES + 0.5;
+    return (x < 0.0) ? 0.0 : ((x > 1.0) ? 1.0 : x);
+}
+
+/* Pseudo-random in [-1, 1), the same every run. */
+static double Noise(uint32_t *state)
+{
+    *state = *state * 1664525U + 1013904223U;
+    return (double)(*state >> 8) / (double)(1U << 23) - 1.0;
+}
+
+/* Pulse train whose rising edges sit at k * period plus up to +-jitter
+   samples; returns the number of rising edges. */
+static uint32_t BuildSignal(double jitter)
+{
+    uint32_t seed = 12345U;
+    uint32_t edges = 0U;
+    for (uint32_t n = 0U; n < SIGNAL_SAMPLES; ++n)
+    {
+        signal[n] = LEVEL_LOW;
+    }
+    for (uint32_t k = 1U;; ++k)
+    {
+        double rise = (double)k * period_samples + jitter * Noise(&seed);
+        double fall = rise + period_samples / 2.0;
+        if (fall + RAMP_SAMPLES >= SIGNAL_SAMPLES)
+        {
+            break;
+        }
+        for (uint32_t n = (uint32_t)(rise - RAMP_SAMPLES); n <= (uint32_t)(fall + RAMP_SAMPLES); ++n)
+        {
+            double a = Ramp((double)n - rise);
+            double b = Ramp(fall - (double)n);
+            double level = LEVEL_LOW + (LEVEL_HIGH - LEVEL_LOW) * ((a < b) ? a : b);
+            signal[n] = (uint16_t)floor(level + 0.5);
+        }
+        edges++;
+    }
+    return edges;
+}
+
+/* Streams the signal in DMA-sized chunks, servicing every `service_every`
+   chunks (0: only at the end). */
+static void Feed(uint32_t service_every)
+{
+    uint32_t chunks = 0U;
+    for (uint32_t n = 0U; n + CHUNK <= SIGNAL_SAMPLES; n += CHUNK)
+    {
+        ScopeJitter_ProcessFromISR(&signal[n], CHUNK);
+        if (service_every != 0U && ++chunks % service_every == 0U)
+        {
+            ScopeJitter_Service();
+        }
+    }
+    ScopeJitter_Service();
+}
+
+static void TestCleanClock(void)
+{
+    uint32_t edges = BuildSignal(0.0);
+    ScopeJitter_Init();
+    ScopeJitter_SetEnabled(1U);
+    Feed(1U);
+
+    ScopeJitterStatus status;
+    ScopeJitter_GetStatus(&status);
+    CHECK_EQ(status.adc_rate_hz, ADC_RATE_HZ);
+    CHECK_EQ(status.dropped, 0U);
+    CHECK_EQ(status.scaled, 1U);
+    /* Edges in the first buffer are missed while the levels are learned. */
+    CHECK(status.edges + CHUNK / 25U >= edges && status.edges <= edges);
+    CHECK(status.tie_count >= SCOPE_JITTER_BLOCK_EDGES * 20U);
+    CHECK(fabs(status.period_ns - 25300.0) < 0.5);
+    /* Only the Q8 timestamp rounding, 1/256 of a sample, is left. */
+    CHECK(status.tie_rms_ns < 3.0f);
+    CHECK(status.period_sd_ns < 5.0f);
+
+    float trend[SCOPE_JITTER_TREND_POINTS];
+    uint16_t points = ScopeJitter_GetTrend(trend, SCOPE_JITTER_TREND_POINTS);
+    CHECK_EQ(points, SCOPE_JITTER_TREND_POINTS);
+    for (uint16_t i = 0U; i < points; ++i)
+    {
+        CHECK(fabsf(trend[i]) < 8.0f);
+    }
+}
+
+static void TestKnownJitter(void)
+{
+    /* Uniform +-0.5 samples: 500 / sqrt(3) = 289 ns RMS and a period
+       deviation sqrt(2) times that. Each block is measured against its own
+       fitted line, whose error adds a little to the 1 us peak to peak. */
+    BuildSignal(0.5);
+    ScopeJitter_Init();
+    ScopeJitter_SetEnabled(1U);
+    Feed(1U);
+
+    ScopeJitterStatus status;
+    ScopeJitter_GetStatus(&status);
+    CHECK(fabs(status.period_ns - 25300.0) < 10.0);
+    CHECK(fabs(status.tie_rms_ns - 288.7) < 0.05 * 288.7);
+    CHECK(status.tie_pp_ns > 900.0f && status.tie_pp_ns < 1250.0f);
+    CHECK(fabs(status.period_sd_ns - 408.2) < 0.05 * 408.2);
+
+    /* The histogram holds every TIE sample. */
+    const uint32_t *hist = ScopeJitter_Histogram();
+    uint32_t total = 0U;
+    for (uint32_t i = 0U; i < SCOPE_JITTER_BINS; ++i)
+    {
+        total += hist[i];
+    }
+    CHECK_EQ(total, status.tie_count);
+}
+
+static void TestOverflowResyncs(void)
+{
+    /* Without servicing, the ring fills: the excess edges are counted and
+       the analysis restarts after the gap instead of measuring across it. */
+    uint32_t edges = BuildSignal(0.0);
+    CHECK(edges > 1024U);
+    ScopeJitter_Init();
+    ScopeJitter_SetEnabled(1U);
+    Feed(0U);
+
+    ScopeJitterStatus status;
+    ScopeJitter_GetStatus(&status);
+    CHECK(status.dropped > 0U);
+    CHECK(status.edges < edges);
+
+    ScopeJitter_Service();
+    Feed(1U);
+    ScopeJitter_GetStatus(&status);
+    CHECK(status.resyncs >= 1U);
+    CHECK(fabs(status.period_ns - 25300.0) < 0.5);
+}
+
+static void TestRateChange(void)
+{
+    BuildSignal(0.0);
+    ScopeJitter_Init();
+    ScopeJitter_SetEnabled(1U);
+    Feed(1U);
+    ScopeJitterStatus status;
+    ScopeJitter_GetStatus(&status);
+    uint32_t generation = status.generation;
+    CHECK(status.edges > 0U);
+
+    /* Timestamps counted at the old rate mean nothing at the new one. */
+    adc_rate_hz = ADC_RATE_HZ / 2U;
+    ScopeJitter_Service();
+    ScopeJitter_GetStatus(&status);
+    CHECK(status.generation != generation);
+    CHECK_EQ(status.edges, 0U);
+    CHECK_EQ(status.adc_rate_hz, ADC_RATE_HZ / 2U);
+    adc_rate_hz = ADC_RATE_HZ;
+
+    ScopeJitter_SetEnabled(0U);
+    CHECK_EQ(ScopeJitter_IsEnabled(), 0U);
+}
+
+int main(void)
+{
+    TestCleanClock();
+    TestKnownJitter();
+    TestOverflowResyncs();
+    TestRateChange();
+    return test_report("test_jitter");
+}
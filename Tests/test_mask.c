@@ -0,0 +1,143 @@
+#include "scope_mask.h"
+
+#include "test_check.h"
+
+#include <string.h>
+
+enum
+{
+    COLUMNS = 101U,
+    LOW = 500U,
+    HIGH = 3000U,
+    STEP_COLUMN = 50U,
+    TOLERANCE_COUNTS = 100U
+};
+
+static uint16_t column_map[SCOPE_MASK_COLUMNS];
+
+static const ScopeMaskWindow window = {
+    .sample_rate_hz = 100000U,
+    .samples_visible = COLUMNS,
+    .center_sample = 0
+};
+
+/* A step from LOW to HIGH at the given column, one sample per column. */
+static void Step(uint16_t *samples, uint16_t edge)
+{
+    for (uint16_t i = 0U; i < COLUMNS; i++)
+    {
+        samples[i] = (i < edge) ? LOW : HIGH;
+    }
+}
+
+static void Setup(uint16_t tolerance_columns)
+{
+    uint16_t reference[COLUMNS];
+    for (uint16_t i = 0U; i < SCOPE_MASK_COLUMNS; i++)
+    {
+        column_map[i] = (i < COLUMNS) ? i : 0U;
+    }
+    Step(reference, STEP_COLUMN);
+    ScopeMask_Init();
+    CHECK(ScopeMask_Build(reference, column_map, COLUMNS, &window, TOLERANCE_COUNTS, tolerance_columns));
+    ScopeMask_SetEnabled(1U);
+}
+
+static void TestNeedsBuild(void)
+{
+    ScopeMask_Init();
+    ScopeMask_SetEnabled(1U);
+    CHECK_EQ(ScopeMask_IsEnabled(), 0U);
+    uint16_t samples[COLUMNS];
+    Step(samples, STEP_COLUMN);
+    CHECK(!ScopeMask_Build(samples, column_map, 0U, &window, 0U, 0U));
+    CHECK(!ScopeMask_Build(samples, column_map, SCOPE_MASK_COLUMNS + 1U, &window, 0U, 0U));
+}
+
+static void TestPassAndFail(void)
+{
+    Setup(0U);
+    uint16_t samples[COLUMNS];
+
+    /* The captured frame and one within the count tolerance pass. */
+    Step(samples, STEP_COLUMN);
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 0U);
+    for (uint16_t i = 0U; i < COLUMNS; i++)
+    {
+        samples[i] = (uint16_t)(samples[i] + TOLERANCE_COUNTS);
+    }
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 0U);
+
+    /* One column just outside, below the band; and the last, odd column
+       above it, which must not be hidden by the padding half. */
+    Step(samples, STEP_COLUMN);
+    samples[10] = LOW - TOLERANCE_COUNTS - 1U;
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 1U);
+    ScopeMaskStatus status;
+    ScopeMask_GetStatus(&status);
+    CHECK_EQ(status.last_fail_columns, 1U);
+
+    Step(samples, STEP_COLUMN);
+    samples[COLUMNS - 1U] = HIGH + TOLERANCE_COUNTS + 1U;
+    samples[11] = 0U;
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 1U);
+    ScopeMask_GetStatus(&status);
+    CHECK_EQ(status.last_fail_columns, 2U);
+    CHECK_EQ(status.tested, 4U);
+    CHECK_EQ(status.passed, 2U);
+    CHECK_EQ(status.failed, 2U);
+
+    ScopeMask_ResetCounters();
+    ScopeMask_GetStatus(&status);
+    CHECK_EQ(status.tested, 0U);
+    CHECK_EQ(status.last_fail_columns, 0U);
+}
+
+static void TestColumnTolerance(void)
+{
+    /* A step one column late fails a tight mask but not one widened by a
+       neighbouring column. */
+    uint16_t samples[COLUMNS];
+    Step(samples, STEP_COLUMN + 1U);
+
+    Setup(0U);
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 1U);
+    ScopeMaskStatus status;
+    ScopeMask_GetStatus(&status);
+    CHECK_EQ(status.last_fail_columns, 1U);
+
+    Setup(1U);
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 0U);
+    Step(samples, STEP_COLUMN + 2U);
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 1U);
+}
+
+static void TestWindowMismatch(void)
+{
+    Setup(0U);
+    uint16_t samples[COLUMNS];
+    memset(samples, 0, sizeof(samples));
+
+    ScopeMaskWindow moved = window;
+    moved.center_sample = 10;
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &moved), 0U);
+    ScopeMaskStatus status;
+    ScopeMask_GetStatus(&status);
+    CHECK_EQ(status.window_mismatch, 1U);
+    CHECK_EQ(status.tested, 0U);
+
+    /* Back at the captured window the frame is tested again. */
+    CHECK_EQ(ScopeMask_Test(samples, column_map, COLUMNS, &window), 1U);
+    ScopeMask_GetStatus(&status);
+    CHECK_EQ(status.window_mismatch, 0U);
+    CHECK_EQ(status.tested, 1U);
+}
+
+int main(void)
+{
+    TestNeedsBuild();
+    TestPassAndFail();
+    TestColumnTolerance();
+    TestWindowMismatch();
+    return test_report("test_mask");
+}
@@ -0,0 +1,201 @@
+#include "scope_record.h"
+
+#include "scope_history.h"
+#include "test_check.h"
+
+#include <string.h>
+
+enum
+{
+    RATE_HZ = 100000U,
+    FRAMES = 40U,
+    COLUMNS = SCOPE_FRAME_SAMPLES,
+    RECORD_SAMPLES = FRAMES * SCOPE_FRAME_SAMPLES
+};
+
+/* The record the history should yield, oldest sample first. */
+static uint16_t expect[RECORD_SAMPLES];
+
+/* Noise with a rare spike, so a min or max lives in a single sample and a
+   missed one shows. */
+static void Frame(uint32_t sequence, uint16_t *samples)
+{
+    uint32_t state = sequence * 2654435761U + 7U;
+    for (uint32_t i = 0U; i < SCOPE_FRAME_SAMPLES; ++i)
+    {
+        state = state * 1664525U + 1013904223U;
+        uint32_t r = state >> 16;
+        samples[i] = (uint16_t)(1500U + (r & 0x3FFU));
+        if ((r & 0xF800U) == 0U)
+        {
+            samples[i] = (r & 0x0400U) ? (uint16_t)(4095U - (r & 0xFFU)) : (uint16_t)(r & 0xFFU);
+        }
+    }
+}
+
+static void Push(uint32_t sequence)
+{
+    uint16_t samples[SCOPE_FRAME_SAMPLES];
+    Frame(sequence, samples);
+    ScopeHistoryInfo info = {.sequence = sequence, .sample_count = SCOPE_FRAME_SAMPLES};
+    ScopeHistory_Push(samples, &info, RATE_HZ);
+}
+
+/* History holding a gap, FRAMES consecutive frames 101..140, another gap
+   and three newer frames: age 3 is the newest frame of the run. */
+static void Setup(void)
+{
+    ScopeHistory_Init();
+    Push(10U);
+    Push(11U);
+    for (uint32_t seq = 101U; seq < 101U + FRAMES; ++seq)
+    {
+        Push(seq);
+        Frame(seq, &expect[(seq - 101U) * SCOPE_FRAME_SAMPLES]);
+    }
+    Push(151U);
+    Push(152U);
+    Push(153U);
+    ScopeRecord_Clear();
+}
+
+static uint32_t Rand(uint32_t *state)
+{
+    *state = *state * 1664525U + 1013904223U;
+    return *state >> 8;
+}
+
+/* Column map like the display's: visible samples spread over the columns
+   from start, wrapping at the end of the record. */
+static void ColumnMap(uint16_t *map, uint32_t start, uint32_t visible, uint32_t length)
+{
+    for (uint32_t i = 0U; i < COLUMNS; ++i)
+    {
+        map[i] = (uint16_t)((start + i * visible / COLUMNS) % length);
+    }
+}
+
+static void BruteEnvelope(const uint16_t *map, uint32_t visible, uint32_t length,
+                          uint16_t *column_min, uint16_t *column_max)
+{
+    uint32_t window_end = (map[0] + visible) % length;
+    for (uint32_t i = 0U; i < COLUMNS; ++i)
+    {
+        uint32_t next = (i + 1U < COLUMNS) ? map[i + 1U] : window_end;
+        uint32_t count = (next + length - map[i]) % length;
+        count = (count == 0U) ? 1U : count;
+        column_min[i] = 0xFFFFU;
+        column_max[i] = 0U;
+        for (uint32_t k = 0U; k < count; ++k)
+        {
+            uint16_t v = expect[(map[i] + k) % length];
+            column_min[i] = (v < column_min[i]) ? v : column_min[i];
+            column_max[i] = (v > column_max[i]) ? v : column_max[i];
+        }
+    }
+}
+
+static void TestBuildJoinsRun(void)
+{
+    Setup();
+    CHECK_EQ(ScopeRecord_Build(3U), FRAMES);
+    ScopeRecordStatus status;
+    ScopeRecord_GetStatus(&status);
+    CHECK_EQ(status.frames, FRAMES);
+    CHECK_EQ(status.newest_age, 3U);
+    CHECK_EQ(ScopeRecord_Length(), RECORD_SAMPLES);
+
+    CHECK(!ScopeRecord_Contains(2U));
+    CHECK(ScopeRecord_Contains(3U));
+    CHECK(ScopeRecord_Contains(3U + FRAMES - 1U));
+    CHECK(!ScopeRecord_Contains(3U + FRAMES));
+    CHECK_EQ(ScopeRecord_FrameStart(3U), RECORD_SAMPLES - SCOPE_FRAME_SAMPLES);
+    CHECK_EQ(ScopeRecord_FrameStart(3U + FRAMES - 1U), 0U);
+
+    /* Whole record, then a read across the end that continues at 0. */
+    static uint16_t back[RECORD_SAMPLES];
+    ScopeRecord_Read(0U, RECORD_SAMPLES, back);
+    CHECK(memcmp(expect, back, sizeof(back)) == 0);
+    uint16_t seam[100];
+    ScopeRecord_Read(RECORD_SAMPLES - 37U, 100U, seam);
+    CHECK(memcmp(seam, &expect[RECORD_SAMPLES - 37U], 37U * sizeof(seam[0])) == 0);
+    CHECK(memcmp(&seam[37], expect, 63U * sizeof(seam[0])) == 0);
+    CHECK_EQ(ScopeRecord_Sample(12345U), expect[12345U]);
+
+    /* From a frame in the middle, only the older part of the run joins. */
+    CHECK_EQ(ScopeRecord_Build(3U + 10U), FRAMES - 10U);
+    /* The three newest frames stop at the gap to 140. */
+    CHECK_EQ(ScopeRecord_Build(0U), 3U);
+    CHECK_EQ(ScopeRecord_Build(ScopeHistory_Count()), 0U);
+    CHECK_EQ(ScopeRecord_Length(), 0U);
+}
+
+static void TestEnvelopeMatchesBruteForce(void)
+{
+    /* The pyramid answer must equal a scan of every sample for zoomed-out
+       windows up to the whole record, zoomed-in ones with several columns
+       per sample, and windows that wrap around the end. */
+    Setup();
+    CHECK_EQ(ScopeRecord_Build(3U), FRAMES);
+    uint32_t state = 99U;
+    uint16_t map[COLUMNS];
+    uint16_t got_min[COLUMNS];
+    uint16_t got_max[COLUMNS];
+    uint16_t want_min[COLUMNS];
+    uint16_t want_max[COLUMNS];
+    for (uint32_t trial = 0U; trial < 400U; ++trial)
+    {
+        uint32_t visible;
+        switch (trial % 4U)
+        {
+        case 0U:
+            visible = RECORD_SAMPLES;
+            break;
+        case 1U:
+            visible = 1U + Rand(&state) % COLUMNS;
+            break;
+        default:
+            visible = COLUMNS + Rand(&state) % (RECORD_SAMPLES - COLUMNS);
+            break;
+        }
+        uint32_t start = Rand(&state) % RECORD_SAMPLES;
+        ColumnMap(map, start, visible, RECORD_SAMPLES);
+        ScopeRecord_Envelope(map, COLUMNS, (uint16_t)visible, got_min, got_max);
+        BruteEnvelope(map, visible, RECORD_SAMPLES, want_min, want_max);
+        CHECK(memcmp(got_min, want_min, sizeof(got_min)) == 0);
+        CHECK(memcmp(got_max, want_max, sizeof(got_max)) == 0);
+    }
+}
+
+static void TestOddBlockCount(void)
+{
+    /* Three frames give 30 blocks, so levels end in lone entries. */
+    Setup();
+    CHECK_EQ(ScopeRecord_Build(3U + FRAMES - 3U), 3U);
+    ScopeRecordStatus status;
+    ScopeRecord_GetStatus(&status);
+    CHECK(status.levels >= 5U);
+
+    uint32_t length = 3U * SCOPE_FRAME_SAMPLES;
+    uint16_t map[COLUMNS];
+    uint16_t got_min[COLUMNS];
+    uint16_t got_max[COLUMNS];
+    uint16_t want_min[COLUMNS];
+    uint16_t want_max[COLUMNS];
+    for (uint32_t start = 0U; start < length; start += 41U)
+    {
+        ColumnMap(map, start, length, length);
+        ScopeRecord_Envelope(map, COLUMNS, (uint16_t)length, got_min, got_max);
+        BruteEnvelope(map, length, length, want_min, want_max);
+        CHECK(memcmp(got_min, want_min, sizeof(got_min)) == 0);
+        CHECK(memcmp(got_max, want_max, sizeof(got_max)) == 0);
+    }
+}
+
+int main(void)
+{
+    TestBuildJoinsRun();
+    TestEnvelopeMatchesBruteForce();
+    TestOddBlockCount();
+    return test_report("test_record");
+}
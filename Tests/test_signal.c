@@ -0,0 +1,116 @@
+#include "scope_signal.h"
+
+#include "adc.h"
+#include "dac.h"
+#include "tim.h"
+#include "test_check.h"
+
+#include <math.h>
+
+enum
+{
+    RECORD = 320U,
+    MIN_DELTA = 100U
+};
+
+/* Stand-ins for the CubeMX handles scope_signal.c reaches through. */
+static TIM_TypeDef tim3_regs;
+static TIM_TypeDef tim4_regs;
+TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim3 = {.Instance = &tim3_regs};
+TIM_HandleTypeDef htim4 = {.Instance = &tim4_regs};
+ADC_HandleTypeDef hadc1;
+DAC_HandleTypeDef hdac;
+
+static uint16_t record[RECORD];
+
+/* Fundamental plus an optional third harmonic around mid-scale. */
+static void Build(double period, double amplitude, double third)
+{
+    for (uint32_t i = 0U; i < RECORD; ++i)
+    {
+        double phase = 2.0 * M_PI * (double)i / period;
+        double v = 2048.0 + amplitude * (sin(phase) + third * sin(3.0 * phase)) / (1.0 + third);
+        record[i] = (uint16_t)floor(v + 0.5);
+    }
+}
+
+static void Span(uint16_t *min, uint16_t *max)
+{
+    *min = 0xFFFFU;
+    *max = 0U;
+    for (uint32_t i = 0U; i < RECORD; ++i)
+    {
+        *min = (record[i] < *min) ? record[i] : *min;
+        *max = (record[i] > *max) ? record[i] : *max;
+    }
+}
+
+static double AcfPeriod(void)
+{
+    return (double)ScopeSignal_EstimatePeriodAcfQ8(record, RECORD) / 256.0;
+}
+
+static void TestAcfPeriods(void)
+{
+    /* Short periods use only the full-rate lags, long ones the decimated
+       search and the full-rate refinement; the parabola recovers the
+       fraction to a few hundredths of a sample. */
+    static const double periods[] = {7.3, 12.0, 37.4, 61.25, 150.6};
+    for (uint32_t p = 0U; p < sizeof(periods) / sizeof(periods[0]); ++p)
+    {
+        Build(periods[p], 1500.0, 0.0);
+        CHECK(fabs(AcfPeriod() - periods[p]) < 0.005 * periods[p] + 0.05);
+    }
+}
+
+static void TestAcfRejects(void)
+{
+    /* Flat input, a period too long to repeat inside the overlap, and a
+       record too short to search all give no estimate. */
+    Build(50.0, 0.0, 0.0);
+    CHECK_EQ(ScopeSignal_EstimatePeriodAcfQ8(record, RECORD), 0U);
+    Build(400.0, 1500.0, 0.0);
+    CHECK_EQ(ScopeSignal_EstimatePeriodAcfQ8(record, RECORD), 0U);
+    Build(10.0, 1500.0, 0.0);
+    CHECK_EQ(ScopeSignal_EstimatePeriodAcfQ8(record, 40U), 0U);
+    CHECK_EQ(ScopeSignal_EstimatePeriodAcfQ8(NULL, RECORD), 0U);
+}
+
+static void TestRobustFallsBack(void)
+{
+    /* A third harmonic stronger than the fundamental adds mid-level
+       crossings inside each cycle, so counting crossings gives a fraction
+       of the period; the autocorrelation does not care. */
+    const double period = 45.0;
+    Build(period, 1500.0, 1.2);
+    uint16_t min;
+    uint16_t max;
+    Span(&min, &max);
+    uint16_t trig = ScopeSignal_FindRisingCrossing(record, RECORD, (uint16_t)((min + max) / 2U));
+    uint32_t crossing = ScopeSignal_EstimatePeriodSamples(record, RECORD, trig, min, max, MIN_DELTA);
+    CHECK(crossing != 0U && crossing < (uint32_t)(period * 0.75));
+
+    double robust = (double)ScopeSignal_EstimatePeriodRobustQ8(record, RECORD, trig, min, max, MIN_DELTA) / 256.0;
+    CHECK(fabs(robust - period) < 0.5);
+
+    /* With a clean sine both agree, and the crossing estimate is kept. */
+    Build(period, 1500.0, 0.0);
+    Span(&min, &max);
+    trig = ScopeSignal_FindRisingCrossing(record, RECORD, (uint16_t)((min + max) / 2U));
+    crossing = ScopeSignal_EstimatePeriodSamples(record, RECORD, trig, min, max, MIN_DELTA);
+    CHECK_EQ(ScopeSignal_EstimatePeriodRobustQ8(record, RECORD, trig, min, max, MIN_DELTA), crossing << 8);
+
+    /* Below the minimum swing nothing is reported. */
+    Build(period, 40.0, 0.0);
+    Span(&min, &max);
+    CHECK_EQ(ScopeSignal_EstimatePeriodRobustQ8(record, RECORD, 0U, min, max, MIN_DELTA), 0U);
+}
+
+int main(void)
+{
+    TestAcfPeriods();
+    TestAcfRejects();
+    TestRobustFallsBack();
+    return test_report("test_signal");
+}
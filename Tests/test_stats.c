@@ -0,0 +1,101 @@
+#include "scope_stats.h"
+
+#include "test_check.h"
+
+#include <string.h>
+
+static void Accumulate(ScopeMeasureId id, int32_t value)
+{
+    ScopeMeasureResult result;
+    memset(&result, 0, sizeof(result));
+    result.values[id] = value;
+    result.valid_mask = 1UL << id;
+    ScopeStats_Accumulate(&result);
+}
+
+static void TestKnownSeries(void)
+{
+    /* 2, 4, 4, 4, 5, 5, 7, 9: mean 5, sample stddev sqrt(32 / 7) = 2.14. */
+    static const int32_t values[] = {2, 4, 4, 4, 5, 5, 7, 9};
+    ScopeStats_Init();
+    for (uint32_t i = 0U; i < sizeof(values) / sizeof(values[0]); ++i)
+    {
+        Accumulate(SCOPE_MEASURE_VPP, values[i]);
+    }
+
+    ScopeStatsSummary summary;
+    CHECK(ScopeStats_Get(SCOPE_MEASURE_VPP, &summary));
+    CHECK_EQ(summary.count, 8U);
+    CHECK_EQ(summary.current, 9);
+    CHECK_EQ(summary.min, 2);
+    CHECK_EQ(summary.max, 9);
+    CHECK_EQ(summary.mean, 5);
+    CHECK_EQ(summary.stddev, 2);
+}
+
+static void TestOnlyValidEntries(void)
+{
+    ScopeStats_Init();
+    ScopeMeasureResult result;
+    memset(&result, 0, sizeof(result));
+    result.values[SCOPE_MEASURE_VMAX] = 1200;
+    result.values[SCOPE_MEASURE_FREQ] = 777;
+    result.valid_mask = 1UL << SCOPE_MEASURE_VMAX;
+    ScopeStats_Accumulate(&result);
+
+    ScopeStatsSummary summary;
+    CHECK(ScopeStats_Get(SCOPE_MEASURE_VMAX, &summary));
+    CHECK_EQ(summary.count, 1U);
+    CHECK_EQ(summary.stddev, 0);
+    CHECK(!ScopeStats_Get(SCOPE_MEASURE_FREQ, &summary));
+    CHECK_EQ(summary.count, 0U);
+    CHECK(!ScopeStats_Get(SCOPE_MEASURE_COUNT, &summary));
+    ScopeStats_Accumulate(NULL);
+}
+
+static void TestLargeOffset(void)
+{
+    /* A 10 MHz frequency toggling by +-3 Hz: a float sum of squares would
+       cancel to noise, the running update must still report 3. */
+    ScopeStats_Init();
+    for (uint32_t i = 0U; i < 200000U; ++i)
+    {
+        Accumulate(SCOPE_MEASURE_FREQ, (i & 1U) ? 10000003 : 9999997);
+    }
+
+    ScopeStatsSummary summary;
+    CHECK(ScopeStats_Get(SCOPE_MEASURE_FREQ, &summary));
+    CHECK_EQ(summary.mean, 10000000);
+    CHECK_EQ(summary.stddev, 3);
+    CHECK_EQ(summary.min, 9999997);
+    CHECK_EQ(summary.max, 10000003);
+}
+
+static void TestNegativeAndReset(void)
+{
+    ScopeStats_Init();
+    Accumulate(SCOPE_MEASURE_VMIN, -300);
+    Accumulate(SCOPE_MEASURE_VMIN, -100);
+
+    ScopeStatsSummary summary;
+    CHECK(ScopeStats_Get(SCOPE_MEASURE_VMIN, &summary));
+    CHECK_EQ(summary.min, -300);
+    CHECK_EQ(summary.max, -100);
+    CHECK_EQ(summary.mean, -200);
+
+    ScopeStats_SetPanelVisible(5U);
+    CHECK_EQ(ScopeStats_IsPanelVisible(), 1U);
+    ScopeStats_Reset();
+    CHECK(!ScopeStats_Get(SCOPE_MEASURE_VMIN, &summary));
+    /* Reset clears the statistics, not the panel. */
+    CHECK_EQ(ScopeStats_IsPanelVisible(), 1U);
+}
+
+int main(void)
+{
+    TestKnownSeries();
+    TestOnlyValidEntries();
+    TestLargeOffset();
+    TestNegativeAndReset();
+    return test_report("test_stats");
+}
@@ -0,0 +1,284 @@
+#include "scope_trigger.h"
+
+#include "test_check.h"
+
+#include <string.h>
+
+enum
+{
+    FRAME = 320U,
+    MAX_FRAMES = 8U,
+    LOW = 500U,
+    HIGH = 3500U,
+    MID = 2000U,
+    /* 1 MHz: one sample per microsecond. */
+    RATE_HZ = 1000000U
+};
+
+typedef struct
+{
+    uint16_t samples[MAX_FRAMES * FRAME];
+    uint32_t length;
+} Stream;
+
+typedef struct
+{
+    uint32_t frame[MAX_FRAMES];
+    uint16_t index[MAX_FRAMES];
+    uint32_t count;
+} Events;
+
+static void Stream_Level(Stream *s, uint16_t value, uint32_t samples)
+{
+    while (samples-- > 0U && s->length < MAX_FRAMES * FRAME)
+    {
+        s->samples[s->length++] = value;
+    }
+}
+
+/* Positive pulse of the given width after a low gap. */
+static void Stream_Pulse(Stream *s, uint32_t gap, uint32_t width)
+{
+    Stream_Level(s, LOW, gap);
+    Stream_Level(s, HIGH, width);
+}
+
+static void Stream_Fill(Stream *s, uint16_t value)
+{
+    Stream_Level(s, value, MAX_FRAMES * FRAME - s->length);
+}
+
+static void Configure(ScopeTriggerType type, uint32_t width_us, ScopeTriggerPolarity polarity)
+{
+    ScopeTriggerConfig cfg = {
+        .type = type,
+        .polarity = polarity,
+        .width_ns = width_us * 1000U,
+        .level_low = 1000U,
+        .level_high = 3000U,
+        .auto_levels = 0U
+    };
+    ScopeTrigger_Init();
+    CHECK(ScopeTrigger_Configure(&cfg));
+    ScopeTrigger_Service(RATE_HZ);
+}
+
+static void Run(const Stream *s, Events *ev)
+{
+    memset(ev, 0, sizeof(*ev));
+    for (uint32_t frame = 0U; frame < MAX_FRAMES; ++frame)
+    {
+        uint16_t index = ScopeTrigger_ProcessFromISR(&s->samples[frame * FRAME], FRAME);
+        if (index != SCOPE_TRIGGER_NO_EVENT && ev->count < MAX_FRAMES)
+        {
+            ev->frame[ev->count] = frame;
+            ev->index[ev->count] = index;
+            ev->count++;
+        }
+    }
+}
+
+static uint32_t EventsCounted(void)
+{
+    ScopeTriggerStatus status;
+    ScopeTrigger_GetStatus(&status);
+    return status.events;
+}
+
+static void TestPulseLess(void)
+{
+    /* Only the 5 us pulse is shorter than 10 us; it ends at sample 40 + 20 +
+       40 + 5 = 105. */
+    Stream s = {0};
+    Stream_Pulse(&s, 40U, 20U);
+    Stream_Pulse(&s, 40U, 5U);
+    Stream_Pulse(&s, 40U, 20U);
+    Stream_Pulse(&s, 40U, 10U);
+    Stream_Fill(&s, LOW);
+
+    Events ev;
+    Configure(SCOPE_TRIGGER_PULSE_LESS, 10U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.frame[0], 0U);
+    CHECK_EQ(ev.index[0], 105U);
+    CHECK_EQ(EventsCounted(), 1U);
+}
+
+static void TestPulseGreater(void)
+{
+    Stream s = {0};
+    Stream_Pulse(&s, 30U, 8U);
+    Stream_Pulse(&s, 30U, 10U);
+    Stream_Pulse(&s, 30U, 25U);
+    Stream_Fill(&s, LOW);
+
+    Events ev;
+    Configure(SCOPE_TRIGGER_PULSE_GREATER, 10U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.index[0], 30U + 8U + 30U + 10U + 30U + 25U);
+    CHECK_EQ(EventsCounted(), 1U);
+}
+
+static void TestRunt(void)
+{
+    /* A full pulse, a runt that stops between the levels, then a pulse that
+       only pauses in the middle on its way up. */
+    Stream s = {0};
+    Stream_Pulse(&s, 20U, 20U);
+    Stream_Level(&s, LOW, 20U);
+    Stream_Level(&s, MID, 15U);
+    Stream_Level(&s, LOW, 20U);
+    Stream_Level(&s, MID, 15U);
+    Stream_Level(&s, HIGH, 15U);
+    Stream_Fill(&s, LOW);
+
+    Events ev;
+    Configure(SCOPE_TRIGGER_RUNT, 0U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.index[0], 20U + 20U + 20U + 15U);
+    CHECK_EQ(EventsCounted(), 1U);
+}
+
+static void TestTimeout(void)
+{
+    /* Edges every 20 us, then silence: fires once, 50 us after the last
+       edge, and not again while the line stays quiet. */
+    Stream s = {0};
+    for (uint32_t i = 0U; i < 5U; ++i)
+    {
+        Stream_Pulse(&s, 20U, 20U);
+    }
+    uint32_t last_edge = s.length;
+    Stream_Fill(&s, LOW);
+
+    Events ev;
+    Configure(SCOPE_TRIGGER_TIMEOUT, 50U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.frame[0] * FRAME + ev.index[0], last_edge + 50U);
+    CHECK_EQ(EventsCounted(), 1U);
+}
+
+static void TestStraddlesFrames(void)
+{
+    /* A 12 us pulse from sample 314 of frame 0 to 6 of frame 1, and a 30 us
+       one spanning frames 2 and 3: each is measured across the boundary and
+       reported in the frame where it ends. */
+    Stream s = {0};
+    Stream_Pulse(&s, FRAME - 6U, 12U);
+    Stream_Level(&s, LOW, 2U * FRAME - s.length - 10U);
+    Stream_Level(&s, HIGH, 30U);
+    Stream_Fill(&s, LOW);
+
+    Events ev;
+    Configure(SCOPE_TRIGGER_PULSE_GREATER, 10U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 2U);
+    CHECK_EQ(ev.frame[0], 1U);
+    CHECK_EQ(ev.index[0], 6U);
+    CHECK_EQ(ev.frame[1], 2U);
+    CHECK_EQ(ev.index[1], 20U);
+
+    /* The same train against a 20 us limit only flags the longer pulse. */
+    Configure(SCOPE_TRIGGER_PULSE_LESS, 20U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.frame[0], 1U);
+    CHECK_EQ(ev.index[0], 6U);
+}
+
+static void TestNegativePolarity(void)
+{
+    /* Low-going pulses on a high line: 5 us and 20 us wide. */
+    Stream s = {0};
+    Stream_Level(&s, HIGH, 40U);
+    Stream_Level(&s, LOW, 5U);
+    Stream_Level(&s, HIGH, 40U);
+    Stream_Level(&s, LOW, 20U);
+    Stream_Fill(&s, HIGH);
+
+    Events ev;
+    Configure(SCOPE_TRIGGER_PULSE_LESS, 10U, SCOPE_TRIGGER_POLARITY_NEGATIVE);
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.index[0], 45U);
+}
+
+static void TestIdleUntilServiced(void)
+{
+    Stream s = {0};
+    Stream_Pulse(&s, 40U, 5U);
+    Stream_Fill(&s, LOW);
+
+    ScopeTriggerConfig cfg = {
+        .type = SCOPE_TRIGGER_PULSE_LESS,
+        .width_ns = 10000U,
+        .level_low = 1000U,
+        .level_high = 3000U
+    };
+    ScopeTrigger_Init();
+    CHECK(ScopeTrigger_Configure(&cfg));
+    Events ev;
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 0U);
+}
+
+static void TestAutoLevels(void)
+{
+    /* Auto levels come from the frames already seen, so the first frame only
+       trains them; the short pulse in the second frame is caught. */
+    Stream s = {0};
+    for (uint32_t i = 0U; i < 4U; ++i)
+    {
+        Stream_Pulse(&s, 60U, 20U);
+    }
+    Stream_Level(&s, LOW, FRAME - s.length);
+    Stream_Pulse(&s, 100U, 4U);
+    Stream_Fill(&s, LOW);
+
+    ScopeTriggerConfig cfg = {
+        .type = SCOPE_TRIGGER_PULSE_LESS,
+        .width_ns = 10000U,
+        .auto_levels = 1U
+    };
+    ScopeTrigger_Init();
+    CHECK(ScopeTrigger_Configure(&cfg));
+    ScopeTrigger_Service(RATE_HZ);
+    Events ev;
+    Run(&s, &ev);
+    CHECK_EQ(ev.count, 1U);
+    CHECK_EQ(ev.frame[0], 1U);
+    CHECK_EQ(ev.index[0], 104U);
+}
+
+static void TestRateChangeResyncs(void)
+{
+    /* A pulse open when the rate changes is not measured across it. */
+    Stream s = {0};
+    Stream_Level(&s, LOW, FRAME - 4U);
+    Stream_Level(&s, HIGH, 8U);
+    Stream_Fill(&s, LOW);
+
+    Configure(SCOPE_TRIGGER_PULSE_LESS, 10U, SCOPE_TRIGGER_POLARITY_POSITIVE);
+    CHECK_EQ(ScopeTrigger_ProcessFromISR(&s.samples[0], FRAME), SCOPE_TRIGGER_NO_EVENT);
+    ScopeTrigger_Service(RATE_HZ / 2U);
+    CHECK_EQ(ScopeTrigger_ProcessFromISR(&s.samples[FRAME], FRAME), SCOPE_TRIGGER_NO_EVENT);
+    CHECK_EQ(EventsCounted(), 0U);
+}
+
+int main(void)
+{
+    TestPulseLess();
+    TestPulseGreater();
+    TestRunt();
+    TestTimeout();
+    TestStraddlesFrames();
+    TestNegativePolarity();
+    TestIdleUntilServiced();
+    TestAutoLevels();
+    TestRateChangeResyncs();
+    return test_report("test_trigger");
+}